@@ -11,6 +11,25 @@
 #define TWOPI 6.283185307
 
 
+/*
+ * Common end of the PLLs: frequency from the loop filter output, then phase angle integration
+ */
+template<class PLL>
+static inline float AdvancePLL(PLL* me, float u)
+{
+	me->omega = me->omega0 + u;
+
+	// Integrate the angular frequency:
+	me->theta += me->omega * me->ts;
+
+    // Oscillate (modulo):
+	if (me->theta > PI){me->theta -= TWOPI;}
+	else if (me->theta < - PI){me->theta += TWOPI;}
+
+    return me->theta;
+}
+
+
 void ConfigDQPLL(DQPLLParameters* me, float kp, float ki, float omega0, float tsample)
 {
 	// Set the PLL parameters:
@@ -18,11 +37,13 @@ void ConfigDQPLL(DQPLLParameters* me, float kp, float ki, float omega0, float ts
     me->ts = tsample;
 
 	// Configure the corresponding controller:
-    ConfigPIDController(&(me->PI_reg), kp, ki, 0.0, 0.1*omega0, -0.1*omega0, tsample, 10);
+	ConfigController(&me->PI_reg, kp, ki);
+	ConfigControllerLimits(&me->PI_reg, 0.1*omega0, -0.1*omega0);
 
     // Initialize the state quantities:
     me->theta = 0.0;
     me->omega = omega0;
+    UpdatePhaseAngle(&me->angle, me->theta);
 }
 
 
@@ -32,7 +53,8 @@ void ConfigSOGIPLL1(SOGIPLL1Parameters* me, float kp, float ki, float sogigain,
 	ConfigSOGI3(&me->SOGI, sogigain, omega0, tsample);
 
 	// Configure the inner PI controller:
-	ConfigPIDController(&me->PI_reg, kp, ki, 0.0, 0.1*omega0, -0.1*omega0, tsample,10);
+	ConfigController(&me->PI_reg, kp, ki);
+	ConfigControllerLimits(&me->PI_reg, 0.1*omega0, -0.1*omega0);
 
 	// Set the PLL parameters:
     me->omega0 = omega0;
@@ -41,6 +63,7 @@ void ConfigSOGIPLL1(SOGIPLL1Parameters* me, float kp, float ki, float sogigain,
     // Initialize the state variable:
     me->theta = 0.0;
     me->omega = omega0;
+    UpdatePhaseAngle(&me->angle, me->theta);
 }
 
 
@@ -71,7 +94,8 @@ void ConfigDSOGIPLL3(DSOGIPLL3Parameters* me, float kp, float ki, float sogigain
 	ConfigSOGI3(&me->SOGIb, sogigain, omega0, tsample);
 
 	// Configure the inner PI controller:
-	ConfigPIDController(&me->PI_reg, kp, ki, 0.0, 0.1*omega0, -0.1*omega0, tsample,10);
+	ConfigController(&me->PI_reg, kp, ki);
+	ConfigControllerLimits(&me->PI_reg, 0.1*omega0, -0.1*omega0);
 
 	// Set the PLL parameters:
     me->omega0 = omega0;
@@ -80,6 +104,7 @@ void ConfigDSOGIPLL3(DSOGIPLL3Parameters* me, float kp, float ki, float sogigain
     // Initialize the state variable:
     me->theta = 0.0;
     me->omega = omega0;
+    UpdatePhaseAngle(&me->angle, me->theta);
 }
 
 
@@ -96,45 +121,22 @@ void ConfigFAE(FAEParameters* me, float R, float L, float tsample)
 
 float RunDQPLL(DQPLLParameters* me, const SpaceVector *vin_dq0)
 {
-	/*********************************************************************** 
-	 * Begin of PI controller code
-	 ***********************************************************************/
-		float ui;
-		float u;
-
-		ui = me->PI_reg.ui_prev + me->PI_reg.ki/me->PI_reg.kp * vin_dq0->imaginary;
-
-		// Compute the output:
-		u = me->PI_reg.kp * (vin_dq0->imaginary + ui);
-
-		// Apply the standard Anti-Reset Windup method:
-		if (u > me->PI_reg.limup){
-			me->PI_reg.ui_prev = me->PI_reg.limup / me->PI_reg.kp - vin_dq0->imaginary;
-			u = me->PI_reg.limup;
-		}
-		else if (u < me->PI_reg.limlow){
-			me->PI_reg.ui_prev = me->PI_reg.limlow / me->PI_reg.kp - vin_dq0->imaginary;
-			u = me->PI_reg.limlow;
-		}
-		else{
-			me->PI_reg.ui_prev = ui;
-											// The integral term is never reset
-		}
-	/************************************************************************ 
-	 * End of PI controller code
-	 ************************************************************************/
-
-    // Control the q axis of the voltage to zero (u is the output of the PI):
-	me->omega = me->omega0 + u;
+	// Loop filter:
+	float u = RunController(&me->PI_reg, vin_dq0->imaginary);
 
-	// Integrate the angular frequency:
-	me->theta += me->omega * me->ts;
+	// Control the q axis of the voltage to zero and integrate the angular frequency:
+	return AdvancePLL(me, u);								                    // The angle is computed on demand (GetDQPLLAngle)
+}
 
-    // Oscillate (modulo):
-	if (me->theta > PI){me->theta -= TWOPI;}
-	else if (me->theta < - PI){me->theta += TWOPI;}
 
-    return me->theta;
+const PhaseAngle* GetDQPLLAngle(DQPLLParameters* me)
+{
+	// Compute the sine and cosine once per new theta, only if somebody reads them:
+	if (me->angle.theta != me->theta){
+		UpdatePhaseAngle(&me->angle, me->theta);
+	}
+
+	return &me->angle;
 }
 
 
@@ -174,47 +176,18 @@ float RunSOGIPLL1(SOGIPLL1Parameters* me, SpaceVector* UABG, float vin)
 	(*UABG) = RunSOGI3(&me->SOGI,vin);
 
 	// Compute the ABG-DQ0 transform for the Q axis only:
-	float vin_q = -sin(me->theta) * UABG->real + cos(me->theta) * UABG->imaginary;
-
-	/*********************************************************************** 
- 	 *  Begin of PI controller code
-	 ***********************************************************************/
-		float ui;
-		float u;
-
-		ui = me->PI_reg.ui_prev + me->PI_reg.ki/me->PI_reg.kp * vin_q;
-
-		// Compute the output:
-		u = me->PI_reg.kp * (vin_q + ui);
-
-		// Apply the standard Anti-Reset Windup method:
-		if (u > me->PI_reg.limup){
-			me->PI_reg.ui_prev = me->PI_reg.limup / me->PI_reg.kp - vin_q;
-			u = me->PI_reg.limup;
-		}
-		else if (u < me->PI_reg.limlow){
-			me->PI_reg.ui_prev = me->PI_reg.limlow / me->PI_reg.kp - vin_q;
-			u = me->PI_reg.limlow;
-		}
-		else{
-			me->PI_reg.ui_prev = ui;
-											// The integral term is never reset
-		}
-	/************************************************************************ 
-	 * End of PI controller code
-	 ************************************************************************/
-
-    // Control the q axis of the voltage to zero (u is the PI's output):
-	me->omega = me->omega0 + u;
+	float vin_q = -me->angle.sinTheta * UABG->real + me->angle.cosTheta * UABG->imaginary;
 
-	// Integrate the angular frequency:
-	me->theta += me->omega * me->ts;
+	// Loop filter:
+	float u = RunController(&me->PI_reg, vin_q);
 
-    // Oscillate (modulo):
-	if (me->theta > PI){me->theta -= TWOPI;}
-	else if (me->theta < - PI){me->theta += TWOPI;}
+	// Control the q axis of the voltage to zero and integrate the angular frequency:
+	float theta = AdvancePLL(me, u);
 
-    return me->theta;
+	// Precompute the sine and cosine of the new angle (used by the next call and by the transformations):
+	UpdatePhaseAngle(&me->angle, theta);
+
+	return theta;
 }
 
 
@@ -230,47 +203,18 @@ float RunDSOGIPLL3(DSOGIPLL3Parameters* me, SpaceVector* vin_abg)
 	UABG.real = a.real - b.imaginary;
 
 	// Compute the ABG-DQ0 transform for the Q axis only:
-	float vin_q = -sin(me->theta) * UABG.real + cos(me->theta) * UABG.imaginary;
-
-	/*********************************************************************** 
- 	 *  Begin of PI controller code
-	 ***********************************************************************/
-		float ui;
-		float u;
-
-		ui = me->PI_reg.ui_prev + me->PI_reg.ki/me->PI_reg.kp * vin_q;
-
-		// Compute the output:
-		u = me->PI_reg.kp * (vin_q + ui);
-
-		// Apply the standard Anti-Reset Windup method:
-		if (u > me->PI_reg.limup){
-			me->PI_reg.ui_prev = me->PI_reg.limup / me->PI_reg.kp - vin_q;
-			u = me->PI_reg.limup;
-		}
-		else if (u < me->PI_reg.limlow){
-			me->PI_reg.ui_prev = me->PI_reg.limlow / me->PI_reg.kp - vin_q;
-			u = me->PI_reg.limlow;
-		}
-		else{
-			me->PI_reg.ui_prev = ui;
-											// The integral term is never reset
-		}
-	/************************************************************************ 
-	 * End of PI controller code
-	 ************************************************************************/
-
-    // Control the q axis of the voltage to zero (u is the PI's output):
-	me->omega = me->omega0 + u;
+	float vin_q = -me->angle.sinTheta * UABG.real + me->angle.cosTheta * UABG.imaginary;
 
-	// Integrate the angular frequency:
-	me->theta += me->omega * me->ts;
+	// Loop filter:
+	float u = RunController(&me->PI_reg, vin_q);
 
-    // Oscillate (modulo):
-	if (me->theta > PI){me->theta -= TWOPI;}
-	else if (me->theta < - PI){me->theta += TWOPI;}
+	// Control the q axis of the voltage to zero and integrate the angular frequency:
+	float theta = AdvancePLL(me, u);
 
-    return me->theta;
+	// Precompute the sine and cosine of the new angle (used by the next call and by the transformations):
+	UpdatePhaseAngle(&me->angle, theta);
+
+	return theta;
 }
 
 
@@ -2,11 +2,18 @@
 #define PLLS_H_
 
 #include "transformations.h"	                                                // Three-phase data types
-#include "controllers.h"		                                                // Controller parameters and data types
+#include "controllertemplate.h"	                                            // Controllers with compile-time policies
 
 #include <stdint.h>
 
 
+/**
+ *	Loop filter shared by all the PLLs: PI controller (mixed structure, per-sample ki as in RunPIController)
+ *	with the standard Anti-Reset Windup method on +/- 10% of omega0. The integral term is never reset.
+ */
+typedef Controller<PIStructure, BackCalculation, NeverReset, float> PLLLoopFilter;
+
+
 /**
  *	Struct holding the state information for a triple integrator. Such a module is used to approximate
  *	1/s in a discrete environment. All the parameters stored in this struct make up a SOGI pseudo-object
@@ -42,13 +49,18 @@ typedef struct{
 /**
  *  Parameters for the DQ-based Phase-Locked Loop. Parameter omega0 refers to the nominal angular frequency of the
  *  sinusoidal signal
+ *  In the SOGI-based PLLs, 'angle' is kept consistent with 'theta' by the run routines (they need it on the next
+ *  call): pass &pll.angle to the transformations of the same interrupt rather than pll.theta to avoid recomputing
+ *  the sine and cosine. RunDQPLL does not need it and leaves it stale: use GetDQPLLAngle(&pll) instead, which
+ *  computes it at most once per new theta.
  */
 typedef struct{
 	float theta;				                                                // Phase angle of the grid voltage
+	PhaseAngle angle;			                                                // Trigonometric values of theta (read with GetDQPLLAngle)
 	float omega;				                                                // Debug only: is not a state variable
 	float omega0;				                                                // Default grid frequency (feedforward quantity)
 	float ts;					                                                // Sampling interval
-	PIDController PI_reg;		                                                // Corresponding PID controller pseudo-object
+	PLLLoopFilter PI_reg;		                                                // Corresponding PI controller pseudo-object
 } DQPLLParameters;
 
 
@@ -57,11 +69,12 @@ typedef struct{
  */
 typedef struct{
 	float theta;				                                                // Phase angle of the grid voltage
+	PhaseAngle angle;			                                                // Trigonometric values of theta (to be shared with the transformations)
 	float omega;				                                                // Debug only: is not a state variable
 	float omega0;				                                                // Default grid frequency (feedforward quantity)
 	float ts;					                                                // Sampling interval
 	SOGI3Parameters SOGI;		                                                // Second-order generalized integrator
-	PIDController PI_reg;		                                                // Corresponding PID controller pseudo-object
+	PLLLoopFilter PI_reg;		                                                // Corresponding PI controller pseudo-object
 } SOGIPLL1Parameters;
 
 
@@ -70,12 +83,13 @@ typedef struct{
  */
 typedef struct{
 	float theta;				                                                // Phase angle of the grid voltage
+	PhaseAngle angle;			                                                // Trigonometric values of theta (to be shared with the transformations)
 	float omega;				                                                // Debug only: is not a state variable
 	float omega0;				                                                // Default grid frequency (feedforward quantity)
 	float ts;					                                                // Sampling interval
 	SOGI3Parameters SOGIa;		                                                // Second-order generalized integrator, alpha axis
 	SOGI3Parameters SOGIb;		                                                // Second-order generalized integrator, beta axis
-	PIDController PI_reg;		                                                // Corresponding PID controller pseudo-object
+	PLLLoopFilter PI_reg;		                                                // Corresponding PI controller pseudo-object
 } DSOGIPLL3Parameters;
 
 
@@ -153,6 +167,15 @@ SpaceVector RunSOGI3(SOGI3Parameters *me, float input);
 float RunDQPLL(DQPLLParameters* me, const SpaceVector *ug_dq0);
 
 
+/**
+ * Return the sine and cosine of the phase angle of the DQ-based PLL, computed on the first call after
+ * each RunDQPLL (callers that only use the returned theta never pay for them)
+ * @param *me		the corresponding PLL pseudo-object
+ * @return			the trigonometric values of me->theta (to be shared with the transformations)
+ */
+const PhaseAngle* GetDQPLLAngle(DQPLLParameters* me);
+
+
 /**
  * Run the single-phase SOGI-based PLL
  * @param	*me 	the SOGI pseudo-object
@@ -0,0 +1,84 @@
+/*
+ *	@title	Per-interrupt control context (core state latch)
+ *	@file	controlcontext.cpp
+ */
+
+
+#include "controlcontext.h"					                                    // Corresponding header file
+
+
+void ConfigControlContext(ControlContext* me)
+{
+	me->state = BLOCKED;
+	me->pid_count = 0;
+	me->pr_count = 0;
+	me->bank_count = 0;
+	me->hook_count = 0;
+}
+
+
+int RegisterPIDController(ControlContext* me, PIDController* ctrl)
+{
+	if (me->pid_count >= CONTROL_CONTEXT_MAX_CONTROLLERS){ return -1; }
+	me->pid[me->pid_count++] = ctrl;
+	ctrl->managed = true;												        // The run routines no longer query the core state
+	return 0;
+}
+
+
+int RegisterPRController(ControlContext* me, PRController* ctrl)
+{
+	if (me->pr_count >= CONTROL_CONTEXT_MAX_CONTROLLERS){ return -1; }
+	me->pr[me->pr_count++] = ctrl;
+	ctrl->managed = true;												        // The run routines no longer query the core state
+	return 0;
+}
+
+
+int RegisterPIDControllerBank(ControlContext* me, PIDControllerBank* ctrl)
+{
+	if (me->bank_count >= CONTROL_CONTEXT_MAX_CONTROLLERS){ return -1; }
+	me->bank[me->bank_count++] = ctrl;
+	ctrl->managed = true;												        // The run routines no longer query the core state
+	return 0;
+}
+
+
+int RegisterControllerReset(ControlContext* me, void* ctrl, void (*reset)(void*))
+{
+	if (me->hook_count >= CONTROL_CONTEXT_MAX_CONTROLLERS){ return -1; }
+	me->hook_object[me->hook_count] = ctrl;
+	me->hook[me->hook_count++] = reset;
+	return 0;
+}
+
+
+/*
+ * Sample the core state and reset all the registered integrators on a transition.
+ */
+tCoreState UpdateControlContext(ControlContext* me)
+{
+	tCoreState state = GetCoreState();
+	bool was_operating = (me->state == OPERATING);
+	bool is_operating = (state == OPERATING);
+	me->state = state;
+
+	if (was_operating == is_operating){ return state; }
+
+	// Reset the integral terms (avoid integrating when the core has been disabled):
+	for (uint16_t i = 0; i < me->pid_count; i++){
+		me->pid[i]->ui_prev = 0.0;
+	}
+	for (uint16_t i = 0; i < me->pr_count; i++){
+		me->pr[i]->ui_prev = 0.0;
+		me->pr[i]->ui_prev2 = 0.0;
+	}
+	for (uint16_t i = 0; i < me->bank_count; i++){
+		for (uint16_t k = 0; k < CONTROLLER_BANK_MAX_CHANNELS; k++){ me->bank[i]->ui_prev[k] = 0.0; }
+	}
+	for (uint16_t i = 0; i < me->hook_count; i++){
+		me->hook[i](me->hook_object[i]);
+	}
+
+	return state;
+}
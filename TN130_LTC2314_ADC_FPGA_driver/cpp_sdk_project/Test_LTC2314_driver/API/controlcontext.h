@@ -0,0 +1,88 @@
+#ifndef CONTROLCONTEXT_H_
+#define CONTROLCONTEXT_H_
+
+#include "controllers.h"					// Controller pseudo-objects
+#include "controllerbank.h"					// Multi-channel controller pseudo-objects
+#include "controllertemplate.h"				// Controllers with compile-time policies
+#include "multiresonant.h"					// Multi-resonant controllers
+
+#include "Core/core.h"
+
+#include <stdint.h>
+
+#define CONTROL_CONTEXT_MAX_CONTROLLERS 32	// Per controller type
+
+
+/**
+ * Pseudo-object latching the core state once per interrupt for all the controllers.
+ * The run routines of the registered controllers do not query the core state themselves: the integral
+ * terms are reset in one pass by UpdateControlContext() when the core leaves OPERATING, and once more
+ * when it comes back, so that nothing integrated while the outputs were inhibited is kept.
+ * Registering a PID, PR controller or a bank marks it as managed; the controllers that are not registered
+ * keep resetting themselves on every call while the core is not OPERATING (one GetCoreState() per call).
+ * The template controllers declared with ResetOnCoreState are only reset by a context: they must be registered.
+ */
+typedef struct{
+	tCoreState state;						// Core state latched by the last UpdateControlContext()
+	uint16_t pid_count;
+	uint16_t pr_count;
+	uint16_t bank_count;
+	uint16_t hook_count;
+	PIDController* pid[CONTROL_CONTEXT_MAX_CONTROLLERS];		// Registered PID, PI and I controllers
+	PRController* pr[CONTROL_CONTEXT_MAX_CONTROLLERS];			// Registered PR controllers
+	PIDControllerBank* bank[CONTROL_CONTEXT_MAX_CONTROLLERS];	// Registered controller banks
+	void* hook_object[CONTROL_CONTEXT_MAX_CONTROLLERS];			// Registered template controllers
+	void (*hook[CONTROL_CONTEXT_MAX_CONTROLLERS])(void*);		// Corresponding reset routines
+} ControlContext;
+
+
+/**
+ * Routine to initialize the control context (no controller registered, core assumed BLOCKED)
+ * @param *me		the context pseudo-object
+ * @return void
+ */
+void ConfigControlContext(ControlContext* me);
+
+
+/**
+ * Routines to register a controller whose integral term must follow the core state.
+ * Typically called in UserInit(), after the controller has been configured (the configuration routines
+ * clear the managed flag: a controller configured again must be registered again).
+ * @param *me		the context pseudo-object
+ * @param *ctrl		the controller pseudo-object to register
+ * @return			0 on success, -1 if the context is full
+ */
+int RegisterPIDController(ControlContext* me, PIDController* ctrl);
+int RegisterPRController(ControlContext* me, PRController* ctrl);
+int RegisterPIDControllerBank(ControlContext* me, PIDControllerBank* ctrl);
+int RegisterControllerReset(ControlContext* me, void* ctrl, void (*reset)(void*));
+
+
+/**
+ * Routines to register a template controller (cf. controllertemplate.h, only compiles for the
+ * ResetOnCoreState policy) or a multi-resonant controller (cf. multiresonant.h).
+ * @param *me		the context pseudo-object
+ * @param *ctrl		the controller pseudo-object to register
+ * @return			0 on success, -1 if the context is full
+ */
+template<template<typename> class S, template<typename> class A, class R, typename Real>
+static inline int RegisterController(ControlContext* me, Controller<S, A, R, Real>* ctrl)
+{
+	return RegisterControllerReset(me, ctrl, &R::template ResetHook<Controller<S, A, R, Real>>);
+}
+
+static inline int RegisterMultiResonantController(ControlContext* me, MultiResonantController* ctrl)
+{
+	return RegisterControllerReset(me, ctrl, ResetMultiResonantController);
+}
+
+
+/**
+ * Routine to sample the core state, to be called once at the beginning of UserInterrupt().
+ * Resets the integral terms of all registered controllers on every transition from or to OPERATING.
+ * @param *me		the context pseudo-object
+ * @return			the latched core state
+ */
+tCoreState UpdateControlContext(ControlContext* me);
+
+#endif /*CONTROLCONTEXT_H_*/
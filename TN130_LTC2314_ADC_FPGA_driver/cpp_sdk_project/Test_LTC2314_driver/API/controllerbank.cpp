@@ -0,0 +1,134 @@
+/*
+ *	@title	Multi-channel discrete controllers (structure-of-arrays)
+ *	@file	controllerbank.cpp
+ */
+
+
+#include "controllerbank.h"					                                    // Corresponding header file
+
+#include "Core/core.h"
+
+
+/*
+ * Number of lanes actually processed: the channel count rounded up to a full vector.
+ * The padding lanes are kept harmless by ConfigPIDControllerBank (kp = 1, zero limits).
+ */
+static inline uint16_t BankLanes(const PIDControllerBank* me)
+{
+	return (me->channels + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+}
+
+
+void ConfigPIDControllerBank(PIDControllerBank* me, uint16_t channels)
+{
+	if (channels > CONTROLLER_BANK_MAX_CHANNELS){ channels = CONTROLLER_BANK_MAX_CHANNELS; }
+	me->channels = channels;
+	me->managed = false;					                                    // Reset by the run routines until registered
+
+	for (int k = 0; k < CONTROLLER_BANK_MAX_CHANNELS; k++){
+		ConfigPIDControllerBankChannel(me, k, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 10);
+		me->error[k] = 0.0;
+		me->output[k] = 0.0;
+	}
+}
+
+
+/*
+ * Same computations as ConfigPIDController, plus the divisions done by the run routines.
+ */
+void ConfigPIDControllerBankChannel(PIDControllerBank* me, uint16_t channel, float kp, float ki, float td, float limup, float limlow, float tsample, uint16_t N)
+{
+	if (channel >= CONTROLLER_BANK_MAX_CHANNELS){ return; }
+
+	// Set the controller parameters:
+	me->kp[channel] = kp;
+	me->ki[channel] = ki;
+	me->N[channel] = N;
+	me->limup[channel] = limup;
+	me->limlow[channel] = limlow;
+
+	// Pre-compute the controller parameters offline:
+	me->b[channel] = td /(td + N * tsample);
+	me->ki_over_kp[channel] = ki / kp;
+	me->limup_over_kp[channel] = limup / kp;
+	me->limlow_over_kp[channel] = limlow / kp;
+
+	// Initialize the state quantities:
+	me->e_prev[channel] = 0.0;
+	me->ui_prev[channel] = 0.0;
+	me->ud_prev[channel] = 0.0;
+}
+
+
+/*
+ * Routine to run all channels as PID controllers (Mixed structure), cf. RunPIDController.
+ */
+void RunPIDControllerBank(PIDControllerBank* me)
+{
+	uint16_t lanes = BankLanes(me);
+
+	for (uint16_t k = 0; k < lanes; k += SIMD_WIDTH){
+		vfloat error = VLoad(&me->error[k]);
+		vfloat kp = VLoad(&me->kp[k]);
+		vfloat limup = VLoad(&me->limup[k]);
+		vfloat limlow = VLoad(&me->limlow[k]);
+
+		vfloat ui = VAdd(VLoad(&me->ui_prev[k]), VMul(VLoad(&me->ki[k]), error));
+		vfloat ud = VMul(VLoad(&me->b[k]), VAdd(VLoad(&me->ud_prev[k]), VMul(VLoad(&me->N[k]), VSub(error, VLoad(&me->e_prev[k])))));
+
+		// Compute the output:
+		vfloat u = VMul(kp, VAdd(VAdd(error, ui), ud));
+
+		// Apply the standard Anti-Reset Windup method (lane-wise selection):
+		vmask high = VGreater(u, limup);
+		vmask low = VLess(u, limlow);
+		vfloat ui_high = VSub(VSub(VLoad(&me->limup_over_kp[k]), error), ud);
+		vfloat ui_low = VSub(VSub(VLoad(&me->limlow_over_kp[k]), error), ud);
+
+		VStore(&me->ui_prev[k], VSelect(high, ui_high, VSelect(low, ui_low, ui)));
+		VStore(&me->output[k], VSelect(high, limup, VSelect(low, limlow, u)));
+
+		// Update the other state quantities:
+		VStore(&me->ud_prev[k], ud);
+		VStore(&me->e_prev[k], error);
+	}
+
+	// Reset the integrals when the outputs are inhibited (when the B-Box is blocked), unless a ControlContext does it:
+	if(!me->managed && GetCoreState() != OPERATING){
+		for (uint16_t k = 0; k < lanes; k++){ me->ui_prev[k] = 0.0; }
+	}
+}
+
+
+/*
+ * Routine to run all channels as PI controllers only, cf. RunPIController.
+ */
+void RunPIControllerBank(PIDControllerBank* me)
+{
+	uint16_t lanes = BankLanes(me);
+
+	for (uint16_t k = 0; k < lanes; k += SIMD_WIDTH){
+		vfloat error = VLoad(&me->error[k]);
+		vfloat limup = VLoad(&me->limup[k]);
+		vfloat limlow = VLoad(&me->limlow[k]);
+
+		vfloat ui = VAdd(VLoad(&me->ui_prev[k]), VMul(VLoad(&me->ki_over_kp[k]), error));
+
+		// Compute the output:
+		vfloat u = VMul(VLoad(&me->kp[k]), VAdd(error, ui));
+
+		// Apply the standard Anti-Reset Windup method (lane-wise selection):
+		vmask high = VGreater(u, limup);
+		vmask low = VLess(u, limlow);
+		vfloat ui_high = VSub(VLoad(&me->limup_over_kp[k]), error);
+		vfloat ui_low = VSub(VLoad(&me->limlow_over_kp[k]), error);
+
+		VStore(&me->ui_prev[k], VSelect(high, ui_high, VSelect(low, ui_low, ui)));
+		VStore(&me->output[k], VSelect(high, limup, VSelect(low, limlow, u)));
+	}
+
+	// Reset the integrals when the outputs are inhibited (when the B-Box is blocked), unless a ControlContext does it:
+	if(!me->managed && GetCoreState() != OPERATING){
+		for (uint16_t k = 0; k < lanes; k++){ me->ui_prev[k] = 0.0; }
+	}
+}
@@ -0,0 +1,75 @@
+#ifndef CONTROLLERBANK_H_
+#define CONTROLLERBANK_H_
+
+#include "simd.h"
+
+#include <stdint.h>
+
+#define CONTROLLER_BANK_MAX_CHANNELS 32		// Must be a multiple of the widest SIMD_WIDTH (8)
+
+
+/**
+ * Pseudo-object describing a bank of PID controllers stored as structure-of-arrays
+ * Every channel behaves exactly as a PIDController run with RunPIDController or RunPIController,
+ * but all channels are updated together in one vectorized pass. The divisions of the scalar
+ * routines (ki/kp, limup/kp, limlow/kp) are computed once at configuration.
+ * The inputs are written to error[] and the outputs read from output[], channel by channel.
+ */
+typedef struct{
+	uint16_t channels;																	// Number of configured channels
+	bool managed;																		// Integrals reset by a ControlContext (set by RegisterPIDControllerBank)
+	float error[CONTROLLER_BANK_MAX_CHANNELS] __attribute__((aligned(SIMD_ALIGN)));		// Inputs: setpoint minus measured value
+	float output[CONTROLLER_BANK_MAX_CHANNELS] __attribute__((aligned(SIMD_ALIGN)));	// Outputs: control variables
+	float kp[CONTROLLER_BANK_MAX_CHANNELS] __attribute__((aligned(SIMD_ALIGN)));		// Proportional gains
+	float ki[CONTROLLER_BANK_MAX_CHANNELS] __attribute__((aligned(SIMD_ALIGN)));		// Integral gains (PID structure)
+	float ki_over_kp[CONTROLLER_BANK_MAX_CHANNELS] __attribute__((aligned(SIMD_ALIGN)));	// Integral gains (PI structure)
+	float limup[CONTROLLER_BANK_MAX_CHANNELS] __attribute__((aligned(SIMD_ALIGN)));		// Upper saturation values of the outputs
+	float limlow[CONTROLLER_BANK_MAX_CHANNELS] __attribute__((aligned(SIMD_ALIGN)));	// Lower saturation values of the outputs
+	float limup_over_kp[CONTROLLER_BANK_MAX_CHANNELS] __attribute__((aligned(SIMD_ALIGN)));	// Offline-computed limup/kp
+	float limlow_over_kp[CONTROLLER_BANK_MAX_CHANNELS] __attribute__((aligned(SIMD_ALIGN)));	// Offline-computed limlow/kp
+	float N[CONTROLLER_BANK_MAX_CHANNELS] __attribute__((aligned(SIMD_ALIGN)));			// Filtering parameters of the derivatives
+	float b[CONTROLLER_BANK_MAX_CHANNELS] __attribute__((aligned(SIMD_ALIGN)));			// Offline-computed constants (Ti and Td informations)
+	float ui_prev[CONTROLLER_BANK_MAX_CHANNELS] __attribute__((aligned(SIMD_ALIGN)));	// Previous values of the integral components
+	float ud_prev[CONTROLLER_BANK_MAX_CHANNELS] __attribute__((aligned(SIMD_ALIGN)));	// Previous values of the derivative components
+	float e_prev[CONTROLLER_BANK_MAX_CHANNELS] __attribute__((aligned(SIMD_ALIGN)));	// Previous values of the errors
+} PIDControllerBank;
+
+
+/**
+ * Routine to initialize the bank with a given number of channels. All channels are cleared and
+ * must then be configured individually with ConfigPIDControllerBankChannel().
+ * @param *me		the bank pseudo-object to initialize
+ * @param channels	the number of channels (at most CONTROLLER_BANK_MAX_CHANNELS)
+ * @return void
+ */
+void ConfigPIDControllerBank(PIDControllerBank* me, uint16_t channels);
+
+
+/**
+ * Routine to configure one channel of the bank and pre-compute the necessary constants.
+ * The parameters have the same meaning as in ConfigPIDController().
+ * @param *me		the bank pseudo-object
+ * @param channel	the index of the channel to configure
+ * @param kp		proportional gain
+ * @param ki		integral gain
+ * @param td 		derivative time-constant
+ * @param limup		upper saturation threshold of the output quantity
+ * @param limlow	lower saturation threshold of the output quantity
+ * @param tsample 	sampling (interrupt) time
+ * @param N 		filtering factor of the derivative term (10 is a good typical value)
+ * @return void
+ */
+void ConfigPIDControllerBankChannel(PIDControllerBank* me, uint16_t channel, float kp, float ki, float td, float limup, float limlow, float tsample, uint16_t N);
+
+
+/**
+ * Routines to run all the channels of the bank at once, as RunPIDController, resp. RunPIController
+ * would do channel by channel, the integral reset included: on every call while the core is not OPERATING,
+ * or, once the bank is registered to a ControlContext, on the core state changes (cf. controlcontext.h).
+ * @param *me		the bank pseudo-object, with error[] up to date
+ * @return void		the outputs are written to me->output[]
+ */
+void RunPIDControllerBank(PIDControllerBank* me);
+void RunPIControllerBank(PIDControllerBank* me);
+
+#endif /*CONTROLLERBANK_H_*/
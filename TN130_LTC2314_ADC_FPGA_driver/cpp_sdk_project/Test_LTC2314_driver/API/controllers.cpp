@@ -30,6 +30,7 @@ void ConfigPIDController(PIDController* me, float kp, float ki, float td, float
 	me->e_prev = 0.0;
 	me->ui_prev = 0.0;
 	me->ud_prev = 0.0;
+	me->managed = false;					                                    // Reset by the run routines until registered
 }
 
 
@@ -51,13 +52,14 @@ void ConfigPRController(PRController* me, float kp, float ki, float wres, float
 	me->a2 = me->a1;
 	me->b0 = kt*kt + 2*kt*wdamp + wres*wres;
 	me->b1 = 2*kt*kt - 2*wres*wres;
-	me->b2 = kt*kt + 2*kt*wdamp + wres*wres;
+	me->b2 = kt*kt - 2*kt*wdamp + wres*wres;
 	
 	// Initialize the state quantities:
 	me->ui_prev = 0.0;
 	me->ui_prev2 = 0.0;
 	me->e_prev = 0.0;
 	me->e_prev2 = 0.0;
+	me->managed = false;					                                    // Reset by the run routines until registered
 }
 
 
@@ -106,8 +108,8 @@ float RunPIDController(PIDController* me, float error)
 	me->ud_prev = ud;
 	me->e_prev = error;
 	
-	// Reset the integral when the outputs are inhibited (when the B-Box is blocked):
-	if(GetCoreState() != OPERATING)
+	// Reset the integral when the outputs are inhibited (when the B-Box is blocked), unless a ControlContext does it:
+	if(!me->managed && GetCoreState() != OPERATING)
 		me->ui_prev = 0.0;					                                    // Avoid integrating when core has been disabled
 
 	return u;
@@ -142,8 +144,8 @@ float RunPIController(PIDController* me, float error)
 		me->ui_prev = ui;
 	}
 	
-	// Reset the integral when the outputs are inhibited (when the B-Box is blocked):
-	if(GetCoreState() != OPERATING)
+	// Reset the integral when the outputs are inhibited (when the B-Box is blocked), unless a ControlContext does it:
+	if(!me->managed && GetCoreState() != OPERATING)
 		me->ui_prev = 0.0;					                                    // Avoid integrating when core has been disabled
 
 	return u;
@@ -188,8 +190,8 @@ float RunIController(PIDController* me, float error)
 		me->ui_prev = ui;
 	}
 	
-	// Reset the integral when the outputs are inhibited (when the B-Box is blocked):
-	if(GetCoreState() != OPERATING)
+	// Reset the integral when the outputs are inhibited (when the B-Box is blocked), unless a ControlContext does it:
+	if(!me->managed && GetCoreState() != OPERATING)
 		me->ui_prev = 0.0;					                                    // Avoid integrating when core has been disabled
 
 	return ui;
@@ -215,8 +217,8 @@ float RunPRController(PRController* me, float error)
 	me->e_prev2 = me->e_prev;
 	me->e_prev = error;
 
-	// Reset the integral when the outputs are inhibited (when the B-Box is blocked):
-	if(GetCoreState() != OPERATING){
+	// Reset the integral when the outputs are inhibited (when the B-Box is blocked), unless a ControlContext does it:
+	if(!me->managed && GetCoreState() != OPERATING){
 		me->ui_prev = 0.0;
 		me->ui_prev2 = 0.0;
 	}
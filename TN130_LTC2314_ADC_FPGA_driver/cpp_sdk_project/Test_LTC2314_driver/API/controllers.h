@@ -17,6 +17,7 @@ uint16_t 	N;					// Filtering parameter of the derivative
 	float ui_prev;				// Previous value of the integral component
 	float ud_prev;				// Previous value of the derivative component
 	float e_prev;				// Previous value of the error
+	bool managed;				// Integral reset by a ControlContext (set by RegisterPIDController)
 } PIDController;
 
 
@@ -32,6 +33,7 @@ typedef struct{
 	float a1,a2,b0,b1,b2;		// Internal coefficients (computed offline)
 	float ui_prev,ui_prev2;	// Previous values of the integral parts of the outputs (k-1, resp. k-2 samples)
 	float e_prev,e_prev2;		// Previous values of the error
+	bool managed;				// Integral reset by a ControlContext (set by RegisterPRController)
 } PRController;
 
 
@@ -95,6 +97,8 @@ void ConfigMPPTracker(MPPTracker* me, float ref_step, float ref_init, float limu
 
 /**
  * Routines to run the pseudo-object 'me' depending of its actual nature (PI, PID, etc. controllers)
+ * The integral term is reset on every call while the core is not OPERATING, or, once the controller
+ * is registered to a ControlContext, on the core state changes by the context (cf. controlcontext.h)
  * @param *me		the corresponding PID pseudo-object (parameters and state quantities)
  * @param error		the setpoint value minus the measured value
  * @return			the control variable for the measured quantity (output of the controller)
@@ -107,6 +111,8 @@ float RunPController(PIDController* me, float error);
 
 /**
  * Routines to run the pseudo-object 'me' for PR-like controllers
+ * The integral terms are reset on every call while the core is not OPERATING, or, once the controller
+ * is registered to a ControlContext, on the core state changes by the context (cf. controlcontext.h)
  * @param *me		the corresponding PR pseudo-object (parameters and state quantities)
  * @param error		the setpoint value minus the measured value
  * @return			the control variable for the measured quantity (output of the controller)
@@ -0,0 +1,420 @@
+/*
+ *	@title	Discrete closed-loop controllers with compile-time policies
+ *	@file	controllertemplate.h
+ *
+ *	A Controller is assembled from four compile-time parameters:
+ *	 - the structure:		PStructure, IStructure, PIStructure, PIDStructure or PRStructure
+ *	 - the anti-windup:		NoSaturation, ClampOutput, BackCalculation or ConditionalIntegration
+ *	 - the reset policy:	NeverReset or ResetOnCoreState
+ *	 - the precision:		float or double
+ *
+ *	Each instantiation carries only the gains and the states its structure needs, with the divisions
+ *	of the scalar routines (ki/kp, 1/b0) done once at configuration, and the run routine contains
+ *	no branch on the mode: only the saturation test of the chosen anti-windup remains. Combinations
+ *	that make no sense (limits without saturation, conditional integration of a resonant term, reset
+ *	of a controller that must never be reset) do not compile. Example:
+ *
+ *		typedef Controller<PIStructure, BackCalculation, ResetOnCoreState> CurrentController;
+ *		CurrentController pi_d;
+ *		...
+ *		ConfigController(&pi_d, kp, ki);									// Same gains as ConfigPIDController
+ *		ConfigControllerLimits(&pi_d, 200.0, -200.0);
+ *		RegisterController(&control, &pi_d);								// Reset by the ControlContext
+ *		...
+ *		float u = RunController(&pi_d, id_ref - id);						// In UserInterrupt
+ *
+ *	With BackCalculation, PStructure, IStructure, PIStructure and PIDStructure behave as RunPController,
+ *	RunIController, RunPIController and RunPIDController (same gains, same standard Anti-Reset Windup
+ *	method). RunPRController has no saturation: PRStructure with NoSaturation takes the same gains and is
+ *	numerically equivalent to it, not identical, since its coefficients are divided by b0 at configuration.
+ */
+
+#ifndef CONTROLLERTEMPLATE_H_
+#define CONTROLLERTEMPLATE_H_
+
+#include <stdint.h>
+
+
+/*
+ * Structures. Each one provides:
+ *   Config(me, gains...)		set the gains and precompute the constants
+ *   Clear(me)					zero all the states
+ *   ResetIntegral(me)			zero the integral states only (core state transitions)
+ *   Evaluate(me, e, step)		unsaturated output, the candidate states are kept in 'step'
+ *   Commit(me, step)			accept the candidate states
+ *   Hold(me, step, limit)		back-calculate the integral states so that the output equals 'limit'
+ *   Freeze(me, step)			update all the states but the integral ones
+ */
+
+/**
+ * Proportional controller: u = kp*e
+ */
+template<typename Real>
+struct PStructure{
+	Real kp;								// Proportional gain
+
+	struct Step{};
+
+	template<class C> static inline void Config(C* me, double kp){ me->kp = (Real)kp; }
+	template<class C> static inline void Clear(C*){}
+	template<class C> static inline void ResetIntegral(C*){}
+	template<class C> static inline Real Evaluate(C* me, Real error, Step*){ return me->kp * error; }
+	template<class C> static inline void Commit(C*, const Step*){}
+	template<class C> static inline void Hold(C*, const Step*, Real){}
+	template<class C> static inline void Freeze(C*, const Step*){}
+};
+
+
+/**
+ * Integral controller: u = ui,  ui = ui_prev + ki*e  (ki per sample, as in RunIController)
+ */
+template<typename Real>
+struct IStructure{
+	Real ki;								// Integral gain (per sample)
+	Real ui_prev;							// Previous value of the output
+
+	struct Step{ Real ui; };
+
+	template<class C> static inline void Config(C* me, double ki){ me->ki = (Real)ki; }
+	template<class C> static inline void Clear(C* me){ me->ui_prev = 0; }
+	template<class C> static inline void ResetIntegral(C* me){ me->ui_prev = 0; }
+
+	template<class C> static inline Real Evaluate(C* me, Real error, Step* step)
+	{
+		step->ui = me->ui_prev + me->ki * error;
+		return step->ui;
+	}
+
+	template<class C> static inline void Commit(C* me, const Step* step){ me->ui_prev = step->ui; }
+	template<class C> static inline void Hold(C* me, const Step*, Real limit){ me->ui_prev = limit; }
+	template<class C> static inline void Freeze(C*, const Step*){}
+};
+
+
+/**
+ * PI controller, mixed structure (cf. Longchamp p. 355): u = kp*(e + ui),  ui = ui_prev + ki/kp*e
+ * (ki per sample, as in RunPIController)
+ */
+template<typename Real>
+struct PIStructure{
+	Real kp;								// Proportional gain
+	Real ki_over_kp;						// Offline-computed ki/kp
+	Real ui_prev;							// Previous value of the integral component
+
+	struct Step{ Real error; Real ui; };
+
+	template<class C> static inline void Config(C* me, double kp, double ki)
+	{
+		me->kp = (Real)kp;
+		me->ki_over_kp = (Real)ki / (Real)kp;										// Rounded as in RunPIController
+	}
+
+	template<class C> static inline void Clear(C* me){ me->ui_prev = 0; }
+	template<class C> static inline void ResetIntegral(C* me){ me->ui_prev = 0; }
+
+	template<class C> static inline Real Evaluate(C* me, Real error, Step* step)
+	{
+		step->error = error;
+		step->ui = me->ui_prev + me->ki_over_kp * error;
+		return me->kp * (error + step->ui);
+	}
+
+	template<class C> static inline void Commit(C* me, const Step* step){ me->ui_prev = step->ui; }
+	// Divided by kp as in RunPIController (bit-exact), on saturation only
+	template<class C> static inline void Hold(C* me, const Step* step, Real limit){ me->ui_prev = limit / me->kp - step->error; }
+	template<class C> static inline void Freeze(C*, const Step*){}
+};
+
+
+/**
+ * PID controller, mixed structure (cf. Longchamp p. 355): u = kp*(e + ui + ud),  ui = ui_prev + ki*e,
+ * ud = b*(ud_prev + N*(e - e_prev))  (gains and rounding as in RunPIDController)
+ */
+template<typename Real>
+struct PIDStructure{
+	Real kp;								// Proportional gain
+	Real ki;								// Integral gain (per sample)
+	Real N;									// Derivative filter coefficient
+	Real b;									// Offline-computed td/(td + N*tsample)
+	Real ui_prev;							// Previous value of the integral component
+	Real ud_prev;							// Previous value of the derivative component
+	Real e_prev;							// Previous value of the error
+
+	struct Step{ Real error; Real ui; Real ud; };
+
+	template<class C> static inline void Config(C* me, double kp, double ki, double td, double tsample, double N)
+	{
+		me->kp = (Real)kp;
+		me->ki = (Real)ki;
+		me->N = (Real)N;
+		me->b = (Real)td / ((Real)td + me->N * (Real)tsample);						// Rounded as in ConfigPIDController
+	}
+
+	template<class C> static inline void Clear(C* me){ me->ui_prev = 0; me->ud_prev = 0; me->e_prev = 0; }
+	template<class C> static inline void ResetIntegral(C* me){ me->ui_prev = 0; }
+
+	template<class C> static inline Real Evaluate(C* me, Real error, Step* step)
+	{
+		step->error = error;
+		step->ui = me->ui_prev + me->ki * error;
+		step->ud = me->b * (me->ud_prev + me->N * (error - me->e_prev));
+		return me->kp * (error + step->ui + step->ud);
+	}
+
+	template<class C> static inline void Commit(C* me, const Step* step)
+	{
+		me->ui_prev = step->ui;
+		Freeze(me, step);
+	}
+
+	template<class C> static inline void Hold(C* me, const Step* step, Real limit)
+	{
+		me->ui_prev = limit / me->kp - step->error - step->ud;				// Divided as in RunPIDController (bit-exact)
+		Freeze(me, step);
+	}
+
+	template<class C> static inline void Freeze(C* me, const Step* step)
+	{
+		me->ud_prev = step->ud;
+		me->e_prev = step->error;
+	}
+};
+
+
+/**
+ * Proportional-resonant controller (Tustin discretization as in ConfigPRController), with all the
+ * coefficients divided by b0 at configuration: u = kp*e + ui,
+ * ui = a1*(e_prev - e_prev2) + b1*ui_prev - b2*ui_prev2
+ * There is no Freeze(): a resonant term cannot be stopped without distorting its oscillation, so
+ * ConditionalIntegration does not compile with this structure.
+ */
+template<typename Real>
+struct PRStructure{
+	Real kp;								// Proportional gain
+	Real a1, b1, b2;						// Offline-computed a1/b0, b1/b0, b2/b0 (a2 = a1)
+	Real ui_prev, ui_prev2;					// Previous values of the resonant part (k-1, resp. k-2 samples)
+	Real e_prev, e_prev2;					// Previous values of the error
+
+	struct Step{ Real error; Real ui; };
+
+	template<class C> static inline void Config(C* me, double kp, double ki, double wres, double wdamp, double tsample)
+	{
+		double kt = 2.0/tsample;
+		double b0 = kt*kt + 2*kt*wdamp + wres*wres;
+		me->kp = (Real)kp;
+		me->a1 = (Real)(2*ki*kt*wdamp / b0);
+		me->b1 = (Real)((2*kt*kt - 2*wres*wres) / b0);
+		me->b2 = (Real)((kt*kt - 2*kt*wdamp + wres*wres) / b0);
+	}
+
+	template<class C> static inline void Clear(C* me){ me->ui_prev = 0; me->ui_prev2 = 0; me->e_prev = 0; me->e_prev2 = 0; }
+	template<class C> static inline void ResetIntegral(C* me){ me->ui_prev = 0; me->ui_prev2 = 0; }
+
+	template<class C> static inline Real Evaluate(C* me, Real error, Step* step)
+	{
+		step->error = error;
+		step->ui = me->a1 * (me->e_prev - me->e_prev2) + me->b1 * me->ui_prev - me->b2 * me->ui_prev2;
+		return me->kp * error + step->ui;
+	}
+
+	template<class C> static inline void Commit(C* me, const Step* step){ Shift(me, step->error, step->ui); }
+	template<class C> static inline void Hold(C* me, const Step* step, Real limit){ Shift(me, step->error, limit - me->kp * step->error); }
+
+	template<class C> static inline void Shift(C* me, Real error, Real ui)
+	{
+		me->ui_prev2 = me->ui_prev;
+		me->ui_prev = ui;
+		me->e_prev2 = me->e_prev;
+		me->e_prev = error;
+	}
+};
+
+
+/*
+ * Anti-windup strategies. Each one provides Limit(me, u, step), which saturates the candidate output
+ * and updates the states accordingly. The limited ones hold the saturation thresholds.
+ */
+
+/**
+ * No saturation at all (the controller carries no limits)
+ */
+template<typename Real>
+struct NoSaturation{
+	template<class C> static inline Real Limit(C* me, Real u, const typename C::Step* step)
+	{
+		C::Commit(me, step);
+		return u;
+	}
+};
+
+
+/**
+ * Output saturation only, the integral states keep integrating (windup is left to the caller)
+ */
+template<typename Real>
+struct ClampOutput{
+	Real limup;								// Upper saturation value of the output
+	Real limlow;							// Lower saturation value of the output
+
+	template<class C> static inline void ConfigLimits(C* me, double limup, double limlow){ me->limup = (Real)limup; me->limlow = (Real)limlow; }
+
+	template<class C> static inline Real Limit(C* me, Real u, const typename C::Step* step)
+	{
+		C::Commit(me, step);
+		if (u > me->limup)		{ return me->limup; }
+		else if (u < me->limlow){ return me->limlow; }
+		else					{ return u; }
+	}
+};
+
+
+/**
+ * Standard Anti-Reset Windup method of RunPIDController: when saturated, the integral states are
+ * recomputed so that the unsaturated output would equal the limit
+ */
+template<typename Real>
+struct BackCalculation{
+	Real limup;								// Upper saturation value of the output
+	Real limlow;							// Lower saturation value of the output
+
+	template<class C> static inline void ConfigLimits(C* me, double limup, double limlow){ me->limup = (Real)limup; me->limlow = (Real)limlow; }
+
+	template<class C> static inline Real Limit(C* me, Real u, const typename C::Step* step)
+	{
+		if (u > me->limup){
+			C::Hold(me, step, me->limup);
+			return me->limup;
+		}
+		else if (u < me->limlow){
+			C::Hold(me, step, me->limlow);
+			return me->limlow;
+		}
+		C::Commit(me, step);
+		return u;
+	}
+};
+
+
+/**
+ * Conditional integration (clamping): the integral states stop while the output is saturated
+ */
+template<typename Real>
+struct ConditionalIntegration{
+	Real limup;								// Upper saturation value of the output
+	Real limlow;							// Lower saturation value of the output
+
+	template<class C> static inline void ConfigLimits(C* me, double limup, double limlow){ me->limup = (Real)limup; me->limlow = (Real)limlow; }
+
+	template<class C> static inline Real Limit(C* me, Real u, const typename C::Step* step)
+	{
+		if (u > me->limup){
+			C::Freeze(me, step);
+			return me->limup;
+		}
+		else if (u < me->limlow){
+			C::Freeze(me, step);
+			return me->limlow;
+		}
+		C::Commit(me, step);
+		return u;
+	}
+};
+
+
+/*
+ * Reset policies
+ */
+
+/**
+ * The integral states are only cleared by the configuration (e.g. the loop filter of a PLL, which
+ * must keep tracking the grid whatever the core state)
+ */
+struct NeverReset{
+	template<class C> static void ResetHook(void*)
+	{
+		static_assert(sizeof(C) == 0, "this controller is declared with NeverReset");
+	}
+};
+
+
+/**
+ * The integral states are cleared by ResetController(), typically called by a ControlContext on
+ * every transition of the core state from or to OPERATING (cf. RegisterController)
+ */
+struct ResetOnCoreState{
+	template<class C> static void ResetHook(void* ctrl)
+	{
+		C::ResetIntegral((C*)ctrl);
+	}
+};
+
+
+/**
+ * Pseudo-object describing a controller, assembled from its policies
+ */
+template<template<typename> class Structure, template<typename> class AntiWindup = BackCalculation, class Reset = NeverReset, typename Real = float>
+struct Controller : Structure<Real>, AntiWindup<Real>{
+	typedef Real RealType;
+	typedef Reset ResetPolicy;
+};
+
+
+/**
+ * Routine to configure the controller 'me', pre-compute the necessary constants and clear the states
+ * @param *me		the controller pseudo-object
+ * @param gains		PStructure: kp
+ *					IStructure: ki (per sample)
+ *					PIStructure: kp, ki (per sample, as ConfigPIDController for RunPIController)
+ *					PIDStructure: kp, ki, td, tsample, N (as ConfigPIDController)
+ *					PRStructure: kp, ki, wres, wdamp, tsample (as ConfigPRController)
+ * @return void
+ */
+template<template<typename> class S, template<typename> class A, class R, typename Real, typename... Gains>
+static inline void ConfigController(Controller<S, A, R, Real>* me, Gains... gains)
+{
+	S<Real>::Config(me, gains...);
+	S<Real>::Clear(me);
+}
+
+
+/**
+ * Routine to set the saturation thresholds (not available with NoSaturation)
+ * @param *me		the controller pseudo-object
+ * @param limup		upper saturation threshold of the output quantity
+ * @param limlow	lower saturation threshold of the output quantity
+ * @return void
+ */
+template<template<typename> class S, template<typename> class A, class R, typename Real>
+static inline void ConfigControllerLimits(Controller<S, A, R, Real>* me, double limup, double limlow)
+{
+	A<Real>::ConfigLimits(me, limup, limlow);
+}
+
+
+/**
+ * Routine to run the controller
+ * @param *me		the controller pseudo-object
+ * @param error		setpoint minus measured value
+ * @return			the control variable
+ */
+template<template<typename> class S, template<typename> class A, class R, typename Real>
+static inline Real RunController(Controller<S, A, R, Real>* me, typename Controller<S, A, R, Real>::RealType error)
+{
+	typename S<Real>::Step step;
+	Real u = S<Real>::Evaluate(me, error, &step);
+	return A<Real>::Limit(me, u, &step);
+}
+
+
+/**
+ * Routine to clear the integral states (not available with NeverReset)
+ * @param *me		the controller pseudo-object
+ * @return void
+ */
+template<template<typename> class S, template<typename> class A, class R, typename Real>
+static inline void ResetController(Controller<S, A, R, Real>* me)
+{
+	R::template ResetHook<Controller<S, A, R, Real>>(me);
+}
+
+#endif /* CONTROLLERTEMPLATE_H_ */
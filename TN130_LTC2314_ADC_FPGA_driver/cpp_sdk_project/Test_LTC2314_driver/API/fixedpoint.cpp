@@ -0,0 +1,218 @@
+/*
+ *	@title	Fixed-point (integer) variants of the transformations, controllers and SOGI
+ *	@file	fixedpoint.cpp
+ */
+
+
+#include "fixedpoint.h"						                                    // Corresponding header file
+#include "sincos.h"							                                    // ConstexprSin()
+
+#define Q15_ONE_THIRD			10923											// 1/3 in Q15
+#define Q15_ONE_OVER_SQRT_3		18919											// 1/sqrt(3) in Q15
+#define Q15_SINE_TABLE_BITS		10												// 1024 intervals per period
+
+
+/*
+ * One period of the sine in Q15, sampled at 2^Q15_SINE_TABLE_BITS + 1 points (generated at compile time).
+ * With the linear interpolation, the error stays below one Q15 LSB.
+ */
+template<int N>
+struct SineTableQ15{
+	int16_t value[N+1];
+
+	constexpr SineTableQ15() : value()
+	{
+		for (int i = 0; i <= N; i++){
+			double x = 6.283185307179586 * i / N;
+			double s = ConstexprSin(x > 3.141592653589793 ? x - 6.283185307179586 : x) * 32768.0;
+			s += (s < 0 ? -0.5 : 0.5);
+			value[i] = (int16_t)(s > 32767 ? 32767 : (s < -32768 ? -32768 : s));
+		}
+	}
+};
+
+static constexpr SineTableQ15<(1 << Q15_SINE_TABLE_BITS)> sine_table_q15{};
+
+
+static inline int16_t SinQ15(uint16_t theta)
+{
+	uint32_t i = theta >> (16 - Q15_SINE_TABLE_BITS);
+	int32_t frac = theta & ((1 << (16 - Q15_SINE_TABLE_BITS)) - 1);
+	int32_t s0 = sine_table_q15.value[i];
+	int32_t s1 = sine_table_q15.value[i+1];
+	return (int16_t)(s0 + (((s1 - s0) * frac + (1 << (15 - Q15_SINE_TABLE_BITS))) >> (16 - Q15_SINE_TABLE_BITS)));
+}
+
+
+void UpdatePhaseAngleQ15(PhaseAngleQ15* me, uint16_t theta)
+{
+	me->theta = theta;
+	me->sinTheta = SinQ15(theta);
+	me->cosTheta = SinQ15((uint16_t)(theta + 16384));						        // cos(x) = sin(x + PI/2)
+}
+
+
+void abc2ABG(SpaceVectorQ15 *fixed, const TimeDomainQ15 *physical)
+{
+	int32_t alpha = 2*physical->A - physical->B - physical->C;
+	int32_t beta = physical->B - physical->C;
+	int32_t gamma = physical->A + physical->B + physical->C;
+
+	fixed->real = SaturateQ15((Q15_ONE_THIRD * alpha + (1 << 14)) >> 15);		// Alpha
+	fixed->imaginary = SaturateQ15((Q15_ONE_OVER_SQRT_3 * beta + (1 << 14)) >> 15);	// Beta
+	fixed->offset = SaturateQ15((Q15_ONE_THIRD * gamma + (1 << 14)) >> 15);		// Gamma
+}
+
+
+void ABG2DQ0(SpaceVectorQ15 *rotating, const SpaceVectorQ15 *fixed, const PhaseAngleQ15 *angle)
+{
+	int64_t d = (int64_t)angle->cosTheta * fixed->real + (int64_t)angle->sinTheta * fixed->imaginary;
+	int64_t q = -(int64_t)angle->sinTheta * fixed->real + (int64_t)angle->cosTheta * fixed->imaginary;
+
+	rotating->real = SaturateQ15((int32_t)((d + (1 << 14)) >> 15));
+	rotating->imaginary = SaturateQ15((int32_t)((q + (1 << 14)) >> 15));
+	rotating->offset = fixed->offset;
+}
+
+
+void abc2DQ0(SpaceVectorQ15 *rotating, const TimeDomainQ15 *physical, const PhaseAngleQ15 *angle)
+{
+	SpaceVectorQ15 fixed;
+	abc2ABG(&fixed, physical);
+	ABG2DQ0(rotating, &fixed, angle);
+}
+
+
+/*
+ * Routine to configure the fixed-point PI controller. The anti-windup thresholds are kept in the
+ * state format so that the comparison happens before any rounding to Q15.
+ */
+void ConfigPIControllerQ15(PIControllerQ15* me, float kp, float ki, float limup, float limlow)
+{
+	me->kp = FloatToFixed(kp, 16);
+	me->ki = FloatToFixed(ki, 31);
+	me->limup = FloatToFixed(limup, 27);
+	me->limlow = FloatToFixed(limlow, 27);
+
+	me->i_prev = 0;
+}
+
+
+/*
+ * Routine to configure the fixed-point PR controller. The coefficients are computed in double
+ * precision as in ConfigPRController, then divided by b0 so that no division is left at run time.
+ */
+void ConfigPRControllerQ15(PRControllerQ15* me, float kp, float ki, float wres, float wdamp, float tsample)
+{
+	double kt = 2.0/tsample;
+	double a1 = 2*ki*kt*wdamp;
+	double b0 = kt*kt + 2*kt*wdamp + (double)wres*wres;
+	double b1 = 2*kt*kt - 2.0*wres*wres;
+	double b2 = kt*kt - 2*kt*wdamp + (double)wres*wres;
+
+	me->kp = FloatToFixed(kp, 16);
+	me->a1 = FloatToFixed(a1/b0, 29);
+	me->a2 = me->a1;
+	me->b1 = FloatToFixed(b1/b0, 29);
+	me->b2 = FloatToFixed(b2/b0, 29);
+
+	me->ui_prev = 0;
+	me->ui_prev2 = 0;
+	me->e_prev = 0;
+	me->e_prev2 = 0;
+}
+
+
+void ConfigSOGI3Q15(SOGI3ParametersQ15* me, float gain, float omega0, float tsample)
+{
+	me->gain = FloatToFixed(gain, 29);
+	me->constant_omega = FloatToFixed(tsample/12.0 * omega0, 31);				// The constant parameter should be Ts/12
+
+	for (int i = 0; i < 2; i++){
+		me->states[i].z1 = 0;
+		me->states[i].z2 = 0;
+		me->states[i].z3 = 0;
+		me->states[i].output = 0;
+	}
+}
+
+
+/*
+ * Same mixed structure and anti-reset windup as RunPIController, with i = kp * ui:
+ *   u = kp*e + i,   i = i_prev + ki*e,   i_prev = lim - kp*e when saturated
+ */
+int16_t RunPIControllerQ15(PIControllerQ15* me, int16_t error)
+{
+	int32_t up = SaturateQ31(((int64_t)me->kp * error) >> 4);					// Q16 * Q15 >> 4 = Q27
+	int32_t ui = SaturateQ31((int64_t)me->i_prev + (((int64_t)me->ki * error) >> 19));			// Q31 * Q15 >> 19 = Q27
+	int32_t u = SaturateQ31((int64_t)up + ui);
+
+	// Apply the standard Anti-Reset Windup method:
+	if (u > me->limup){
+		me->i_prev = SaturateQ31((int64_t)me->limup - up);
+		u = me->limup;
+	}
+	else if (u < me->limlow){
+		me->i_prev = SaturateQ31((int64_t)me->limlow - up);
+		u = me->limlow;
+	}
+	else{
+		me->i_prev = ui;
+	}
+
+	return Q27ToQ15(u);
+}
+
+
+int16_t RunPRControllerQ15(PRControllerQ15* me, int16_t error)
+{
+	// First half of the integral term (Q29 * Q15 = Q44, >> 17 = Q27):
+	int64_t ua = ((int64_t)me->a1 * me->e_prev - (int64_t)me->a2 * me->e_prev2) >> 17;
+
+	// Second half (Q29 * Q27 = Q56, >> 29 = Q27), already divided by b0:
+	int32_t ui = SaturateQ31(ua + (((int64_t)me->b1 * me->ui_prev - (int64_t)me->b2 * me->ui_prev2) >> 29));
+
+	// Update the delayed samples:
+	me->ui_prev2 = me->ui_prev;
+	me->ui_prev = ui;
+	me->e_prev2 = me->e_prev;
+	me->e_prev = error;
+
+	// Return the sum of the integral terms and the proportional gain:
+	return Q27ToQ15(SaturateQ31((((int64_t)me->kp * error) >> 4) + ui));
+}
+
+
+SpaceVectorQ15 RunSOGI3Q15(SOGI3ParametersQ15 *me, int16_t measurement)
+{
+	SOGI3StatesQ15* s0 = &me->states[0];
+	SOGI3StatesQ15* s1 = &me->states[1];
+
+	// Update the states for the first block (step z):
+	s0->z3 = s0->z2;
+	s0->z2 = s0->z1;
+
+	// Compute the value of the first state of the first block (Q29 * Q27 >> 29, then Q31 * Q27 >> 31):
+	int64_t input = ((int64_t)me->gain * ((((int64_t)measurement) << 12) - s0->output)) >> 29;
+	int64_t dz = ((int64_t)me->constant_omega * SaturateQ31(input - s1->output)) >> 31;
+	s0->z1 = SaturateQ31(s0->z1 + dz);
+
+	// Update the values of the states for the second block (step z):
+	s1->z3 = s1->z2;
+	s1->z2 = s1->z1;
+
+	// Compute the value of the first state of the second block:
+	s1->z1 = SaturateQ31(s1->z1 + (((int64_t)me->constant_omega * s0->output) >> 31));
+
+	// Update the output:
+	s0->output = SaturateQ31(23*(int64_t)s0->z1 - 16*(int64_t)s0->z2 + 5*(int64_t)s0->z3);
+	s1->output = SaturateQ31(23*(int64_t)s1->z1 - 16*(int64_t)s1->z2 + 5*(int64_t)s1->z3);
+
+	// Prepare the return:
+	SpaceVectorQ15 myreturn;
+	myreturn.real = Q27ToQ15(s0->output);
+	myreturn.imaginary = Q27ToQ15(s1->output);
+	myreturn.offset = 0;
+
+	return myreturn;
+}
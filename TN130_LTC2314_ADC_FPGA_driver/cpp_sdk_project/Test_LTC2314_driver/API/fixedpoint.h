@@ -0,0 +1,220 @@
+/*
+ *	@title	Fixed-point (integer) variants of the transformations, controllers and SOGI
+ *	@file	fixedpoint.h
+ *
+ *	Number formats (all signals are normalized to the full scale, 1.0 = full scale):
+ *	 - Q15	int16_t, signals, limits and trigonometric values, range [-1, 1)
+ *	 - Q27	int32_t, internal states and accumulators, range [-16, 16) with 2^-27 resolution
+ *	 - Q29	int32_t, filter coefficients, range [-4, 4)
+ *	 - Q31	int32_t, small coefficients (|c| < 1), e.g. omega*Ts or the per-sample integral gain
+ *	 - Q16	int32_t, controller gains, range [-32768, 32768) with 2^-16 resolution
+ *	 - binary angle: uint16_t, 0..65535 <-> [0, 2*PI), wraps naturally
+ *	All the arithmetic saturates instead of wrapping around. The configuration routines take the same
+ *	(float) parameters as their floating-point counterparts and convert them offline.
+ *
+ *	Largest deviation of the outputs from the floating-point routines on the same Q15 inputs, measured
+ *	by host/check/fixedpoint_check (which asserts the bounds in brackets):
+ *	 - RunPIControllerQ15: 0.85 LSB [1], into both saturations
+ *	 - RunSOGI3Q15: 0.75 LSB [1]
+ *	 - RunPRControllerQ15: 2.7 LSB [3] on a resonant output of 0.21 full scale, against the difference
+ *	   equation of RunPRController in double precision: near wres, the rounding of the Q27 states is
+ *	   amplified by the resonant poles. The float routine itself is ~20 LSB off that reference there
+ *	   (its coefficients, ~kt^2, are rounded to float), hence the PR coefficients are converted from
+ *	   double to Q29 without any float rounding (b1/b0 ~ 2 and b2/b0 ~ 1 need all the bits)
+ */
+
+#ifndef FIXEDPOINT_H_
+#define FIXEDPOINT_H_
+
+#include <stdint.h>
+
+
+// Three-phase quantity in complex form (ABG or DQ0 reference frames), Q15
+typedef struct{
+	int16_t real;
+	int16_t imaginary;
+	int16_t offset;
+} SpaceVectorQ15;
+
+
+// Three-phase quantity in time domain, Q15
+typedef struct{
+	int16_t A;
+	int16_t B;
+	int16_t C;
+} TimeDomainQ15;
+
+
+// Phase angle with its precomputed trigonometric values, Q15
+typedef struct{
+	uint16_t theta;				// Binary angle
+	int16_t cosTheta;
+	int16_t sinTheta;
+} PhaseAngleQ15;
+
+
+/**
+ * Pseudo-object describing a PI controller in fixed point. The integral state is kept in output
+ * units (kp * ui of the floating-point version), which gives the same outputs and the same
+ * anti-windup as RunPIController, with a bounded state.
+ */
+typedef struct{
+	int32_t kp;					// Proportional gain, Q16
+	int32_t ki;					// Integral gain (per sample, as in RunPIDController, |ki| < 1), Q31
+	int32_t limup;				// Upper saturation value of the output, Q27
+	int32_t limlow;				// Lower saturation value of the output, Q27
+	int32_t i_prev;				// Previous value of the integral component (output units), Q27
+} PIControllerQ15;
+
+
+/**
+ * Pseudo-object describing a PR controller in fixed point (cf. PRController), with the
+ * coefficients already divided by b0
+ */
+typedef struct{
+	int32_t kp;					// Proportional gain, Q16
+	int32_t a1,a2,b1,b2;		// Internal coefficients divided by b0, Q29
+	int32_t ui_prev,ui_prev2;	// Previous values of the integral part of the output, Q27
+	int16_t e_prev,e_prev2;		// Previous values of the error, Q15
+} PRControllerQ15;
+
+
+/**
+ * SOGI based on the triple integrator in fixed point (cf. SOGI3Parameters)
+ */
+typedef struct{
+	int32_t z1;					// Q27
+	int32_t z2;					// Q27
+	int32_t z3;					// Q27
+	int32_t output;				// Q27
+} SOGI3StatesQ15;
+
+typedef struct{
+	SOGI3StatesQ15 states[2];
+	int32_t gain;				// Q29
+	int32_t constant_omega;		// Ts/12 * omega, Q31
+} SOGI3ParametersQ15;
+
+
+/**
+ * Saturating conversions between the formats
+ */
+static inline int16_t SaturateQ15(int32_t x)
+{
+	return x > 32767 ? 32767 : (x < -32768 ? -32768 : (int16_t)x);
+}
+
+static inline int32_t SaturateQ31(int64_t x)
+{
+	return x > INT32_MAX ? INT32_MAX : (x < INT32_MIN ? INT32_MIN : (int32_t)x);
+}
+
+static inline int16_t Q27ToQ15(int32_t x)
+{
+	return SaturateQ15((int32_t)(((int64_t)x + (1 << 11)) >> 12));			// Rounded
+}
+
+static inline int32_t FloatToFixed(double x, int fractional_bits)
+{
+	return SaturateQ31((int64_t)(x * (double)(1LL << fractional_bits) + (x < 0 ? -0.5 : 0.5)));
+}
+
+static inline int16_t FloatToQ15(float x)
+{
+	return SaturateQ15(FloatToFixed(x, 15));
+}
+
+static inline float Q15ToFloat(int16_t x)
+{
+	return x * (1.0f / 32768);
+}
+
+
+/**
+ * Routine to bring an ADC code into the Q15 domain
+ * @param code			the raw ADC code (e.g. 14-bit LTC2314 code from Sbi_Read)
+ * @param offset		the code corresponding to zero (e.g. 8192 for a bipolar mid-scale front-end)
+ * @param shift			16 minus the ADC width (e.g. 2 for 14 bits)
+ * @return				the sample in Q15, full scale = full ADC range
+ */
+static inline int16_t AdcCodeToQ15(uint16_t code, uint16_t offset, uint8_t shift)
+{
+	return SaturateQ15(((int32_t)code - offset) << shift);
+}
+
+
+/**
+ * Routine to convert an angle in rad. into a binary angle
+ * @param theta			the angle in rad.
+ * @return				the binary angle
+ */
+static inline uint16_t AngleToBinary(float theta)
+{
+	return (uint16_t)(int32_t)(theta * (65536.0f / 6.28318531f));
+}
+
+
+/**
+ * Routine to compute the Q15 cosine and sine of a binary angle (integer table, interpolated)
+ * @param *me			the phase angle pseudo-object that will be updated
+ * @param theta			binary angle
+ * @return void
+ */
+void UpdatePhaseAngleQ15(PhaseAngleQ15* me, uint16_t theta);
+
+
+/**
+ * Fixed-point counterparts of abc2ABG, ABG2DQ0 and abc2DQ0 (cf. transformations.h)
+ */
+void abc2ABG(SpaceVectorQ15 *fixed, const TimeDomainQ15 *physical);
+void ABG2DQ0(SpaceVectorQ15 *rotating, const SpaceVectorQ15 *fixed, const PhaseAngleQ15 *angle);
+void abc2DQ0(SpaceVectorQ15 *rotating, const TimeDomainQ15 *physical, const PhaseAngleQ15 *angle);
+
+
+/**
+ * Routine to configure the fixed-point PI controller (parameters as for ConfigPIDController)
+ * @param *me		the PI pseudo-object to be configured
+ * @param kp		proportional gain
+ * @param ki		integral gain (per sample, |ki| < 1)
+ * @param limup		upper saturation threshold of the output quantity (full-scale units, < 1)
+ * @param limlow	lower saturation threshold of the output quantity (full-scale units, >= -1)
+ * @return void
+ */
+void ConfigPIControllerQ15(PIControllerQ15* me, float kp, float ki, float limup, float limlow);
+
+
+/**
+ * Routine to configure the fixed-point PR controller (parameters as for ConfigPRController)
+ * @param *me		the PR pseudo-object to be configured
+ * @param kp		proportional gain
+ * @param ki		integral gain
+ * @param wres		center resonant frequency of the resonant term (in rad/s.)
+ * @param wdamp		frequency "width" of the resonant term (in rad/s.)
+ * @param tsample 	sampling (interrupt) time
+ * @return void
+ */
+void ConfigPRControllerQ15(PRControllerQ15* me, float kp, float ki, float wres, float wdamp, float tsample);
+
+
+/**
+ * Routine to configure the fixed-point SOGI (parameters as for ConfigSOGI3)
+ * @param *me  		the SOGI pseudo-object
+ * @param gain 		the gain value of the SOGI module
+ * @param omega0	the expected angle speed of the input signal (feedforward)
+ * @param tsample	the sampling time
+ * @return void
+ */
+void ConfigSOGI3Q15(SOGI3ParametersQ15* me, float gain, float omega0, float tsample);
+
+
+/**
+ * Fixed-point counterparts of RunPIController, RunPRController and RunSOGI3
+ * @param *me		the corresponding pseudo-object (parameters and state quantities)
+ * @param error		the setpoint value minus the measured value, Q15 (resp. the measurement for the SOGI)
+ * @return			the output of the controller, Q15 (resp. the alpha-beta space vector for the SOGI)
+ */
+int16_t RunPIControllerQ15(PIControllerQ15* me, int16_t error);
+int16_t RunPRControllerQ15(PRControllerQ15* me, int16_t error);
+SpaceVectorQ15 RunSOGI3Q15(SOGI3ParametersQ15 *me, int16_t measurement);
+
+#endif /* FIXEDPOINT_H_ */
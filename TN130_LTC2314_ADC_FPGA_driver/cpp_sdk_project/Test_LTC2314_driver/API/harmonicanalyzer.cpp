@@ -0,0 +1,171 @@
+/*
+ *	@title	Harmonic analyzer locked to a PLL (phase-domain DFT, vectorized)
+ *	@file	harmonicanalyzer.cpp
+ */
+
+
+#include "harmonicanalyzer.h"				                                    // Corresponding header file
+#include <cmath>							                                    // Standard math library
+
+#define PI 3.141592654
+#define TWOPI 6.283185307
+
+
+int ConfigHarmonicAnalyzer(HarmonicAnalyzer* me, const uint16_t* orders, uint16_t bins, float tsample)
+{
+	if (bins == 0 || bins > HARMONIC_MAX_BINS){ return -1; }
+	for (uint16_t k = 0; k < bins; k++){
+		if (orders[k] > HARMONIC_MAX_ORDER){ return -1; }
+	}
+
+	me->bins = bins;
+	me->lanes = (bins + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+	me->max_order = 0;
+	me->locked = false;
+	me->tsample = tsample;
+	me->theta = 0.0;
+	me->samples = 0.0;
+
+	// Padding lanes: order 0 with a zero weight, they stay at zero:
+	for (uint16_t k = 0; k < HARMONIC_MAX_BINS; k++){
+		me->order[k] = k < bins ? orders[k] : 0;
+		if (me->order[k] > me->max_order){ me->max_order = me->order[k]; }
+		me->re[k] = 0.0;
+		me->im[k] = 0.0;
+		me->cosk[k] = k < bins ? 1.0f : 0.0f;
+		me->sink[k] = 0.0;
+		me->last_re[k] = 0.0;
+		me->last_im[k] = 0.0;
+	}
+
+	me->sequence.store(0, std::memory_order_relaxed);
+	me->periods = 0;
+	me->last_samples = 0.0;
+	return 0;
+}
+
+
+/*
+ * Adds weight*sample*exp(-j k theta) to the sums of every lane
+ */
+static inline void Accumulate(HarmonicAnalyzer* me, float weight)
+{
+	vfloat w = VSet(weight);
+	for (uint16_t k = 0; k < me->lanes; k += SIMD_WIDTH){
+		VStore(&me->re[k], VAdd(VLoad(&me->re[k]), VMul(w, VLoad(&me->cosk[k]))));
+		VStore(&me->im[k], VSub(VLoad(&me->im[k]), VMul(w, VLoad(&me->sink[k]))));
+	}
+}
+
+
+/*
+ * d(theta) is the advance of the angle since the previous sample (the angle runs forward, a step
+ * below -PI is a wrap). The weights are the angle advances, so the sums are rectangle-rule integrals
+ * over theta, exact for the harmonics of a uniformly sampled period.
+ */
+void RunHarmonicAnalyzer(HarmonicAnalyzer* me, float sample, const PhaseAngle* angle)
+{
+	// exp(j k theta) for k = 0..max_order by successive rotations, then one per lane:
+	float cosk[HARMONIC_MAX_ORDER + 1];
+	float sink[HARMONIC_MAX_ORDER + 1];
+	cosk[0] = 1.0f;
+	sink[0] = 0.0f;
+	for (uint16_t k = 1; k <= me->max_order; k++){
+		cosk[k] = cosk[k-1] * angle->cosTheta - sink[k-1] * angle->sinTheta;
+		sink[k] = sink[k-1] * angle->cosTheta + cosk[k-1] * angle->sinTheta;
+	}
+	for (uint16_t k = 0; k < me->bins; k++){
+		me->cosk[k] = cosk[me->order[k]];
+		me->sink[k] = sink[me->order[k]];
+	}
+
+	float previous = me->theta;
+	float step = angle->theta - previous;
+	me->theta = angle->theta;
+
+	if (step >= -(float)PI){
+		Accumulate(me, sample * step);
+		me->samples += 1.0f;
+		return;
+	}
+
+	// Wrap: the part of the step up to +PI closes the period, the rest opens the next one
+	// (the first period is incomplete, it is dropped):
+	step += (float)TWOPI;
+	float before = ((float)PI - previous) / step;
+	if (before < 0.0f){ before = 0.0f; }
+	else if (before > 1.0f){ before = 1.0f; }
+	Accumulate(me, sample * step * before);
+
+	if (me->locked){
+		uint32_t sequence = me->sequence.load(std::memory_order_relaxed);
+		me->sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		for (uint16_t k = 0; k < me->bins; k++){
+			me->last_re[k] = me->re[k];
+			me->last_im[k] = me->im[k];
+		}
+		me->last_samples = me->samples + before;
+		me->periods++;
+
+		me->sequence.store(sequence + 2, std::memory_order_release);
+	}
+	me->locked = true;
+
+	for (uint16_t k = 0; k < me->lanes; k++){
+		me->re[k] = 0.0;
+		me->im[k] = 0.0;
+	}
+	Accumulate(me, sample * step * (1.0f - before));
+	me->samples = 1.0f - before;
+}
+
+
+/*
+ * X_k = (re + j im)/PI is the complex amplitude of the harmonic k: x = |X_k| cos(k theta + arg X_k).
+ * For k = 0, re/PI is twice the mean value.
+ */
+uint32_t GetHarmonicAnalysis(const HarmonicAnalyzer* me, HarmonicAnalysis* analysis)
+{
+	// Copy of the last period, retried if the interrupt latched a new one meanwhile:
+	float re[HARMONIC_MAX_BINS];
+	float im[HARMONIC_MAX_BINS];
+	uint32_t before, after, periods;
+	float samples;
+	do{
+		before = me->sequence.load(std::memory_order_acquire);
+		for (uint16_t k = 0; k < me->bins; k++){
+			re[k] = me->last_re[k];
+			im[k] = me->last_im[k];
+		}
+		periods = me->periods;
+		samples = me->last_samples;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		after = me->sequence.load(std::memory_order_relaxed);
+	} while ((before & 1) || before != after);
+
+	analysis->periods = periods;
+	analysis->samples = samples;
+	analysis->frequency = samples > 0.0f ? 1.0f / (samples * me->tsample) : 0.0f;
+	analysis->bins = me->bins;
+
+	float fundamental = 0.0;
+	float distortion = 0.0;
+	for (uint16_t k = 0; k < me->bins; k++){
+		analysis->order[k] = me->order[k];
+		if (me->order[k] == 0){
+			analysis->magnitude[k] = re[k] / (float)TWOPI;
+			analysis->phase[k] = 0.0;
+			continue;
+		}
+		float magnitude = sqrtf(re[k]*re[k] + im[k]*im[k]) / (float)PI;
+		analysis->magnitude[k] = magnitude;
+		analysis->phase[k] = atan2f(im[k], re[k]);
+		if (me->order[k] == 1){ fundamental = magnitude; }
+		else{ distortion += magnitude * magnitude; }
+	}
+	analysis->thd = fundamental > 0.0f ? sqrtf(distortion) / fundamental : 0.0f;
+
+	return periods;
+}
@@ -0,0 +1,124 @@
+/*
+ *	@title	Harmonic analyzer locked to a PLL, updated sample by sample
+ *	@file	harmonicanalyzer.h
+ *
+ *	Magnitudes and phases of selected harmonics of a measured signal, and its THD, without any FFT
+ *	burst: every interrupt adds one sample to a DFT of the current fundamental period, at a constant
+ *	cost proportional to the number of harmonics. The samples are taken as they are converted:
+ *
+ *		ConfigHarmonicAnalyzer(&analyzer, orders, 6, tsample);					// In UserInit
+ *		...
+ *		ReadSensors(sensors, sensor_raw, sensor_value);							// In UserInterrupt
+ *		RunHarmonicAnalyzer(&analyzer, sensor_value[0], &pll.angle);			// Before RunDQPLL(&pll, ...)
+ *		...
+ *		GetHarmonicAnalysis(&analyzer, &analysis);								// In the background loop
+ *
+ *	The window is locked to the PLL rather than to a number of samples: the DFT is computed in the
+ *	phase domain, X_k = 1/pi * integral over one turn of theta of x * exp(-j k theta) d(theta), with
+ *	theta the angle of the PLL (DQPLL, SOGIPLL, DSOGIPLL3) and d(theta) its advance between two
+ *	samples. A turn is closed when theta wraps around; the sample straddling the wrap is split between
+ *	the two periods in proportion of the angle on each side, so the window covers exactly one period
+ *	of the estimated fundamental even when it is not a whole number of samples (e.g. 404.04 at 49.5 Hz
+ *	and 20 kHz), and follows its variations without recomputing any coefficient. The spectral leakage
+ *	of a fixed window of N samples (about 1/N of the fundamental on every bin, i.e. a THD floor of
+ *	0.1 %) is avoided: between 49 and 62 Hz at 20 kHz, the error on the orders up to 13 stays below
+ *	1e-4 of the fundamental (the rectangle rule loses accuracy on the highest orders, about 5 % on
+ *	the 49th).
+ *
+ *	The result is updated once per fundamental period (non-overlapping windows) rather than on every
+ *	sample as with a sliding DFT: the latter would have to store one period of products per harmonic,
+ *	its window could not follow the frequency, and its running sums drift in single precision.
+ *	The exp(-j k theta) are obtained from the cosine and sine of the PLL angle by successive rotations,
+ *	without any trigonometric call; the sums of all the harmonics are updated in one vectorized pass.
+ *	The interrupt only latches the sums at the end of a period; the magnitudes, phases and THD are
+ *	computed in the background by GetHarmonicAnalysis (consistent snapshot, never blocking the
+ *	interrupt, as for the profiler).
+ */
+
+#ifndef HARMONICANALYZER_H_
+#define HARMONICANALYZER_H_
+
+#include "simd.h"
+#include "transformations.h"				// PhaseAngle
+
+#include <atomic>
+#include <stdint.h>
+
+#define HARMONIC_MAX_BINS		32			// Must be a multiple of the widest SIMD_WIDTH (8)
+#define HARMONIC_MAX_ORDER		50
+
+
+/**
+ * Pseudo-object describing the analyzer of one signal. The sums of the period in progress are
+ * stored as structure-of-arrays (one lane per harmonic), the sums of the last complete period are
+ * latched under a sequence counter.
+ */
+typedef struct{
+	uint16_t bins;
+	uint16_t lanes;																	// bins, rounded up to SIMD_WIDTH
+	uint16_t max_order;
+	bool locked;																	// A wrap of theta was seen: the period in progress is complete
+	float tsample;
+	float theta;																	// Angle of the previous sample
+	float samples;																	// Samples in the period in progress (fractional)
+	uint16_t order[HARMONIC_MAX_BINS];												// Harmonic order of each lane (0 for the mean value)
+	float re[HARMONIC_MAX_BINS] __attribute__((aligned(SIMD_ALIGN)));				// Sums of x*cos(k theta)*d(theta)
+	float im[HARMONIC_MAX_BINS] __attribute__((aligned(SIMD_ALIGN)));				// Sums of -x*sin(k theta)*d(theta)
+	float cosk[HARMONIC_MAX_BINS] __attribute__((aligned(SIMD_ALIGN)));				// cos(k theta) of the current sample, per lane
+	float sink[HARMONIC_MAX_BINS] __attribute__((aligned(SIMD_ALIGN)));				// sin(k theta), idem
+
+	std::atomic<uint32_t> sequence;													// Odd while the interrupt latches a period
+	uint32_t periods;																// Complete periods analyzed
+	float last_samples;																// Length of the last period, in samples
+	float last_re[HARMONIC_MAX_BINS];												// Sums of the last complete period
+	float last_im[HARMONIC_MAX_BINS];
+} HarmonicAnalyzer;
+
+
+/**
+ * Spectrum of the last complete period, as computed by GetHarmonicAnalysis
+ */
+typedef struct{
+	uint32_t periods;																// Complete periods analyzed since the configuration
+	float frequency;																// Fundamental frequency over the last period, in Hz
+	float samples;																	// Length of the last period, in samples
+	uint16_t bins;
+	uint16_t order[HARMONIC_MAX_BINS];
+	float magnitude[HARMONIC_MAX_BINS];												// Peak value of each harmonic (mean value for order 0)
+	float phase[HARMONIC_MAX_BINS];													// Phase relative to k*theta, in rad.
+	float thd;																		// sqrt(sum of the squared magnitudes of orders >= 2) / fundamental
+} HarmonicAnalysis;
+
+
+/**
+ * Routine to initialize the analyzer (the first period starts at the first wrap of the angle)
+ * @param *me		the analyzer pseudo-object
+ * @param *orders	the harmonic orders to analyze (e.g. {1, 3, 5, 7, 11, 13}), at most HARMONIC_MAX_ORDER;
+ *					the THD is computed over the listed orders above 1, relative to order 1
+ * @param bins		the number of orders (at most HARMONIC_MAX_BINS)
+ * @param tsample	the sampling (interrupt) time
+ * @return			0 on success, -1 if there are too many orders or an order is too high
+ */
+int ConfigHarmonicAnalyzer(HarmonicAnalyzer* me, const uint16_t* orders, uint16_t bins, float tsample);
+
+
+/**
+ * Routine to add one sample, to be called on every interrupt
+ * @param *me		the analyzer pseudo-object
+ * @param sample	the measured value (e.g. from ReadSensors)
+ * @param *angle	the PLL angle of this sample: pll.angle before the run routine of the PLL, as for the transformations
+ * @return void
+ */
+void RunHarmonicAnalyzer(HarmonicAnalyzer* me, float sample, const PhaseAngle* angle);
+
+
+/**
+ * Routine to compute the spectrum of the last complete period.
+ * Must be called from the non-interrupt context only.
+ * @param *me		the analyzer pseudo-object
+ * @param *analysis	the spectrum (all zero before the first complete period)
+ * @return			the number of periods analyzed (the spectrum is new if it changed since the last call)
+ */
+uint32_t GetHarmonicAnalysis(const HarmonicAnalyzer* me, HarmonicAnalysis* analysis);
+
+#endif /*HARMONICANALYZER_H_*/
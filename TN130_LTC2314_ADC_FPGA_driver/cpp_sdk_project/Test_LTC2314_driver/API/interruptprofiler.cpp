@@ -0,0 +1,131 @@
+/*
+ *	@title	Interrupt budget profiler: per-stage cycle histograms, worst case and percentiles
+ *	@file	interruptprofiler.cpp
+ */
+
+#include "interruptprofiler.h"
+
+#include <string.h>
+
+
+/*
+ * Counts per second of ReadCycleCounter(): CPU clock on the target, measured against
+ * clock_gettime() for rdtsc on the host
+ */
+double ConfigCycleCounter(void)
+{
+#if defined(__arm__)
+	uint32_t pmcr;
+	__asm__ volatile("mrc p15, 0, %0, c9, c12, 0" : "=r"(pmcr));
+	pmcr = (pmcr | 0x1 | 0x4) & ~0x8u;											// Enable, reset the cycle counter, no /64 divider
+	__asm__ volatile("mcr p15, 0, %0, c9, c12, 0" :: "r"(pmcr));
+	__asm__ volatile("mcr p15, 0, %0, c9, c12, 1" :: "r"(0x80000000u));		// PMCNTENSET: cycle counter
+	return PROFILER_ARM_CPU_HZ;
+#elif defined(__x86_64__) || defined(__i386__)
+	struct timespec t0, t1;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	uint64_t c0 = __rdtsc();
+	do{ clock_gettime(CLOCK_MONOTONIC, &t1); }
+	while ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec) < 20e6);	// 20 ms
+	uint64_t c1 = __rdtsc();
+	return (c1 - c0) / ((t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9);
+#else
+	return 1e9;
+#endif
+}
+
+
+/*
+ * Smallest duration falling into a bucket (inverse of the mapping of RecordProfileStage)
+ */
+static uint32_t BucketLowerBound(uint32_t bucket)
+{
+	if (bucket < (2u << PROFILER_SUB_BITS)){ return bucket; }
+	uint32_t msb = (bucket >> PROFILER_SUB_BITS) + PROFILER_SUB_BITS - 1;
+	uint32_t mantissa = (1u << PROFILER_SUB_BITS) + (bucket & ((1u << PROFILER_SUB_BITS) - 1));
+	return mantissa << (msb - PROFILER_SUB_BITS);
+}
+
+static uint32_t BucketUpperBound(uint32_t bucket)
+{
+	return bucket + 1 < PROFILER_BUCKETS ? BucketLowerBound(bucket + 1) - 1 : UINT32_MAX;
+}
+
+
+static void ClearStage(ProfileStage* s)
+{
+	s->count = 0;
+	s->min = UINT32_MAX;
+	s->max = 0;
+	s->sum = 0;
+	memset(s->histogram, 0, sizeof(s->histogram));
+}
+
+
+void ConfigInterruptProfiler(InterruptProfiler* me, const char* const* names, uint8_t stages, double period)
+{
+	me->stages = stages < PROFILER_MAX_STAGES ? stages : PROFILER_MAX_STAGES;
+	me->counter_hz = ConfigCycleCounter();
+	me->period_counts = period * me->counter_hz;
+	for (int k = 0; k < me->stages; k++){
+		me->name[k] = names[k];
+		me->stage[k].sequence.store(0, std::memory_order_relaxed);
+		ClearStage(&me->stage[k]);
+	}
+}
+
+
+void GetProfileStats(const InterruptProfiler* me, uint8_t stage, ProfileStats* stats)
+{
+	// Copy of the stage, retried if an interrupt updated it meanwhile:
+	static ProfileStage copy;
+	const ProfileStage* s = &me->stage[stage];
+	uint32_t before, after;
+	do{
+		before = s->sequence.load(std::memory_order_acquire);
+		copy.count = s->count;
+		copy.min = s->min;
+		copy.max = s->max;
+		copy.sum = s->sum;
+		memcpy(copy.histogram, s->histogram, sizeof(copy.histogram));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		after = s->sequence.load(std::memory_order_relaxed);
+	} while ((before & 1) || before != after);
+
+	stats->name = me->name[stage];
+	stats->count = copy.count;
+	stats->min = copy.count ? copy.min : 0;
+	stats->max = copy.max;
+	stats->mean = copy.count ? (double)copy.sum / copy.count : 0.0;
+	stats->max_seconds = copy.max / me->counter_hz;
+	stats->max_budget = copy.max / me->period_counts;
+
+	// Percentiles and overruns from the histogram:
+	const double fraction[4] = {0.5, 0.9, 0.99, 0.999};
+	uint32_t* percentile[4] = {&stats->p50, &stats->p90, &stats->p99, &stats->p999};
+	uint64_t cumulated = 0;
+	int next = 0;
+	stats->overruns = 0;
+	for (uint32_t b = 0; b < PROFILER_BUCKETS; b++){
+		cumulated += copy.histogram[b];
+		while (next < 4 && copy.count > 0 && cumulated >= fraction[next] * copy.count){
+			uint32_t bound = BucketUpperBound(b);
+			*percentile[next++] = bound < copy.max ? bound : copy.max;
+		}
+		if (BucketLowerBound(b) > me->period_counts){ stats->overruns += copy.histogram[b]; }
+	}
+	while (next < 4){ *percentile[next++] = 0; }
+}
+
+
+void ResetInterruptProfiler(InterruptProfiler* me)
+{
+	for (int k = 0; k < me->stages; k++){
+		ProfileStage* s = &me->stage[k];
+		uint32_t sequence = s->sequence.load(std::memory_order_relaxed);
+		s->sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		ClearStage(s);
+		s->sequence.store(sequence + 2, std::memory_order_release);
+	}
+}
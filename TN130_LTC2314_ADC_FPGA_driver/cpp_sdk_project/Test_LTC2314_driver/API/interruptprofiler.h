@@ -0,0 +1,192 @@
+/*
+ *	@title	Interrupt budget profiler: per-stage cycle histograms, worst case and percentiles
+ *	@file	interruptprofiler.h
+ *
+ *	Scoped markers time the stages of UserInterrupt with the CPU cycle counter and record every
+ *	duration into a fixed histogram per stage, in the interrupt, in a few tens of cycles:
+ *
+ *		ProfileScope total(&profiler, STAGE_TOTAL);						// Whole interrupt
+ *		{
+ *			ProfileScope scope(&profiler, STAGE_SENSORS);				// Until the end of the block
+ *			ReadSensors(sensors, raw, value);
+ *		}
+ *
+ *	The background loop takes consistent snapshots (count, mean, min, max, percentiles, share of the
+ *	interrupt period) without ever blocking the interrupt: every stage is protected by a sequence
+ *	counter and the reader retries when the interrupt updated the stage meanwhile.
+ *
+ *	The histogram buckets are log-linear: exact below 16 cycles, then 8 buckets per power of two, so
+ *	the percentiles are within 12.5 % (rounded up) from a few cycles to 2^32 cycles with 240 buckets;
+ *	the worst case is exact. Cycle counter:
+ *	 - target (ARM): the Cortex-A9 PMU cycle counter (PMCCNTR), enabled by ConfigInterruptProfiler
+ *	 - host x86: rdtsc, host others: clock_gettime (1 count = 1 ns)
+ *	so the same markers work in the host simulations, with the host timings.
+ *	Defining INTERRUPT_PROFILER_DISABLED (e.g. -DINTERRUPT_PROFILER_DISABLED) compiles the markers out.
+ */
+
+#ifndef INTERRUPTPROFILER_H_
+#define INTERRUPTPROFILER_H_
+
+#include <atomic>
+#include <stdint.h>
+
+#if !defined(__arm__)
+#include <time.h>														// Host: clock_gettime()
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>													// Host: __rdtsc()
+#endif
+#endif
+
+#define PROFILER_MAX_STAGES		8
+#define PROFILER_SUB_BITS		3											// 2^3 buckets per power of two
+#define PROFILER_BUCKETS		((32 - PROFILER_SUB_BITS + 1) << PROFILER_SUB_BITS)
+#define PROFILER_ARM_CPU_HZ		666666667.0									// Zynq-7000 CPU clock of the B-Box
+
+
+/**
+ * Routine to read the cycle counter
+ * @return			the current count (wraps around)
+ */
+static inline uint32_t ReadCycleCounter(void)
+{
+#if defined(__arm__)
+	uint32_t cycles;
+	__asm__ volatile("mrc p15, 0, %0, c9, c13, 0" : "=r"(cycles));			// PMCCNTR
+	return cycles;
+#elif defined(__x86_64__) || defined(__i386__)
+	return (uint32_t)__rdtsc();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec);
+#endif
+}
+
+
+/**
+ * Routine to enable the cycle counter on the target and to get its frequency (done by
+ * ConfigInterruptProfiler, for the other users of ReadCycleCounter)
+ * @return			the counts per second of ReadCycleCounter() (measured over 20 ms with rdtsc)
+ */
+double ConfigCycleCounter(void);
+
+
+/**
+ * Statistics of one stage, updated by the interrupt
+ */
+typedef struct{
+	std::atomic<uint32_t> sequence;			// Odd while the interrupt updates the stage
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t sum;
+	uint32_t histogram[PROFILER_BUCKETS];
+} ProfileStage;
+
+
+/**
+ * Pseudo-object describing the profiler
+ */
+typedef struct{
+	uint8_t stages;
+	const char* name[PROFILER_MAX_STAGES];
+	double counter_hz;						// Counts per second of ReadCycleCounter()
+	double period_counts;					// Interrupt period in counts
+	ProfileStage stage[PROFILER_MAX_STAGES];
+} InterruptProfiler;
+
+
+/**
+ * Snapshot of one stage, for the background loop (durations in counts and in seconds)
+ */
+typedef struct{
+	const char* name;
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	double mean;
+	uint32_t p50, p90, p99, p999;			// Percentiles, upper bound of their bucket
+	double max_seconds;
+	double max_budget;						// Worst case as a fraction of the interrupt period
+	uint32_t overruns;						// Durations longer than the interrupt period
+} ProfileStats;
+
+
+/**
+ * Routine to configure the profiler (and to enable the cycle counter on the target)
+ * @param *me			the profiler pseudo-object
+ * @param *names		the names of the stages
+ * @param stages		the number of stages (at most PROFILER_MAX_STAGES)
+ * @param period		the interrupt period in s (e.g. 1/20e3)
+ * @return void
+ */
+void ConfigInterruptProfiler(InterruptProfiler* me, const char* const* names, uint8_t stages, double period);
+
+
+/**
+ * Routine to record one duration (interrupt side, normally through ProfileScope)
+ * @param *me			the profiler pseudo-object
+ * @param stage			the stage
+ * @param counts		the duration in counts of ReadCycleCounter()
+ * @return void
+ */
+static inline void RecordProfileStage(InterruptProfiler* me, uint8_t stage, uint32_t counts)
+{
+	ProfileStage* s = &me->stage[stage];
+	uint32_t sequence = s->sequence.load(std::memory_order_relaxed);
+	s->sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	uint32_t bucket = counts;
+	if (counts >= (2u << PROFILER_SUB_BITS)){
+		uint32_t msb = 31 - __builtin_clz(counts);
+		bucket = ((msb - PROFILER_SUB_BITS + 1) << PROFILER_SUB_BITS) + ((counts >> (msb - PROFILER_SUB_BITS)) & ((1u << PROFILER_SUB_BITS) - 1));
+	}
+	s->histogram[bucket]++;
+	s->count++;
+	s->sum += counts;
+	if (counts > s->max){ s->max = counts; }
+	if (counts < s->min){ s->min = counts; }
+
+	s->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+
+/**
+ * Scoped marker: times its own lifetime and records it into a stage
+ */
+#ifndef INTERRUPT_PROFILER_DISABLED
+struct ProfileScope{
+	InterruptProfiler* profiler;
+	uint8_t stage;
+	uint32_t start;
+
+	ProfileScope(InterruptProfiler* p, uint8_t s) : profiler(p), stage(s), start(ReadCycleCounter()) {}
+	~ProfileScope(){ RecordProfileStage(profiler, stage, ReadCycleCounter() - start); }
+};
+#else
+struct ProfileScope{
+	ProfileScope(InterruptProfiler*, uint8_t) {}
+};
+#endif
+
+
+/**
+ * Routine to take a consistent snapshot of one stage (background loop only)
+ * @param *me			the profiler pseudo-object
+ * @param stage			the stage
+ * @param *stats		the snapshot
+ * @return void
+ */
+void GetProfileStats(const InterruptProfiler* me, uint8_t stage, ProfileStats* stats);
+
+
+/**
+ * Routine to clear the statistics of all the stages (background loop only; a duration recorded
+ * by an interrupt at the same time may be lost)
+ * @param *me			the profiler pseudo-object
+ * @return void
+ */
+void ResetInterruptProfiler(InterruptProfiler* me);
+
+#endif /* INTERRUPTPROFILER_H_ */
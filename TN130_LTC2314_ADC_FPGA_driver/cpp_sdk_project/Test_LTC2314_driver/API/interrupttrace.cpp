@@ -0,0 +1,253 @@
+/*
+ *	@title	Record and replay of the inputs and outputs of the main interrupt
+ *	@file	interrupttrace.cpp
+ */
+
+#include "interrupttrace.h"
+#include "Driver/peripherals.h"
+
+#define TRACE_HEADER_SIZE		8
+#define TRACE_STATE_MASK		0x03
+#define TRACE_MAX_RECORD		(1 + 4 + (TRACE_MAX_INPUTS/8) + 2*TRACE_MAX_INPUTS + (TRACE_MAX_OUTPUTS/8) + 4*TRACE_MAX_OUTPUTS)
+
+
+static inline void Put16(uint8_t* p, uint16_t x)
+{
+	p[0] = (uint8_t)x;
+	p[1] = (uint8_t)(x >> 8);
+}
+
+static inline void Put32(uint8_t* p, uint32_t x)
+{
+	Put16(p, (uint16_t)x);
+	Put16(p + 2, (uint16_t)(x >> 16));
+}
+
+static inline uint16_t Get16(const uint8_t* p)
+{
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t Get32(const uint8_t* p)
+{
+	return Get16(p) | ((uint32_t)Get16(p + 2) << 16);
+}
+
+// Core state in the trace, independent of the values of tCoreState (any other state is traced as FAULT)
+static inline uint8_t EncodeCoreState(tCoreState state)
+{
+	switch (state){
+	case BLOCKED:	return 0;
+	case OPERATING:	return 1;
+	default:		return 2;
+	}
+}
+
+static inline tCoreState DecodeCoreState(uint8_t code)
+{
+	static const tCoreState states[TRACE_STATE_MASK + 1] = {BLOCKED, OPERATING, FAULT, FAULT};
+	return states[code & TRACE_STATE_MASK];
+}
+
+
+void ConfigInterruptRecorder(InterruptRecorder* me, uint8_t* buffer, uint32_t size)
+{
+	me->buffer = buffer;
+	me->size = size;
+	me->length = 0;
+	me->records = 0;
+	me->overflow = false;
+	me->enabled = true;
+	me->inputs = 0;
+	me->outputs = 0;
+	me->next_tick = 0;
+	me->pending = false;
+}
+
+
+bool AddRecorderInput(InterruptRecorder* me, uint16_t address)
+{
+	if (me->inputs >= TRACE_MAX_INPUTS || me->length > 0){ return false; }
+	me->address[me->inputs] = address;
+	me->input[me->inputs] = 0;
+	me->inputs++;
+	return true;
+}
+
+
+bool AddRecorderOutputBits(InterruptRecorder* me, const char* name, const void* variable, tTraceOutputType type)
+{
+	if (me->outputs >= TRACE_MAX_OUTPUTS || me->length > 0){ return false; }
+	me->name[me->outputs] = name;
+	me->variable[me->outputs] = (const uint32_t*)variable;
+	me->type[me->outputs] = (uint8_t)type;
+	me->output[me->outputs] = 0;
+	me->outputs++;
+	return true;
+}
+
+
+static void WriteHeader(InterruptRecorder* me)
+{
+	uint8_t* p = me->buffer;
+	p[0] = 'U'; p[1] = 'I'; p[2] = 'T'; p[3] = 'R';
+	p[4] = TRACE_VERSION;
+	p[5] = me->inputs;
+	p[6] = me->outputs;
+	p[7] = 0;
+	p += TRACE_HEADER_SIZE;
+	for (int k = 0; k < me->inputs; k++, p += 2){ Put16(p, me->address[k]); }
+	for (int k = 0; k < me->outputs; k++, p++){ *p = me->type[k]; }
+	me->length = (uint32_t)(p - me->buffer);
+}
+
+
+/*
+ * Size of the change mask of 'count' values (one bit per value)
+ */
+static inline uint32_t MaskBytes(int count)
+{
+	return (count + 7) / 8;
+}
+
+
+void RecordInterruptInputs(InterruptRecorder* me, uint32_t tick)
+{
+	me->pending = false;
+	if (!me->enabled){ return; }
+
+	if (me->length == 0){
+		if (me->size < TRACE_HEADER_SIZE + 3u*TRACE_MAX_INPUTS + TRACE_MAX_OUTPUTS){ me->overflow = true; me->enabled = false; return; }
+		WriteHeader(me);
+	}
+	if (me->size - me->length < TRACE_MAX_RECORD){								// Room for the worst-case record
+		me->overflow = true;
+		me->enabled = false;
+		return;
+	}
+
+	me->record_start = me->length;
+	uint8_t* flags = me->buffer + me->length;
+	uint8_t* p = flags + 1;
+	*flags = EncodeCoreState(GetCoreState());
+	if (tick != me->next_tick){
+		*flags |= TRACE_TICK_JUMP;
+		Put32(p, tick);
+		p += 4;
+	}
+	me->next_tick = tick + 1;
+
+	uint8_t* mask = p;
+	p += MaskBytes(me->inputs);
+	for (uint32_t b = 0; b < MaskBytes(me->inputs); b++){ mask[b] = 0; }
+	for (int k = 0; k < me->inputs; k++){
+		uint16_t value = (uint16_t)Sbi_Read(me->address[k]);
+		if (value != me->input[k]){
+			mask[k >> 3] |= (uint8_t)(1 << (k & 7));
+			Put16(p, value);
+			p += 2;
+			me->input[k] = value;
+		}
+	}
+
+	me->length = (uint32_t)(p - me->buffer);
+	me->records++;
+	me->pending = true;
+}
+
+
+void RecordInterruptOutputs(InterruptRecorder* me)
+{
+	if (!me->pending){ return; }
+	me->pending = false;
+
+	uint8_t* p = me->buffer + me->length;
+	uint8_t* mask = p;
+	p += MaskBytes(me->outputs);
+	for (uint32_t b = 0; b < MaskBytes(me->outputs); b++){ mask[b] = 0; }
+	for (int k = 0; k < me->outputs; k++){
+		uint32_t value = *me->variable[k];
+		if (value != me->output[k]){
+			mask[k >> 3] |= (uint8_t)(1 << (k & 7));
+			Put32(p, value);
+			p += 4;
+			me->output[k] = value;
+		}
+	}
+
+	me->buffer[me->record_start] |= TRACE_OUTPUTS;
+	me->length = (uint32_t)(p - me->buffer);
+}
+
+
+bool ConfigTraceReader(TraceReader* me, const uint8_t* data, uint32_t size)
+{
+	me->data = data;
+	me->size = size;
+	me->position = 0;
+	if (size < TRACE_HEADER_SIZE || data[0] != 'U' || data[1] != 'I' || data[2] != 'T' || data[3] != 'R'){ return false; }
+	if (data[4] != TRACE_VERSION || data[5] > TRACE_MAX_INPUTS || data[6] > TRACE_MAX_OUTPUTS){ return false; }
+
+	me->inputs = data[5];
+	me->outputs = data[6];
+	uint32_t position = TRACE_HEADER_SIZE;
+	if (size < position + 2u*me->inputs + me->outputs){ return false; }
+	for (int k = 0; k < me->inputs; k++, position += 2){ me->address[k] = Get16(data + position); }
+	for (int k = 0; k < me->outputs; k++, position++){ me->type[k] = data[position]; }
+	me->position = position;
+
+	me->last.tick = (uint32_t)-1;												// The first tick expected is 0
+	me->last.state = BLOCKED;
+	me->last.has_outputs = false;
+	for (int k = 0; k < TRACE_MAX_INPUTS; k++){ me->last.input[k] = 0; }
+	for (int k = 0; k < TRACE_MAX_OUTPUTS; k++){ me->last.output[k] = 0; }
+	return true;
+}
+
+
+bool ReadTraceRecord(TraceReader* me, TraceRecord* record)
+{
+	const uint8_t* p = me->data + me->position;
+	const uint8_t* end = me->data + me->size;
+	if (p >= end){ return false; }
+
+	uint8_t flags = *p++;
+	TraceRecord r = me->last;
+	r.state = DecodeCoreState(flags);
+	r.has_outputs = (flags & TRACE_OUTPUTS) != 0;
+	r.tick = me->last.tick + 1;
+	if (flags & TRACE_TICK_JUMP){
+		if (end - p < 4){ return false; }
+		r.tick = Get32(p);
+		p += 4;
+	}
+
+	if ((uint32_t)(end - p) < MaskBytes(me->inputs)){ return false; }
+	const uint8_t* mask = p;
+	p += MaskBytes(me->inputs);
+	for (int k = 0; k < me->inputs; k++){
+		if (mask[k >> 3] & (1 << (k & 7))){
+			if (end - p < 2){ return false; }
+			r.input[k] = Get16(p);
+			p += 2;
+		}
+	}
+
+	if (r.has_outputs){
+		if ((uint32_t)(end - p) < MaskBytes(me->outputs)){ return false; }
+		mask = p;
+		p += MaskBytes(me->outputs);
+		for (int k = 0; k < me->outputs; k++){
+			if (mask[k >> 3] & (1 << (k & 7))){
+				if (end - p < 4){ return false; }
+				r.output[k] = Get32(p);
+				p += 4;
+			}
+		}
+	}
+
+	me->position = (uint32_t)(p - me->data);
+	me->last = r;
+	*record = r;
+	return true;
+}
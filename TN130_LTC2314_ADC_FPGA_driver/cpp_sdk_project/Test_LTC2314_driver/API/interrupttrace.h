@@ -0,0 +1,174 @@
+/*
+ *	@title	Record and replay of the inputs and outputs of the main interrupt
+ *	@file	interrupttrace.h
+ *
+ *	The recorder logs, at every interrupt, everything UserInterrupt depends on (the registered SBI
+ *	registers, the core state and the interrupt tick) and, optionally, the values it produced (the
+ *	registered output variables), into a compact binary trace in RAM. A host replayer feeds the
+ *	inputs back through the same user code and compares the outputs bit by bit. Usage:
+ *
+ *		ConfigInterruptRecorder(&recorder, trace_buffer, sizeof(trace_buffer));		// In UserInit
+ *		AddRecorderInput(&recorder, 0);												// Every SBI register read
+ *		AddRecorderOutput(&recorder, "Vmeas", &Vmeas);
+ *		...
+ *		RecordInterruptInputs(&recorder, tick);										// First line of UserInterrupt
+ *		...
+ *		RecordInterruptOutputs(&recorder);											// Last line of UserInterrupt
+ *
+ *	The SBI registers are sampled once, at the beginning of the interrupt: this is what the user code
+ *	sees as long as they are configured as real-time (latched) registers.
+ *
+ *	Trace format (little endian, byte aligned):
+ *	 - header: "UITR", version, number of inputs, number of outputs, 0, then the 16-bit address of
+ *	   every input and the type (tTraceOutputType) of every output
+ *	 - one record per interrupt: a flag byte (core state in bits 0-1: 0 BLOCKED, 1 OPERATING, 2 FAULT,
+ *	   whatever the values of tCoreState in the SDK; TRACE_TICK_JUMP, TRACE_OUTPUTS),
+ *	   the 32-bit tick if it does not follow the previous one, a bit mask of the inputs that changed
+ *	   followed by their new 16-bit values, then (TRACE_OUTPUTS) the same for the 32-bit outputs
+ *	A constant input costs no byte, so a record usually takes a few bytes. When the buffer is full
+ *	the recording stops at a record boundary (the trace stays valid, 'overflow' is set).
+ */
+
+#ifndef INTERRUPTTRACE_H_
+#define INTERRUPTTRACE_H_
+
+#include "Core/core.h"
+
+#include <stdint.h>
+#include <type_traits>
+
+#define TRACE_MAX_INPUTS		16
+#define TRACE_MAX_OUTPUTS		16
+#define TRACE_VERSION			1
+#define TRACE_TICK_JUMP			0x04				// Record flag: the tick follows (not previous + 1)
+#define TRACE_OUTPUTS			0x08				// Record flag: the outputs follow
+
+
+/**
+ * Type of a recorded output variable (the value is stored as its 32-bit pattern)
+ */
+typedef enum{
+	TRACE_FLOAT = 0,
+	TRACE_UINT32 = 1,
+	TRACE_INT32 = 2
+} tTraceOutputType;
+
+
+/**
+ * Pseudo-object describing a recorder
+ */
+typedef struct{
+	uint8_t* buffer;
+	uint32_t size;							// Capacity of the buffer in bytes
+	uint32_t length;						// Bytes written (header included)
+	uint32_t records;						// Interrupts recorded
+	bool overflow;							// The buffer got full, recording stopped
+	bool enabled;
+	uint8_t inputs;
+	uint8_t outputs;
+	uint16_t address[TRACE_MAX_INPUTS];
+	uint16_t input[TRACE_MAX_INPUTS];		// Last recorded values (delta reference)
+	uint8_t type[TRACE_MAX_OUTPUTS];
+	const char* name[TRACE_MAX_OUTPUTS];
+	const uint32_t* variable[TRACE_MAX_OUTPUTS];
+	uint32_t output[TRACE_MAX_OUTPUTS];		// Last recorded values (delta reference)
+	uint32_t next_tick;						// Tick expected for the next record
+	uint32_t record_start;					// Offset of the flag byte of the last record
+	bool pending;							// A record has been opened by RecordInterruptInputs
+} InterruptRecorder;
+
+
+/**
+ * One decoded record
+ */
+typedef struct{
+	uint32_t tick;
+	tCoreState state;
+	bool has_outputs;
+	uint16_t input[TRACE_MAX_INPUTS];
+	uint32_t output[TRACE_MAX_OUTPUTS];
+} TraceRecord;
+
+
+/**
+ * Pseudo-object describing a reader of a trace (e.g. mapped from a file by the host replayer)
+ */
+typedef struct{
+	const uint8_t* data;
+	uint32_t size;
+	uint32_t position;
+	uint8_t inputs;
+	uint8_t outputs;
+	uint16_t address[TRACE_MAX_INPUTS];
+	uint8_t type[TRACE_MAX_OUTPUTS];
+	TraceRecord last;						// Delta reference
+} TraceReader;
+
+
+/**
+ * Routine to configure a recorder (register the inputs and outputs before the first record)
+ * @param *me		the recorder pseudo-object
+ * @param *buffer	the trace memory
+ * @param size		its size in bytes
+ * @return void
+ */
+void ConfigInterruptRecorder(InterruptRecorder* me, uint8_t* buffer, uint32_t size);
+
+
+/**
+ * Routines to register an SBI register read by the user code, and a variable it produces
+ * @param *me			the recorder pseudo-object
+ * @param address		the SBI register
+ * @param name			the name of the variable (reports only, not stored in the trace)
+ * @param *variable		the variable, read after every interrupt (any 32-bit type)
+ * @param type			how to interpret its 32 bits
+ * @return				false if the maximum number of inputs (outputs) is reached
+ */
+bool AddRecorderInput(InterruptRecorder* me, uint16_t address);
+bool AddRecorderOutputBits(InterruptRecorder* me, const char* name, const void* variable, tTraceOutputType type);
+
+template<typename T>
+static inline bool AddRecorderOutput(InterruptRecorder* me, const char* name, const T* variable)
+{
+	static_assert(sizeof(T) == 4, "the recorded outputs are 32-bit variables");
+	return AddRecorderOutputBits(me, name, variable,
+			std::is_floating_point<T>::value ? TRACE_FLOAT : (std::is_signed<T>::value ? TRACE_INT32 : TRACE_UINT32));
+}
+
+
+/**
+ * Routine to record the inputs of the interrupt (first call of UserInterrupt)
+ * @param *me		the recorder pseudo-object
+ * @param tick		the interrupt counter
+ * @return void
+ */
+void RecordInterruptInputs(InterruptRecorder* me, uint32_t tick);
+
+
+/**
+ * Routine to record the outputs of the interrupt (last call of UserInterrupt, optional)
+ * @param *me		the recorder pseudo-object
+ * @return void
+ */
+void RecordInterruptOutputs(InterruptRecorder* me);
+
+
+/**
+ * Routine to open a trace
+ * @param *me		the reader pseudo-object
+ * @param *data		the trace
+ * @param size		its size in bytes
+ * @return			false if the header is not valid
+ */
+bool ConfigTraceReader(TraceReader* me, const uint8_t* data, uint32_t size);
+
+
+/**
+ * Routine to decode the next record
+ * @param *me		the reader pseudo-object
+ * @param *record	the decoded record (all the inputs and outputs, not only the changed ones)
+ * @return			false at the end of the trace (or on a truncated record)
+ */
+bool ReadTraceRecord(TraceReader* me, TraceRecord* record);
+
+#endif /* INTERRUPTTRACE_H_ */
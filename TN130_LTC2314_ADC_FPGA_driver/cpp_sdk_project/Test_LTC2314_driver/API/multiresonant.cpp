@@ -0,0 +1,100 @@
+/*
+ *	@title	Multi-resonant controller (structure-of-arrays, vectorized)
+ *	@file	multiresonant.cpp
+ */
+
+
+#include "multiresonant.h"					                                    // Corresponding header file
+
+
+int ConfigMultiResonantController(MultiResonantController* me, uint16_t channels, float kp, const uint16_t* orders, const float* ki, uint16_t terms, float omega0, float wdamp, float tsample)
+{
+	if (channels == 0 || channels > MULTIRESONANT_MAX_CHANNELS || terms * channels > MULTIRESONANT_MAX_LANES){ return -1; }
+
+	me->channels = channels;
+	me->terms = terms;
+	me->lanes = (terms * channels + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+	me->index = 0;
+	me->tsample = tsample;
+	me->wdamp = wdamp;
+
+	for (uint16_t c = 0; c < MULTIRESONANT_MAX_CHANNELS; c++){
+		me->kp[c] = kp;
+		me->error[c] = 0.0;
+		me->output[c] = 0.0;
+	}
+
+	// Padding lanes: zero gain, they stay at zero:
+	for (uint16_t k = 0; k < MULTIRESONANT_MAX_LANES; k++){
+		me->order[k] = k < terms * channels ? orders[k / channels] : 0.0f;
+		me->ki[k] = k < terms * channels ? ki[k / channels] : 0.0f;
+	}
+
+	SetMultiResonantFrequency(me, omega0);
+	ResetMultiResonantController(me);
+	for (uint16_t k = 0; k < MULTIRESONANT_MAX_LANES; k++){
+		me->e[0][k] = 0.0;
+		me->e[1][k] = 0.0;
+	}
+	return 0;
+}
+
+
+/*
+ * Same coefficients as ConfigPRController, computed in double precision and divided by b0.
+ */
+void SetMultiResonantFrequency(MultiResonantController* me, float omega0)
+{
+	double kt = 2.0/me->tsample;
+	double wdamp = me->wdamp;
+
+	for (uint16_t k = 0; k < MULTIRESONANT_MAX_LANES; k++){
+		double wres = me->order[k] * (double)omega0;
+		double b0 = kt*kt + 2*kt*wdamp + wres*wres;
+		me->a1[k] = (float)(2*me->ki[k]*kt*wdamp / b0);
+		me->b1[k] = (float)((2*kt*kt - 2*wres*wres) / b0);
+		me->b2[k] = (float)((kt*kt - 2*kt*wdamp + wres*wres) / b0);
+	}
+}
+
+
+/*
+ * ui = a1*(e_prev - e_prev2) + b1*ui_prev - b2*ui_prev2 on every lane. The k-2 entries are
+ * overwritten by the new samples, which become the k-1 ones when the index flips.
+ */
+void RunMultiResonantController(MultiResonantController* me)
+{
+	uint16_t used = me->terms * me->channels;
+	uint8_t p1 = me->index;
+	uint8_t p2 = p1 ^ 1;
+
+	for (uint16_t k = 0; k < me->lanes; k += SIMD_WIDTH){
+		vfloat e1 = VLoad(&me->e[p1][k]);
+		vfloat ui1 = VLoad(&me->ui[p1][k]);
+		vfloat ua = VMul(VLoad(&me->a1[k]), VSub(e1, VLoad(&me->e[p2][k])));
+		vfloat ui = VSub(VAdd(ua, VMul(VLoad(&me->b1[k]), ui1)), VMul(VLoad(&me->b2[k]), VLoad(&me->ui[p2][k])));
+		VStore(&me->ui[p2][k], ui);
+	}
+
+	// Sum of the resonant terms and proportional gain, and new errors for the next step:
+	for (uint16_t c = 0; c < me->channels; c++){
+		float u = me->kp[c] * me->error[c];
+		for (uint16_t k = c; k < used; k += me->channels){
+			u += me->ui[p2][k];
+			me->e[p2][k] = me->error[c];
+		}
+		me->output[c] = u;
+	}
+
+	me->index = p2;
+}
+
+
+void ResetMultiResonantController(void* ctrl)
+{
+	MultiResonantController* me = (MultiResonantController*)ctrl;
+	for (uint16_t k = 0; k < MULTIRESONANT_MAX_LANES; k++){
+		me->ui[0][k] = 0.0;
+		me->ui[1][k] = 0.0;
+	}
+}
@@ -0,0 +1,84 @@
+#ifndef MULTIRESONANT_H_
+#define MULTIRESONANT_H_
+
+#include "simd.h"
+
+#include <stdint.h>
+
+#define MULTIRESONANT_MAX_LANES		32		// Resonant terms x channels, must be a multiple of the widest SIMD_WIDTH (8)
+#define MULTIRESONANT_MAX_CHANNELS	4
+
+
+/**
+ * Pseudo-object describing a multi-resonant controller: one proportional gain and N resonant terms
+ * (fundamental plus selected harmonics) per channel, e.g. on the alpha and beta axes.
+ *   u = kp*e + sum of the resonant terms (each one as in ConfigPRController, with its own ki and wres)
+ * The resonant terms of all the channels are stored as structure-of-arrays (lane t*channels + c holds
+ * the term t of the channel c) and evaluated together in one vectorized pass. Their coefficients are
+ * divided by b0 at configuration, so the run routine contains no division. The delayed samples are
+ * not shifted: the two histories are swapped by flipping an index.
+ * The integral terms are reset on core state changes by a ControlContext (cf. controlcontext.h).
+ * The inputs are written to error[], the outputs read from output[], channel by channel.
+ */
+typedef struct{
+	uint16_t channels;
+	uint16_t terms;
+	uint16_t lanes;															// terms*channels, rounded up to SIMD_WIDTH
+	uint8_t index;															// History holding the k-1 samples (0 or 1)
+	float tsample;
+	float wdamp;
+	float kp[MULTIRESONANT_MAX_CHANNELS];									// Proportional gains
+	float error[MULTIRESONANT_MAX_CHANNELS];								// Inputs: setpoint minus measured value
+	float output[MULTIRESONANT_MAX_CHANNELS];								// Outputs: control variables
+	float order[MULTIRESONANT_MAX_LANES];									// Harmonic order of each lane
+	float ki[MULTIRESONANT_MAX_LANES];										// Resonant gain of each lane
+	float a1[MULTIRESONANT_MAX_LANES] __attribute__((aligned(SIMD_ALIGN)));	// Offline-computed a1/b0 (a2 = a1)
+	float b1[MULTIRESONANT_MAX_LANES] __attribute__((aligned(SIMD_ALIGN)));	// Offline-computed b1/b0
+	float b2[MULTIRESONANT_MAX_LANES] __attribute__((aligned(SIMD_ALIGN)));	// Offline-computed b2/b0
+	float e[2][MULTIRESONANT_MAX_LANES] __attribute__((aligned(SIMD_ALIGN)));	// Previous errors (k-1 at index, k-2 at 1-index)
+	float ui[2][MULTIRESONANT_MAX_LANES] __attribute__((aligned(SIMD_ALIGN)));	// Previous resonant outputs, idem
+} MultiResonantController;
+
+
+/**
+ * Routine to configure the controller and pre-compute the necessary constants (all the states cleared)
+ * @param *me		the controller pseudo-object
+ * @param channels	the number of channels (at most MULTIRESONANT_MAX_CHANNELS)
+ * @param kp		proportional gain (same for all the channels)
+ * @param *orders	harmonic orders of the resonant terms (e.g. {1, 5, 7, 11, 13})
+ * @param *ki		integral gains of the resonant terms, in the same order
+ * @param terms		number of resonant terms (terms*channels at most MULTIRESONANT_MAX_LANES)
+ * @param omega0	fundamental angular frequency (in rad/s.)
+ * @param wdamp		frequency "width" of every resonant term (in rad/s.), as in ConfigPRController
+ * @param tsample 	sampling (interrupt) time
+ * @return			0 on success, -1 if the controller is too large
+ */
+int ConfigMultiResonantController(MultiResonantController* me, uint16_t channels, float kp, const uint16_t* orders, const float* ki, uint16_t terms, float omega0, float wdamp, float tsample);
+
+
+/**
+ * Routine to move all the resonant frequencies to the harmonics of a new fundamental (e.g. from a
+ * PLL). Recomputes the coefficients with divisions: to be called at a low rate (e.g. in a rate group).
+ * @param *me		the controller pseudo-object
+ * @param omega0	fundamental angular frequency (in rad/s.)
+ * @return void
+ */
+void SetMultiResonantFrequency(MultiResonantController* me, float omega0);
+
+
+/**
+ * Routine to run all the channels
+ * @param *me		the controller pseudo-object, with error[] up to date
+ * @return void		the outputs are written to me->output[]
+ */
+void RunMultiResonantController(MultiResonantController* me);
+
+
+/**
+ * Routine to clear the resonant terms (registered as a reset hook by RegisterMultiResonantController)
+ * @param *me		the controller pseudo-object
+ * @return void
+ */
+void ResetMultiResonantController(void* me);
+
+#endif /*MULTIRESONANT_H_*/
@@ -0,0 +1,207 @@
+/*
+ *	@title	Multi-rate task scheduler run from the main interrupt
+ *	@file	ratescheduler.cpp
+ */
+
+#include "ratescheduler.h"
+
+#include <math.h>
+
+
+static uint32_t Gcd(uint32_t a, uint32_t b)
+{
+	while (b != 0){
+		uint32_t r = a % b;
+		a = b;
+		b = r;
+	}
+	return a;
+}
+
+
+static void ClearGroup(RateGroup* g)
+{
+	g->runs = 0;
+	g->last = 0;
+	g->max = 0;
+	g->sum = 0;
+	g->overruns = 0;
+}
+
+
+void ConfigRateScheduler(RateScheduler* me, double frequency)
+{
+	me->frequency = frequency;
+	me->clock = ReadCycleCounter;
+	me->clock_hz = ConfigCycleCounter();
+	me->tick = 0;
+	me->groups = 0;
+	me->tasks = 0;
+}
+
+
+void SetSchedulerClock(RateScheduler* me, tSchedulerClock clock, double hz)
+{
+	me->clock = clock;
+	me->clock_hz = hz;
+}
+
+
+int AddRateGroup(RateScheduler* me, const char* name, double frequency, double budget)
+{
+	if (me->groups >= SCHEDULER_MAX_GROUPS || frequency <= 0 || frequency > me->frequency){ return -1; }
+
+	double divider = me->frequency / frequency;
+	if (fabs(divider - floor(divider + 0.5)) > 1e-6 * divider){ return -1; }		// Not an integer divisor
+
+	RateGroup* g = &me->group[me->groups];
+	g->sequence.store(0, std::memory_order_relaxed);
+	g->name = name;
+	g->divider = (uint32_t)floor(divider + 0.5);
+	g->budget = (uint32_t)(budget * me->clock_hz);
+	ClearGroup(g);
+	return me->groups++;
+}
+
+
+int AddScheduledTask(RateScheduler* me, int group, const char* name, tScheduledTask run, void* context, float cost)
+{
+	if (group < 0 || group >= me->groups || me->tasks >= SCHEDULER_MAX_TASKS){ return -1; }
+
+	ScheduledTask* t = &me->task[me->tasks];
+	t->name = name;
+	t->run = run;
+	t->context = context;
+	t->group = (uint8_t)group;
+	t->cost = cost;
+	t->divider = me->group[group].divider;
+	t->phase = 0;
+	t->countdown = 1;
+	return me->tasks++;
+}
+
+
+/*
+ * Greedy placement from the fastest task to the slowest. When a task is placed, all the placed
+ * tasks have a shorter or equal period, so the load of any of its ticks is exactly its own cost plus
+ * the costs of the placed tasks with a matching phase (exact for harmonic rates, an upper bound
+ * otherwise).
+ */
+float StartRateScheduler(RateScheduler* me)
+{
+	bool placed[SCHEDULER_MAX_TASKS] = {false};
+	float worst = 0;
+
+	for (uint8_t n = 0; n < me->tasks; n++){
+		// Fastest task not placed yet (the first added one on a tie):
+		int next = -1;
+		for (uint8_t k = 0; k < me->tasks; k++){
+			if (!placed[k] && (next < 0 || me->task[k].divider < me->task[next].divider)){ next = k; }
+		}
+		ScheduledTask* t = &me->task[next];
+
+		float best = 0;
+		for (uint32_t phase = 0; phase < t->divider; phase++){
+			float load = t->cost;
+			for (uint8_t k = 0; k < me->tasks; k++){
+				if (!placed[k]){ continue; }
+				uint32_t g = Gcd(t->divider, me->task[k].divider);
+				if (phase % g == me->task[k].phase % g){ load += me->task[k].cost; }
+			}
+			if (phase == 0 || load < best){
+				best = load;
+				t->phase = phase;
+			}
+		}
+		placed[next] = true;
+		if (best > worst){ worst = best; }
+	}
+
+	for (uint8_t k = 0; k < me->tasks; k++){
+		me->task[k].countdown = me->task[k].phase + 1;							// Runs on the ticks phase, phase + divider, ...
+	}
+	for (uint8_t g = 0; g < me->groups; g++){ ClearGroup(&me->group[g]); }
+	me->tick = 0;
+
+	return worst;
+}
+
+
+void RunRateScheduler(RateScheduler* me)
+{
+	uint32_t spent[SCHEDULER_MAX_GROUPS];
+	uint32_t ran = 0;
+
+	for (uint8_t k = 0; k < me->tasks; k++){
+		ScheduledTask* t = &me->task[k];
+		if (--t->countdown != 0){ continue; }
+		t->countdown = t->divider;
+
+		uint32_t start = me->clock();
+		t->run(t->context);
+		uint32_t duration = me->clock() - start;
+
+		if (ran & (1u << t->group)){ spent[t->group] += duration; }
+		else{
+			spent[t->group] = duration;
+			ran |= 1u << t->group;
+		}
+	}
+	me->tick++;
+
+	// Budget accounting of the groups that ran:
+	for (uint8_t k = 0; ran != 0; k++, ran >>= 1){
+		if (!(ran & 1)){ continue; }
+		RateGroup* g = &me->group[k];
+		uint32_t sequence = g->sequence.load(std::memory_order_relaxed);
+		g->sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		g->runs++;
+		g->last = spent[k];
+		g->sum += spent[k];
+		if (spent[k] > g->max){ g->max = spent[k]; }
+		if (spent[k] > g->budget){ g->overruns++; }
+
+		g->sequence.store(sequence + 2, std::memory_order_release);
+	}
+}
+
+
+float GetScheduledCost(const RateScheduler* me, uint32_t tick)
+{
+	float cost = 0;
+	for (uint8_t k = 0; k < me->tasks; k++){
+		if (tick % me->task[k].divider == me->task[k].phase){ cost += me->task[k].cost; }
+	}
+	return cost;
+}
+
+
+void GetRateGroupStats(const RateScheduler* me, uint8_t group, RateGroupStats* stats)
+{
+	// Copy of the group, retried if an interrupt updated it meanwhile:
+	const RateGroup* g = &me->group[group];
+	uint32_t before, after;
+	uint32_t runs, max, overruns;
+	uint64_t sum;
+	do{
+		before = g->sequence.load(std::memory_order_acquire);
+		runs = g->runs;
+		max = g->max;
+		sum = g->sum;
+		overruns = g->overruns;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		after = g->sequence.load(std::memory_order_relaxed);
+	} while ((before & 1) || before != after);
+
+	stats->name = g->name;
+	stats->frequency = me->frequency / g->divider;
+	stats->runs = runs;
+	stats->max = max;
+	stats->mean = runs ? (double)sum / runs : 0.0;
+	stats->max_seconds = max / me->clock_hz;
+	stats->budget_seconds = g->budget / me->clock_hz;
+	stats->max_budget = g->budget ? (double)max / g->budget : 0.0;
+	stats->overruns = overruns;
+}
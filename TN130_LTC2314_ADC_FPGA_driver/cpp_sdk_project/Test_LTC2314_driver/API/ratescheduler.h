@@ -0,0 +1,187 @@
+/*
+ *	@title	Multi-rate task scheduler run from the main interrupt
+ *	@file	ratescheduler.h
+ *
+ *	The tasks slower than the main interrupt are grouped by rate (e.g. 2 kHz, 100 Hz, 1 Hz at 20 kHz)
+ *	and run from UserInterrupt by a single call, without any hand-rolled counter:
+ *
+ *		group_2k = AddRateGroup(&scheduler, "2 kHz", 2e3, 5e-6);			// 5 us budget per tick
+ *		group_100 = AddRateGroup(&scheduler, "100 Hz", 100, 10e-6);
+ *		AddScheduledTask(&scheduler, group_2k, "temperature", ConvertTask, NULL, 1.0);
+ *		AddScheduledTask(&scheduler, group_100, "mppt", MpptTask, &mppt, 3.0);
+ *		StartRateScheduler(&scheduler);									// End of UserInit
+ *		...
+ *		RunRateScheduler(&scheduler);										// In UserInterrupt
+ *
+ *	Every task of a group runs at the rate of the group, but not necessarily on the same tick as the
+ *	other tasks: StartRateScheduler gives each task a phase (the tick within its period) chosen so that
+ *	the worst-case sum of the estimated costs of the tasks running on the same tick is as small as
+ *	possible. The tasks are placed from the fastest to the slowest, each on the phase where it adds
+ *	the least to the tasks it can coincide with (two tasks of periods D1 and D2 meet if and only if
+ *	their phases are equal modulo gcd(D1, D2)). The schedule is fixed at start: the same tick always
+ *	runs the same tasks, in the order in which they were added.
+ *
+ *	The run routine only decrements one counter per task (no division, the Cortex-A9 has none) and
+ *	reads the cycle counter around the tasks that run. The time spent by each group on a tick is
+ *	compared to its budget; the background loop reads the worst case, the mean and the overruns with
+ *	GetRateGroupStats (consistent snapshot, never blocking the interrupt, as for the profiler).
+ *	The clock can be replaced by SetSchedulerClock, e.g. by a simulated one on the host.
+ */
+
+#ifndef RATESCHEDULER_H_
+#define RATESCHEDULER_H_
+
+#include "interruptprofiler.h"				// ReadCycleCounter()
+
+#include <atomic>
+#include <stdint.h>
+
+#define SCHEDULER_MAX_GROUPS	4
+#define SCHEDULER_MAX_TASKS		16
+
+
+typedef void (*tScheduledTask)(void* context);
+typedef uint32_t (*tSchedulerClock)(void);
+
+
+/**
+ * One task, run every 'divider' ticks when 'countdown' reaches zero
+ */
+typedef struct{
+	const char* name;
+	tScheduledTask run;
+	void* context;
+	uint8_t group;
+	float cost;								// Estimated duration (any unit), used for the phase staggering
+	uint32_t divider;						// Period in ticks (from the group)
+	uint32_t phase;							// Tick within the period (from StartRateScheduler)
+	uint32_t countdown;						// Ticks until the next run
+} ScheduledTask;
+
+
+/**
+ * One rate group and its budget accounting, updated by the interrupt
+ */
+typedef struct{
+	std::atomic<uint32_t> sequence;			// Odd while the interrupt updates the statistics
+	const char* name;
+	uint32_t divider;						// Period in ticks of the main interrupt
+	uint32_t budget;						// Allowed duration per tick, in clock counts
+	uint32_t runs;							// Ticks on which at least one task of the group ran
+	uint32_t last;							// Duration on the last of these ticks
+	uint32_t max;
+	uint64_t sum;
+	uint32_t overruns;						// Ticks on which the budget was exceeded
+} RateGroup;
+
+
+/**
+ * Pseudo-object describing the scheduler
+ */
+typedef struct{
+	double frequency;						// Rate of the main interrupt (tick)
+	double clock_hz;						// Counts per second of the clock
+	tSchedulerClock clock;
+	uint32_t tick;							// Ticks since StartRateScheduler
+	uint8_t groups;
+	uint8_t tasks;
+	RateGroup group[SCHEDULER_MAX_GROUPS];
+	ScheduledTask task[SCHEDULER_MAX_TASKS];
+} RateScheduler;
+
+
+/**
+ * Snapshot of one group, for the background loop
+ */
+typedef struct{
+	const char* name;
+	double frequency;
+	uint32_t runs;
+	uint32_t max;							// Worst duration per tick, in clock counts
+	double mean;
+	double max_seconds;
+	double budget_seconds;
+	double max_budget;						// Worst case as a fraction of the budget
+	uint32_t overruns;
+} RateGroupStats;
+
+
+/**
+ * Routine to initialize the scheduler (no group, cycle counter as clock)
+ * @param *me			the scheduler pseudo-object
+ * @param frequency		the rate of the main interrupt in Hz (e.g. 20e3)
+ * @return void
+ */
+void ConfigRateScheduler(RateScheduler* me, double frequency);
+
+
+/**
+ * Routine to replace the clock used for the budget accounting (before StartRateScheduler)
+ * @param *me			the scheduler pseudo-object
+ * @param clock			the clock routine (wrapping 32-bit counter)
+ * @param hz			its counts per second
+ * @return void
+ */
+void SetSchedulerClock(RateScheduler* me, tSchedulerClock clock, double hz);
+
+
+/**
+ * Routine to add a rate group
+ * @param *me			the scheduler pseudo-object
+ * @param *name			the name of the group (kept as a pointer)
+ * @param frequency		the rate of the group, an integer divisor of the main interrupt rate
+ * @param budget		the allowed duration of all the tasks of the group on one tick, in s
+ * @return				the index of the group, -1 if the rate is not a divisor or if the scheduler is full
+ */
+int AddRateGroup(RateScheduler* me, const char* name, double frequency, double budget);
+
+
+/**
+ * Routine to add a task to a group
+ * @param *me			the scheduler pseudo-object
+ * @param group			the index returned by AddRateGroup
+ * @param *name			the name of the task (kept as a pointer)
+ * @param run			the task routine
+ * @param *context		the argument of the task routine
+ * @param cost			the estimated duration of the task (any unit common to all the tasks, e.g. us)
+ * @return				the index of the task, -1 if the group is invalid or if the scheduler is full
+ */
+int AddScheduledTask(RateScheduler* me, int group, const char* name, tScheduledTask run, void* context, float cost);
+
+
+/**
+ * Routine to stagger the phases of the tasks and to clear the statistics, at the end of UserInit
+ * @param *me			the scheduler pseudo-object
+ * @return				the worst-case estimated cost of one tick (same unit as the task costs)
+ */
+float StartRateScheduler(RateScheduler* me);
+
+
+/**
+ * Routine to run the tasks due on this tick, to be called once per main interrupt
+ * @param *me			the scheduler pseudo-object
+ * @return void
+ */
+void RunRateScheduler(RateScheduler* me);
+
+
+/**
+ * Routine to sum the estimated costs of the tasks running on a given tick (e.g. to plot the load
+ * over a hyperperiod)
+ * @param *me			the scheduler pseudo-object
+ * @param tick			the tick, counted from StartRateScheduler
+ * @return				the sum of the costs
+ */
+float GetScheduledCost(const RateScheduler* me, uint32_t tick);
+
+
+/**
+ * Routine to take a consistent snapshot of one group (background loop only)
+ * @param *me			the scheduler pseudo-object
+ * @param group			the index of the group
+ * @param *stats		the snapshot
+ * @return void
+ */
+void GetRateGroupStats(const RateScheduler* me, uint8_t group, RateGroupStats* stats);
+
+#endif /* RATESCHEDULER_H_ */
@@ -0,0 +1,46 @@
+/*
+ *	@title	Lock-free single-producer/single-consumer sample buffer
+ *	@file	samplebuffer.cpp
+ */
+
+
+#include "samplebuffer.h"					                                    // Corresponding header file
+#include <string.h>
+
+
+void ConfigSampleBuffer(SampleBuffer* me)
+{
+	me->head.store(0, std::memory_order_relaxed);
+	me->tail.store(0, std::memory_order_relaxed);
+	me->overruns.store(0, std::memory_order_relaxed);
+}
+
+
+/*
+ * Copy the available samples in at most two contiguous blocks, then release the slots.
+ */
+uint32_t DrainSamples(SampleBuffer* me, Sample* out, uint32_t max)
+{
+	uint32_t tail = me->tail.load(std::memory_order_relaxed);
+	uint32_t head = me->head.load(std::memory_order_acquire);
+
+	uint32_t count = head - tail;
+	if (count > max){ count = max; }
+	if (count == 0){ return 0; }
+
+	uint32_t first = tail & (SAMPLE_BUFFER_SIZE - 1);
+	uint32_t chunk = SAMPLE_BUFFER_SIZE - first;										// Samples before the wrap-around
+	if (chunk > count){ chunk = count; }
+
+	memcpy(out, &me->data[first], chunk * sizeof(Sample));
+	memcpy(out + chunk, &me->data[0], (count - chunk) * sizeof(Sample));
+
+	me->tail.store(tail + count, std::memory_order_release);							// Hand the slots back to the producer
+	return count;
+}
+
+
+uint32_t GetSampleBufferOverruns(const SampleBuffer* me)
+{
+	return me->overruns.load(std::memory_order_relaxed);
+}
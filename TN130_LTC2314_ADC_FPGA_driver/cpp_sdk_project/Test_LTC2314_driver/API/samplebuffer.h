@@ -0,0 +1,84 @@
+#ifndef SAMPLEBUFFER_H_
+#define SAMPLEBUFFER_H_
+
+#include <atomic>
+#include <stdint.h>
+
+#define SAMPLE_BUFFER_SIZE 4096				// Capacity in samples (power of 2)
+
+
+/**
+ * One captured ADC sample, tagged with the interrupt tick at which it was read
+ */
+typedef struct{
+	uint32_t raw;							// Raw value as returned by Sbi_Read()
+	uint32_t tick;							// Interrupt counter at the time of the read
+} Sample;
+
+
+/**
+ * Pseudo-object describing a single-producer/single-consumer lock-free ring buffer of samples.
+ * The producer (typ. UserInterrupt) only writes 'head' and 'overruns', the consumer (typ. the
+ * background loop) only writes 'tail'. The indices run freely and are wrapped on access, so the
+ * buffer is full when head - tail == SAMPLE_BUFFER_SIZE. A push on a full buffer is dropped and
+ * counted, it never blocks.
+ */
+typedef struct{
+	std::atomic<uint32_t> head __attribute__((aligned(64)));	// Next slot to write (producer side)
+	std::atomic<uint32_t> overruns;								// Number of samples dropped because the buffer was full
+	std::atomic<uint32_t> tail __attribute__((aligned(64)));	// Next slot to read (consumer side)
+	Sample data[SAMPLE_BUFFER_SIZE] __attribute__((aligned(64)));
+} SampleBuffer;
+
+
+/**
+ * Routine to initialize (empty) the sample buffer. Must not run concurrently with a push or a drain.
+ * @param *me		the buffer pseudo-object
+ * @return void
+ */
+void ConfigSampleBuffer(SampleBuffer* me);
+
+
+/**
+ * Routine to append a sample (producer side, typ. in UserInterrupt)
+ * @param *me		the buffer pseudo-object
+ * @param raw		the raw ADC value
+ * @param tick		the interrupt counter
+ * @return			true if the sample was stored, false if it was dropped (buffer full)
+ */
+static inline bool PushSample(SampleBuffer* me, uint32_t raw, uint32_t tick)
+{
+	uint32_t head = me->head.load(std::memory_order_relaxed);
+	uint32_t tail = me->tail.load(std::memory_order_acquire);
+
+	if (head - tail >= SAMPLE_BUFFER_SIZE){
+		me->overruns.store(me->overruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		return false;
+	}
+
+	Sample* slot = &me->data[head & (SAMPLE_BUFFER_SIZE - 1)];
+	slot->raw = raw;
+	slot->tick = tick;
+	me->head.store(head + 1, std::memory_order_release);						// Publish the sample
+	return true;
+}
+
+
+/**
+ * Routine to remove all the available samples at once, up to 'max' (consumer side)
+ * @param *me		the buffer pseudo-object
+ * @param *out		destination array of at least 'max' samples
+ * @param max		the maximum number of samples to copy
+ * @return			the number of samples copied to out[]
+ */
+uint32_t DrainSamples(SampleBuffer* me, Sample* out, uint32_t max);
+
+
+/**
+ * Routine to read the number of samples dropped since the configuration (consumer side)
+ * @param *me		the buffer pseudo-object
+ * @return			the overrun count
+ */
+uint32_t GetSampleBufferOverruns(const SampleBuffer* me);
+
+#endif /*SAMPLEBUFFER_H_*/
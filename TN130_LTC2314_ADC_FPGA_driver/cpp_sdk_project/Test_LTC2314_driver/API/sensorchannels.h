@@ -0,0 +1,147 @@
+/*
+ *	@title	Compile-time description of the sensor channels and fused raw-to-engineering conversion
+ *	@file	sensorchannels.h
+ *
+ *	Each measured quantity is described once by a SensorChannel: the SBI register it is read from,
+ *	the ADC front-end (scale, width, coding) and the sensor (gain as in sensors.h, offset). The list of
+ *	channels is folded at compile time into a SensorRegistry holding one gain, one bias, one mask and
+ *	one sign per channel, so that the conversion of all the channels is a single branch-free loop
+ *	(mask, sign-extend, multiply, add) without any runtime lookup, which the compiler unrolls and
+ *	vectorizes. Example:
+ *
+ *		static constexpr SensorChannel channels[] = {
+ *			MakeSensorChannel(0, LTC2314_ADC, ADCONV),						// Volts at the ADC pins
+ *			MakeSensorChannel(1, BBOX_ADC, LEM_LA55_GAIN),					// Amps
+ *			MakeSensorChannel(2, BBOX_ADC, IX_DIN800V_GAIN, 0.01),			// Volts, 10 mV front-end offset
+ *		};
+ *		static constexpr SensorRegistry<3> sensors(channels);
+ *		...
+ *		ReadSensors(sensors, raw, value);									// In UserInterrupt
+ */
+
+#ifndef SENSORCHANNELS_H_
+#define SENSORCHANNELS_H_
+
+#include "sensors.h"
+#include "Driver/peripherals.h"
+
+#include <stdint.h>
+
+#define LTC2314_ADCONV		(4.096/8192.0)								// LTC2314 (LT2314_driver data_out), V/LSB
+
+
+/**
+ * Description of an ADC front-end
+ */
+typedef struct{
+	double lsb;								// Volts per code
+	uint8_t bits;							// Number of significant bits of the raw value
+	bool is_signed;							// Two's complement (true) or straight binary (false) coding
+} AdcFrontEnd;
+
+constexpr AdcFrontEnd BBOX_ADC = {ADCONV, 16, true};						// B-Box analog inputs (ADCONV scale)
+constexpr AdcFrontEnd LTC2314_ADC = {LTC2314_ADCONV, 14, false};			// LTC2314 through LT2314_driver
+
+
+/**
+ * Description of one measured quantity
+ */
+typedef struct{
+	uint16_t address;						// SBI register holding the raw value
+	AdcFrontEnd adc;						// ADC front-end
+	double gain;							// Engineering units per code, for this ADC front-end
+	double offset;							// Voltage at the ADC input for a zero measured quantity
+} SensorChannel;
+
+
+/**
+ * Routine to describe a channel from one of the sensors.h gains
+ * @param address		the SBI register holding the raw value
+ * @param adc			the ADC front-end (BBOX_ADC, LTC2314_ADC, ...)
+ * @param gain			the gain from sensors.h (expressed for the ADCONV scale), ADCONV for Volts
+ * @param offset		the voltage at the ADC input for a zero measured quantity (optional)
+ * @return				the channel description
+ */
+constexpr SensorChannel MakeSensorChannel(uint16_t address, AdcFrontEnd adc, double gain, double offset = 0.0)
+{
+	return SensorChannel{address, adc, gain / ADCONV * adc.lsb, offset};
+}
+
+
+/**
+ * Per-channel constants of the fused conversion, generated at compile time from the descriptions:
+ *   value = ((raw & mask) ^ sign) - sign) * gain + bias
+ * The xor/subtract pair sign-extends the two's complement codes (sign = 0 for straight binary).
+ */
+template<int N>
+struct SensorRegistry{
+	uint16_t address[N];
+	int32_t mask[N];
+	int32_t sign[N];
+	float gain[N];
+	float bias[N];
+
+	constexpr SensorRegistry(const SensorChannel (&channels)[N]) : address(), mask(), sign(), gain(), bias()
+	{
+		for (int i = 0; i < N; i++){
+			address[i] = channels[i].address;
+			mask[i] = (int32_t)((1UL << channels[i].adc.bits) - 1);
+			sign[i] = channels[i].adc.is_signed ? (int32_t)(1UL << (channels[i].adc.bits - 1)) : 0;
+			gain[i] = (float)channels[i].gain;
+			bias[i] = (float)(-channels[i].offset / channels[i].adc.lsb * channels[i].gain);
+		}
+	}
+};
+
+
+/**
+ * Routine to convert one raw value of each channel
+ * @param &me			the registry
+ * @param *raw			N raw values, in channel order
+ * @param *value		N converted values (engineering units)
+ * @return void
+ */
+template<int N>
+static inline void ConvertSensors(const SensorRegistry<N>& me, const uint16_t* raw, float* value)
+{
+	for (int i = 0; i < N; i++){
+		int32_t code = (((int32_t)raw[i] & me.mask[i]) ^ me.sign[i]) - me.sign[i];
+		value[i] = (float)code * me.gain[i] + me.bias[i];
+	}
+}
+
+
+/**
+ * Routine to convert a block of frames (e.g. samples drained from a SampleBuffer or burst reads)
+ * @param &me			the registry
+ * @param *raw			frames*N raw values, frame after frame, in channel order within a frame
+ * @param *value		frames*N converted values, same layout
+ * @param frames		the number of frames
+ * @return void
+ */
+template<int N>
+static inline void ConvertSensorBlock(const SensorRegistry<N>& me, const uint16_t* raw, float* value, unsigned int frames)
+{
+	for (unsigned int f = 0; f < frames; f++){
+		ConvertSensors(me, raw + f*N, value + f*N);
+	}
+}
+
+
+/**
+ * Routine to read all the channels from their SBI registers and convert them (typ. in UserInterrupt)
+ * @param &me			the registry
+ * @param *raw			N raw values read (kept for logging)
+ * @param *value		N converted values (engineering units)
+ * @return void
+ */
+template<int N>
+static inline void ReadSensors(const SensorRegistry<N>& me, uint16_t* raw, float* value)
+{
+	for (int i = 0; i < N; i++){
+		raw[i] = (uint16_t)Sbi_Read(me.address[i]);
+	}
+	ConvertSensors(me, raw, value);
+}
+
+#endif /* SENSORCHANNELS_H_ */
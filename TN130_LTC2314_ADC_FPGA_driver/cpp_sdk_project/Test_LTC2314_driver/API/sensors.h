@@ -5,6 +5,7 @@
 /**
  * Default analog front-end parameters for some of the most commonly
  * used sensors along with the BoomBox
+ * (describe the channels with MakeSensorChannel() from sensorchannels.h to convert them)
  */
  
 #define ADCONV 				(10.0/32768.0)
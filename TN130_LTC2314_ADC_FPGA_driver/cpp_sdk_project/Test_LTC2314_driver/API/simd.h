@@ -0,0 +1,100 @@
+/*
+ *	@title	Minimal single-precision vector layer
+ *	@file	simd.h
+ *
+ *	Thin inline wrappers so that the multi-channel routines are written once and compiled to
+ *	NEON on the Zynq (-mfpu=neon), to AVX or SSE on a host PC, or to plain scalar code otherwise.
+ *	Only lane-wise IEEE operations are exposed (no reciprocal estimates, no fused multiply-add),
+ *	so that every lane computes exactly what the corresponding scalar routine would compute.
+ *	NB: NEON flushes denormals to zero, which is the only expected difference with the VFP.
+ */
+
+#ifndef SIMD_H_
+#define SIMD_H_
+
+#include <stdint.h>
+
+#define SIMD_ALIGN 32						// Alignment of the SoA arrays (sufficient for AVX)
+
+#if defined(SIMD_FORCE_SCALAR)
+	#define SIMD_WIDTH 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#include <arm_neon.h>
+	#define SIMD_NEON
+	#define SIMD_WIDTH 4
+#elif defined(__AVX__)
+	#include <immintrin.h>
+	#define SIMD_AVX
+	#define SIMD_WIDTH 8
+#elif defined(__SSE2__)
+	#include <emmintrin.h>
+	#define SIMD_SSE
+	#define SIMD_WIDTH 4
+#else
+	#define SIMD_WIDTH 1
+#endif
+
+
+#if defined(SIMD_NEON)
+
+typedef float32x4_t vfloat;
+typedef uint32x4_t vmask;
+
+static inline vfloat VLoad(const float* p)					{ return vld1q_f32(p); }
+static inline void VStore(float* p, vfloat a)				{ vst1q_f32(p, a); }
+static inline vfloat VSet(float a)							{ return vdupq_n_f32(a); }
+static inline vfloat VAdd(vfloat a, vfloat b)				{ return vaddq_f32(a, b); }
+static inline vfloat VSub(vfloat a, vfloat b)				{ return vsubq_f32(a, b); }
+static inline vfloat VMul(vfloat a, vfloat b)				{ return vmulq_f32(a, b); }
+static inline vmask VGreater(vfloat a, vfloat b)			{ return vcgtq_f32(a, b); }
+static inline vmask VLess(vfloat a, vfloat b)				{ return vcltq_f32(a, b); }
+static inline vfloat VSelect(vmask m, vfloat a, vfloat b)	{ return vbslq_f32(m, a, b); }
+
+#elif defined(SIMD_AVX)
+
+typedef __m256 vfloat;
+typedef __m256 vmask;
+
+static inline vfloat VLoad(const float* p)					{ return _mm256_loadu_ps(p); }
+static inline void VStore(float* p, vfloat a)				{ _mm256_storeu_ps(p, a); }
+static inline vfloat VSet(float a)							{ return _mm256_set1_ps(a); }
+static inline vfloat VAdd(vfloat a, vfloat b)				{ return _mm256_add_ps(a, b); }
+static inline vfloat VSub(vfloat a, vfloat b)				{ return _mm256_sub_ps(a, b); }
+static inline vfloat VMul(vfloat a, vfloat b)				{ return _mm256_mul_ps(a, b); }
+static inline vmask VGreater(vfloat a, vfloat b)			{ return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+static inline vmask VLess(vfloat a, vfloat b)				{ return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline vfloat VSelect(vmask m, vfloat a, vfloat b)	{ return _mm256_blendv_ps(b, a, m); }
+
+#elif defined(SIMD_SSE)
+
+typedef __m128 vfloat;
+typedef __m128 vmask;
+
+static inline vfloat VLoad(const float* p)					{ return _mm_loadu_ps(p); }
+static inline void VStore(float* p, vfloat a)				{ _mm_storeu_ps(p, a); }
+static inline vfloat VSet(float a)							{ return _mm_set1_ps(a); }
+static inline vfloat VAdd(vfloat a, vfloat b)				{ return _mm_add_ps(a, b); }
+static inline vfloat VSub(vfloat a, vfloat b)				{ return _mm_sub_ps(a, b); }
+static inline vfloat VMul(vfloat a, vfloat b)				{ return _mm_mul_ps(a, b); }
+static inline vmask VGreater(vfloat a, vfloat b)			{ return _mm_cmpgt_ps(a, b); }
+static inline vmask VLess(vfloat a, vfloat b)				{ return _mm_cmplt_ps(a, b); }
+static inline vfloat VSelect(vmask m, vfloat a, vfloat b)	{ return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+
+#else
+
+typedef float vfloat;
+typedef bool vmask;
+
+static inline vfloat VLoad(const float* p)					{ return *p; }
+static inline void VStore(float* p, vfloat a)				{ *p = a; }
+static inline vfloat VSet(float a)							{ return a; }
+static inline vfloat VAdd(vfloat a, vfloat b)				{ return a + b; }
+static inline vfloat VSub(vfloat a, vfloat b)				{ return a - b; }
+static inline vfloat VMul(vfloat a, vfloat b)				{ return a * b; }
+static inline vmask VGreater(vfloat a, vfloat b)			{ return a > b; }
+static inline vmask VLess(vfloat a, vfloat b)				{ return a < b; }
+static inline vfloat VSelect(vmask m, vfloat a, vfloat b)	{ return m ? a : b; }
+
+#endif
+
+#endif /* SIMD_H_ */
@@ -0,0 +1,10 @@
+/*
+ *	@title	Fast sine-cosine evaluation for phase angles
+ *	@file	sincos.cpp
+ */
+
+#include "sincos.h"							                                    // Corresponding header file
+
+
+// Generated by the compiler: no runtime initialization and no code in the final image
+extern constexpr SineTable<SINCOS_TABLE_SIZE> sine_table{};
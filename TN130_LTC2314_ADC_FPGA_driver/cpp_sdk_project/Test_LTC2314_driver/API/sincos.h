@@ -0,0 +1,160 @@
+/*
+ *	@title	Fast sine-cosine evaluation for phase angles
+ *	@file	sincos.h
+ *
+ *	The engine used by UpdatePhaseAngle() (and hence by all the theta-based transformations and
+ *	PLLs) is selected at compile time with SINCOS_ENGINE, and its accuracy with SINCOS_TABLE_SIZE,
+ *	resp. SINCOS_POLY_DEGREE. These symbols must be identical for the whole project (e.g. set them
+ *	in the project's preprocessor symbols), not per file.
+ *
+ *	Maximum absolute error over [-2*PI, 2*PI], measured against double-precision sin/cos:
+ *	 - SINCOS_ENGINE_LIBM				double sin() and cos() of the C library rounded to float, 3.0e-8
+ *										(reference, slowest): the values of the original transformations
+ *	 - SINCOS_ENGINE_TABLE				linear interpolation, ~4.93/SIZE^2, i.e.
+ *										256: 7.5e-5, 512: 1.9e-5, 1024: 4.8e-6, 4096: 5.6e-7
+ *	 - SINCOS_ENGINE_POLY, degree 5	6.8e-5
+ *	 - SINCOS_ENGINE_POLY, degree 7	7.6e-7
+ *	 - SINCOS_ENGINE_POLY, degree 9	2.1e-7 (limited by the single-precision evaluation)
+ *	The table and polynomial engines accept any angle in [-2*PI, 2*PI].
+ */
+
+#ifndef SINCOS_H_
+#define SINCOS_H_
+
+#include <math.h>
+
+#define SINCOS_ENGINE_LIBM	0
+#define SINCOS_ENGINE_TABLE	1
+#define SINCOS_ENGINE_POLY	2
+
+#ifndef SINCOS_ENGINE
+#define SINCOS_ENGINE		SINCOS_ENGINE_LIBM	// Default: same sin/cos as the original transformations
+#endif
+
+#ifndef SINCOS_TABLE_SIZE
+#define SINCOS_TABLE_SIZE	1024				// Number of intervals over one period (power of 2)
+#endif
+
+#ifndef SINCOS_POLY_DEGREE
+#define SINCOS_POLY_DEGREE	7					// Degree of the odd minimax polynomial (5, 7 or 9)
+#endif
+
+static_assert((SINCOS_TABLE_SIZE & (SINCOS_TABLE_SIZE - 1)) == 0 && SINCOS_TABLE_SIZE >= 16, "SINCOS_TABLE_SIZE must be a power of 2");
+static_assert(SINCOS_POLY_DEGREE == 5 || SINCOS_POLY_DEGREE == 7 || SINCOS_POLY_DEGREE == 9, "SINCOS_POLY_DEGREE must be 5, 7 or 9");
+
+
+/**
+ * Sine evaluated at compile time (Taylor series, accurate to ~1e-15 over [-PI, PI])
+ */
+constexpr double ConstexprSin(double x)
+{
+	double term = x;
+	double sum = x;
+	for (int k = 1; k < 16; k++){
+		term *= -x * x / ((2*k) * (2*k + 1));
+		sum += term;
+	}
+	return sum;
+}
+
+
+/**
+ * One period of the sine, sampled at N+1 points (the last one closes the period so that the
+ * interpolation never has to wrap). Generated entirely at compile time.
+ */
+template<int N>
+struct SineTable{
+	float value[N+1];
+
+	constexpr SineTable() : value()
+	{
+		for (int i = 0; i <= N; i++){
+			double x = 6.283185307179586 * i / N;
+			value[i] = (float)ConstexprSin(x > 3.141592653589793 ? x - 6.283185307179586 : x);
+		}
+	}
+};
+
+extern const SineTable<SINCOS_TABLE_SIZE> sine_table;		// Defined in sincos.cpp
+
+
+/**
+ * Routine to compute sin(x) and cos(x) by linear interpolation in sine_table
+ * @param x			the angle in rad., within [-2*PI, 2*PI]
+ * @param *s		the sine of x
+ * @param *c		the cosine of x
+ */
+static inline void SinCosTable(float x, float* s, float* c)
+{
+	float t = x * (float)(SINCOS_TABLE_SIZE / 6.283185307179586);
+	int i = (int)t - (t < 0);															// floor(t)
+	float frac = t - i;
+
+	int is = i & (SINCOS_TABLE_SIZE - 1);
+	int ic = (i + SINCOS_TABLE_SIZE/4) & (SINCOS_TABLE_SIZE - 1);						// cos(x) = sin(x + PI/2)
+
+	*s = sine_table.value[is] + frac * (sine_table.value[is+1] - sine_table.value[is]);
+	*c = sine_table.value[ic] + frac * (sine_table.value[ic+1] - sine_table.value[ic]);
+}
+
+
+/**
+ * Odd minimax polynomial approximating sin(x) over [-PI/2, PI/2] (absolute error criterion)
+ */
+static inline float SinPolyHalfPeriod(float x)
+{
+	float x2 = x * x;
+#if SINCOS_POLY_DEGREE == 5
+	return x * (9.996967731e-01f + x2 * (-1.656730793e-01f + x2 * 7.514377180e-03f));
+#elif SINCOS_POLY_DEGREE == 7
+	return x * (9.999966159e-01f + x2 * (-1.666482838e-01f + x2 * (8.306325227e-03f + x2 * -1.836365398e-04f)));
+#else
+	return x * (9.999999766e-01f + x2 * (-1.666664763e-01f + x2 * (8.332899823e-03f + x2 * (-1.980089776e-04f + x2 * 2.590488501e-06f))));
+#endif
+}
+
+
+/**
+ * Routine to compute sin(x) and cos(x) with the minimax polynomial
+ * @param x			the angle in rad., within [-2*PI, 2*PI]
+ * @param *s		the sine of x
+ * @param *c		the cosine of x
+ */
+static inline void SinCosPoly(float x, float* s, float* c)
+{
+	const float pi = 3.14159265f;
+	const float half_pi = 1.57079633f;
+
+	// Bring the angle back to [-PI, PI]:
+	if (x > pi){ x -= 2*pi; }
+	else if (x < -pi){ x += 2*pi; }
+
+	// Fold onto [-PI/2, PI/2] using sin(x) = sin(PI - x), and cos(x) = sin(PI/2 - |x|):
+	float xs = x;
+	if (xs > half_pi){ xs = pi - xs; }
+	else if (xs < -half_pi){ xs = -pi - xs; }
+
+	*s = SinPolyHalfPeriod(xs);
+	*c = SinPolyHalfPeriod(half_pi - fabsf(x));
+}
+
+
+/**
+ * Routine to compute sin(x) and cos(x) with the engine selected by SINCOS_ENGINE
+ * @param x			the angle in rad.
+ * @param *s		the sine of x
+ * @param *c		the cosine of x
+ */
+static inline void FastSinCos(float x, float* s, float* c)
+{
+#if SINCOS_ENGINE == SINCOS_ENGINE_TABLE
+	SinCosTable(x, s, c);
+#elif SINCOS_ENGINE == SINCOS_ENGINE_POLY
+	SinCosPoly(x, s, c);
+#else
+	*s = (float)sin((double)x);												// Double overloads, as the original cos(theta)
+	*c = (float)cos((double)x);												// and sin(theta): sincosf() differs by up to 1 ulp
+#endif
+}
+
+#endif /* SINCOS_H_ */
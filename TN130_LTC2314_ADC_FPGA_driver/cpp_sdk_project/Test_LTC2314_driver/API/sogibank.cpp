@@ -0,0 +1,99 @@
+/*
+ *	@title	Bank of harmonic SOGIs (structure-of-arrays, vectorized)
+ *	@file	sogibank.cpp
+ */
+
+
+#include "sogibank.h"						                                    // Corresponding header file
+
+
+int ConfigSOGIBank(SOGIBank* me, uint16_t channels, const uint16_t* orders, uint16_t harmonics, float gain, float omega0, float tsample, bool cross_feedback)
+{
+	if (channels == 0 || channels > SOGI_BANK_MAX_CHANNELS || harmonics * channels > SOGI_BANK_MAX_LANES){ return -1; }
+
+	me->channels = channels;
+	me->harmonics = harmonics;
+	me->lanes = (harmonics * channels + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+	me->index = 0;
+	me->cross_feedback = cross_feedback;
+	me->constant = tsample/12.0;												// The constant parameter should be Ts/12, as in ConfigSOGI3
+
+	// Padding lanes: zero gain and frequency, they stay at zero:
+	for (uint16_t k = 0; k < SOGI_BANK_MAX_LANES; k++){
+		me->order[k] = k < harmonics * channels ? orders[k / channels] : 0.0f;
+		me->gain[k] = k < harmonics * channels ? gain : 0.0f;
+		me->error[k] = 0.0;
+		me->alpha[k] = 0.0;
+		me->beta[k] = 0.0;
+		for (int i = 0; i < 3; i++){
+			me->za[i][k] = 0.0;
+			me->zb[i][k] = 0.0;
+		}
+	}
+	for (uint16_t c = 0; c < SOGI_BANK_MAX_CHANNELS; c++){ me->input[c] = 0.0; }
+
+	SetSOGIBankFrequency(me, omega0);
+	return 0;
+}
+
+
+void SetSOGIBankFrequency(SOGIBank* me, float omega)
+{
+	// Same rounding as RunSOGI3 (constant * omega, then times the integrator input):
+	for (uint16_t k = 0; k < SOGI_BANK_MAX_LANES; k++){
+		me->kw[k] = me->constant * (me->order[k] * omega);
+	}
+}
+
+
+/*
+ * One step of RunSOGI3 on all the lanes. With z1 at 'index' in the histories, z2 and z3 are at
+ * index-1 and index-2 (mod 3); after the step, the new z1 is written over z3 and becomes the entry
+ * 'index+1', the old z1 and z2 becoming z2 and z3 without any copy.
+ */
+void RunSOGIBank(SOGIBank* me)
+{
+	uint16_t used = me->harmonics * me->channels;
+
+	// Inputs of the SOGIs, from the outputs of the previous step:
+	if (me->cross_feedback){
+		for (uint16_t c = 0; c < me->channels; c++){
+			float sum = 0;
+			for (uint16_t k = c; k < used; k += me->channels){ sum += me->alpha[k]; }
+			float error = me->input[c] - sum;
+			for (uint16_t k = c; k < used; k += me->channels){ me->error[k] = error; }
+		}
+	}
+	else{
+		for (uint16_t k = 0; k < used; k += me->channels){
+			for (uint16_t c = 0; c < me->channels; c++){ me->error[k + c] = me->input[c] - me->alpha[k + c]; }
+		}
+	}
+
+	uint8_t i1 = me->index;														// z1, before the step
+	uint8_t i2 = i1 == 0 ? 2 : i1 - 1;											// z2, before the step
+	uint8_t i0 = i2 == 0 ? 2 : i2 - 1;											// z3 before the step, new z1 after
+	vfloat w23 = VSet(23.0f);
+	vfloat w16 = VSet(16.0f);
+	vfloat w5 = VSet(5.0f);
+
+	for (uint16_t k = 0; k < me->lanes; k += SIMD_WIDTH){
+		vfloat kw = VLoad(&me->kw[k]);
+		vfloat alpha = VLoad(&me->alpha[k]);
+		vfloat beta = VLoad(&me->beta[k]);
+		vfloat za1 = VLoad(&me->za[i1][k]);
+		vfloat zb1 = VLoad(&me->zb[i1][k]);
+
+		// New first states (the quadrature integrator uses the direct output of the previous step):
+		vfloat za = VAdd(za1, VMul(kw, VSub(VMul(VLoad(&me->gain[k]), VLoad(&me->error[k])), beta)));
+		vfloat zb = VAdd(zb1, VMul(kw, alpha));
+		VStore(&me->za[i0][k], za);
+		VStore(&me->zb[i0][k], zb);
+
+		// Outputs: 23 z1 - 16 z2 + 5 z3, with the old z1 and z2 as the new z2 and z3:
+		VStore(&me->alpha[k], VAdd(VSub(VMul(w23, za), VMul(w16, za1)), VMul(w5, VLoad(&me->za[i2][k]))));
+		VStore(&me->beta[k], VAdd(VSub(VMul(w23, zb), VMul(w16, zb1)), VMul(w5, VLoad(&me->zb[i2][k]))));
+	}
+
+	me->index = i0;
+}
@@ -0,0 +1,114 @@
+/*
+ *	@title	Vectorized bank of SOGIs at several harmonics of several channels
+ *	@file	sogibank.h
+ *
+ *	Harmonic extraction (e.g. orders 1, 5, 7, 11, 13 of the three phase voltages) by one SOGI per
+ *	harmonic and channel, run together through the vector layer of simd.h. Independent SOGIs are
+ *	bit-exact with RunSOGI3; the multiple SOGI structure (cross feedback) trades stability margin for
+ *	selectivity. Example, in UserInit() and UserInterrupt():
+ *
+ *		static const uint16_t orders[] = {1, 5, 7, 11, 13};
+ *		ConfigSOGIBank(&bank, 3, orders, 5, 0.7, 2*M_PI*50, SAMPLING_PERIOD, true);
+ *		...
+ *		for (int c = 0; c < 3; c++){ bank.input[c] = v[c]; }
+ *		SetSOGIBankFrequency(&bank, pll.omega);								// Optional: track the grid
+ *		RunSOGIBank(&bank);
+ *		SpaceVector v5_a = GetSOGIBankOutput(&bank, 1, 0);					// 5th harmonic of the phase a
+ */
+
+#ifndef SOGIBANK_H_
+#define SOGIBANK_H_
+
+#include "simd.h"
+#include "transformations.h"				// SpaceVector
+
+#include <stdint.h>
+
+#define SOGI_BANK_MAX_LANES		32			// Harmonics x channels, must be a multiple of the widest SIMD_WIDTH (8)
+#define SOGI_BANK_MAX_CHANNELS	8
+
+
+/**
+ * Pseudo-object describing a bank of SOGIs (triple integrator approximation, as ConfigSOGI3) at
+ * several harmonics of several channels, stored as structure-of-arrays and updated in one
+ * vectorized pass. Lane h*channels + c holds the harmonic h of the channel c.
+ * The z1, z2, z3 states are not shifted on every sample: each axis keeps a history of three
+ * values and a circular index designates z1 (z2 and z3 are the two previous entries), so a step
+ * writes only the new z1 over the oldest value.
+ *
+ * Without cross feedback, every lane computes exactly what RunSOGI3 computes for the same
+ * parameters. With cross feedback (multiple SOGI structure), the error fed to each SOGI is the input
+ * minus the direct outputs of all the SOGIs of the channel, so that each harmonic is removed from the
+ * inputs of the others and the extraction is selective. The cross-coupled loop is less tolerant of
+ * the one-sample delay: with the orders 1, 5, 7, 11, 13 at 20 kHz it is stable up to a gain of 1.0
+ * and diverges from 1.1 (typ. 0.5..1.0, against 1.41 for a single SOGI).
+ * The inputs are written to input[], channel by channel, the outputs read from alpha[] and beta[].
+ */
+typedef struct{
+	uint16_t channels;
+	uint16_t harmonics;
+	uint16_t lanes;															// harmonics*channels, rounded up to SIMD_WIDTH
+	uint8_t index;															// Position of z1 in the histories (0..2)
+	bool cross_feedback;
+	float constant;															// Ts/12
+	float order[SOGI_BANK_MAX_LANES];										// Harmonic order of each lane (1, 5, 7, ...)
+	float input[SOGI_BANK_MAX_CHANNELS];									// Inputs: one measurement per channel
+	float error[SOGI_BANK_MAX_LANES] __attribute__((aligned(SIMD_ALIGN)));	// Input of each SOGI, per lane
+	float gain[SOGI_BANK_MAX_LANES] __attribute__((aligned(SIMD_ALIGN)));	// SOGI gains
+	float kw[SOGI_BANK_MAX_LANES] __attribute__((aligned(SIMD_ALIGN)));		// Offline-computed Ts/12 * omega of each lane
+	float za[3][SOGI_BANK_MAX_LANES] __attribute__((aligned(SIMD_ALIGN)));	// Histories of the integrator states, direct axis
+	float zb[3][SOGI_BANK_MAX_LANES] __attribute__((aligned(SIMD_ALIGN)));	// Histories of the integrator states, quadrature axis
+	float alpha[SOGI_BANK_MAX_LANES] __attribute__((aligned(SIMD_ALIGN)));	// Outputs: direct (in phase) signals
+	float beta[SOGI_BANK_MAX_LANES] __attribute__((aligned(SIMD_ALIGN)));	// Outputs: quadrature (lagging) signals
+} SOGIBank;
+
+
+/**
+ * Routine to initialize the bank (all the states cleared)
+ * @param *me				the bank pseudo-object
+ * @param channels			the number of channels (phases), at most SOGI_BANK_MAX_CHANNELS
+ * @param *orders			the harmonic orders (e.g. {1, 5, 7, 11, 13})
+ * @param harmonics			the number of harmonic orders (harmonics*channels at most SOGI_BANK_MAX_LANES)
+ * @param gain				the gain of the SOGIs (as in ConfigSOGI3, e.g. 1.41)
+ * @param omega0			the fundamental angular frequency
+ * @param tsample			the sampling time
+ * @param cross_feedback	true for the multiple SOGI structure (selective), false for independent SOGIs
+ * @return					0 on success, -1 if the bank is too large
+ */
+int ConfigSOGIBank(SOGIBank* me, uint16_t channels, const uint16_t* orders, uint16_t harmonics, float gain, float omega0, float tsample, bool cross_feedback);
+
+
+/**
+ * Routine to change the fundamental angular frequency (e.g. from a PLL), applied to all the orders
+ * @param *me				the bank pseudo-object
+ * @param omega				the fundamental angular frequency
+ * @return void
+ */
+void SetSOGIBankFrequency(SOGIBank* me, float omega);
+
+
+/**
+ * Routine to update all the SOGIs with the inputs in me->input[]
+ * @param *me				the bank pseudo-object
+ * @return void				the outputs are written to me->alpha[] and me->beta[]
+ */
+void RunSOGIBank(SOGIBank* me);
+
+
+/**
+ * Routine to read the outputs of one SOGI
+ * @param *me				the bank pseudo-object
+ * @param harmonic			the index of the harmonic order (position in orders[])
+ * @param channel			the channel
+ * @return					the direct (real) and quadrature (imaginary) signals
+ */
+static inline SpaceVector GetSOGIBankOutput(const SOGIBank* me, uint16_t harmonic, uint16_t channel)
+{
+	SpaceVector out;
+	out.real = me->alpha[harmonic * me->channels + channel];
+	out.imaginary = me->beta[harmonic * me->channels + channel];
+	out.offset = 0.0;
+	return out;
+}
+
+#endif /*SOGIBANK_H_*/
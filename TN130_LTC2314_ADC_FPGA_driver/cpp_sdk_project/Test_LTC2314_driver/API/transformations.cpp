@@ -6,6 +6,7 @@
 
 
 #include "transformations.h"			    							        // Corresponding header file
+#include "sincos.h"																// Sine-cosine engine (SINCOS_ENGINE)
 #include <cmath>
 
 #define PI 3.141592654
@@ -30,28 +31,59 @@ void ABG2abc(TimeDomain *physical, const SpaceVector *fixed)
 }
 
 
-void ABG2DQ0(SpaceVector *rotating, const SpaceVector *fixed, const float theta)
+void UpdatePhaseAngle(PhaseAngle* me, const float theta)
 {
-	float cosTheta; cosTheta=cos(theta);
-	float sinTheta; sinTheta=sin(theta); 								        // Compute the sine and cosine only once !
+	float cosTheta, sinTheta;
+	FastSinCos(theta, &sinTheta, &cosTheta);							        // Fused evaluation of the sine and cosine
+
+	me->theta = theta;
+	me->cosTheta = cosTheta;
+	me->sinTheta = sinTheta;
+	me->cos2Theta = (cosTheta - sinTheta) * (cosTheta + sinTheta);		        // cos(2x) = cos^2(x) - sin^2(x)
+	me->sin2Theta = 2 * sinTheta * cosTheta;							        // sin(2x) = 2 sin(x) cos(x)
+}
 
-	rotating->real = cosTheta * fixed->real + sinTheta * fixed->imaginary;
-	rotating->imaginary = -sinTheta * fixed->real + cosTheta * fixed->imaginary;
+
+void ABG2DQ0(SpaceVector *rotating, const SpaceVector *fixed, const PhaseAngle *angle)
+{
+	rotating->real = angle->cosTheta * fixed->real + angle->sinTheta * fixed->imaginary;
+	rotating->imaginary = -angle->sinTheta * fixed->real + angle->cosTheta * fixed->imaginary;
 	rotating->offset = fixed->offset;
 }
 
 
-void DQ02ABG(SpaceVector *fixed, const SpaceVector *rotating, const float theta)
+void ABG2DQ0(SpaceVector *rotating, const SpaceVector *fixed, const float theta)
 {
-	float cosTheta; cosTheta=cos(theta);
-	float sinTheta; sinTheta=sin(theta); 								        // Compute the sine and cosine only once !
+	PhaseAngle angle;
+	UpdatePhaseAngle(&angle, theta);											// Compute the sine and cosine only once !
+	ABG2DQ0(rotating, fixed, &angle);
+}
+
 
-	fixed->real = cosTheta * rotating->real - sinTheta * rotating->imaginary;
-	fixed->imaginary = sinTheta * rotating->real + cosTheta * rotating->imaginary;
+void DQ02ABG(SpaceVector *fixed, const SpaceVector *rotating, const PhaseAngle *angle)
+{
+	fixed->real = angle->cosTheta * rotating->real - angle->sinTheta * rotating->imaginary;
+	fixed->imaginary = angle->sinTheta * rotating->real + angle->cosTheta * rotating->imaginary;
 	fixed->offset = rotating->offset;
 }
 
 
+void DQ02ABG(SpaceVector *fixed, const SpaceVector *rotating, const float theta)
+{
+	PhaseAngle angle;
+	UpdatePhaseAngle(&angle, theta);											// Compute the sine and cosine only once !
+	DQ02ABG(fixed, rotating, &angle);
+}
+
+
+void abc2DQ0(SpaceVector *rotating, const TimeDomain *physical, const PhaseAngle *angle)
+{
+	SpaceVector fixed;
+	abc2ABG(&fixed,physical);
+	ABG2DQ0(rotating,&fixed,angle);
+}
+
+
 void abc2DQ0(SpaceVector *rotating, const TimeDomain *physical, const float theta)
 {
 	SpaceVector fixed;
@@ -60,6 +92,14 @@ void abc2DQ0(SpaceVector *rotating, const TimeDomain *physical, const float thet
 }
 
 
+void DQ02abc(TimeDomain *physical, const SpaceVector *rotating, const PhaseAngle *angle)
+{
+	SpaceVector fixed;
+	DQ02ABG(&fixed,rotating,angle);
+	ABG2abc(physical,&fixed);
+}
+
+
 void DQ02abc(TimeDomain *physical, const SpaceVector *rotating, const float theta)
 {
 	SpaceVector fixed;
@@ -90,16 +130,16 @@ void ConfigSequences(Sequences* me, const float fcut, const float tsample)
 }
 
 
-void RunDSRF(Sequences* me, const TimeDomain* physical, const float theta)
+void RunDSRF(Sequences* me, const TimeDomain* physical, const PhaseAngle *angle)
 {
 	//Define some internal variables:
 	SpaceVector fixed, pos, neg, pos_fb, neg_fb;
 
-	//Compute some constant terms:
-	float cosTheta; cosTheta=cos(theta);
-	float sinTheta; sinTheta=sin(theta);
-	float cos2Theta; cos2Theta=cos(2*theta);
-	float sin2Theta; sin2Theta=sin(2*theta);
+	//Fetch the precomputed constant terms:
+	float cosTheta = angle->cosTheta;
+	float sinTheta = angle->sinTheta;
+	float cos2Theta = angle->cos2Theta;
+	float sin2Theta = angle->sin2Theta;
 
 	//Convert to ABG:
 	abc2ABG(&fixed,physical);
@@ -128,3 +168,11 @@ void RunDSRF(Sequences* me, const TimeDomain* physical, const float theta)
 	me->neg_lpf.real = (1.0-me->k)*me->neg_lpf.real + me->k * me->dqneg.real;
 	me->neg_lpf.imaginary = (1.0-me->k)*me->neg_lpf.imaginary + me->k * me->dqneg.imaginary;
 }
+
+
+void RunDSRF(Sequences* me, const TimeDomain* physical, const float theta)
+{
+	PhaseAngle angle;
+	UpdatePhaseAngle(&angle, theta);
+	RunDSRF(me, physical, &angle);
+}
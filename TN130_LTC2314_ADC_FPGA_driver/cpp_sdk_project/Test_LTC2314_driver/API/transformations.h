@@ -20,6 +20,20 @@ typedef struct{
 } TimeDomain;
 
 
+/**
+ * Phase angle with its precomputed trigonometric values.
+ * Computed once per interrupt with UpdatePhaseAngle(), it can then be shared by all the
+ * transformations using the same angle (typ. the PLL output) instead of calling cos/sin in each.
+ */
+typedef struct{
+	float theta;				// Phase angle
+	float cosTheta;				// cos(theta)
+	float sinTheta;				// sin(theta)
+	float cos2Theta;			// cos(2*theta), from the double-angle identities
+	float sin2Theta;			// sin(2*theta), from the double-angle identities
+} PhaseAngle;
+
+
 /**
  * Pseudo-object containing all the necessary data for the
  * Double-synchronous Reference Frame (DSRF) Park transformation
@@ -34,6 +48,15 @@ typedef struct{
 } Sequences;
 
 
+/**
+ * Routine to compute the trigonometric values of a phase angle (one fused sine-cosine evaluation)
+ * @param *me			pointer on the phase angle pseudo-object that will be updated
+ * @param theta 		phase angle
+ * @return void
+ */
+void UpdatePhaseAngle(PhaseAngle* me, const float theta);
+
+
 /**
  * Transformation from physical (abc) to stationary (ABG) reference frame
  * @param *fixed		pointer on the space vector that will be updated
@@ -47,30 +70,33 @@ void abc2ABG(SpaceVector *fixed, const TimeDomain *physical);
  * Transformation from stationary (ABG) to rotating (DQ0) reference frame
  * @param *rotating		pointer on the DQ0 space vector that will be updated
  * @param *fixed		pointer on the alphabetagamma space vector that will be transformed
- * @param theta 		phase angle used for the transformation
+ * @param theta 		phase angle used for the transformation (or *angle, precomputed)
  * @return void			the return is the *rotating structure itself
  */
 void ABG2DQ0(SpaceVector *rotating, const SpaceVector *fixed, const float theta);
+void ABG2DQ0(SpaceVector *rotating, const SpaceVector *fixed, const PhaseAngle *angle);
 
 
 /**
  * Transformation from physical (abc) to rotating (DQ0) reference frame
  * @param *rotating		pointer on the space vector that will be updated
  * @param *physical		pointer on the time domain data that will be transformed
- * @param theta 		phase angle used for the transformation
+ * @param theta 		phase angle used for the transformation (or *angle, precomputed)
  * @return void			the return is the *rotating space vector itself
  */
 void abc2DQ0(SpaceVector* rotating, const TimeDomain* physical, const float theta);
+void abc2DQ0(SpaceVector* rotating, const TimeDomain* physical, const PhaseAngle *angle);
 
 
 /**
  * Transformation from rotating (DQ0) to stationary (ABG) reference frame
  * @param *fixed		pointer on the alphabetagamma space vector that will be updated
  * @param *rotating		pointer on the DQ0 space vector that will be transformed
- * @param theta 		phase angle used for the transformation
+ * @param theta 		phase angle used for the transformation (or *angle, precomputed)
  * @return void			the return is the *fixed structure itself
  */
 void DQ02ABG(SpaceVector *fixed, const SpaceVector *rotating, const float theta);
+void DQ02ABG(SpaceVector *fixed, const SpaceVector *rotating, const PhaseAngle *angle);
 
 
 /**
@@ -87,10 +113,11 @@ void ABG2abc(TimeDomain *physical, const SpaceVector *fixed);
  * Transformation from rotating (DQ0) to physical (abc) reference frame
  * @param *physical		pointer on the time domain data that will be updated
  * @param *rotating		pointer on the space vector that will be transformed
- * @param theta 		phase angle used for the transformation
+ * @param theta 		phase angle used for the transformation (or *angle, precomputed)
  * @return void			the return is the *physical structure itself
  */
 void DQ02abc(TimeDomain *physical, const SpaceVector *rotating, const float theta);
+void DQ02abc(TimeDomain *physical, const SpaceVector *rotating, const PhaseAngle *angle);
 
 
 /**
@@ -106,9 +133,10 @@ void ConfigSequences(Sequences* me, const float fcut, const float tsample);
  * Transformation from physical (abc) to double synchronous reference frame (DSRF)
  * @param *me			pointer on the pseudo-object containing all the necessary data
  * @param *physical		pointer on the time domain (abc) data
- * @param theta 		phase angle used for the transformation
+ * @param theta 		phase angle used for the transformation (or *angle, precomputed)
  * @return void			the return is the *physical structure itself
  */
 void RunDSRF(Sequences* me, const TimeDomain* physical, const float theta);
+void RunDSRF(Sequences* me, const TimeDomain* physical, const PhaseAngle *angle);
 
 #endif /*TRANSFORMATIONS_H_*/
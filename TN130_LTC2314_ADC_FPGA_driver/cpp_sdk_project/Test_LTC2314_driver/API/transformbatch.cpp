@@ -0,0 +1,139 @@
+/*
+ *	@title	Coordinate transformations over arrays of samples (structure-of-arrays, vectorized)
+ *	@file	transformbatch.cpp
+ */
+
+
+#include "transformbatch.h"					                                    // Corresponding header file
+#include "sincos.h"																// Sine-cosine engine (SINCOS_ENGINE)
+
+static const float ONE_THIRD = 1/3.f;
+static const float ONE_OVER_SQRT_3 = 0.577350269f;							// Same values as transformations.cpp
+static const float SQRT_3_OVER_2 = 0.866025403f;
+
+static_assert(TRANSFORM_BATCH_CHUNK % SIMD_WIDTH == 0, "TRANSFORM_BATCH_CHUNK must be a multiple of SIMD_WIDTH");
+
+
+/*
+ * Kernels: SIMD_WIDTH samples from the positions given (outputs o0..o2, inputs i0..i2, cosines and sines).
+ * All the inputs are loaded before the first store, so that an output may be an input.
+ */
+static inline void abc2ABGKernel(float* o0, float* o1, float* o2, const float* i0, const float* i1, const float* i2,
+		const float* cs, const float* sn)
+{
+	(void)cs; (void)sn;
+	vfloat a = VLoad(i0), b = VLoad(i1), c = VLoad(i2);
+	VStore(o0, VMul(VSet(ONE_THIRD), VSub(VSub(VAdd(a, a), b), c)));			// Alpha
+	VStore(o1, VMul(VSet(ONE_OVER_SQRT_3), VSub(b, c)));						// Beta
+	VStore(o2, VMul(VSet(ONE_THIRD), VAdd(VAdd(a, b), c)));						// Gamma
+}
+
+static inline void ABG2DQ0Kernel(float* o0, float* o1, float* o2, const float* i0, const float* i1, const float* i2,
+		const float* cs, const float* sn)
+{
+	vfloat alpha = VLoad(i0), beta = VLoad(i1), gamma = VLoad(i2);
+	vfloat cosTheta = VLoad(cs), sinTheta = VLoad(sn);
+	VStore(o0, VAdd(VMul(cosTheta, alpha), VMul(sinTheta, beta)));
+	VStore(o1, VSub(VMul(cosTheta, beta), VMul(sinTheta, alpha)));
+	VStore(o2, gamma);
+}
+
+static inline void abc2DQ0Kernel(float* o0, float* o1, float* o2, const float* i0, const float* i1, const float* i2,
+		const float* cs, const float* sn)
+{
+	vfloat a = VLoad(i0), b = VLoad(i1), c = VLoad(i2);
+	vfloat cosTheta = VLoad(cs), sinTheta = VLoad(sn);
+	vfloat alpha = VMul(VSet(ONE_THIRD), VSub(VSub(VAdd(a, a), b), c));
+	vfloat beta = VMul(VSet(ONE_OVER_SQRT_3), VSub(b, c));
+	VStore(o0, VAdd(VMul(cosTheta, alpha), VMul(sinTheta, beta)));
+	VStore(o1, VSub(VMul(cosTheta, beta), VMul(sinTheta, alpha)));
+	VStore(o2, VMul(VSet(ONE_THIRD), VAdd(VAdd(a, b), c)));
+}
+
+static inline void DQ02abcKernel(float* o0, float* o1, float* o2, const float* i0, const float* i1, const float* i2,
+		const float* cs, const float* sn)
+{
+	vfloat d = VLoad(i0), q = VLoad(i1), zero = VLoad(i2);
+	vfloat cosTheta = VLoad(cs), sinTheta = VLoad(sn);
+	vfloat alpha = VSub(VMul(cosTheta, d), VMul(sinTheta, q));
+	vfloat beta = VAdd(VMul(sinTheta, d), VMul(cosTheta, q));
+	vfloat common = VSub(zero, VMul(VSet(0.5f), alpha));
+	vfloat differential = VMul(VSet(SQRT_3_OVER_2), beta);
+	VStore(o0, VAdd(alpha, zero));
+	VStore(o1, VAdd(common, differential));
+	VStore(o2, VSub(common, differential));
+}
+
+
+typedef void (*tBatchKernel)(float*, float*, float*, const float*, const float*, const float*, const float*, const float*);
+
+/*
+ * Runs a kernel over the arrays, one chunk of angles at a time; the last incomplete vector goes
+ * through padded copies, so that every sample is computed by the same vector code.
+ */
+template<tBatchKernel Kernel>
+static void RunBatch(float* o0, float* o1, float* o2, const float* i0, const float* i1, const float* i2,
+		const float* theta, uint32_t count)
+{
+	float cs[TRANSFORM_BATCH_CHUNK] __attribute__((aligned(SIMD_ALIGN)));
+	float sn[TRANSFORM_BATCH_CHUNK] __attribute__((aligned(SIMD_ALIGN)));
+
+	for (uint32_t start = 0; start < count; start += TRANSFORM_BATCH_CHUNK){
+		uint32_t n = count - start < TRANSFORM_BATCH_CHUNK ? count - start : TRANSFORM_BATCH_CHUNK;
+		if (theta){
+			for (uint32_t k = 0; k < n; k++){ FastSinCos(theta[start + k], &sn[k], &cs[k]); }
+		}
+
+		uint32_t full = n / SIMD_WIDTH * SIMD_WIDTH;
+		for (uint32_t k = 0; k < full; k += SIMD_WIDTH){
+			uint32_t i = start + k;
+			Kernel(o0 + i, o1 + i, o2 + i, i0 + i, i1 + i, i2 + i, cs + k, sn + k);
+		}
+
+		if (full < n){
+			float in[3][SIMD_WIDTH] = {}, out[3][SIMD_WIDTH], tail_cs[SIMD_WIDTH] = {}, tail_sn[SIMD_WIDTH] = {};
+			for (uint32_t k = full; k < n; k++){
+				in[0][k - full] = i0[start + k];
+				in[1][k - full] = i1[start + k];
+				in[2][k - full] = i2[start + k];
+				if (theta){
+					tail_cs[k - full] = cs[k];
+					tail_sn[k - full] = sn[k];
+				}
+			}
+			Kernel(out[0], out[1], out[2], in[0], in[1], in[2], tail_cs, tail_sn);
+			for (uint32_t k = full; k < n; k++){
+				o0[start + k] = out[0][k - full];
+				o1[start + k] = out[1][k - full];
+				o2[start + k] = out[2][k - full];
+			}
+		}
+	}
+}
+
+
+void abc2ABGBatch(float* alpha, float* beta, float* gamma, const float* a, const float* b, const float* c, uint32_t count)
+{
+	RunBatch<abc2ABGKernel>(alpha, beta, gamma, a, b, c, 0, count);
+}
+
+
+void ABG2DQ0Batch(float* d, float* q, float* zero, const float* alpha, const float* beta, const float* gamma,
+		const float* theta, uint32_t count)
+{
+	RunBatch<ABG2DQ0Kernel>(d, q, zero, alpha, beta, gamma, theta, count);
+}
+
+
+void abc2DQ0Batch(float* d, float* q, float* zero, const float* a, const float* b, const float* c,
+		const float* theta, uint32_t count)
+{
+	RunBatch<abc2DQ0Kernel>(d, q, zero, a, b, c, theta, count);
+}
+
+
+void DQ02abcBatch(float* a, float* b, float* c, const float* d, const float* q, const float* zero,
+		const float* theta, uint32_t count)
+{
+	RunBatch<DQ02abcKernel>(a, b, c, d, q, zero, theta, count);
+}
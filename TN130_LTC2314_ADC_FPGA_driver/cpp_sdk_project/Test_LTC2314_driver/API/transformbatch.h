@@ -0,0 +1,75 @@
+/*
+ *	@title	Coordinate transformations over arrays of samples (structure-of-arrays, vectorized)
+ *	@file	transformbatch.h
+ *
+ *	Array variants of abc2ABG, ABG2DQ0, abc2DQ0 and DQ02abc (transformations.h) for the post-processing
+ *	of captured waveforms and for the simulations: every quantity is an array (A[], B[], C[], theta[],
+ *	d[], q[], zero[]), all of the same length, processed SIMD_WIDTH samples at a time (simd.h).
+ *	The angles are processed in chunks of TRANSFORM_BATCH_CHUNK: FastSinCos (the engine of
+ *	UpdatePhaseAngle) fills a small table of cosines and sines, then the rotations are vectorized.
+ *	An output array may be the same as an input array (in-place), but must not partially overlap one.
+ *
+ *	Accuracy against the scalar routines, for the same inputs:
+ *	 - the rotations are computed exactly as in ABG2DQ0 and DQ02ABG (same cosines and sines)
+ *	 - the scalar abc2ABG and ABG2abc evaluate their constants 1/3 and -1/2 in double precision, the
+ *	   batch in single precision: the results differ by at most TRANSFORM_BATCH_TOLERANCE times the
+ *	   largest magnitude of the inputs of the sample (4 float ulps; 2.3e-7 measured by host/batch)
+ */
+
+#ifndef TRANSFORMBATCH_H_
+#define TRANSFORMBATCH_H_
+
+#include "simd.h"
+
+#include <stdint.h>
+
+#define TRANSFORM_BATCH_CHUNK		256				// Angles converted to cosines and sines at a time (multiple of SIMD_WIDTH)
+#define TRANSFORM_BATCH_TOLERANCE	5e-7f			// Deviation from the scalar routines, relative to the largest input
+
+
+/**
+ * Transformation from physical (abc) to stationary (ABG) reference frame, as abc2ABG
+ * @param *alpha, *beta, *gamma		the output arrays
+ * @param *a, *b, *c				the input arrays
+ * @param count						the number of samples
+ * @return void
+ */
+void abc2ABGBatch(float* alpha, float* beta, float* gamma, const float* a, const float* b, const float* c, uint32_t count);
+
+
+/**
+ * Transformation from stationary (ABG) to rotating (DQ0) reference frame, as ABG2DQ0
+ * @param *d, *q, *zero				the output arrays
+ * @param *alpha, *beta, *gamma		the input arrays
+ * @param *theta					the phase angles, one per sample
+ * @param count						the number of samples
+ * @return void
+ */
+void ABG2DQ0Batch(float* d, float* q, float* zero, const float* alpha, const float* beta, const float* gamma,
+		const float* theta, uint32_t count);
+
+
+/**
+ * Transformation from physical (abc) to rotating (DQ0) reference frame, as abc2DQ0
+ * @param *d, *q, *zero				the output arrays
+ * @param *a, *b, *c				the input arrays
+ * @param *theta					the phase angles, one per sample
+ * @param count						the number of samples
+ * @return void
+ */
+void abc2DQ0Batch(float* d, float* q, float* zero, const float* a, const float* b, const float* c,
+		const float* theta, uint32_t count);
+
+
+/**
+ * Transformation from rotating (DQ0) to physical (abc) reference frame, as DQ02abc
+ * @param *a, *b, *c				the output arrays
+ * @param *d, *q, *zero				the input arrays
+ * @param *theta					the phase angles, one per sample
+ * @param count						the number of samples
+ * @return void
+ */
+void DQ02abcBatch(float* a, float* b, float* c, const float* d, const float* q, const float* zero,
+		const float* theta, uint32_t count);
+
+#endif /* TRANSFORMBATCH_H_ */
@@ -0,0 +1,58 @@
+#include "adc_oversampling.h"
+
+
+void ConfigOversampledAdc(OversampledAdc* me, uint16_t burst_length, float gain, unsigned int sbo_burst, unsigned int sbi_sum,
+		unsigned int sbi_sequence)
+{
+	if (burst_length == 0){ burst_length = 1; }
+
+	me->sbi_sum = sbi_sum;
+	me->sbi_sequence = sbi_sequence;
+	me->burst_length = burst_length;
+	me->gain = gain;
+	me->gain_over_burst = gain / burst_length;
+	me->count = 0;
+	me->value = 0.0;
+	me->coherent = true;
+	me->retries = 0;
+	me->torn = 0;
+
+	Sbi_ConfigureAsRealTime(sbi_sum);			// Sum, LSBs
+	Sbi_ConfigureAsRealTime(sbi_sum + 1);		// Sum, MSBs
+	Sbi_ConfigureAsRealTime(sbi_sum + 2);		// Number of conversions summed
+	Sbi_ConfigureAsRealTime(sbi_sequence);		// Updated on the same clock as the sum
+	Sbo_WriteDirectly(sbo_burst, burst_length);
+}
+
+
+float ReadOversampledAdc(OversampledAdc* me)
+{
+	uint32_t sum = 0;
+	uint16_t count = 0;
+	uint16_t before = Sbi_Read(me->sbi_sequence);
+
+	// The sum is published at most once per sampling pulse: one retry reads the burst that ended meanwhile.
+	me->coherent = false;
+	for (int attempt = 0; attempt < 2 && !me->coherent; attempt++){
+		sum = (Sbi_Read(me->sbi_sum) & 0xFFFF) | ((Sbi_Read(me->sbi_sum + 1) & 0xFFFF) << 16);
+		count = Sbi_Read(me->sbi_sum + 2);
+		uint16_t after = Sbi_Read(me->sbi_sequence);
+		me->coherent = ((after ^ before) & ADC_SEQUENCE_MASK) == 0;
+		if (!me->coherent && attempt == 0){ me->retries++; }
+		before = after;
+	}
+	if (!me->coherent){
+		me->torn++;
+		return me->value;						// The sum may mix two bursts: keep the previous value
+	}
+	me->count = count;
+
+	if (me->count == me->burst_length){
+		me->value = sum * me->gain_over_burst;	// Nominal case: no division
+	}
+	else if (me->count > 0){
+		me->value = sum * me->gain / me->count;
+	}
+
+	return me->value;
+}
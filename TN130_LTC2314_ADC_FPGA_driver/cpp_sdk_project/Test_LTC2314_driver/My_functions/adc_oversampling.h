@@ -0,0 +1,62 @@
+#ifndef MY_FUNCTIONS_ADC_OVERSAMPLING_H_
+#define MY_FUNCTIONS_ADC_OVERSAMPLING_H_
+
+#include "Driver/peripherals.h"
+
+#include "sequenced_adc.h"				// ADC_SEQUENCE_MASK
+
+#include <stdint.h>
+
+
+/**
+ * Pseudo-object decimating the bursts of conversions accumulated by LT2314_driver.
+ * The FPGA performs burst_length back-to-back conversions per sampling pulse and exposes their sum
+ * (two 16-bit SBI registers) and their count (one SBI register). Averaging N conversions reduces the
+ * white noise by sqrt(N), i.e. adds log2(sqrt(N)) effective bits, without raising the interrupt rate.
+ * A burst takes burst_length * 17 SCK periods (272 ns at 62.5 MHz) and must complete before the
+ * registers are read, i.e. within the interrupt phase (25 us at 20 kHz / 0.5): burst_length <= 90.
+ * The three registers are read one after the other: sequence_out, which the FPGA updates on the same clock
+ * as the sum and the count, is read before and after them, and the read is repeated if it changed.
+ */
+typedef struct{
+	unsigned int sbi_sum;		// SBI address of the sum LSBs (MSBs at sbi_sum+1, count at sbi_sum+2)
+	unsigned int sbi_sequence;	// SBI address of sequence_out
+	uint16_t burst_length;		// Conversions per sampling pulse (as configured in the FPGA)
+	float gain;					// Conversion factor from ADC code to engineering unit
+	float gain_over_burst;		// Offline-computed gain/burst_length
+	uint16_t count;				// Number of conversions in the last burst read
+	float value;				// Last decimated value (engineering unit)
+	bool coherent;				// The last read returned a sum and a count of the same burst
+	uint32_t retries;			// Reads repeated because a conversion completed in between
+	uint32_t torn;				// Reads still incoherent after the retry (previous value returned)
+} OversampledAdc;
+
+
+/**
+ * Routine to configure the burst mode in the FPGA and the corresponding decimator.
+ * Must be called in UserInit()
+ * @param *me			the decimator pseudo-object
+ * @param burst_length	conversions per sampling pulse (1 = oversampling disabled)
+ * @param gain			conversion factor from ADC code to engineering unit (e.g. 4.096/8192 V/LSB)
+ * @param sbo_burst		SBO register connected to burst_length_in
+ * @param sbi_sum		first of the three consecutive SBI registers (sum LSBs, sum MSBs, count)
+ * @param sbi_sequence	SBI register connected to sequence_out
+ * @return void
+ */
+void ConfigOversampledAdc(OversampledAdc* me, uint16_t burst_length, float gain, unsigned int sbo_burst, unsigned int sbi_sum,
+		unsigned int sbi_sequence);
+
+
+/**
+ * Routine to read the last burst and return its average, scaled to the engineering unit.
+ * When the FPGA reports an incomplete burst, the actual count is used; when it reports none,
+ * the previous value is returned. The sum and the count are published once per burst, i.e. at most
+ * once per sampling pulse, a full sampling period apart: if a burst ends during the read, the retry
+ * reads the new one. A second change means that the reads overlap the conversions (pulse too close to
+ * the interrupt, or burst too long): the previous value is returned, coherent is cleared and torn counted.
+ * @param *me			the decimator pseudo-object
+ * @return				the averaged measurement
+ */
+float ReadOversampledAdc(OversampledAdc* me);
+
+#endif /* MY_FUNCTIONS_ADC_OVERSAMPLING_H_ */
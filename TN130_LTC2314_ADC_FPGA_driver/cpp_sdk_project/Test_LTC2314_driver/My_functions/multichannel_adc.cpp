@@ -0,0 +1,44 @@
+#include "multichannel_adc.h"
+
+
+int ConfigMultiChannelAdc(MultiChannelAdc* me, uint16_t channels, unsigned int sbi_data)
+{
+	if (channels == 0 || channels > MULTICHANNEL_ADC_MAX_CHANNELS){ return -1; }
+
+	me->sbi_data = sbi_data;
+	me->channels = channels;
+	me->frame = 0;
+	me->coherent = false;
+	me->retries = 0;
+	me->torn = 0;
+
+	for (uint16_t k = 0; k <= channels; k++){
+		Sbi_ConfigureAsRealTime(sbi_data + k);		// Channels, then frame number
+	}
+	return 0;
+}
+
+
+uint16_t ReadAdcFrame(MultiChannelAdc* me, uint16_t* frame)
+{
+	unsigned int sbi_frame = me->sbi_data + me->channels;
+	uint16_t before = Sbi_Read(sbi_frame);
+	uint16_t after = before;
+
+	// Single frames are latched a sampling period apart: one retry reads the one latched meanwhile.
+	// Within a burst they are 17 SCK periods apart, possibly during the retry too: reported.
+	me->coherent = false;
+	for (int attempt = 0; attempt < 2 && !me->coherent; attempt++){
+		for (uint16_t k = 0; k < me->channels; k++){
+			frame[k] = Sbi_Read(me->sbi_data + k);
+		}
+		after = Sbi_Read(sbi_frame);
+		me->coherent = ((after ^ before) & ADC_SEQUENCE_MASK) == 0;
+		if (!me->coherent && attempt == 0){ me->retries++; }
+		before = after;
+	}
+	if (!me->coherent){ me->torn++; }
+
+	me->frame = after & ADC_SEQUENCE_MASK;
+	return me->frame;
+}
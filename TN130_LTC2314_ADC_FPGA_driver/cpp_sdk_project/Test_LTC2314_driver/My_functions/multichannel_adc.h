@@ -0,0 +1,57 @@
+#ifndef MY_FUNCTIONS_MULTICHANNEL_ADC_H_
+#define MY_FUNCTIONS_MULTICHANNEL_ADC_H_
+
+#include "Driver/peripherals.h"
+
+#include "sequenced_adc.h"				// ADC_SEQUENCE_MASK
+
+#include <stdint.h>
+
+#define MULTICHANNEL_ADC_MAX_CHANNELS 16
+
+
+/**
+ * Pseudo-object reading the frames of LT2314_multi_driver: up to 16 LTC2314 converted together on a
+ * shared SCK / CS, the same conversion time as a single ADC. The FPGA latches all the channels and
+ * the frame number on the same clock; they are mapped to consecutive SBI registers (channel k at
+ * sbi_data + k, sequence_out right after the last channel: frame number in bits 14..0, valid bit 15).
+ * The frame can be converted directly, e.g. with a SensorRegistry whose addresses are sbi_data + k:
+ *
+ *		ReadAdcFrame(&adc, raw);								// In UserInterrupt
+ *		ConvertSensors(sensors, raw, value);
+ */
+typedef struct{
+	unsigned int sbi_data;		// SBI address of channel 0
+	uint16_t channels;			// Number of channels (CHANNELS generic of the FPGA driver)
+	uint16_t frame;				// Number of the last frame read
+	bool coherent;				// The last read returned the channels of a single frame
+	uint32_t retries;			// Frames re-read because a new frame was latched during the read
+	uint32_t torn;				// Reads still mixing two frames after the retry (coherent cleared)
+} MultiChannelAdc;
+
+
+/**
+ * Routine to configure the SBI registers of the frame.
+ * Must be called in UserInit()
+ * @param *me			the reader pseudo-object
+ * @param channels		number of channels (at most MULTICHANNEL_ADC_MAX_CHANNELS)
+ * @param sbi_data		first of the channels+1 consecutive SBI registers (channels, then frame number)
+ * @return				0 on success, -1 if there are too many channels
+ */
+int ConfigMultiChannelAdc(MultiChannelAdc* me, uint16_t channels, unsigned int sbi_data);
+
+
+/**
+ * Routine to read a whole frame in one call. The frame number is read before and after the channels:
+ * if the FPGA latched a new frame in between, the channels are read again (once). Without burst, one
+ * frame per sampling pulse, the next one is latched a full sampling period later, so the retry reads a
+ * single frame. In a burst, frames are latched 17 SCK periods apart (136 ns at 125 MHz), less than the
+ * channels+2 reads: the retry may be torn too. The buffer may then mix two frames: me->coherent is
+ * cleared and torn counted, and the caller should discard it.
+ * @param *me			the reader pseudo-object
+ * @param *frame		the raw values of all the channels, in channel order (me->channels entries)
+ * @return				the frame number (incremented by the FPGA on every conversion, 15 bits, wraps around)
+ */
+uint16_t ReadAdcFrame(MultiChannelAdc* me, uint16_t* frame);
+
+#endif /* MY_FUNCTIONS_MULTICHANNEL_ADC_H_ */
@@ -0,0 +1,55 @@
+#include "sequenced_adc.h"
+
+
+void ConfigSequencedAdc(SequencedAdc* me, unsigned int sbi_data, unsigned int sbi_sequence, uint16_t conversions)
+{
+	if (conversions == 0){ conversions = 1; }
+
+	me->sbi_data = sbi_data;
+	me->sbi_sequence = sbi_sequence;
+	me->conversions = conversions;
+	me->sequence = 0;
+	me->started = false;
+	me->stale = 0;
+	me->dropped = 0;
+	me->pending = 0;
+	me->retries = 0;
+	me->torn = 0;
+
+	Sbi_ConfigureAsRealTime(sbi_data);
+	Sbi_ConfigureAsRealTime(sbi_sequence);
+}
+
+
+AdcSample ReadAdcSample(SequencedAdc* me)
+{
+	AdcSample out;
+	uint16_t before = Sbi_Read(me->sbi_sequence);
+	uint16_t after = before;
+
+	// Single conversions complete a sampling period apart: one retry reads the one completed meanwhile.
+	// Within a burst they complete 17 SCK periods apart, possibly during the retry too: reported.
+	out.coherent = false;
+	for (int attempt = 0; attempt < 2 && !out.coherent; attempt++){
+		out.sample = Sbi_Read(me->sbi_data);
+		after = Sbi_Read(me->sbi_sequence);
+		out.coherent = ((after ^ before) & ADC_SEQUENCE_MASK) == 0;
+		if (!out.coherent && attempt == 0){ me->retries++; }
+		before = after;
+	}
+	if (!out.coherent){ me->torn++; }
+
+	out.sequence = after & ADC_SEQUENCE_MASK;
+	uint16_t delta = (out.sequence - me->sequence) & ADC_SEQUENCE_MASK;
+	out.is_new = delta != 0 || !me->started;
+
+	if (me->started){
+		if (delta == 0){ me->stale++; }
+		else if (delta > me->conversions){ me->dropped += delta - me->conversions; }
+	}
+	if (!(after & ADC_SEQUENCE_VALID)){ me->pending++; }
+
+	me->sequence = out.sequence;
+	me->started = true;
+	return out;
+}
@@ -0,0 +1,70 @@
+#ifndef MY_FUNCTIONS_SEQUENCED_ADC_H_
+#define MY_FUNCTIONS_SEQUENCED_ADC_H_
+
+#include "Driver/peripherals.h"
+
+#include <stdint.h>
+
+#define ADC_SEQUENCE_MASK	0x7FFF		// sequence_out bits 14..0: conversions completed
+#define ADC_SEQUENCE_VALID	0x8000		// sequence_out bit 15: the conversions of the last sampling pulse are done
+
+
+/**
+ * One conversion of LT2314_driver with its sequence number
+ */
+typedef struct{
+	uint16_t sample;			// Raw value (data_out)
+	uint16_t sequence;			// Number of the conversion (15 bits, wraps around)
+	bool is_new;				// The conversion was not returned by the previous read
+	bool coherent;				// sample is the conversion numbered sequence (else one completed before it)
+} AdcSample;
+
+
+/**
+ * Pseudo-object reading data_out of LT2314_driver together with sequence_out, which the FPGA updates
+ * on the same clock. Comparing the sequence with the previous read tells a fresh conversion from a
+ * stale one without any extra work in the interrupt, and counts the anomalies:
+ *  - stale: no new conversion since the previous read (missed sampling pulse, or read too early)
+ *  - dropped: more conversions than expected since the previous read (e.g. a missed interrupt)
+ *  - pending: the conversions triggered by the last sampling pulse were not complete at read time
+ */
+typedef struct{
+	unsigned int sbi_data;		// SBI address of data_out
+	unsigned int sbi_sequence;	// SBI address of sequence_out
+	uint16_t conversions;		// Conversions expected between two reads (burst length, 1 without oversampling)
+	uint16_t sequence;			// Sequence number of the last read
+	bool started;				// At least one read
+	uint32_t stale;
+	uint32_t dropped;			// Conversions never read
+	uint32_t pending;
+	uint32_t retries;			// Reads repeated because a conversion completed in between
+	uint32_t torn;				// Reads still unpaired after the retry (coherent cleared)
+} SequencedAdc;
+
+
+/**
+ * Routine to configure the SBI registers and the expected rate of conversions.
+ * Must be called in UserInit()
+ * @param *me			the reader pseudo-object
+ * @param sbi_data		SBI register connected to data_out
+ * @param sbi_sequence	SBI register connected to sequence_out
+ * @param conversions	conversions per read, i.e. per sampling pulse (burst length, 1 without oversampling)
+ * @return void
+ */
+void ConfigSequencedAdc(SequencedAdc* me, unsigned int sbi_data, unsigned int sbi_sequence, uint16_t conversions);
+
+
+/**
+ * Routine to read the last conversion with its sequence number, to be called once per interrupt.
+ * The sequence is read before and after the data: if a conversion completed in between, the data is
+ * read again (once). One conversion per sampling pulse completes a full sampling period after the
+ * previous one, so the retry reads it whole. In a burst, the conversions are only 17 SCK periods apart
+ * (136 ns at 125 MHz), less than the reads: the retry may see another one complete. The sample is then
+ * one of the conversions up to the sequence number returned, but not necessarily that one: coherent is
+ * cleared and torn counted, so that a sample is never silently paired with the number of another.
+ * @param *me			the reader pseudo-object
+ * @return				the raw value, its sequence number and whether it is a new conversion
+ */
+AdcSample ReadAdcSample(SequencedAdc* me);
+
+#endif /* MY_FUNCTIONS_SEQUENCED_ADC_H_ */
@@ -0,0 +1,160 @@
+#include "spi_calibration.h"
+
+#define CLK_250_PERIOD	4e-9		// LT2314_driver clock (clk_250)
+
+
+float SpiConversionLatency(uint16_t postscaler, uint16_t burst_length)
+{
+	float sck_half_periods = postscaler > 1 ? postscaler : 1;
+	float conversions = burst_length > 1 ? burst_length : 1;
+	return (34 * conversions * sck_half_periods + 2) * CLK_250_PERIOD;
+}
+
+
+static void StartSetting(SpiCalibration* me, uint16_t postscaler, bool repeat = false)
+{
+	me->postscaler = postscaler;
+	me->repeat = repeat;
+	me->settle = SPI_CAL_SETTLE;
+	me->idle = 0;
+	me->count = 0;
+	Sbo_WriteDirectly(me->sbo_postscaler, postscaler);
+}
+
+
+static void Finish(SpiCalibration* me, tSpiCalibrationState state, uint16_t postscaler)
+{
+	me->state = state;
+	me->postscaler = postscaler;
+	Sbo_WriteDirectly(me->sbo_postscaler, postscaler);
+}
+
+
+void ConfigSpiCalibration(SpiCalibration* me, unsigned int sbo_postscaler, uint16_t burst_length, uint16_t slowest,
+		uint16_t fastest, uint16_t tolerance, uint16_t margin, int32_t expected)
+{
+	if (fastest < 1){ fastest = 1; }											// 0 and 1 give the same SCK
+	if (slowest < fastest){ slowest = fastest; }
+	if (slowest - fastest >= SPI_CAL_MAX_SETTINGS){ fastest = slowest - SPI_CAL_MAX_SETTINGS + 1; }
+
+	me->sbo_postscaler = sbo_postscaler;
+	me->burst_length = burst_length;
+	me->slowest = slowest;
+	me->fastest = fastest;
+	me->tolerance = tolerance;
+	me->margin = margin;
+	me->expected = expected;
+
+	me->state = SPI_CAL_RUNNING;
+	me->reference = expected;
+	me->threshold = tolerance;
+	me->tested = 0;
+	me->repeats = 0;
+	me->drift = 0;
+	StartSetting(me, slowest);
+}
+
+
+// Statistics of the conversions collected for the setting under test, compared with the reference
+static bool EvaluateSetting(SpiCalibration* me)
+{
+	SpiSetting* s = &me->settings[me->tested++];
+	uint32_t sum = 0;
+	uint16_t min = 0xFFFF, max = 0;
+
+	for (int k = 0; k < SPI_CAL_SAMPLES; k++){
+		uint16_t x = me->samples[k];
+		sum += x;
+		if (x < min){ min = x; }
+		if (x > max){ max = x; }
+	}
+	s->postscaler = me->postscaler;
+	s->sck = 1.0f / (2 * CLK_250_PERIOD * (me->postscaler > 1 ? me->postscaler : 1));
+	s->latency = SpiConversionLatency(me->postscaler, me->burst_length);
+	s->mean = (float)sum / SPI_CAL_SAMPLES;
+	s->min = min;
+	s->max = max;
+
+	// The slowest setting defines the reference when the input is unknown
+	if (me->expected < 0 && me->tested == 1){
+		me->reference = s->mean;
+		me->threshold = me->tolerance + (max - min);
+	}
+
+	s->errors = 0;
+	for (int k = 0; k < SPI_CAL_SAMPLES; k++){
+		float deviation = me->samples[k] - me->reference;
+		if (deviation > me->threshold || deviation < -me->threshold){ s->errors++; }
+	}
+	s->passed = s->errors == 0;
+	return s->passed;
+}
+
+
+// Repeat of the slowest setting: the input must not have moved since the reference was taken
+static bool EvaluateRepeat(SpiCalibration* me)
+{
+	uint32_t sum = 0;
+	for (int k = 0; k < SPI_CAL_SAMPLES; k++){
+		float deviation = me->samples[k] - me->reference;
+		if (deviation > me->threshold || deviation < -me->threshold){ return false; }
+		sum += me->samples[k];
+	}
+	float drift = (float)sum / SPI_CAL_SAMPLES - me->reference;
+	if (drift < 0){ drift = -drift; }
+	if (drift > me->drift){ me->drift = drift; }
+	me->repeats++;
+	return drift <= me->tolerance;
+}
+
+
+// Next step of the sweep after the last setting in settings[]
+static void Conclude(SpiCalibration* me)
+{
+	const SpiSetting* last = &me->settings[me->tested - 1];
+	if (!last->passed){
+		if (me->tested == 1){ Finish(me, SPI_CAL_FAILED, me->slowest); }
+		else{
+			uint16_t fastest_passed = last->postscaler + 1;
+			uint16_t chosen = fastest_passed + me->margin;
+			Finish(me, SPI_CAL_DONE, chosen < me->slowest ? chosen : me->slowest);
+		}
+	}
+	else if (last->postscaler <= me->fastest){
+		uint16_t chosen = last->postscaler + me->margin;
+		Finish(me, SPI_CAL_DONE, chosen < me->slowest ? chosen : me->slowest);
+	}
+	else{
+		StartSetting(me, last->postscaler - 1);
+	}
+}
+
+
+bool RunSpiCalibration(SpiCalibration* me, AdcSample sample)
+{
+	if (me->state != SPI_CAL_RUNNING){ return true; }
+
+	if (!sample.is_new){
+		if (++me->idle >= SPI_CAL_TIMEOUT){ Finish(me, SPI_CAL_FAILED, me->slowest); }	// No conversion at all
+		return me->state != SPI_CAL_RUNNING;
+	}
+	me->idle = 0;
+	if (me->settle > 0){														// Converted (partly) with the previous SCK
+		me->settle--;
+		return false;
+	}
+
+	me->samples[me->count++] = sample.sample;
+	if (me->count < SPI_CAL_SAMPLES){ return false; }
+
+	if (me->repeat){
+		if (!EvaluateRepeat(me)){ Finish(me, SPI_CAL_UNSTEADY, me->slowest); }				// The reference is not valid
+		else{ Conclude(me); }
+	}
+	else{
+		EvaluateSetting(me);
+		if (me->expected < 0){ StartSetting(me, me->slowest, true); }					// Conclude once the input is confirmed
+		else{ Conclude(me); }
+	}
+	return me->state != SPI_CAL_RUNNING;
+}
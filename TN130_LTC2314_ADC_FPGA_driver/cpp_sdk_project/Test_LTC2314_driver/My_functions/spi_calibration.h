@@ -0,0 +1,118 @@
+#ifndef MY_FUNCTIONS_SPI_CALIBRATION_H_
+#define MY_FUNCTIONS_SPI_CALIBRATION_H_
+
+#include "Driver/peripherals.h"
+
+#include "sequenced_adc.h"
+
+#include <stdint.h>
+
+#define SPI_CAL_MAX_SETTINGS	16			// Postscalers swept at most
+#define SPI_CAL_SAMPLES			64			// New conversions compared per setting
+#define SPI_CAL_SETTLE			2			// New conversions discarded after a change (burst in flight)
+#define SPI_CAL_TIMEOUT			256			// Interrupts without a new conversion before giving up
+
+
+/**
+ * Result of the calibration for one postscaler
+ */
+typedef struct{
+	uint16_t postscaler;		// postscaler_in
+	float sck;					// SPI clock, in Hz
+	float latency;				// Worst case from the sampling pulse to the burst published by the FPGA, in s
+	float mean;					// Mean of the conversions read
+	uint16_t min;
+	uint16_t max;
+	uint16_t errors;			// Conversions off the reference by more than the tolerance
+	bool passed;
+} SpiSetting;
+
+typedef enum{
+	SPI_CAL_RUNNING = 0,
+	SPI_CAL_DONE,				// postscaler: the fastest passing one, plus the margin
+	SPI_CAL_FAILED,				// The slowest setting failed too, or no conversion: postscaler is the slowest
+	SPI_CAL_UNSTEADY			// No known input and it moved during the sweep: postscaler is the slowest
+} tSpiCalibrationState;
+
+
+/**
+ * Pseudo-object choosing the SPI clock of LT2314_driver (SBO postscaler_in, spi_sck = 125 MHz / postscaler)
+ * at start-up. SDO is sampled by the FPGA on the rising edge of SCK after it was changed by the ADC on the
+ * falling edge: past the fastest SCK allowed by the propagation delay (ADC output delay, cable, input
+ * buffer), the bits are read one period late and the codes come out shifted.
+ * The postscalers are swept from the slowest, one per SPI_CAL_SAMPLES new conversions, and the readings
+ * compared to a reference:
+ *  - a known input (e.g. a reference voltage on the channel): every reading within the tolerance of it
+ *  - otherwise the slowest setting, assumed reliable: every reading within the tolerance plus the noise
+ *    band (max - min) seen at the slowest setting, of the mean at the slowest setting. This only holds
+ *    for a steady input: the slowest setting is read again after the reference and after every faster
+ *    setting, and the sweep ends UNSTEADY as soon as one of these repeats leaves the band or its mean
+ *    is off the reference by more than the tolerance (e.g. an AC input)
+ * The sweep stops at the first failing setting; the chosen postscaler keeps 'margin' settings between
+ * itself and the fastest passing one (component spread, temperature drift).
+ * A faster SCK shortens the burst, hence the latency from the sampling pulse to the data (in settings[]).
+ */
+typedef struct{
+	unsigned int sbo_postscaler;	// SBO address of postscaler_in
+	uint16_t burst_length;			// Conversions per sampling pulse (for the latencies)
+	uint16_t slowest;				// Sweep range, postscalers
+	uint16_t fastest;
+	uint16_t tolerance;				// Codes
+	uint16_t margin;				// Settings
+	int32_t expected;				// Known input code, < 0 if none
+
+	tSpiCalibrationState state;
+	uint16_t postscaler;			// Setting under test, then chosen
+	uint16_t settle;				// New conversions still to discard
+	uint16_t idle;					// Interrupts since the last new conversion
+	uint16_t count;					// Conversions collected for this setting
+	bool repeat;					// The setting under test is a repeat of the slowest one (unknown input)
+	uint16_t samples[SPI_CAL_SAMPLES];
+	float reference;				// Expected code, or mean at the slowest setting
+	uint16_t threshold;				// Tolerance, plus the noise band at the slowest setting
+	uint16_t tested;				// Settings in settings[]
+	uint16_t repeats;				// Repeats of the slowest setting passed
+	float drift;					// Largest deviation of their means from the reference, in codes
+	SpiSetting settings[SPI_CAL_MAX_SETTINGS];
+} SpiCalibration;
+
+
+/**
+ * Routine to start the calibration: writes the slowest postscaler.
+ * Must be called in UserInit()
+ * @param *me				the calibration pseudo-object
+ * @param sbo_postscaler	SBO register connected to postscaler_in
+ * @param burst_length		conversions per sampling pulse (as configured in the FPGA)
+ * @param slowest			postscaler assumed reliable (e.g. 8: SCK = 15.6 MHz)
+ * @param fastest			fastest postscaler tried (1: SCK = 125 MHz)
+ * @param tolerance			deviation allowed from the reference, in codes
+ * @param margin			settings kept above the fastest passing one
+ * @param expected			code of the known input, -1 to compare with the slowest setting
+ * @return void
+ */
+void ConfigSpiCalibration(SpiCalibration* me, unsigned int sbo_postscaler, uint16_t burst_length, uint16_t slowest,
+		uint16_t fastest, uint16_t tolerance, uint16_t margin, int32_t expected = -1);
+
+
+/**
+ * Routine to feed the calibration with the conversion read by the interrupt, to be called once per
+ * interrupt until it returns true. The conversions read before are not reliable.
+ * When done, the chosen postscaler is written and its results are in settings[].
+ * @param *me				the calibration pseudo-object
+ * @param sample			the conversion read by ReadAdcSample in this interrupt
+ * @return					true when the calibration is over (DONE, FAILED or UNSTEADY)
+ */
+bool RunSpiCalibration(SpiCalibration* me, AdcSample sample);
+
+
+/**
+ * Routine to compute the worst-case latency of LT2314_driver from the sampling pulse to the publication
+ * of the last conversion of the burst: 17 SCK periods per conversion (the wait for the first SCK rising
+ * edge included) and 2 clocks of 4 ns to latch.
+ * @param postscaler		postscaler_in (0 and 1: SCK = 125 MHz)
+ * @param burst_length		conversions per sampling pulse
+ * @return					the latency, in s
+ */
+float SpiConversionLatency(uint16_t postscaler, uint16_t burst_length);
+
+#endif /* MY_FUNCTIONS_SPI_CALIBRATION_H_ */
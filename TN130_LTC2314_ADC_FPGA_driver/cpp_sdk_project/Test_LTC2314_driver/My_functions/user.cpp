@@ -1,9 +1,144 @@
 #include "user.h"
 
-#define ADC_GAIN (4.096/8192.0)
+#define ADC_BURST_LENGTH 1      // conversions per sampling pulse: 1 = burst mode off (e.g. 16 for +2 effective bits in Vavg)
+#ifndef INTERRUPT_TRACE
+#define INTERRUPT_TRACE 0       // 1: record the inputs and outputs of UserInterrupt for the host replayer (host/replay)
+#endif
+#ifndef ADC_HARMONICS
+#define ADC_HARMONICS 0         // 1: AC input on SBI_reg_00, its harmonics analyzed into adc_spectrum
+#endif
+#define ADC_AC_OFFSET 2.048     // AC input: mid-scale offset of the front end, in Volts
+#define ADC_AC_PEAK 1.0         // AC input: amplitude of the fundamental, in Volts (scales the PLL gains)
+#define ADC_AC_FREQUENCY 50.0   // AC input: nominal frequency, in Hz
+#define TRACE_BUFFER_SIZE (1 << 20) // interrupt trace, ~12 bytes per interrupt with a noisy ADC
+#define INTERRUPT_FREQUENCY 20e3
+
+/**
+ * Measured channels, converted all at once by ReadSensors (add new sensors here)
+ */
+#define SENSOR_COUNT 1
+static constexpr SensorChannel sensor_channels[SENSOR_COUNT] = {
+	MakeSensorChannel(0, LTC2314_ADC, ADCONV),  // SBI_reg_00: LT2314_driver data_out, in Volts
+};
+static constexpr SensorRegistry<SENSOR_COUNT> sensors(sensor_channels);
+
+uint16_t sensor_raw[SENSOR_COUNT];
+float sensor_value[SENSOR_COUNT];
+
+/**
+ * Temperature sensor on SBI_reg_00: 10k NTC (B ~ 3950) below a 10k resistor supplied by 4.096 V
+ */
+static constexpr ThermalSensor ntc = NtcDivider(LTC2314_ADCONV, 4.096, 10e3,
+		1.009249522e-3, 2.378405444e-4, 2.019202697e-7, -40.0, 125.0);
+static constexpr TemperatureTable<10> ntc_table(ntc);   // 1025 entries, 0.012 degC max. interpolation error
 
 unsigned int adc_raw;
 float Vmeas;
+float Tmeas;                    // degC
+float Vavg;                     // average of the last ADC burst (same as Vmeas with the burst mode off)
+OversampledAdc adc_avg;
+SequencedAdc adc_sequence;      // data_out with its conversion number, to skip stale samples
+AdcSample adc_sample;
+SpiCalibration spi_calibration; // SCK chosen at start-up, results per postscaler in spi_calibration.settings (not with ADC_HARMONICS)
+
+ControlContext control;         // Core state latch shared by all the controllers
+RateScheduler scheduler;        // Tasks slower than UserInterrupt (add new groups and tasks in UserInit)
+int group_2khz;
+int group_100hz;
+
+uint32_t tick;                  // Interrupt counter
+SampleBuffer adc_capture;       // ADC history, filled by UserInterrupt, drained by ProcessAdcCapture
+Sample adc_block[256];          // Last block drained from adc_capture
+
+/**
+ * Statistics of the ADC samples drained by the last ProcessAdcCapture (for the Cockpit)
+ */
+typedef struct{
+	uint32_t count;             // New samples drained
+	uint16_t min;
+	uint16_t max;
+	float mean;
+	uint32_t gaps;              // Interrupts without a new sample between two drained samples (stale conversions)
+	uint32_t overruns;          // Samples dropped since UserInit because adc_capture was full
+} AdcCaptureStats;
+AdcCaptureStats adc_capture_stats;
+uint32_t adc_capture_last_tick;
+
+/**
+ * Stages of UserInterrupt timed by the profiler (add new stages here)
+ */
+typedef enum{
+	STAGE_TOTAL = 0,
+	STAGE_SENSORS,                  // SBI reads and conversion of all the channels (and harmonic analysis)
+	STAGE_SCHEDULED,                // Slow tasks run by the rate scheduler on this tick
+	STAGE_OVERSAMPLING,
+	STAGE_CAPTURE,                  // Sample buffer
+	STAGE_COUNT
+} tProfileStage;
+static const char* const stage_names[STAGE_COUNT] = {"total", "sensors", "scheduled", "oversampling", "capture"};
+
+InterruptProfiler profiler;
+ProfileStats profile_stats[STAGE_COUNT]; // Exported by UpdateInterruptProfile, for the Cockpit
+RateGroupStats rate_group_stats[SCHEDULER_MAX_GROUPS]; // Budget accounting of the rate groups, idem
+
+#if ADC_HARMONICS
+/**
+ * Spectrum of an AC input on SBI_reg_00 (e.g. a grid voltage through an isolation amplifier), one period
+ * of the fundamental at a time, locked to a single-phase PLL on the same samples
+ */
+static const uint16_t harmonic_orders[] = {0, 1, 2, 3, 5, 7, 11, 13}; // 0: mean value (offset of the front end)
+SOGIPLL1Parameters adc_pll;
+SpaceVector adc_uabg;           // SOGI outputs of the PLL
+HarmonicAnalyzer adc_harmonics;
+HarmonicAnalysis adc_spectrum;  // last complete period, refreshed at 100 Hz by the task "harmonics"
+#endif
+
+#if INTERRUPT_TRACE
+uint8_t trace_buffer[TRACE_BUFFER_SIZE];
+InterruptRecorder trace_recorder; // Inputs and outputs of UserInterrupt, for the host replayer (host/replay)
+#endif
+
+/**
+ * Slow tasks (run by the rate scheduler)
+ */
+static void ConvertTemperatureTask(void* context)
+{
+	Tmeas = ConvertTemperature(ntc_table, sensor_raw[0]);
+}
+
+static void ProcessAdcCaptureTask(void* context)
+{
+	ProcessAdcCapture();
+}
+
+#if ADC_HARMONICS
+static void UpdateHarmonicsTask(void* context)
+{
+	GetHarmonicAnalysis(&adc_harmonics, &adc_spectrum);
+}
+#endif
+
+/**
+ * Export of one profiled stage, or of the rate groups, into profile_stats / rate_group_stats
+ */
+static void ExportProfileEntry(uint8_t entry)
+{
+	if (entry < STAGE_COUNT){
+		GetProfileStats(&profiler, entry, &profile_stats[entry]);
+	}
+	else{
+		for (uint8_t group = 0; group < scheduler.groups; group++){
+			GetRateGroupStats(&scheduler, group, &rate_group_stats[group]);
+		}
+	}
+}
+
+static void UpdateInterruptProfileTask(void* context)
+{
+	static uint8_t entry = 0;   // one histogram per run: all refreshed every (STAGE_COUNT + 1) * 10 ms
+	ExportProfileEntry(entry);
+	entry = entry < STAGE_COUNT ? entry + 1 : 0;
+}
 
 /**
  * Initialization routine executed only once, before the first call of the main interrupt
@@ -12,12 +147,54 @@ float Vmeas;
 tUserSafe UserInit(void)
 {
 
-	Clock_SetFrequency(CLOCK_0, 20e3);
+	Clock_SetFrequency(CLOCK_0, INTERRUPT_FREQUENCY);
 	ConfigureMainInterrupt(UserInterrupt, CLOCK_0, 0.5);
 
 	Sbi_ConfigureAsRealTime(0); // SBI_reg_00 contains the ADC value (LT2314_driver data_out)
-	Sbo_WriteDirectly(0, 2);    // SBO_reg_00 is the clk postscaler (LT2314_driver postscaler_in)
-	                              // postscaler = 2 -> SCK = 62.5 MHz
+#if ADC_HARMONICS
+	Sbo_WriteDirectly(0, 8);      // SBO_reg_00 is the clk postscaler: SCK = 15.6 MHz, the calibration needs a steady input
+#else
+	ConfigSpiCalibration(&spi_calibration, 0, ADC_BURST_LENGTH, 8, 1, 4, 1); // SBO_reg_00 is the clk postscaler (LT2314_driver postscaler_in)
+	                              // swept from 8 (SCK = 15.6 MHz) to 1 (125 MHz), then the fastest reliable one + 1
+#endif
+	ConfigOversampledAdc(&adc_avg, ADC_BURST_LENGTH, sensors.gain[0], 1, 1, 4); // SBO_reg_01 = burst length, SBI_reg_01..03 = sum and count
+	ConfigSequencedAdc(&adc_sequence, 0, 4, ADC_BURST_LENGTH); // SBI_reg_04 = sequence_out (data_out advances by one burst per pulse)
+
+	ConfigControlContext(&control); // Register the controllers here (RegisterPIDController, ...)
+	ConfigSampleBuffer(&adc_capture);
+	tick = 0;
+	adc_capture_last_tick = tick - 1;  // no gap before the first sample
+
+#if ADC_HARMONICS
+	ConfigSOGIPLL1(&adc_pll, 44.0 / ADC_AC_PEAK, 31.25*31.25 / INTERRUPT_FREQUENCY / ADC_AC_PEAK, 1.41,
+			2*M_PI*ADC_AC_FREQUENCY, 1.0 / INTERRUPT_FREQUENCY); // ~7 Hz crossover: the harmonics barely modulate the angle
+	ConfigHarmonicAnalyzer(&adc_harmonics, harmonic_orders, sizeof(harmonic_orders)/sizeof(harmonic_orders[0]),
+			1.0 / INTERRUPT_FREQUENCY);
+#endif
+
+	ConfigInterruptProfiler(&profiler, stage_names, STAGE_COUNT, 1.0 / INTERRUPT_FREQUENCY);
+
+	ConfigRateScheduler(&scheduler, INTERRUPT_FREQUENCY);
+	group_2khz = AddRateGroup(&scheduler, "2 kHz", 2e3, 2e-6); // 2 us per tick at most
+	AddScheduledTask(&scheduler, group_2khz, "temperature", ConvertTemperatureTask, NULL, 1.0);
+	group_100hz = AddRateGroup(&scheduler, "100 Hz", 100, 5e-6); // consumers of the interrupt data (200 interrupts per run)
+	AddScheduledTask(&scheduler, group_100hz, "capture", ProcessAdcCaptureTask, NULL, 2.0);
+	AddScheduledTask(&scheduler, group_100hz, "profile", UpdateInterruptProfileTask, NULL, 3.0); // staggered: never on the capture tick
+#if ADC_HARMONICS
+	AddScheduledTask(&scheduler, group_100hz, "harmonics", UpdateHarmonicsTask, NULL, 2.0); // spectrum of the last period into adc_spectrum
+#endif
+	StartRateScheduler(&scheduler); // staggers the phases, after the last AddScheduledTask
+
+#if INTERRUPT_TRACE
+	ConfigInterruptRecorder(&trace_recorder, trace_buffer, sizeof(trace_buffer));
+	for (uint16_t address = 0; address <= 4; address++){
+		AddRecorderInput(&trace_recorder, address); // data_out, burst sum (low, high), count and sequence
+	}
+	AddRecorderOutput(&trace_recorder, "adc_raw", &adc_raw);
+	AddRecorderOutput(&trace_recorder, "Vmeas", &Vmeas);
+	AddRecorderOutput(&trace_recorder, "Tmeas", &Tmeas);
+	AddRecorderOutput(&trace_recorder, "Vavg", &Vavg);
+#endif
 
 	return SAFE;
 }
@@ -27,12 +204,98 @@ tUserSafe UserInit(void)
  */
 tUserSafe UserInterrupt(void)
 {
-	adc_raw = Sbi_Read(0);      // read SBI_reg_00
-	Vmeas = adc_raw * ADC_GAIN; // convert to Volts
+	ProfileScope total(&profiler, STAGE_TOTAL); // recorded when the routine returns
+#if INTERRUPT_TRACE
+	RecordInterruptInputs(&trace_recorder, tick); // everything read below, stops when the buffer is full
+#endif
+	UpdateControlContext(&control); // Sample the core state once for all the controllers
+
+	{
+		ProfileScope stage(&profiler, STAGE_SENSORS);
+		adc_sample = ReadAdcSample(&adc_sequence); // SBI channel 0 with its sequence number (ReadSensors for the others)
+#if !ADC_HARMONICS
+		if (!RunSpiCalibration(&spi_calibration, adc_sample)){
+			adc_sample.is_new = false; // not reliable until the SPI clock is chosen (~55 ms)
+		}
+#endif
+		if (adc_sample.is_new){     // a stale sample is not converted again
+			sensor_raw[0] = adc_sample.sample;
+			ConvertSensors(sensors, sensor_raw, sensor_value);
+		}
+		adc_raw = sensor_raw[0];
+		Vmeas = sensor_value[0];    // Volts
+#if ADC_HARMONICS
+		RunHarmonicAnalyzer(&adc_harmonics, Vmeas, &adc_pll.angle); // angle of this sample: before the PLL advances it
+		RunSOGIPLL1(&adc_pll, &adc_uabg, Vmeas - ADC_AC_OFFSET);   // the SOGI passes an offset to its quadrature output
+#endif
+	}
+	{
+		ProfileScope stage(&profiler, STAGE_SCHEDULED);
+		RunRateScheduler(&scheduler); // temperature at 2 kHz, capture statistics at 100 Hz
+	}
+	{
+		ProfileScope stage(&profiler, STAGE_OVERSAMPLING);
+		Vavg = ReadOversampledAdc(&adc_avg);
+	}
+	{
+		ProfileScope stage(&profiler, STAGE_CAPTURE);
+		if (adc_sample.is_new){
+			PushSample(&adc_capture, adc_raw, tick); // keep the history of the new samples (dropped and counted if full)
+		}
+		tick++;
+	}
+
+#if INTERRUPT_TRACE
+	RecordInterruptOutputs(&trace_recorder);
+#endif
 
 	return SAFE;
 }
 
+/**
+ * Routine draining the ADC capture buffer into adc_capture_stats (example of consumer: replace or extend
+ * the loop body to log, filter or transmit the samples)
+ */
+unsigned int ProcessAdcCapture(void)
+{
+	AdcCaptureStats stats = {0, 0xFFFF, 0, 0.0f, 0, 0};
+	float sum = 0.0f;
+	unsigned int count;
+
+	while ((count = DrainSamples(&adc_capture, adc_block, sizeof(adc_block)/sizeof(adc_block[0]))) > 0){
+		for (unsigned int k = 0; k < count; k++){  // adc_block[0..count-1] holds the oldest samples not yet processed
+			uint16_t raw = adc_block[k].raw;
+			if (raw < stats.min){ stats.min = raw; }
+			if (raw > stats.max){ stats.max = raw; }
+			sum += raw;
+			stats.gaps += adc_block[k].tick - adc_capture_last_tick - 1;
+			adc_capture_last_tick = adc_block[k].tick;
+		}
+		stats.count += count;
+	}
+
+	if (stats.count > 0){
+		stats.mean = sum / stats.count;
+	}
+	else{
+		stats.min = 0;
+	}
+	stats.overruns = GetSampleBufferOverruns(&adc_capture);
+	adc_capture_stats = stats;
+
+	return stats.count;
+}
+
+/**
+ * Routine exporting all the interrupt timings into profile_stats and rate_group_stats at once
+ */
+void UpdateInterruptProfile(void)
+{
+	for (uint8_t entry = 0; entry <= STAGE_COUNT; entry++){
+		ExportProfileEntry(entry);
+	}
+}
+
 /**
  * Routine executed when the core state goes into FAULT mode
  */
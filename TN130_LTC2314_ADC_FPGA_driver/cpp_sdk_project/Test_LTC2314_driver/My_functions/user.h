@@ -8,7 +8,23 @@
 #include "Driver/peripherals.h"
 
 #include "../API/sensors.h"
+#include "../API/sensorchannels.h"
+#include "../API/temperature.h"
 #include "../API/controllers.h"
+#include "../API/PLLs.h"
+#include "../API/harmonicanalyzer.h"
+#include "../API/controlcontext.h"
+#include "../API/samplebuffer.h"
+#include "../API/interrupttrace.h"
+#include "../API/interruptprofiler.h"
+#include "../API/ratescheduler.h"
+
+#include "adc_oversampling.h"
+#include "multichannel_adc.h"
+#include "sequenced_adc.h"
+#include "spi_calibration.h"
+
+#include <math.h>
 
 /**
  * Main interrupt routine.
@@ -17,6 +33,30 @@
  */
 tUserSafe UserInterrupt(void);
 
+/**
+ * Routine draining the ADC samples captured by UserInterrupt in bulk, and computing their statistics
+ * into adc_capture_stats. Run at 100 Hz by the rate scheduler (at most 200 new samples per run, far
+ * below the capacity of adc_capture); it can be moved as is to a background loop, the buffer being
+ * lock-free, but must remain the single consumer of adc_capture.
+ * @param	void
+ * @return	unsigned int	the number of samples drained
+ */
+unsigned int ProcessAdcCapture(void);
+
+/**
+ * Routine exporting the worst case, mean and percentiles of every profiled stage of UserInterrupt into
+ * profile_stats (all fractions of the interrupt period are in max_budget), and the budget accounting of
+ * the rate groups into rate_group_stats.
+ * On the target, the same export is done incrementally by the 100 Hz task "profile" of the rate
+ * scheduler, one stage histogram per run (the whole export would take a large part of one interrupt
+ * period on the Cortex-A9): profile_stats and rate_group_stats are refreshed every 60 ms. Call this
+ * routine only where the task does not run (e.g. on the host, after a simulation): it would race with
+ * the task on profile_stats.
+ * @param	void
+ * @return	void
+ */
+void UpdateInterruptProfile(void);
+
 /**
  * Modes of operation of the user-level application
  */
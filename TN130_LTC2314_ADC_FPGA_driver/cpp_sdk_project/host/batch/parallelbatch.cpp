@@ -0,0 +1,57 @@
+/*
+ *	@title	Multithreaded driver of the batch transformations (API/transformbatch.h) for long captures
+ *	@file	parallelbatch.cpp
+ */
+
+#include "parallelbatch.h"
+#include "transformbatch.h"
+
+
+static uint32_t ChunkOf(const TransformJob* job)
+{
+	uint32_t chunk = job->chunk ? job->chunk : BATCH_DEFAULT_CHUNK;
+	chunk = (chunk + 63) & ~63u;												// Whole cache lines per worker
+	return chunk;
+}
+
+
+static void RunChunk(void* context, uint64_t index, unsigned int worker)
+{
+	(void)worker;
+	const TransformJob* job = (const TransformJob*)context;
+	uint64_t start = index * ChunkOf(job);
+	uint32_t n = job->count - start < ChunkOf(job) ? job->count - start : ChunkOf(job);
+	const float* theta = job->theta ? job->theta + start : 0;
+
+	switch (job->transform){
+	case BATCH_ABC2ABG:
+		abc2ABGBatch(job->out[0] + start, job->out[1] + start, job->out[2] + start,
+				job->in[0] + start, job->in[1] + start, job->in[2] + start, n);
+		break;
+	case BATCH_ABG2DQ0:
+		ABG2DQ0Batch(job->out[0] + start, job->out[1] + start, job->out[2] + start,
+				job->in[0] + start, job->in[1] + start, job->in[2] + start, theta, n);
+		break;
+	case BATCH_ABC2DQ0:
+		abc2DQ0Batch(job->out[0] + start, job->out[1] + start, job->out[2] + start,
+				job->in[0] + start, job->in[1] + start, job->in[2] + start, theta, n);
+		break;
+	case BATCH_DQ02ABC:
+		DQ02abcBatch(job->out[0] + start, job->out[1] + start, job->out[2] + start,
+				job->in[0] + start, job->in[1] + start, job->in[2] + start, theta, n);
+		break;
+	}
+}
+
+
+void RunTransformJob(WorkStealingPool* pool, const TransformJob* job)
+{
+	uint32_t chunk = ChunkOf(job);
+	uint64_t chunks = (job->count + chunk - 1) / chunk;
+
+	if (!pool){
+		for (uint64_t k = 0; k < chunks; k++){ RunChunk((void*)job, k, 0); }
+		return;
+	}
+	RunParallelFor(pool, chunks, RunChunk, (void*)job);
+}
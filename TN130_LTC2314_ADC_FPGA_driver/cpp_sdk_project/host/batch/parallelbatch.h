@@ -0,0 +1,49 @@
+/*
+ *	@title	Multithreaded driver of the batch transformations (API/transformbatch.h) for long captures
+ *	@file	parallelbatch.h
+ *
+ *	The arrays are cut into chunks of TransformJob.chunk samples, executed as the items of a parallel
+ *	loop on the work-stealing pool of tuner/threadpool.h. The chunks start on multiples of 64 samples
+ *	(256 bytes), so that two workers never write the same cache line, and every sample is computed
+ *	by the same vector code as with a single call: the results do not depend on the number of threads.
+ */
+
+#ifndef PARALLELBATCH_H_
+#define PARALLELBATCH_H_
+
+#include "threadpool.h"
+
+#include <stdint.h>
+
+#define BATCH_DEFAULT_CHUNK		16384		// Samples per item: 6 arrays of 64 kB, within a core's L2 cache
+
+typedef enum{
+	BATCH_ABC2ABG = 0,						// in: a, b, c				out: alpha, beta, gamma
+	BATCH_ABG2DQ0,							// in: alpha, beta, gamma	out: d, q, zero		(theta)
+	BATCH_ABC2DQ0,							// in: a, b, c				out: d, q, zero		(theta)
+	BATCH_DQ02ABC							// in: d, q, zero			out: a, b, c		(theta)
+} tBatchTransform;
+
+
+/**
+ * One transformation of a whole capture
+ */
+typedef struct{
+	tBatchTransform transform;
+	float* out[3];
+	const float* in[3];
+	const float* theta;						// Phase angles (not used by BATCH_ABC2ABG)
+	uint64_t count;							// Samples
+	uint32_t chunk;							// Samples per item (multiple of 64), 0: BATCH_DEFAULT_CHUNK
+} TransformJob;
+
+
+/**
+ * Routine to run a transformation over the whole arrays, in parallel
+ * @param *pool			the pool (NULL: in the calling thread only, chunk by chunk)
+ * @param *job			the transformation and its arrays
+ * @return void
+ */
+void RunTransformJob(WorkStealingPool* pool, const TransformJob* job);
+
+#endif /* PARALLELBATCH_H_ */
@@ -0,0 +1,196 @@
+/*
+ *	@title	Accuracy and throughput of the batch transformations against the scalar routines
+ *	@file	transform_batch.cpp
+ *
+ *	A synthetic capture (distorted and unbalanced 325 V grid with noise, 50 Hz angle wrapped to
+ *	[-PI, PI], sampled at 20 kHz) is transformed by the scalar routines of transformations.h, one
+ *	TimeDomain/SpaceVector at a time, by the batch routines of transformbatch.h in one thread and by
+ *	the parallel driver. Checks:
+ *	 - every output within TRANSFORM_BATCH_TOLERANCE of the scalar one (relative to the largest input)
+ *	 - the parallel results bit-identical to the single-thread ones (any number of threads)
+ *	 - a length that is not a multiple of the vector or chunk sizes, and in-place transformations
+ *	Then prints the throughput of the three, in Msamples/s.
+ *
+ *	Usage: transform_batch [--samples N] [--threads N] [--chunk N]
+ */
+
+#include "parallelbatch.h"
+#include "transformbatch.h"
+#include "transformations.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#define TSAMPLE		50e-6
+#define GRID_PEAK	325.0
+
+typedef std::vector<float> Array;
+
+typedef struct{
+	Array in[3];
+	Array theta;
+} Capture;
+
+static double NowS(void)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void MakeCapture(Capture* me, uint64_t count)
+{
+	uint32_t noise = 1;
+	for (int k = 0; k < 3; k++){ me->in[k].resize(count); }
+	me->theta.resize(count);
+
+	for (uint64_t n = 0; n < count; n++){
+		double t = n * TSAMPLE;
+		double theta = std::remainder(2 * M_PI * 50.0 * t, 2 * M_PI);
+		for (int k = 0; k < 3; k++){
+			double phase = 2 * M_PI * 50.0 * t - k * 2 * M_PI / 3;
+			noise = noise * 1664525u + 1013904223u;
+			me->in[k][n] = (float)((1.0 + 0.05 * k) * GRID_PEAK * cos(phase) + 0.04 * GRID_PEAK * cos(5 * phase)
+					+ 0.03 * GRID_PEAK * cos(7 * phase) + 2.0 * k + ((noise >> 8) * (1.0 / 16777216) - 0.5));
+		}
+		me->theta[n] = (float)theta;
+	}
+}
+
+// The scalar routines of transformations.h, sample by sample on AoS copies
+static void RunScalar(tBatchTransform transform, Array out[3], const Array in[3], const Array& theta)
+{
+	uint64_t count = theta.size();
+	std::vector<TimeDomain> abc(count);
+	std::vector<SpaceVector> vectors(count);
+	for (uint64_t n = 0; n < count; n++){
+		abc[n] = {in[0][n], in[1][n], in[2][n]};
+		vectors[n] = {in[0][n], in[1][n], in[2][n]};
+	}
+
+	for (uint64_t n = 0; n < count; n++){
+		SpaceVector v;
+		TimeDomain p;
+		switch (transform){
+		case BATCH_ABC2ABG: abc2ABG(&v, &abc[n]); break;
+		case BATCH_ABG2DQ0: ABG2DQ0(&v, &vectors[n], theta[n]); break;
+		case BATCH_ABC2DQ0: abc2DQ0(&v, &abc[n], theta[n]); break;
+		case BATCH_DQ02ABC: DQ02abc(&p, &vectors[n], theta[n]); v = {p.A, p.B, p.C}; break;
+		}
+		out[0][n] = v.real;
+		out[1][n] = v.imaginary;
+		out[2][n] = v.offset;
+	}
+}
+
+static TransformJob MakeJob(tBatchTransform transform, Array out[3], const Array in[3], const Array& theta, uint32_t chunk)
+{
+	TransformJob job;
+	job.transform = transform;
+	for (int k = 0; k < 3; k++){
+		job.out[k] = out[k].data();
+		job.in[k] = in[k].data();
+	}
+	job.theta = theta.data();
+	job.count = theta.size();
+	job.chunk = chunk;
+	return job;
+}
+
+// Largest deviation from the scalar results, relative to the largest input of the sample
+static double MaxRelativeError(const Array out[3], const Array reference[3], const Array in[3])
+{
+	double worst = 0;
+	for (uint64_t n = 0; n < in[0].size(); n++){
+		double scale = fmax(fmax(fabs(in[0][n]), fabs(in[1][n])), fmax(fabs(in[2][n]), 1e-30));
+		for (int k = 0; k < 3; k++){
+			double e = fabs((double)out[k][n] - reference[k][n]) / scale;
+			if (e > worst){ worst = e; }
+		}
+	}
+	return worst;
+}
+
+static bool SameArrays(const Array a[3], const Array b[3])
+{
+	for (int k = 0; k < 3; k++){
+		if (memcmp(a[k].data(), b[k].data(), a[k].size() * sizeof(float))){ return false; }
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	uint64_t samples = 4000000;
+	unsigned int threads = 0;
+	uint32_t chunk = 0;
+	for (int i = 1; i < argc; i++){
+		if (!strcmp(argv[i], "--samples") && i + 1 < argc){ samples = (uint64_t)atof(argv[++i]); }
+		else if (!strcmp(argv[i], "--threads") && i + 1 < argc){ threads = atoi(argv[++i]); }
+		else if (!strcmp(argv[i], "--chunk") && i + 1 < argc){ chunk = atoi(argv[++i]); }
+		else{
+			fprintf(stderr, "usage: %s [--samples N] [--threads N] [--chunk N]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	static WorkStealingPool pool;
+	ConfigWorkStealingPool(&pool, threads);
+
+	static const char* const names[] = {"abc2ABG", "ABG2DQ0", "abc2DQ0", "DQ02abc"};
+	int failures = 0;
+
+	// Odd length (tail of the vectors and of the chunks), then the capture
+	for (uint64_t count : {(uint64_t)1000003, samples}){
+		Capture capture;
+		MakeCapture(&capture, count);
+		printf("%llu samples, SIMD_WIDTH %d, %u threads, tolerance %.1e\n", (unsigned long long)count, SIMD_WIDTH,
+				pool.workers, TRANSFORM_BATCH_TOLERANCE);
+		printf("  transform    max error   scalar Ms/s   batch Ms/s  parallel Ms/s\n");
+
+		for (int t = BATCH_ABC2ABG; t <= BATCH_DQ02ABC; t++){
+			tBatchTransform transform = (tBatchTransform)t;
+			Array reference[3], single[3], parallel[3];
+			for (int k = 0; k < 3; k++){
+				single[k].resize(count);
+				parallel[k].resize(count);
+				reference[k].resize(count);
+			}
+
+			double start = NowS();
+			RunScalar(transform, reference, capture.in, capture.theta);
+			double scalar = NowS() - start;
+
+			TransformJob job = MakeJob(transform, single, capture.in, capture.theta, chunk);
+			start = NowS();
+			RunTransformJob(0, &job);
+			double batch = NowS() - start;
+
+			job = MakeJob(transform, parallel, capture.in, capture.theta, chunk);
+			start = NowS();
+			RunTransformJob(&pool, &job);
+			double threaded = NowS() - start;
+
+			double error = MaxRelativeError(single, reference, capture.in);
+			bool identical = SameArrays(single, parallel);
+
+			// In place: the outputs over the inputs
+			Array inplace[3] = {capture.in[0], capture.in[1], capture.in[2]};
+			job = MakeJob(transform, inplace, inplace, capture.theta, chunk);
+			RunTransformJob(&pool, &job);
+			bool inplace_ok = SameArrays(inplace, single);
+
+			bool ok = error <= TRANSFORM_BATCH_TOLERANCE && identical && inplace_ok;
+			if (!ok){ failures++; }
+			printf("  %-9s  %10.2e  %12.1f  %11.1f  %13.1f  %s%s%s\n", names[t], error, count / scalar * 1e-6,
+					count / batch * 1e-6, count / threaded * 1e-6, ok ? "" : "FAIL",
+					identical ? "" : " (parallel differs)", inplace_ok ? "" : " (in-place differs)");
+		}
+	}
+
+	CloseWorkStealingPool(&pool);
+	printf("%s\n", failures ? "FAIL" : "PASS");
+	return failures ? 1 : 0;
+}
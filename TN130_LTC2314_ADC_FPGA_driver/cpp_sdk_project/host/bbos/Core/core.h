@@ -0,0 +1,57 @@
+/*
+ *	@title	Host stand-in for the bbos core services
+ *	@file	Core/core.h
+ *
+ *	Only the subset of the B-Box SDK used by the project is declared here. The Host* routines
+ *	do not exist on the target: they let host tools drive what the real bbos would report.
+ */
+
+#ifndef CORE_H_
+#define CORE_H_
+
+#include <stdint.h>
+
+
+/**
+ * States of the B-Box core (outputs enabled only when OPERATING)
+ */
+typedef enum{
+	BLOCKED   = 0,
+	OPERATING = 1,
+	FAULT     = 2
+} tCoreState;
+
+
+/**
+ * Return value of the user routines
+ */
+typedef enum{
+	SAFE   = 0,
+	UNSAFE = 1
+} tUserSafe;
+
+
+/**
+ * Origin of a fault reported to UserError()
+ */
+typedef enum{
+	USER_ERROR     = 0,
+	CORE_ERROR     = 1,
+	HARDWARE_ERROR = 2
+} tErrorSource;
+
+
+/**
+ * Return the current state of the core
+ * @return			the core state (BLOCKED, OPERATING or FAULT)
+ */
+tCoreState GetCoreState(void);
+
+
+/**
+ * Host only: force the state returned by GetCoreState()
+ * @param state		the new core state
+ */
+void HostSetCoreState(tCoreState state);
+
+#endif /* CORE_H_ */
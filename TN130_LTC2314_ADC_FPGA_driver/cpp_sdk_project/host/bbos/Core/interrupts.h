@@ -0,0 +1,56 @@
+/*
+ *	@title	Host stand-in for the bbos interrupt services
+ *	@file	Core/interrupts.h
+ */
+
+#ifndef INTERRUPTS_H_
+#define INTERRUPTS_H_
+
+#include "core.h"
+
+
+/**
+ * Clock generators available on the B-Box
+ */
+typedef enum{
+	CLOCK_0 = 0,
+	CLOCK_1 = 1,
+	CLOCK_2 = 2,
+	CLOCK_3 = 3
+} tClock;
+
+typedef tUserSafe (*tInterruptHandler)(void);
+
+
+/**
+ * Configure the frequency of a clock generator
+ * @param clock		the clock to configure
+ * @param frequency	the frequency in Hz
+ */
+void Clock_SetFrequency(tClock clock, float frequency);
+
+
+/**
+ * Register the main interrupt routine
+ * @param handler	the routine to call at each period of 'clock'
+ * @param clock		the clock triggering the interrupt
+ * @param phase		the phase of the interrupt relative to the clock period (0..1)
+ */
+void ConfigureMainInterrupt(tInterruptHandler handler, tClock clock, float phase);
+
+
+/**
+ * Host only: return the routine registered with ConfigureMainInterrupt()
+ * @return			the main interrupt handler, or 0 if none is registered
+ */
+tInterruptHandler HostGetMainInterrupt(void);
+
+
+/**
+ * Host only: return the frequency set with Clock_SetFrequency()
+ * @param clock		the clock to query
+ * @return			the frequency in Hz
+ */
+float HostGetClockFrequency(tClock clock);
+
+#endif /* INTERRUPTS_H_ */
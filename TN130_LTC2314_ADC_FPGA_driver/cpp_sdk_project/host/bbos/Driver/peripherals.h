@@ -0,0 +1,57 @@
+/*
+ *	@title	Host stand-in for the bbos peripheral drivers
+ *	@file	Driver/peripherals.h
+ */
+
+#ifndef PERIPHERALS_H_
+#define PERIPHERALS_H_
+
+#include "../Core/interrupts.h"
+
+#define HOST_SBI_REGISTERS	64
+#define HOST_SBO_REGISTERS	64
+
+
+/**
+ * PWM outputs, carriers and output modes (subset)
+ */
+typedef enum{ PWM_CHANNEL_0 = 0, PWM_CHANNEL_1, PWM_CHANNEL_2, PWM_CHANNEL_3 } tPwmOutput;
+typedef enum{ TRIANGLE = 0, SAWTOOTH = 1 } tPwmCarrier;
+typedef enum{ COMPLEMENTARY = 0, INDEPENDENT = 1 } tPwmOutputMode;
+
+
+/**
+ * Source of the SBI registers on the host (e.g. a simulated ADC)
+ * @param address	the SBI register being read
+ * @return			the register value
+ */
+typedef unsigned int (*tHostSbiSource)(unsigned int address);
+
+
+/**
+ * Standard bus input (SBI) and output (SBO) registers
+ */
+void Sbi_ConfigureAsRealTime(unsigned int address, unsigned int device=0);
+unsigned int Sbi_Read(unsigned int address, unsigned int device=0);
+void Sbo_WriteDirectly(unsigned int address, unsigned int value, unsigned int device=0);
+
+
+/**
+ * Carrier-based PWM configuration
+ */
+void CbPwm_ConfigureClock(tPwmOutput output, tClock clock, unsigned int device=0);
+void CbPwm_ConfigureOutputMode(tPwmOutput output, tPwmOutputMode mode, unsigned int device=0);
+void CbPwm_ConfigureCarrier(tPwmOutput output, tPwmCarrier carrier, unsigned int device=0);
+void CbPwm_ConfigureDeadTime(tPwmOutput output, float deadTime, unsigned int device=0);
+void CbPwm_SetDutyCycle(tPwmOutput output, float dutyCycle, unsigned int device=0);
+void CbPwm_SetPhase(tPwmOutput output, float phase, unsigned int device=0);
+
+
+/**
+ * Host only: access to the register files seen by the user code
+ */
+void HostSetSbiRegister(unsigned int address, unsigned int value);
+void HostSetSbiSource(tHostSbiSource source);
+unsigned int HostGetSboRegister(unsigned int address);
+
+#endif /* PERIPHERALS_H_ */
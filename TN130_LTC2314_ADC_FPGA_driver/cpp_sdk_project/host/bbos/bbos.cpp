@@ -0,0 +1,94 @@
+/*
+ *	@title	Host stand-in for the bbos library
+ *	@file	bbos.cpp
+ *
+ *	Minimal state-holding implementation: every call records or returns what the host tool set.
+ */
+
+#include "Core/core.h"
+#include "Core/interrupts.h"
+#include "Driver/peripherals.h"
+
+static tCoreState core_state = OPERATING;
+static tInterruptHandler main_interrupt = 0;
+static float clock_frequency[4] = {0.0, 0.0, 0.0, 0.0};
+static unsigned int sbi_registers[HOST_SBI_REGISTERS];
+static unsigned int sbo_registers[HOST_SBO_REGISTERS];
+static tHostSbiSource sbi_source = 0;
+
+
+tCoreState GetCoreState(void)
+{
+	return core_state;
+}
+
+void HostSetCoreState(tCoreState state)
+{
+	core_state = state;
+}
+
+
+void Clock_SetFrequency(tClock clock, float frequency)
+{
+	clock_frequency[clock] = frequency;
+}
+
+void ConfigureMainInterrupt(tInterruptHandler handler, tClock clock, float phase)
+{
+	(void)clock;
+	(void)phase;
+	main_interrupt = handler;
+}
+
+tInterruptHandler HostGetMainInterrupt(void)
+{
+	return main_interrupt;
+}
+
+float HostGetClockFrequency(tClock clock)
+{
+	return clock_frequency[clock];
+}
+
+
+void Sbi_ConfigureAsRealTime(unsigned int address, unsigned int device)
+{
+	(void)address;
+	(void)device;
+}
+
+unsigned int Sbi_Read(unsigned int address, unsigned int device)
+{
+	(void)device;
+	if (sbi_source){ return sbi_source(address); }
+	return sbi_registers[address % HOST_SBI_REGISTERS];
+}
+
+void Sbo_WriteDirectly(unsigned int address, unsigned int value, unsigned int device)
+{
+	(void)device;
+	sbo_registers[address % HOST_SBO_REGISTERS] = value;
+}
+
+void HostSetSbiRegister(unsigned int address, unsigned int value)
+{
+	sbi_registers[address % HOST_SBI_REGISTERS] = value;
+}
+
+void HostSetSbiSource(tHostSbiSource source)
+{
+	sbi_source = source;
+}
+
+unsigned int HostGetSboRegister(unsigned int address)
+{
+	return sbo_registers[address % HOST_SBO_REGISTERS];
+}
+
+
+void CbPwm_ConfigureClock(tPwmOutput, tClock, unsigned int){}
+void CbPwm_ConfigureOutputMode(tPwmOutput, tPwmOutputMode, unsigned int){}
+void CbPwm_ConfigureCarrier(tPwmOutput, tPwmCarrier, unsigned int){}
+void CbPwm_ConfigureDeadTime(tPwmOutput, float, unsigned int){}
+void CbPwm_SetDutyCycle(tPwmOutput, float, unsigned int){}
+void CbPwm_SetPhase(tPwmOutput, float, unsigned int){}
@@ -0,0 +1,14 @@
+/*
+ *	@title	Host stand-in for the user entry points expected by bbos
+ *	@file	extern_user.h
+ */
+
+#ifndef EXTERN_USER_H_
+#define EXTERN_USER_H_
+
+#include "Core/core.h"
+
+tUserSafe UserInit(void);
+void UserError(tErrorSource source);
+
+#endif /* EXTERN_USER_H_ */
@@ -0,0 +1,716 @@
+/*
+ *	@title	Host microbenchmarks of the API run routines
+ *	@file	api_bench.cpp
+ *
+ *	Every case calls one routine in a tight loop on a pre-generated input waveform. The loop is
+ *	timed in batches and the per-batch cost is reported as mean, standard deviation and minimum
+ *	ns/call, together with the throughput and the share of the 50 us interrupt budget (20 kHz).
+ *
+ *	Usage: api_bench [--filter text] [--csv] [--baseline file.csv [--tolerance percent]]
+ *	--csv writes "name,mean_ns,stddev_ns,min_ns" lines that can be stored and fed back through
+ *	--baseline: the run then fails if any routine's minimum ns/call exceeds the stored one by more
+ *	than the tolerance (10 % by default).
+ */
+
+#include "controllers.h"
+#include "controllerbank.h"
+#include "controllertemplate.h"
+#include "sogibank.h"
+#include "multiresonant.h"
+#include "harmonicanalyzer.h"
+#include "PLLs.h"
+#include "transformations.h"
+#include "sincos.h"
+#include "fixedpoint.h"
+#include "sensorchannels.h"
+#include "temperature.h"
+#include "interruptprofiler.h"
+#include "Core/core.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <time.h>
+
+#define TSAMPLE			50e-6		// Interrupt period (20 kHz)
+#define BUDGET_NS		50000.0		// Interrupt budget in ns
+#define OMEGA_GRID		314.159265	// 50 Hz
+#define INPUT_LENGTH	1024		// Length of the pre-generated input waveforms (power of 2)
+#define CALLS_PER_BATCH	20000
+#define BATCHES			31
+#define BANK_CHANNELS	32			// Channels of the multi-channel cases (one call runs them all)
+#define SENSOR_CHANNELS	8			// Channels of the sensor conversion cases
+#define NTC_CHANNELS	16			// Channels of the temperature conversion cases
+#define SOGI_HARMONICS	5			// Harmonic orders of the SOGI bank cases (1, 5, 7, 11, 13)
+#define SOGI_PHASES		3			// Phases of the SOGI bank cases
+
+typedef struct{
+	const char* name;
+	void (*setup)(void);
+	float (*run)(uint32_t count);	// Performs 'count' calls and returns a value depending on all of them
+} BenchCase;
+
+typedef struct{
+	double mean;
+	double stddev;
+	double min;
+} BenchResult;
+
+static float error_in[INPUT_LENGTH];		// Small controller error, +/- 1
+static float theta_in[INPUT_LENGTH];		// Phase angle wrapped to [-PI, PI]
+static TimeDomain abc_in[INPUT_LENGTH];		// Slightly unbalanced three-phase voltage
+static SpaceVector dq0_in[INPUT_LENGTH];	// Rotating-frame voltage with ripple
+static SpaceVector abg_in[INPUT_LENGTH];	// Stationary-frame voltage
+static int16_t error_q15[INPUT_LENGTH];		// error_in / 2 in Q15
+static uint16_t theta_q15[INPUT_LENGTH];	// theta_in as a binary angle
+static TimeDomainQ15 abc_q15[INPUT_LENGTH];	// abc_in / 400 in Q15
+static uint16_t raw_in[INPUT_LENGTH + NTC_CHANNELS];	// Raw SBI values
+
+volatile float sink;						// Defeats dead-code elimination of the benchmarked calls
+
+static PIDController pid;
+static PRController pr;
+static Controller<PIStructure, BackCalculation> pi_template;
+static Controller<PIDStructure, BackCalculation> pid_template;
+static Controller<PRStructure, NoSaturation> pr_template;
+static PRController pr_array[SOGI_HARMONICS * 2];
+static MultiResonantController multi_pr;
+static const float resonant_ki[SOGI_HARMONICS] = {200.0, 80.0, 60.0, 40.0, 30.0};
+static SOGI3Parameters sogi;
+static SOGI3Parameters sogi_array[SOGI_HARMONICS * SOGI_PHASES];
+static SOGIBank sogi_bank;
+static const uint16_t sogi_orders[SOGI_HARMONICS] = {1, 5, 7, 11, 13};
+static HarmonicAnalyzer analyzer;
+static const uint16_t analyzer_orders[] = {1, 2, 3, 5, 7, 11, 13};
+static PhaseAngle angle_in[INPUT_LENGTH];	// Angles of theta_in, for the analyzer
+static DQPLLParameters dqpll;
+static SOGIPLL1Parameters sogipll;
+static DSOGIPLL3Parameters dsogipll;
+static Sequences dsrf;
+static PIDController pid_array[BANK_CHANNELS];
+static PIDControllerBank bank;
+static PIControllerQ15 pi_q15;
+static PRControllerQ15 pr_q15;
+static SOGI3ParametersQ15 sogi_q15;
+static InterruptProfiler profiler;
+
+
+static void GenerateInputs(void)
+{
+	srand(1);
+	for (int i = 0; i < INPUT_LENGTH; i++){
+		float wt = OMEGA_GRID * TSAMPLE * i;
+		float noise = 0.01f * ((float)rand() / RAND_MAX - 0.5f);
+
+		error_in[i] = sinf(0.37f * i) + noise;
+		theta_in[i] = remainderf(wt, 2*M_PI);
+
+		abc_in[i].A = 325.0f * cosf(wt) + noise;
+		abc_in[i].B = 320.0f * cosf(wt - 2*M_PI/3) + noise;
+		abc_in[i].C = 330.0f * cosf(wt + 2*M_PI/3) + noise;
+
+		dq0_in[i].real = 325.0f + 5.0f * cosf(2*wt);
+		dq0_in[i].imaginary = 5.0f * sinf(2*wt) + noise;
+		dq0_in[i].offset = noise;
+
+		abc2ABG(&abg_in[i], &abc_in[i]);
+
+		error_q15[i] = FloatToQ15(0.5f * error_in[i]);
+		theta_q15[i] = AngleToBinary(theta_in[i]);
+		abc_q15[i].A = FloatToQ15(abc_in[i].A / 400.0f);
+		abc_q15[i].B = FloatToQ15(abc_in[i].B / 400.0f);
+		abc_q15[i].C = FloatToQ15(abc_in[i].C / 400.0f);
+	}
+	for (int i = 0; i < INPUT_LENGTH + NTC_CHANNELS; i++){ raw_in[i] = (uint16_t)rand(); }
+}
+
+
+/*
+ * Benchmark cases (one per API routine)
+ */
+static void SetupPID(void){ ConfigPIDController(&pid, 0.5, 200.0, 1e-4, 10.0, -10.0, TSAMPLE, 10); }
+static void SetupPR(void){ ConfigPRController(&pr, 0.5, 200.0, OMEGA_GRID, 5.0, TSAMPLE); }
+static void SetupPITemplate(void){ ConfigController(&pi_template, 0.5, 200.0); ConfigControllerLimits(&pi_template, 10.0, -10.0); }
+static void SetupPIDTemplate(void){ ConfigController(&pid_template, 0.5, 200.0, 1e-4, TSAMPLE, 10); ConfigControllerLimits(&pid_template, 10.0, -10.0); }
+static void SetupPRTemplate(void){ ConfigController(&pr_template, 0.5, 200.0, OMEGA_GRID, 5.0, TSAMPLE); }
+static void SetupSOGI3(void){ ConfigSOGI3(&sogi, 1.41, OMEGA_GRID, TSAMPLE); }
+static void SetupPRArray(void)
+{
+	for (int k = 0; k < SOGI_HARMONICS * 2; k++){
+		ConfigPRController(&pr_array[k], k < 2 ? 0.5 : 0.0, resonant_ki[k / 2], sogi_orders[k / 2] * OMEGA_GRID, 5.0, TSAMPLE);
+	}
+}
+static void SetupMultiPR(void){ ConfigMultiResonantController(&multi_pr, 2, 0.5, sogi_orders, resonant_ki, SOGI_HARMONICS, OMEGA_GRID, 5.0, TSAMPLE); }
+static void SetupSOGIArray(void)
+{
+	for (int k = 0; k < SOGI_HARMONICS * SOGI_PHASES; k++){ ConfigSOGI3(&sogi_array[k], 0.7, sogi_orders[k / SOGI_PHASES] * OMEGA_GRID, TSAMPLE); }
+}
+static void SetupAnalyzer(void)
+{
+	ConfigHarmonicAnalyzer(&analyzer, analyzer_orders, sizeof(analyzer_orders)/sizeof(analyzer_orders[0]), TSAMPLE);
+	for (int i = 0; i < INPUT_LENGTH; i++){ UpdatePhaseAngle(&angle_in[i], theta_in[i]); }
+}
+static void SetupSOGIBank(void){ ConfigSOGIBank(&sogi_bank, SOGI_PHASES, sogi_orders, SOGI_HARMONICS, 0.7, OMEGA_GRID, TSAMPLE, false); }
+static void SetupDQPLL(void){ ConfigDQPLL(&dqpll, 2.0, 100.0, OMEGA_GRID, TSAMPLE); }
+static void SetupSOGIPLL1(void){ ConfigSOGIPLL1(&sogipll, 2.0, 100.0, 1.41, OMEGA_GRID, TSAMPLE); }
+static void SetupDSOGIPLL3(void){ ConfigDSOGIPLL3(&dsogipll, 2.0, 100.0, 1.41, OMEGA_GRID, TSAMPLE); }
+static void SetupDSRF(void){ ConfigSequences(&dsrf, 10.0, TSAMPLE); }
+static void SetupPIQ15(void){ ConfigPIControllerQ15(&pi_q15, 0.5, 200.0 * TSAMPLE, 0.9, -0.9); }
+static void SetupPRQ15(void){ ConfigPRControllerQ15(&pr_q15, 0.5, 200.0, OMEGA_GRID, 5.0, TSAMPLE); }
+static void SetupSOGI3Q15(void){ ConfigSOGI3Q15(&sogi_q15, 1.41, OMEGA_GRID, TSAMPLE); }
+static void SetupNone(void){}
+static void SetupProfiler(void)
+{
+	static const char* const names[1] = {"bench"};
+	ConfigInterruptProfiler(&profiler, names, 1, TSAMPLE);
+}
+
+static void SetupPIDArray(void)
+{
+	for (int k = 0; k < BANK_CHANNELS; k++){
+		ConfigPIDController(&pid_array[k], 0.5 + 0.01*k, 200.0, 1e-4, 10.0, -10.0, TSAMPLE, 10);
+	}
+}
+
+static void SetupBank(void)
+{
+	ConfigPIDControllerBank(&bank, BANK_CHANNELS);
+	for (int k = 0; k < BANK_CHANNELS; k++){
+		ConfigPIDControllerBankChannel(&bank, k, 0.5 + 0.01*k, 200.0, 1e-4, 10.0, -10.0, TSAMPLE, 10);
+	}
+}
+
+static float RunPID(uint32_t count)
+{
+	float acc = 0;
+	for (uint32_t i = 0; i < count; i++){ acc += RunPIDController(&pid, error_in[i & (INPUT_LENGTH-1)]); }
+	return acc;
+}
+
+static float RunPI(uint32_t count)
+{
+	float acc = 0;
+	for (uint32_t i = 0; i < count; i++){ acc += RunPIController(&pid, error_in[i & (INPUT_LENGTH-1)]); }
+	return acc;
+}
+
+static float RunPR(uint32_t count)
+{
+	float acc = 0;
+	for (uint32_t i = 0; i < count; i++){ acc += RunPRController(&pr, error_in[i & (INPUT_LENGTH-1)]); }
+	return acc;
+}
+
+static float RunPITemplate(uint32_t count)
+{
+	float acc = 0;
+	for (uint32_t i = 0; i < count; i++){ acc += RunController(&pi_template, error_in[i & (INPUT_LENGTH-1)]); }
+	return acc;
+}
+
+static float RunPIDTemplate(uint32_t count)
+{
+	float acc = 0;
+	for (uint32_t i = 0; i < count; i++){ acc += RunController(&pid_template, error_in[i & (INPUT_LENGTH-1)]); }
+	return acc;
+}
+
+static float RunPRTemplate(uint32_t count)
+{
+	float acc = 0;
+	for (uint32_t i = 0; i < count; i++){ acc += RunController(&pr_template, error_in[i & (INPUT_LENGTH-1)]); }
+	return acc;
+}
+
+static float RunSOGI(uint32_t count)
+{
+	float acc = 0;
+	for (uint32_t i = 0; i < count; i++){ acc += RunSOGI3(&sogi, abc_in[i & (INPUT_LENGTH-1)].A).imaginary; }
+	return acc;
+}
+
+static float RunPRArray(uint32_t count)
+{
+	float acc = 0;
+	for (uint32_t i = 0; i < count; i++){
+		const SpaceVector* e = &abg_in[i & (INPUT_LENGTH-1)];
+		for (int k = 0; k < SOGI_HARMONICS * 2; k += 2){
+			acc += RunPRController(&pr_array[k], 0.01f * e->real);
+			acc += RunPRController(&pr_array[k + 1], 0.01f * e->imaginary);
+		}
+	}
+	return acc;
+}
+
+static float RunMultiPR(uint32_t count)
+{
+	float acc = 0;
+	for (uint32_t i = 0; i < count; i++){
+		const SpaceVector* e = &abg_in[i & (INPUT_LENGTH-1)];
+		multi_pr.error[0] = 0.01f * e->real;
+		multi_pr.error[1] = 0.01f * e->imaginary;
+		RunMultiResonantController(&multi_pr);
+		acc += multi_pr.output[0] + multi_pr.output[1];
+	}
+	return acc;
+}
+
+static float RunAnalyzer(uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++){
+		uint32_t k = i & (INPUT_LENGTH-1);
+		RunHarmonicAnalyzer(&analyzer, abc_in[k].A, &angle_in[k]);
+	}
+	return analyzer.re[0] + (float)analyzer.periods;
+}
+
+static float RunSOGIArray(uint32_t count)
+{
+	float acc = 0;
+	for (uint32_t i = 0; i < count; i++){
+		const TimeDomain* abc = &abc_in[i & (INPUT_LENGTH-1)];
+		const float input[SOGI_PHASES] = {abc->A, abc->B, abc->C};
+		for (int k = 0; k < SOGI_HARMONICS * SOGI_PHASES; k++){ acc += RunSOGI3(&sogi_array[k], input[k % SOGI_PHASES]).imaginary; }
+	}
+	return acc;
+}
+
+static float RunSOGIBankCase(uint32_t count)
+{
+	float acc = 0;
+	for (uint32_t i = 0; i < count; i++){
+		const TimeDomain* abc = &abc_in[i & (INPUT_LENGTH-1)];
+		sogi_bank.input[0] = abc->A;
+		sogi_bank.input[1] = abc->B;
+		sogi_bank.input[2] = abc->C;
+		RunSOGIBank(&sogi_bank);
+		acc += sogi_bank.beta[0];
+	}
+	return acc;
+}
+
+static float RunDQ(uint32_t count)
+{
+	float acc = 0;
+	for (uint32_t i = 0; i < count; i++){ acc += RunDQPLL(&dqpll, &dq0_in[i & (INPUT_LENGTH-1)]); }
+	return acc;
+}
+
+static float RunSOGIPLL(uint32_t count)
+{
+	float acc = 0;
+	SpaceVector uabg;
+	for (uint32_t i = 0; i < count; i++){ acc += RunSOGIPLL1(&sogipll, &uabg, abc_in[i & (INPUT_LENGTH-1)].A); }
+	return acc;
+}
+
+static float RunDSOGIPLL(uint32_t count)
+{
+	float acc = 0;
+	for (uint32_t i = 0; i < count; i++){ acc += RunDSOGIPLL3(&dsogipll, &abg_in[i & (INPUT_LENGTH-1)]); }
+	return acc;
+}
+
+static float RunSequences(uint32_t count)
+{
+	float acc = 0;
+	for (uint32_t i = 0; i < count; i++){
+		uint32_t k = i & (INPUT_LENGTH-1);
+		RunDSRF(&dsrf, &abc_in[k], theta_in[k]);
+		acc += dsrf.dqpos.real;
+	}
+	return acc;
+}
+
+static float RunABC2DQ0(uint32_t count)
+{
+	float acc = 0;
+	SpaceVector dq0;
+	for (uint32_t i = 0; i < count; i++){
+		uint32_t k = i & (INPUT_LENGTH-1);
+		abc2DQ0(&dq0, &abc_in[k], theta_in[k]);
+		acc += dq0.real;
+	}
+	return acc;
+}
+
+static float RunDQ02ABC(uint32_t count)
+{
+	float acc = 0;
+	TimeDomain abc;
+	for (uint32_t i = 0; i < count; i++){
+		uint32_t k = i & (INPUT_LENGTH-1);
+		DQ02abc(&abc, &dq0_in[k], theta_in[k]);
+		acc += abc.B;
+	}
+	return acc;
+}
+
+static float RunPIArray(uint32_t count)
+{
+	float acc = 0;
+	for (uint32_t i = 0; i < count; i++){
+		for (int k = 0; k < BANK_CHANNELS; k++){
+			acc += RunPIController(&pid_array[k], error_in[(i + k) & (INPUT_LENGTH-1)]);
+		}
+	}
+	return acc;
+}
+
+static float RunPIBank(uint32_t count)
+{
+	float acc = 0;
+	for (uint32_t i = 0; i < count; i++){
+		for (int k = 0; k < BANK_CHANNELS; k++){ bank.error[k] = error_in[(i + k) & (INPUT_LENGTH-1)]; }
+		RunPIControllerBank(&bank);
+		acc += bank.output[0];
+	}
+	return acc;
+}
+
+static float RunPIDBank(uint32_t count)
+{
+	float acc = 0;
+	for (uint32_t i = 0; i < count; i++){
+		for (int k = 0; k < BANK_CHANNELS; k++){ bank.error[k] = error_in[(i + k) & (INPUT_LENGTH-1)]; }
+		RunPIDControllerBank(&bank);
+		acc += bank.output[0];
+	}
+	return acc;
+}
+
+static float RunPhaseAngle(uint32_t count)
+{
+	float acc = 0;
+	PhaseAngle angle;
+	for (uint32_t i = 0; i < count; i++){
+		UpdatePhaseAngle(&angle, theta_in[i & (INPUT_LENGTH-1)]);
+		acc += angle.sin2Theta;
+	}
+	return acc;
+}
+
+static float RunSinCosLibm(uint32_t count)
+{
+	float acc = 0, s, c;
+	for (uint32_t i = 0; i < count; i++){
+		float x = theta_in[i & (INPUT_LENGTH-1)];
+		s = (float)sin((double)x);											// SINCOS_ENGINE_LIBM
+		c = (float)cos((double)x);
+		acc += s + c;
+	}
+	return acc;
+}
+
+static float RunSinCosTable(uint32_t count)
+{
+	float acc = 0, s, c;
+	for (uint32_t i = 0; i < count; i++){ SinCosTable(theta_in[i & (INPUT_LENGTH-1)], &s, &c); acc += s + c; }
+	return acc;
+}
+
+static float RunSinCosPoly(uint32_t count)
+{
+	float acc = 0, s, c;
+	for (uint32_t i = 0; i < count; i++){ SinCosPoly(theta_in[i & (INPUT_LENGTH-1)], &s, &c); acc += s + c; }
+	return acc;
+}
+
+static float RunPIQ15(uint32_t count)
+{
+	int32_t acc = 0;
+	for (uint32_t i = 0; i < count; i++){ acc += RunPIControllerQ15(&pi_q15, error_q15[i & (INPUT_LENGTH-1)]); }
+	return acc;
+}
+
+static float RunPRQ15(uint32_t count)
+{
+	int32_t acc = 0;
+	for (uint32_t i = 0; i < count; i++){ acc += RunPRControllerQ15(&pr_q15, error_q15[i & (INPUT_LENGTH-1)]); }
+	return acc;
+}
+
+static float RunSOGIQ15(uint32_t count)
+{
+	int32_t acc = 0;
+	for (uint32_t i = 0; i < count; i++){ acc += RunSOGI3Q15(&sogi_q15, abc_q15[i & (INPUT_LENGTH-1)].A).imaginary; }
+	return acc;
+}
+
+static float RunABC2DQ0Q15(uint32_t count)
+{
+	int32_t acc = 0;
+	SpaceVectorQ15 dq0;
+	PhaseAngleQ15 angle;
+	for (uint32_t i = 0; i < count; i++){
+		uint32_t k = i & (INPUT_LENGTH-1);
+		UpdatePhaseAngleQ15(&angle, theta_q15[k]);
+		abc2DQ0(&dq0, &abc_q15[k], &angle);
+		acc += dq0.real;
+	}
+	return acc;
+}
+
+// Mixed B-Box and LTC2314 channels, as a typical UserInterrupt would convert them
+static constexpr SensorChannel sensor_channels[SENSOR_CHANNELS] = {
+	MakeSensorChannel(0, LTC2314_ADC, ADCONV),
+	MakeSensorChannel(1, BBOX_ADC, LEM_LA55_GAIN),
+	MakeSensorChannel(2, BBOX_ADC, LEM_LA55_GAIN),
+	MakeSensorChannel(3, BBOX_ADC, LEM_LA55_GAIN),
+	MakeSensorChannel(4, BBOX_ADC, IX_DIN800V_GAIN, 0.01),
+	MakeSensorChannel(5, BBOX_ADC, IX_DIN800V_GAIN, 0.01),
+	MakeSensorChannel(6, BBOX_ADC, IX_DIN800V_GAIN, 0.01),
+	MakeSensorChannel(7, LTC2314_ADC, LEM_LV100_400_GAIN, 2.048),
+};
+static constexpr SensorRegistry<SENSOR_CHANNELS> sensor_registry(sensor_channels);
+
+static float RunSensorsHand(uint32_t count)
+{
+	float acc = 0;
+	float v[SENSOR_CHANNELS];
+	for (uint32_t i = 0; i < count; i++){
+		const uint16_t* raw = &raw_in[i & (INPUT_LENGTH-1)];
+		v[0] = (raw[0] & 0x3FFF) * (float)LTC2314_ADCONV;
+		v[1] = (int16_t)raw[1] * (float)LEM_LA55_GAIN;
+		v[2] = (int16_t)raw[2] * (float)LEM_LA55_GAIN;
+		v[3] = (int16_t)raw[3] * (float)LEM_LA55_GAIN;
+		v[4] = ((int16_t)raw[4] * (float)ADCONV - 0.01f) * (float)(IX_DIN800V_GAIN / ADCONV);
+		v[5] = ((int16_t)raw[5] * (float)ADCONV - 0.01f) * (float)(IX_DIN800V_GAIN / ADCONV);
+		v[6] = ((int16_t)raw[6] * (float)ADCONV - 0.01f) * (float)(IX_DIN800V_GAIN / ADCONV);
+		v[7] = ((raw[7] & 0x3FFF) * (float)LTC2314_ADCONV - 2.048f) * (float)(LEM_LV100_400_GAIN / ADCONV);
+		acc += v[0] + v[4] + v[7];
+	}
+	return acc;
+}
+
+static float RunSensorsRegistry(uint32_t count)
+{
+	float acc = 0;
+	float v[SENSOR_CHANNELS];
+	for (uint32_t i = 0; i < count; i++){
+		ConvertSensors(sensor_registry, &raw_in[i & (INPUT_LENGTH-1)], v);
+		acc += v[0] + v[4] + v[7];
+	}
+	return acc;
+}
+
+// 10k NTC below a 10k resistor on 4.096 V
+static constexpr ThermalSensor ntc = NtcDivider(LTC2314_ADCONV, 4.096, 10e3, 1.009249522e-3, 2.378405444e-4, 2.019202697e-7, -40.0, 125.0);
+static constexpr TemperatureTable<10> ntc_table(ntc);
+
+static float RunNtcLog(uint32_t count)
+{
+	float acc = 0;
+	for (uint32_t i = 0; i < count; i++){
+		const uint16_t* raw = &raw_in[i & (INPUT_LENGTH-1)];
+		for (int k = 0; k < NTC_CHANNELS; k++){
+			float v = (raw[k] & 0x1FFF) * (float)LTC2314_ADCONV;
+			float l = logf(10e3f * v / (4.096f - v));
+			acc += 1.0f / (1.009249522e-3f + 2.378405444e-4f*l + 2.019202697e-7f*l*l*l) - 273.15f;
+		}
+	}
+	return acc;
+}
+
+static float RunNtcTable(uint32_t count)
+{
+	float acc = 0;
+	float t[NTC_CHANNELS];
+	for (uint32_t i = 0; i < count; i++){
+		ConvertTemperatureBlock(ntc_table, &raw_in[i & (INPUT_LENGTH-1)], t, NTC_CHANNELS);
+		acc += t[0] + t[NTC_CHANNELS-1];
+	}
+	return acc;
+}
+
+// Typical interrupt chain on one angle: abc2DQ0, RunDSRF and DQ02abc
+static float RunChainTheta(uint32_t count)
+{
+	float acc = 0;
+	SpaceVector dq0;
+	TimeDomain abc;
+	for (uint32_t i = 0; i < count; i++){
+		uint32_t k = i & (INPUT_LENGTH-1);
+		abc2DQ0(&dq0, &abc_in[k], theta_in[k]);
+		RunDSRF(&dsrf, &abc_in[k], theta_in[k]);
+		DQ02abc(&abc, &dq0, theta_in[k]);
+		acc += abc.A + dsrf.dqneg.real;
+	}
+	return acc;
+}
+
+static float RunChainAngle(uint32_t count)
+{
+	float acc = 0;
+	SpaceVector dq0;
+	TimeDomain abc;
+	PhaseAngle angle;
+	for (uint32_t i = 0; i < count; i++){
+		uint32_t k = i & (INPUT_LENGTH-1);
+		UpdatePhaseAngle(&angle, theta_in[k]);
+		abc2DQ0(&dq0, &abc_in[k], &angle);
+		RunDSRF(&dsrf, &abc_in[k], &angle);
+		DQ02abc(&abc, &dq0, &angle);
+		acc += abc.A + dsrf.dqneg.real;
+	}
+	return acc;
+}
+
+// Overhead of one profiled stage (two counter reads and the histogram update), around an empty stage
+static float RunProfileScope(uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++){
+		ProfileScope scope(&profiler, 0);
+	}
+	return (float)profiler.stage[0].count;
+}
+
+static const BenchCase cases[] = {
+	{"RunPIDController",	SetupPID,		RunPID},
+	{"RunPIController",		SetupPID,		RunPI},
+	{"RunPRController",		SetupPR,		RunPR},
+	{"RunPRController 5x2",	SetupPRArray,	RunPRArray},
+	{"RunMultiResonant 5x2",	SetupMultiPR,	RunMultiPR},
+	{"Controller<PI>",		SetupPITemplate,	RunPITemplate},
+	{"Controller<PID>",		SetupPIDTemplate,	RunPIDTemplate},
+	{"Controller<PR>",		SetupPRTemplate,	RunPRTemplate},
+	{"RunSOGI3",			SetupSOGI3,		RunSOGI},
+	{"RunSOGI3 x15",		SetupSOGIArray,	RunSOGIArray},
+	{"RunSOGIBank 5x3",		SetupSOGIBank,	RunSOGIBankCase},
+	{"RunHarmonicAnalyzer 7",	SetupAnalyzer,	RunAnalyzer},
+	{"RunDQPLL",			SetupDQPLL,		RunDQ},
+	{"RunSOGIPLL1",			SetupSOGIPLL1,	RunSOGIPLL},
+	{"RunDSOGIPLL3",		SetupDSOGIPLL3,	RunDSOGIPLL},
+	{"RunDSRF",				SetupDSRF,		RunSequences},
+	{"abc2DQ0",				SetupNone,		RunABC2DQ0},
+	{"DQ02abc",				SetupNone,		RunDQ02ABC},
+	{"sin/cos (double)",	SetupNone,		RunSinCosLibm},
+	{"SinCosTable",			SetupNone,		RunSinCosTable},
+	{"SinCosPoly",			SetupNone,		RunSinCosPoly},
+	{"UpdatePhaseAngle",	SetupNone,		RunPhaseAngle},
+	{"chain (theta)",		SetupDSRF,		RunChainTheta},
+	{"chain (PhaseAngle)",	SetupDSRF,		RunChainAngle},
+	{"RunPIController x32",	SetupPIDArray,	RunPIArray},
+	{"RunPIControllerBank32",	SetupBank,	RunPIBank},
+	{"RunPIDControllerBank32",	SetupBank,	RunPIDBank},
+	{"RunPIControllerQ15",	SetupPIQ15,		RunPIQ15},
+	{"RunPRControllerQ15",	SetupPRQ15,		RunPRQ15},
+	{"RunSOGI3Q15",			SetupSOGI3Q15,	RunSOGIQ15},
+	{"abc2DQ0 (Q15)",		SetupNone,		RunABC2DQ0Q15},
+	{"sensors x8 (by hand)",	SetupNone,	RunSensorsHand},
+	{"ConvertSensors x8",	SetupNone,		RunSensorsRegistry},
+	{"NTC logf() x16",		SetupNone,		RunNtcLog},
+	{"ConvertTemperature x16",	SetupNone,	RunNtcTable},
+	{"ProfileScope (empty)",	SetupProfiler,	RunProfileScope},
+};
+
+
+/*
+ * Harness
+ */
+static double NowNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static BenchResult Measure(const BenchCase* bench)
+{
+	double samples[BATCHES];
+	double sum = 0.0;
+
+	bench->setup();
+	sink = bench->run(CALLS_PER_BATCH);										// Warm-up (caches, branch predictors)
+
+	for (int b = 0; b < BATCHES; b++){
+		double start = NowNs();
+		sink = bench->run(CALLS_PER_BATCH);
+		samples[b] = (NowNs() - start) / CALLS_PER_BATCH;
+		sum += samples[b];
+	}
+
+	BenchResult r;
+	r.mean = sum / BATCHES;
+	r.min = samples[0];
+	double var = 0.0;
+	for (int b = 0; b < BATCHES; b++){
+		var += (samples[b] - r.mean) * (samples[b] - r.mean);
+		if (samples[b] < r.min){ r.min = samples[b]; }
+	}
+	r.stddev = sqrt(var / (BATCHES - 1));
+	return r;
+}
+
+// Look up the minimum ns/call of 'name' in a CSV file written with --csv (negative if absent)
+static double LookupBaseline(const char* path, const char* name)
+{
+	FILE* f = fopen(path, "r");
+	if (!f){ return -1.0; }
+
+	char line[256];
+	double found = -1.0;
+	while (fgets(line, sizeof(line), f)){
+		char* comma = strchr(line, ',');
+		if (!comma){ continue; }
+		*comma = '\0';
+		if (strcmp(line, name) == 0){
+			double mean, stddev, min;
+			if (sscanf(comma + 1, "%lf,%lf,%lf", &mean, &stddev, &min) == 3){ found = min; }
+			break;
+		}
+	}
+	fclose(f);
+	return found;
+}
+
+int main(int argc, char** argv)
+{
+	const char* filter = 0;
+	const char* baseline = 0;
+	double tolerance = 10.0;
+	bool csv = false;
+
+	for (int i = 1; i < argc; i++){
+		if (!strcmp(argv[i], "--filter") && i+1 < argc){ filter = argv[++i]; }
+		else if (!strcmp(argv[i], "--csv")){ csv = true; }
+		else if (!strcmp(argv[i], "--baseline") && i+1 < argc){ baseline = argv[++i]; }
+		else if (!strcmp(argv[i], "--tolerance") && i+1 < argc){ tolerance = atof(argv[++i]); }
+		else{
+			fprintf(stderr, "usage: %s [--filter text] [--csv] [--baseline file.csv [--tolerance percent]]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	HostSetCoreState(OPERATING);
+	GenerateInputs();
+
+	if (!csv){
+		printf("%-22s %10s %10s %10s %12s %9s\n", "routine", "mean ns", "stddev ns", "min ns", "Mcalls/s", "budget %");
+	}
+
+	int regressions = 0;
+	for (unsigned c = 0; c < sizeof(cases)/sizeof(cases[0]); c++){
+		if (filter && !strstr(cases[c].name, filter)){ continue; }
+
+		BenchResult r = Measure(&cases[c]);
+		if (csv){
+			printf("%s,%.3f,%.3f,%.3f\n", cases[c].name, r.mean, r.stddev, r.min);
+		}
+		else{
+			printf("%-22s %10.2f %10.2f %10.2f %12.2f %9.4f\n", cases[c].name, r.mean, r.stddev, r.min,
+					1e3 / r.mean, 100.0 * r.mean / BUDGET_NS);
+		}
+
+		if (baseline){
+			double ref = LookupBaseline(baseline, cases[c].name);
+			if (ref > 0.0 && r.min > ref * (1.0 + tolerance / 100.0)){
+				fprintf(stderr, "REGRESSION %s: %.2f ns/call vs. baseline %.2f ns/call\n", cases[c].name, r.min, ref);
+				regressions++;
+			}
+		}
+	}
+
+	return regressions ? 1 : 0;
+}
@@ -0,0 +1,248 @@
+/*
+ *	@title	Conversion, inspection and benchmark of compressed capture files
+ *	@file	capture_tool.cpp
+ *
+ *	Usage:
+ *	  capture_tool encode raw.bin out.ltcap --channels N [--rate Hz] [--block frames]
+ *	        raw.bin: interleaved little-endian uint16 frames (the raw dumps used so far), first tick 0
+ *	  capture_tool decode in.ltcap raw.bin [--channel k] [--from s] [--to s]
+ *	  capture_tool info in.ltcap
+ *	  capture_tool bench [--channels N] [--seconds s] [--file path]
+ *	        writes a synthetic capture (slow ADC codes with noise, one gap), checks that it decodes
+ *	        bit-exactly, then reports the compression ratio, the write, open, full-decode and
+ *	        random-seek speeds
+ */
+
+#include "capturefile.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static double Now(void)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+static int Encode(const char* in, const char* out, uint32_t channels, double rate, uint32_t block)
+{
+	FILE* f = fopen(in, "rb");
+	if (!f){ perror(in); return 1; }
+	CaptureWriter writer;
+	if (!ConfigCaptureWriter(&writer, out, channels, rate, block)){ perror(out); fclose(f); return 1; }
+
+	std::vector<uint16_t> frames((size_t)65536 * channels);
+	uint64_t tick = 0;
+	size_t n;
+	while ((n = fread(frames.data(), channels * sizeof(uint16_t), 65536, f)) > 0){
+		if (!WriteCaptureFrames(&writer, tick, frames.data(), (uint32_t)n)){ perror(out); fclose(f); return 1; }
+		tick += n;
+	}
+	fclose(f);
+	if (!CloseCaptureWriter(&writer)){ perror(out); return 1; }
+	printf("%llu frames of %u channels written to %s\n", (unsigned long long)tick, channels, out);
+	return 0;
+}
+
+
+/*
+ * Tick following the last frame of the capture
+ */
+static uint64_t CaptureEndTick(const CaptureReader* reader)
+{
+	const CaptureHeader* h = reader->header;
+	if (h->blocks == 0){ return 0; }
+	const CaptureIndexEntry* last = &reader->index[h->blocks - 1];
+	return last->first_tick + (h->frames - last->first_frame);
+}
+
+
+static int Decode(const char* in, const char* out, int channel, double from, double to)
+{
+	CaptureReader reader;
+	if (!OpenCaptureReader(&reader, in)){ fprintf(stderr, "%s: not a complete capture file\n", in); return 1; }
+	const CaptureHeader* h = reader.header;
+	if (channel >= (int)h->channels){ fprintf(stderr, "%s: no channel %d\n", in, channel); return 1; }
+
+	// Times are relative to the first frame:
+	uint64_t origin = h->blocks ? reader.index[0].first_tick : 0;
+	uint64_t first = origin + (uint64_t)(from * h->sample_rate);
+	uint64_t last = CaptureEndTick(&reader);
+	if (to > 0 && origin + (uint64_t)(to * h->sample_rate) < last){ last = origin + (uint64_t)(to * h->sample_rate); }
+
+	FILE* f = fopen(out, "wb");
+	if (!f){ perror(out); return 1; }
+	uint32_t width = channel < 0 ? h->channels : 1;
+	std::vector<uint16_t> values((size_t)h->block_frames * width);
+	uint64_t written = 0;
+	for (uint64_t tick = first; tick < last; tick += h->block_frames){
+		uint64_t span = last - tick < h->block_frames ? last - tick : h->block_frames;
+		uint64_t n = ReadCaptureRange(&reader, tick, span, channel, values.data(), 0);
+		if (fwrite(values.data(), width * sizeof(uint16_t), n, f) != n){ perror(out); fclose(f); return 1; }
+		written += n;
+	}
+	fclose(f);
+	CloseCaptureReader(&reader);
+	printf("%llu frames written to %s\n", (unsigned long long)written, out);
+	return 0;
+}
+
+
+static int Info(const char* in)
+{
+	CaptureReader reader;
+	if (!OpenCaptureReader(&reader, in)){ fprintf(stderr, "%s: not a complete capture file\n", in); return 1; }
+	const CaptureHeader* h = reader.header;
+	uint64_t raw = h->frames * h->channels * sizeof(uint16_t);
+
+	uint64_t gaps = 0;
+	for (uint64_t b = 1; b < h->blocks; b++){
+		uint64_t previous_end = reader.index[b-1].first_tick + (reader.index[b].first_frame - reader.index[b-1].first_frame);
+		if (reader.index[b].first_tick != previous_end){ gaps++; }
+	}
+
+	printf("%s: %u channels, %.0f Hz, %llu frames (%.1f s), %llu blocks of up to %u frames, %llu tick gaps\n",
+			in, h->channels, h->sample_rate, (unsigned long long)h->frames, h->frames / h->sample_rate,
+			(unsigned long long)h->blocks, h->block_frames, (unsigned long long)gaps);
+	printf("ticks %llu..%llu, %llu bytes (raw %llu, ratio %.2f, %.2f bits per sample)\n",
+			(unsigned long long)(h->blocks ? reader.index[0].first_tick : 0), (unsigned long long)CaptureEndTick(&reader),
+			(unsigned long long)reader.size, (unsigned long long)raw, (double)raw / reader.size,
+			8.0 * reader.size / (h->frames * h->channels));
+	CloseCaptureReader(&reader);
+	return 0;
+}
+
+
+/*
+ * Synthetic ADC codes: a slow temperature-like drift per channel with +/- 2 LSB of noise
+ */
+static uint16_t SyntheticCode(uint64_t tick, uint32_t channel, uint32_t* noise)
+{
+	*noise = *noise * 1664525u + 1013904223u;
+	double t = tick / 20e3;
+	double level = 6000.0 + 2000.0 * sin(2 * M_PI * t / (60.0 + 13.0 * channel)) + 500.0 * channel;
+	return (uint16_t)(level + (int)((*noise >> 24) % 5) - 2);
+}
+
+static int Bench(uint32_t channels, double seconds, const char* path)
+{
+	const double rate = 20e3;
+	const uint64_t frames = (uint64_t)(seconds * rate);
+	const uint64_t gap_at = frames / 3, gap_length = 1234;					// Samples dropped once
+
+	// Write, 1 s of frames per call:
+	CaptureWriter writer;
+	if (!ConfigCaptureWriter(&writer, path, channels, rate, 0)){ perror(path); return 1; }
+	std::vector<uint16_t> chunk((size_t)rate * channels);
+	uint32_t noise = 1;
+	double write_time = 0.0, start;
+	for (uint64_t f = 0; f < frames; ){
+		uint64_t n = frames - f < (uint64_t)rate ? frames - f : (uint64_t)rate;
+		if (f < gap_at && f + n > gap_at){ n = gap_at - f; }
+		uint64_t tick = f + (f >= gap_at ? gap_length : 0);
+		for (uint64_t k = 0; k < n; k++){
+			for (uint32_t c = 0; c < channels; c++){ chunk[k * channels + c] = SyntheticCode(tick + k, c, &noise); }
+		}
+		start = Now();
+		if (!WriteCaptureFrames(&writer, tick, chunk.data(), (uint32_t)n)){ perror(path); return 1; }
+		write_time += Now() - start;
+		f += n;
+	}
+	start = Now();
+	if (!CloseCaptureWriter(&writer)){ perror(path); return 1; }
+	write_time += Now() - start;
+
+	// Open (map) and full decode, checked against the generator:
+	start = Now();
+	CaptureReader reader;
+	if (!OpenCaptureReader(&reader, path)){ fprintf(stderr, "%s: cannot be opened\n", path); return 1; }
+	double open_time = Now() - start;
+
+	std::vector<uint16_t> block((size_t)reader.header->block_frames * channels);
+	uint64_t errors = 0, decoded = 0;
+	double decode_time = 0.0;
+	noise = 1;
+	for (uint64_t b = 0; b < reader.header->blocks; b++){
+		start = Now();
+		uint32_t n = DecodeCaptureBlock(&reader, b, -1, block.data());
+		decode_time += Now() - start;
+		decoded += n;
+		if (n == 0){ errors++; }
+		uint64_t tick = reader.index[b].first_tick;
+		for (uint32_t k = 0; k < n; k++){
+			for (uint32_t c = 0; c < channels; c++){
+				if (block[(size_t)k * channels + c] != SyntheticCode(tick + k, c, &noise)){ errors++; }
+			}
+		}
+	}
+
+	// Random 10 ms reads of one channel anywhere in the capture:
+	const int seeks = 2000;
+	std::vector<uint16_t> window(200);
+	uint64_t end_tick = CaptureEndTick(&reader), found = 0;
+	start = Now();
+	for (int k = 0; k < seeks; k++){
+		noise = noise * 1664525u + 1013904223u;
+		found += ReadCaptureRange(&reader, (uint64_t)noise * (end_tick - 200) >> 32, 200, k % channels, window.data(), 0);
+	}
+	double seek_time = Now() - start;
+
+	double raw_mb = frames * channels * 2.0 / 1e6;
+	printf("%u channels x %.0f s at 20 kHz: %llu frames, %.1f MB raw -> %.1f MB (ratio %.2f), %llu blocks\n",
+			channels, seconds, (unsigned long long)frames, raw_mb, reader.size / 1e6, raw_mb * 1e6 / reader.size,
+			(unsigned long long)reader.header->blocks);
+	printf("write %.0f MB/s raw, open %.1f us, full decode %.0f MB/s raw, random 10 ms read %.1f us (%llu frames found)\n",
+			raw_mb / write_time, open_time * 1e6, raw_mb / decode_time, seek_time * 1e6 / seeks, (unsigned long long)found);
+	printf("round trip: %llu frames decoded, %llu mismatches -> %s\n",
+			(unsigned long long)decoded, (unsigned long long)errors, errors == 0 && decoded == frames ? "PASS" : "FAIL");
+
+	CloseCaptureReader(&reader);
+	remove(path);
+	return errors == 0 && decoded == frames ? 0 : 1;
+}
+
+
+static int Usage(const char* name)
+{
+	fprintf(stderr, "usage: %s encode raw.bin out.ltcap --channels N [--rate Hz] [--block frames]\n"
+			"       %s decode in.ltcap raw.bin [--channel k] [--from s] [--to s]\n"
+			"       %s info in.ltcap\n"
+			"       %s bench [--channels N] [--seconds s] [--file path]\n", name, name, name, name);
+	return 2;
+}
+
+
+int main(int argc, char** argv)
+{
+	if (argc < 2){ return Usage(argv[0]); }
+	const char* command = argv[1];
+	const char* file[2] = {0, 0};
+	int files = 0;
+	uint32_t channels = 0, block = 0;
+	double rate = 20e3, seconds = 600.0, from = 0.0, to = 0.0;
+	int channel = -1;
+	const char* bench_file = "/tmp/capture_bench.ltcap";
+
+	for (int i = 2; i < argc; i++){
+		if (!strcmp(argv[i], "--channels") && i + 1 < argc){ channels = (uint32_t)atoi(argv[++i]); }
+		else if (!strcmp(argv[i], "--rate") && i + 1 < argc){ rate = atof(argv[++i]); }
+		else if (!strcmp(argv[i], "--block") && i + 1 < argc){ block = (uint32_t)atoi(argv[++i]); }
+		else if (!strcmp(argv[i], "--channel") && i + 1 < argc){ channel = atoi(argv[++i]); }
+		else if (!strcmp(argv[i], "--from") && i + 1 < argc){ from = atof(argv[++i]); }
+		else if (!strcmp(argv[i], "--to") && i + 1 < argc){ to = atof(argv[++i]); }
+		else if (!strcmp(argv[i], "--seconds") && i + 1 < argc){ seconds = atof(argv[++i]); }
+		else if (!strcmp(argv[i], "--file") && i + 1 < argc){ bench_file = argv[++i]; }
+		else if (argv[i][0] != '-' && files < 2){ file[files++] = argv[i]; }
+		else{ return Usage(argv[0]); }
+	}
+
+	if (!strcmp(command, "encode") && files == 2 && channels > 0){ return Encode(file[0], file[1], channels, rate, block); }
+	if (!strcmp(command, "decode") && files == 2){ return Decode(file[0], file[1], channel, from, to); }
+	if (!strcmp(command, "info") && files == 1){ return Info(file[0]); }
+	if (!strcmp(command, "bench") && files == 0){ return Bench(channels ? channels : 4, seconds, bench_file); }
+	return Usage(argv[0]);
+}
@@ -0,0 +1,344 @@
+/*
+ *	@title	Compressed block capture files of 16-bit ADC streams, with a zero-copy mmap reader
+ *	@file	capturefile.cpp
+ */
+
+#include "capturefile.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+static_assert(sizeof(CaptureHeader) == 64, "CaptureHeader is part of the file format");
+static_assert(sizeof(CaptureBlockHeader) == 16, "CaptureBlockHeader is part of the file format");
+static_assert(sizeof(CaptureIndexEntry) == 24, "CaptureIndexEntry is part of the file format");
+
+
+/*
+ * One channel of a block: first value, then delta to the previous value, zigzag mapping
+ * of the signed delta to an unsigned one (0, -1, 1, -2 ... -> 0, 1, 2, 3 ...), stored in whichever
+ * is smaller of:
+ *  - bit packing: all the deltas on the width of the largest one (ADC noise: a few bits per sample)
+ *  - LEB128 varint: 7 bits per byte, MSB set when more bytes follow (rare large steps)
+ * The stream starts with the packing width (or CAPTURE_VARINT) and the first value (16 bits); the
+ * deltas follow, starting with the one of the first value itself (always 0).
+ */
+#define CAPTURE_VARINT		0x80
+
+static uint8_t* EncodeChannel(uint8_t* p, const uint16_t* frames, uint32_t count, uint32_t stride, uint32_t* zigzag)
+{
+	int32_t first = count ? frames[0] : 0;
+	int32_t previous = first;
+	uint32_t all = 0;
+	uint64_t varint_size = 0;
+	for (uint32_t f = 0; f < count; f++){
+		int32_t value = frames[f * stride];
+		int32_t delta = value - previous;
+		uint32_t z = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+		previous = value;
+		zigzag[f] = z;
+		all |= z;
+		varint_size += z < 0x80 ? 1 : (z < 0x4000 ? 2 : 3);
+	}
+
+	uint32_t width = 0;
+	while (width < 32 && (all >> width) != 0){ width++; }
+	uint64_t packed_size = ((uint64_t)width * count + 7) / 8;
+
+	*p++ = packed_size <= varint_size ? (uint8_t)width : CAPTURE_VARINT;
+	*p++ = (uint8_t)first;
+	*p++ = (uint8_t)(first >> 8);
+
+	if (packed_size <= varint_size){
+		uint64_t acc = 0;
+		uint32_t bits = 0;
+		for (uint32_t f = 0; f < count; f++){
+			acc |= (uint64_t)zigzag[f] << bits;
+			bits += width;
+			while (bits >= 8){
+				*p++ = (uint8_t)acc;
+				acc >>= 8;
+				bits -= 8;
+			}
+		}
+		if (bits > 0){ *p++ = (uint8_t)acc; }
+	}
+	else{
+		for (uint32_t f = 0; f < count; f++){
+			uint32_t z = zigzag[f];
+			while (z >= 0x80){
+				*p++ = (uint8_t)(z | 0x80);
+				z >>= 7;
+			}
+			*p++ = (uint8_t)z;
+		}
+	}
+	return p;
+}
+
+static inline uint16_t Unzigzag(int32_t* previous, uint32_t z)
+{
+	*previous += (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+	return (uint16_t)*previous;
+}
+
+static bool DecodeChannel(const uint8_t* p, const uint8_t* end, uint16_t* out, uint32_t count, uint32_t stride)
+{
+	if (end - p < 3){ return false; }
+	uint8_t mode = p[0];
+	int32_t previous = p[1] | (p[2] << 8);
+	p += 3;
+
+	if (mode != CAPTURE_VARINT){
+		uint32_t width = mode;
+		if (width > 17 || (uint64_t)(end - p) != ((uint64_t)width * count + 7) / 8){ return false; }
+		uint32_t mask = (1u << width) - 1;
+		uint64_t acc = 0;
+		uint32_t bits = 0;
+		for (uint32_t f = 0; f < count; f++){
+			while (bits < width){
+				acc |= (uint64_t)*p++ << bits;
+				bits += 8;
+			}
+			out[f * stride] = Unzigzag(&previous, (uint32_t)acc & mask);
+			acc >>= width;
+			bits -= width;
+		}
+		return true;
+	}
+
+	for (uint32_t f = 0; f < count; f++){
+		uint32_t z;
+		if (p < end && *p < 0x80){ z = *p++; }								// Fast path: small delta
+		else{
+			z = 0;
+			for (int shift = 0; ; shift += 7){
+				if (p >= end || shift > 14){ return false; }
+				uint8_t byte = *p++;
+				z |= (uint32_t)(byte & 0x7F) << shift;
+				if (byte < 0x80){ break; }
+			}
+		}
+		out[f * stride] = Unzigzag(&previous, z);
+	}
+	return p == end;
+}
+
+
+static bool FlushBlock(CaptureWriter* me)
+{
+	if (me->pending == 0){ return true; }
+	uint32_t channels = me->header.channels;
+
+	CaptureBlockHeader* block = (CaptureBlockHeader*)me->encoded;
+	uint32_t* sizes = (uint32_t*)(me->encoded + sizeof(CaptureBlockHeader));
+	uint8_t* p = (uint8_t*)(sizes + channels);
+	for (uint32_t c = 0; c < channels; c++){
+		uint8_t* start = p;
+		p = EncodeChannel(p, me->frames + c, me->pending, channels, me->zigzag);
+		sizes[c] = (uint32_t)(p - start);
+	}
+	block->first_tick = me->pending_tick;
+	block->frames = me->pending;
+	block->size = (uint32_t)(p - me->encoded);
+
+	if (me->header.blocks == me->index_capacity){
+		me->index_capacity = me->index_capacity ? 2 * me->index_capacity : 1024;
+		me->index = (CaptureIndexEntry*)realloc(me->index, me->index_capacity * sizeof(CaptureIndexEntry));
+		if (!me->index){ return false; }
+	}
+	CaptureIndexEntry* entry = &me->index[me->header.blocks++];
+	entry->first_tick = me->pending_tick;
+	entry->first_frame = me->header.frames;
+	entry->offset = me->offset;
+
+	if (fwrite(me->encoded, 1, block->size, me->file) != block->size){ return false; }
+	me->offset += block->size;
+	me->header.frames += me->pending;
+	me->pending = 0;
+	return true;
+}
+
+
+bool ConfigCaptureWriter(CaptureWriter* me, const char* path, uint32_t channels, double sample_rate, uint32_t block_frames)
+{
+	memset(me, 0, sizeof(*me));
+	if (channels == 0 || channels > CAPTURE_MAX_CHANNELS){ return false; }
+	if (block_frames == 0){ block_frames = CAPTURE_DEFAULT_BLOCK; }
+
+	memcpy(me->header.magic, CAPTURE_MAGIC, sizeof(me->header.magic));
+	me->header.channels = channels;
+	me->header.block_frames = block_frames;
+	me->header.sample_rate = sample_rate;
+
+	me->frames = (uint16_t*)malloc((size_t)block_frames * channels * sizeof(uint16_t));
+	me->encoded = (uint8_t*)malloc(sizeof(CaptureBlockHeader) + 7 * channels + (size_t)3 * block_frames * channels);
+	me->zigzag = (uint32_t*)malloc((size_t)block_frames * sizeof(uint32_t));
+	me->file = fopen(path, "wb");
+	if (!me->frames || !me->encoded || !me->zigzag || !me->file){
+		if (me->file){ fclose(me->file); }
+		free(me->frames);
+		free(me->encoded);
+		free(me->zigzag);
+		return false;
+	}
+
+	// Header of an incomplete capture (index_offset = 0), rewritten by CloseCaptureWriter:
+	me->offset = sizeof(CaptureHeader);
+	return fwrite(&me->header, sizeof(CaptureHeader), 1, me->file) == 1;
+}
+
+
+bool WriteCaptureFrames(CaptureWriter* me, uint64_t first_tick, const uint16_t* values, uint32_t frames)
+{
+	uint32_t channels = me->header.channels;
+	while (frames > 0){
+		bool contiguous = me->pending > 0 && first_tick == me->pending_tick + me->pending;
+		if (me->pending == me->header.block_frames || (me->pending > 0 && !contiguous)){
+			if (!FlushBlock(me)){ return false; }
+		}
+		if (me->pending == 0){ me->pending_tick = first_tick; }
+
+		uint32_t n = me->header.block_frames - me->pending;
+		if (n > frames){ n = frames; }
+		memcpy(me->frames + (size_t)me->pending * channels, values, (size_t)n * channels * sizeof(uint16_t));
+		me->pending += n;
+		values += (size_t)n * channels;
+		first_tick += n;
+		frames -= n;
+	}
+	return true;
+}
+
+
+bool CloseCaptureWriter(CaptureWriter* me)
+{
+	bool ok = FlushBlock(me);
+
+	me->header.index_offset = me->offset;
+	ok = ok && fwrite(me->index, sizeof(CaptureIndexEntry), me->header.blocks, me->file) == me->header.blocks;
+	ok = ok && fseek(me->file, 0, SEEK_SET) == 0;
+	ok = ok && fwrite(&me->header, sizeof(CaptureHeader), 1, me->file) == 1;
+	ok = (fclose(me->file) == 0) && ok;
+
+	free(me->frames);
+	free(me->encoded);
+	free(me->zigzag);
+	free(me->index);
+	me->file = 0;
+	return ok;
+}
+
+
+bool OpenCaptureReader(CaptureReader* me, const char* path)
+{
+	memset(me, 0, sizeof(*me));
+	int fd = open(path, O_RDONLY);
+	if (fd < 0){ return false; }
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(CaptureHeader)){ close(fd); return false; }
+	void* map = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);																	// The mapping keeps the file open
+	if (map == MAP_FAILED){ return false; }
+
+	me->map = (const uint8_t*)map;
+	me->size = st.st_size;
+	me->header = (const CaptureHeader*)map;
+
+	const CaptureHeader* h = me->header;
+	bool valid = memcmp(h->magic, CAPTURE_MAGIC, sizeof(h->magic)) == 0
+			&& h->channels > 0 && h->channels <= CAPTURE_MAX_CHANNELS && h->block_frames > 0
+			&& h->index_offset >= sizeof(CaptureHeader) && h->index_offset <= me->size
+			&& h->blocks <= (me->size - h->index_offset) / sizeof(CaptureIndexEntry);
+	if (!valid){
+		CloseCaptureReader(me);
+		return false;
+	}
+	me->index = (const CaptureIndexEntry*)(me->map + h->index_offset);
+	return true;
+}
+
+
+static uint64_t BlockFrames(const CaptureReader* me, uint64_t block)
+{
+	uint64_t next = block + 1 < me->header->blocks ? me->index[block + 1].first_frame : me->header->frames;
+	return next - me->index[block].first_frame;
+}
+
+
+uint64_t FindCaptureBlock(const CaptureReader* me, uint64_t tick)
+{
+	// Last block starting at or before the tick:
+	uint64_t low = 0, high = me->header->blocks;
+	while (low < high){
+		uint64_t mid = low + (high - low) / 2;
+		if (me->index[mid].first_tick <= tick){ low = mid + 1; }
+		else{ high = mid; }
+	}
+	if (low == 0){ return 0; }
+	uint64_t block = low - 1;
+	return tick < me->index[block].first_tick + BlockFrames(me, block) ? block : block + 1;
+}
+
+
+uint32_t DecodeCaptureBlock(const CaptureReader* me, uint64_t block, int channel, uint16_t* out)
+{
+	uint32_t channels = me->header->channels;
+	if (block >= me->header->blocks || channel >= (int)channels){ return 0; }
+
+	uint64_t offset = me->index[block].offset;
+	if (offset + sizeof(CaptureBlockHeader) + 4 * channels > me->header->index_offset){ return 0; }
+	const CaptureBlockHeader* b = (const CaptureBlockHeader*)(me->map + offset);
+	if (b->frames > me->header->block_frames || offset + b->size > me->header->index_offset){ return 0; }
+
+	const uint32_t* sizes = (const uint32_t*)(b + 1);
+	const uint8_t* stream = (const uint8_t*)(sizes + channels);
+	const uint8_t* end = me->map + offset + b->size;
+	for (uint32_t c = 0; c < channels; c++){
+		if (sizes[c] > (uint64_t)(end - stream)){ return 0; }
+		if (channel < 0 && !DecodeChannel(stream, stream + sizes[c], out + c, b->frames, channels)){ return 0; }
+		if (channel == (int)c){ return DecodeChannel(stream, stream + sizes[c], out, b->frames, 1) ? b->frames : 0; }
+		stream += sizes[c];
+	}
+	return b->frames;
+}
+
+
+uint64_t ReadCaptureRange(const CaptureReader* me, uint64_t first_tick, uint64_t frames, int channel, uint16_t* out, uint64_t* ticks)
+{
+	uint32_t width = channel < 0 ? me->header->channels : 1;
+	std::vector<uint16_t> scratch((size_t)me->header->block_frames * width);
+	uint64_t end_tick = first_tick + frames;
+	uint64_t written = 0;
+
+	for (uint64_t block = FindCaptureBlock(me, first_tick); block < me->header->blocks; block++){
+		uint64_t block_tick = me->index[block].first_tick;
+		if (block_tick >= end_tick){ break; }
+
+		uint32_t n = DecodeCaptureBlock(me, block, channel, scratch.data());
+		uint64_t from = first_tick > block_tick ? first_tick - block_tick : 0;
+		uint64_t to = end_tick - block_tick < n ? end_tick - block_tick : n;
+		if (from >= to){ continue; }
+
+		memcpy(out + written * width, scratch.data() + from * width, (size_t)(to - from) * width * sizeof(uint16_t));
+		if (ticks){
+			for (uint64_t f = from; f < to; f++){ ticks[written + f - from] = block_tick + f; }
+		}
+		written += to - from;
+	}
+	return written;
+}
+
+
+void CloseCaptureReader(CaptureReader* me)
+{
+	if (me->map){ munmap((void*)me->map, me->size); }
+	me->map = 0;
+	me->header = 0;
+	me->index = 0;
+}
@@ -0,0 +1,168 @@
+/*
+ *	@title	Compressed block capture files of 16-bit ADC streams, with a zero-copy mmap reader
+ *	@file	capturefile.h
+ *
+ *	A capture holds frames of N 16-bit channels (e.g. LT2314_driver data_out and other SBI registers)
+ *	sampled at a constant rate and tagged with the interrupt tick of their first frame. The frames
+ *	are grouped into blocks of consecutive ticks (a block is closed early at a tick discontinuity,
+ *	e.g. samples dropped by a SampleBuffer). Inside a block every channel is stored on its own as
+ *	zigzag-coded deltas, either bit-packed on the width of the largest delta or as LEB128 varints
+ *	(whichever is smaller), so a slowly varying ADC code costs the few bits of its noise instead of
+ *	16, and one channel can be decoded without touching the others. A channel of full-scale white
+ *	noise is the worst case (17 bits per sample).
+ *
+ *	File layout (little endian):
+ *	 - CaptureHeader (64 bytes)
+ *	 - blocks: CaptureBlockHeader, then N uint32 channel stream sizes, then the N streams (one mode
+ *	   byte: packing width or 0x80 for varints, the first value, then the deltas)
+ *	 - index: one CaptureIndexEntry per block, ordered by tick (written by CloseCaptureWriter)
+ *	The reader maps the file and uses the index in place: opening is O(1) whatever the size, a
+ *	seek by time is a binary search in the index, and only the blocks that are read get decoded.
+ */
+
+#ifndef CAPTUREFILE_H_
+#define CAPTUREFILE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define CAPTURE_MAGIC				"LTCAP01"
+#define CAPTURE_MAX_CHANNELS		64
+#define CAPTURE_DEFAULT_BLOCK		4096			// Frames per block (0.2 s at 20 kHz)
+
+
+typedef struct{
+	char magic[8];							// CAPTURE_MAGIC
+	uint32_t channels;
+	uint32_t block_frames;					// Maximum number of frames per block
+	double sample_rate;						// Frames per second (one tick per frame)
+	uint64_t frames;						// Total number of frames
+	uint64_t blocks;						// Number of blocks (entries of the index)
+	uint64_t index_offset;					// File offset of the index, 0 while the file is being written
+	uint8_t reserved[16];
+} CaptureHeader;
+
+typedef struct{
+	uint64_t first_tick;					// Tick of the first frame
+	uint32_t frames;
+	uint32_t size;							// Bytes of the block, header included
+} CaptureBlockHeader;
+
+typedef struct{
+	uint64_t first_tick;
+	uint64_t first_frame;					// Number of frames in the previous blocks
+	uint64_t offset;						// File offset of the CaptureBlockHeader
+} CaptureIndexEntry;
+
+
+/**
+ * Pseudo-object describing a capture being written
+ */
+typedef struct{
+	FILE* file;
+	CaptureHeader header;
+	uint64_t offset;						// Current end of the file
+	uint16_t* frames;						// Pending block, frame after frame (block_frames * channels)
+	uint32_t pending;						// Frames in the pending block
+	uint64_t pending_tick;					// Tick of its first frame
+	uint8_t* encoded;						// Encoding scratch (worst case of one block)
+	uint32_t* zigzag;						// Deltas of one channel of the pending block
+	CaptureIndexEntry* index;
+	uint64_t index_capacity;
+} CaptureWriter;
+
+
+/**
+ * Pseudo-object describing a mapped capture
+ */
+typedef struct{
+	const uint8_t* map;
+	uint64_t size;
+	const CaptureHeader* header;
+	const CaptureIndexEntry* index;			// Points into the mapping (zero copy)
+} CaptureReader;
+
+
+/**
+ * Routine to create a capture file
+ * @param *me				the writer pseudo-object
+ * @param path				the file name
+ * @param channels			the number of channels per frame
+ * @param sample_rate		the frame rate in Hz
+ * @param block_frames		the maximum number of frames per block (0: CAPTURE_DEFAULT_BLOCK)
+ * @return					false if the file cannot be created
+ */
+bool ConfigCaptureWriter(CaptureWriter* me, const char* path, uint32_t channels, double sample_rate, uint32_t block_frames);
+
+
+/**
+ * Routine to append frames of consecutive ticks
+ * @param *me				the writer pseudo-object
+ * @param first_tick		the tick of the first frame
+ * @param *values			frames*channels values, frame after frame
+ * @param frames			the number of frames
+ * @return					false on a write error
+ */
+bool WriteCaptureFrames(CaptureWriter* me, uint64_t first_tick, const uint16_t* values, uint32_t frames);
+
+
+/**
+ * Routine to flush the last block, write the index and close the file
+ * @param *me				the writer pseudo-object
+ * @return					false on a write error
+ */
+bool CloseCaptureWriter(CaptureWriter* me);
+
+
+/**
+ * Routine to map a capture file (nothing is read or decoded)
+ * @param *me				the reader pseudo-object
+ * @param path				the file name
+ * @return					false if the file cannot be mapped or is not a complete capture
+ */
+bool OpenCaptureReader(CaptureReader* me, const char* path);
+
+
+/**
+ * Routine to find the block holding a tick
+ * @param *me				the reader pseudo-object
+ * @param tick				the tick searched
+ * @return					the block number, or the next block if the tick falls into a gap
+ *							(header->blocks if there is none)
+ */
+uint64_t FindCaptureBlock(const CaptureReader* me, uint64_t tick);
+
+
+/**
+ * Routine to decode one block
+ * @param *me				the reader pseudo-object
+ * @param block				the block number
+ * @param channel			the channel to decode, or -1 for all of them
+ * @param *out				the values: frames values for one channel, frames*channels frame after
+ *							frame for all of them (at most block_frames frames)
+ * @return					the number of frames of the block, 0 if it is corrupted
+ */
+uint32_t DecodeCaptureBlock(const CaptureReader* me, uint64_t block, int channel, uint16_t* out);
+
+
+/**
+ * Routine to read the frames of a tick range, decoding only the blocks it covers
+ * @param *me				the reader pseudo-object
+ * @param first_tick		the first tick
+ * @param frames			the number of ticks
+ * @param channel			the channel to read, or -1 for all of them
+ * @param *out				the values (same layout as DecodeCaptureBlock); ticks missing from the capture are not written
+ * @param *ticks			the tick of each frame written (optional)
+ * @return					the number of frames written
+ */
+uint64_t ReadCaptureRange(const CaptureReader* me, uint64_t first_tick, uint64_t frames, int channel, uint16_t* out, uint64_t* ticks);
+
+
+/**
+ * Routine to unmap the file
+ * @param *me				the reader pseudo-object
+ * @return void
+ */
+void CloseCaptureReader(CaptureReader* me);
+
+#endif /* CAPTUREFILE_H_ */
@@ -0,0 +1,209 @@
+/*
+ *	@title	Coherence of the multi-register ADC reads when the FPGA publishes during the read
+ *	@file	adc_read_check.cpp
+ *
+ *	The SBI registers of LT2314_driver are served by a source that counts the Sbi_Read() calls and
+ *	publishes a new burst (data_out, sum, count and sequence_out, on the same clock as in the VHDL)
+ *	just before given reads. For every position of one or two publications within the reads:
+ *	 - ReadOversampledAdc must either return the value of a single burst, or report the read as torn
+ *	   and keep the previous value. The old and new sums straddle a 16-bit boundary, so that a sum
+ *	   mixing the LSBs of one burst and the MSBs of the other cannot go unnoticed.
+ *	 - ReadAdcSample must either return a sample with its own sequence number, or report it as torn
+ *	   (conversions of a burst completing during the read and during the retry).
+ *	 - ReadAdcFrame (LT2314_multi_driver) must either return the channels of the frame whose number it
+ *	   returns, or report the frame as torn.
+ *
+ *	Usage: adc_read_check
+ */
+
+#include "My_functions/adc_oversampling.h"
+#include "My_functions/multichannel_adc.h"
+#include "My_functions/sequenced_adc.h"
+
+#include <cstdio>
+
+#define BURST			16
+#define SBI_DATA		0
+#define SBI_SUM			1					// Sum LSBs, MSBs and count at SBI_SUM..SBI_SUM+2
+#define SBI_SEQUENCE	4
+#define SBI_FRAME		8					// Channels of LT2314_multi_driver, then its sequence_out
+#define FRAME_CHANNELS	3
+#define MAX_EVENTS		2
+
+/*
+ * Registers of LT2314_driver, published atomically before the reads listed in events[]
+ */
+typedef struct{
+	uint16_t burst;							// Number of the last burst published
+	unsigned int reads;						// Sbi_Read() calls so far
+	unsigned int events[MAX_EVENTS];		// Read indices (from 1) before which a burst is published
+	int event_count;
+} RegisterModel;
+
+static RegisterModel model;
+
+static uint16_t BurstCode(uint16_t burst){ return 4095 + burst; }		// Sum 0xFFF0, then 0x10000, ...
+static uint16_t FrameCode(uint16_t frame, uint16_t channel){ return 1000 * channel + frame; }
+
+static unsigned int ModelSbiRead(unsigned int address)
+{
+	model.reads++;
+	for (int k = 0; k < model.event_count; k++){
+		if (model.events[k] == model.reads){ model.burst++; }
+	}
+
+	uint16_t code = BurstCode(model.burst);
+	uint32_t sum = (uint32_t)code * BURST;
+	if (address >= SBI_FRAME && address < SBI_FRAME + FRAME_CHANNELS){ return FrameCode(model.burst, address - SBI_FRAME); }
+	if (address == SBI_FRAME + FRAME_CHANNELS){ return ADC_SEQUENCE_VALID | model.burst; }		// One frame per publication
+	switch (address){
+	case SBI_DATA:		return code;
+	case SBI_SUM:		return sum & 0xFFFF;
+	case SBI_SUM + 1:	return sum >> 16;
+	case SBI_SUM + 2:	return BURST;
+	case SBI_SEQUENCE:	return ADC_SEQUENCE_VALID | ((model.burst * BURST) & ADC_SEQUENCE_MASK);
+	default:			return 0;
+	}
+}
+
+static void ResetModel(unsigned int first, unsigned int second)
+{
+	model.burst = 0;
+	model.reads = 0;
+	model.event_count = 0;
+	if (first){ model.events[model.event_count++] = first; }
+	if (second){ model.events[model.event_count++] = second; }
+}
+
+
+/*
+ * ReadOversampledAdc: 5 reads per attempt (sequence, sum LSBs, sum MSBs, count, sequence), 9 for two
+ */
+static int CheckOversampling(void)
+{
+	static const unsigned int reads = 9;
+	int failures = 0, torn_cases = 0, retried_cases = 0, cases = 0;
+
+	for (unsigned int first = 0; first <= reads; first++){
+		for (unsigned int second = 0; second <= reads; second++){
+			if (second && (!first || second <= first)){ continue; }		// None, one, or two in order
+
+			OversampledAdc adc;
+			ConfigOversampledAdc(&adc, BURST, 1.0f, 1, SBI_SUM, SBI_SEQUENCE);
+			adc.value = -1.0f;												// Previous value
+
+			ResetModel(first, second);
+			float value = ReadOversampledAdc(&adc);
+
+			// A single burst, whichever, or the previous value reported as torn:
+			bool single = value == BurstCode(0) || value == BurstCode(1) || value == BurstCode(2);
+			bool ok = adc.coherent ? single && adc.torn == 0 : value == -1.0f && adc.torn == 1;
+			if (!adc.coherent){ torn_cases++; }
+			if (adc.retries){ retried_cases++; }
+			if (!ok){
+				printf("  FAIL: bursts published before reads %u and %u: value %.1f, coherent %d, torn %u\n", first, second,
+						value, adc.coherent, adc.torn);
+				failures++;
+			}
+			cases++;
+		}
+	}
+
+	printf("ReadOversampledAdc: %d publication patterns, %d retried, %d reported torn, %d wrong\n", cases, retried_cases,
+			torn_cases, failures);
+	return failures + (torn_cases == 0) + (retried_cases == 0);		// Both paths must be exercised
+}
+
+
+/*
+ * ReadAdcSample: 3 reads per attempt (sequence, data, sequence), 5 for two
+ */
+static int CheckSequenced(void)
+{
+	static const unsigned int reads = 5;
+	int failures = 0, torn_cases = 0, retried_cases = 0, cases = 0;
+
+	for (unsigned int first = 0; first <= reads; first++){
+		for (unsigned int second = 0; second <= reads; second++){
+			if (second && (!first || second <= first)){ continue; }
+
+			SequencedAdc adc;
+			ConfigSequencedAdc(&adc, SBI_DATA, SBI_SEQUENCE, BURST);
+
+			ResetModel(first, second);
+			AdcSample s = ReadAdcSample(&adc);
+
+			// The conversion numbered s.sequence, or an older one reported as torn:
+			uint16_t expected = BurstCode(s.sequence / BURST);
+			bool ok = s.coherent ? s.sample == expected && adc.torn == 0 : s.sample <= expected && adc.torn == 1;
+			if (!s.coherent){ torn_cases++; }
+			if (adc.retries){ retried_cases++; }
+			if (!ok){
+				printf("  FAIL: conversions published before reads %u and %u: sample %u, sequence %u, coherent %d, torn %u\n",
+						first, second, s.sample, s.sequence, s.coherent, adc.torn);
+				failures++;
+			}
+			cases++;
+		}
+	}
+
+	printf("ReadAdcSample: %d publication patterns, %d retried, %d reported torn, %d wrong\n", cases, retried_cases,
+			torn_cases, failures);
+	return failures + (torn_cases == 0) + (retried_cases == 0);
+}
+
+
+/*
+ * ReadAdcFrame: FRAME_CHANNELS + 1 reads per attempt after the first frame number, 9 for two
+ */
+static int CheckFrame(void)
+{
+	static const unsigned int reads = 1 + 2 * (FRAME_CHANNELS + 1);
+	int failures = 0, torn_cases = 0, retried_cases = 0, cases = 0;
+
+	for (unsigned int first = 0; first <= reads; first++){
+		for (unsigned int second = 0; second <= reads; second++){
+			if (second && (!first || second <= first)){ continue; }
+
+			MultiChannelAdc adc;
+			ConfigMultiChannelAdc(&adc, FRAME_CHANNELS, SBI_FRAME);
+
+			ResetModel(first, second);
+			uint16_t raw[FRAME_CHANNELS];
+			uint16_t number = ReadAdcFrame(&adc, raw);
+
+			// All the channels of the frame returned, or reported as torn:
+			bool single = true;
+			for (uint16_t k = 0; k < FRAME_CHANNELS; k++){
+				if (raw[k] != FrameCode(number, k)){ single = false; }
+			}
+			bool ok = adc.coherent ? single && adc.torn == 0 : adc.torn == 1;
+			if (!adc.coherent){ torn_cases++; }
+			if (adc.retries){ retried_cases++; }
+			if (!ok){
+				printf("  FAIL: frames published before reads %u and %u: frame %u, channels %u %u %u, coherent %d, torn %u\n",
+						first, second, number, raw[0], raw[1], raw[2], adc.coherent, adc.torn);
+				failures++;
+			}
+			cases++;
+		}
+	}
+
+	printf("ReadAdcFrame: %d publication patterns, %d retried, %d reported torn, %d wrong\n", cases, retried_cases,
+			torn_cases, failures);
+	return failures + (torn_cases == 0) + (retried_cases == 0);
+}
+
+
+int main(void)
+{
+	HostSetSbiSource(ModelSbiRead);
+
+	int failures = CheckOversampling();
+	failures += CheckSequenced();
+	failures += CheckFrame();
+
+	HostSetSbiSource(0);
+	printf("%s\n", failures ? "FAIL" : "PASS");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,129 @@
+/*
+ *	@title	Bit-exactness of the controller bank against the scalar PI and PID controllers
+ *	@file	controllerbank_check.cpp
+ *
+ *	A PIDControllerBank and one PIDController per channel are configured with the same random gains
+ *	and limits, then stepped on the same random errors, large enough to drive the outputs into both
+ *	saturations regularly. After every step the outputs and the states (ui_prev, ud_prev, e_prev) of
+ *	RunPIControllerBank and RunPIDControllerBank must equal those of RunPIController and
+ *	RunPIDController bit for bit. The channel count is not a multiple of SIMD_WIDTH (padding lanes).
+ *	The core is BLOCKED for 100 steps every 2000: neither is registered to a ControlContext, so both must
+ *	clear their integrals on each of these calls.
+ *
+ *	Usage: controllerbank_check [--steps N]
+ */
+
+#include "controllerbank.h"
+#include "controllers.h"
+#include "Core/core.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define CHANNELS	13
+#define TSAMPLE		50e-6
+
+typedef float (*tScalarController)(PIDController*, float);
+typedef void (*tBankController)(PIDControllerBank*);
+
+static uint32_t seed = 1;
+
+// Uniform in [low, high)
+static float Random(float low, float high)
+{
+	seed = seed * 1664525u + 1013904223u;
+	return low + (high - low) * ((seed >> 8) * (1.0f / 16777216));
+}
+
+static bool SameFloat(float a, float b)
+{
+	return !memcmp(&a, &b, sizeof(float));
+}
+
+typedef struct{
+	uint64_t steps;
+	uint64_t high;							// Steps saturated at limup, resp. limlow (all channels)
+	uint64_t low;
+	uint64_t mismatches;
+	uint64_t not_reset;						// Integrals left while BLOCKED
+} CheckResult;
+
+static void RunCheck(CheckResult* result, const char* name, tScalarController scalar, tBankController bank_run, uint64_t steps)
+{
+	static PIDControllerBank bank;
+	PIDController pid[CHANNELS];
+
+	ConfigPIDControllerBank(&bank, CHANNELS);
+	for (int k = 0; k < CHANNELS; k++){
+		float kp = Random(0.05f, 20.0f);
+		float ki = Random(0.0f, 0.5f);
+		float td = k % 3 ? Random(0.0f, 1e-3f) : 0.0f;
+		float limup = Random(0.5f, 50.0f);
+		float limlow = -Random(0.5f, 50.0f);
+		uint16_t N = 2 + k;
+		ConfigPIDController(&pid[k], kp, ki, td, limup, limlow, TSAMPLE, N);
+		ConfigPIDControllerBankChannel(&bank, k, kp, ki, td, limup, limlow, TSAMPLE, N);
+	}
+
+	memset(result, 0, sizeof(*result));
+	for (uint64_t n = 0; n < steps; n++){
+		float bias = (n / 500) % 3 == 0 ? 0.0f : ((n / 500) % 3 == 1 ? 5.0f : -5.0f);	// Long runs into each saturation
+		for (int k = 0; k < CHANNELS; k++){ bank.error[k] = bias + Random(-2.0f, 2.0f); }
+		bool blocked = n % 2000 >= 1900;
+		HostSetCoreState(blocked ? BLOCKED : OPERATING);
+
+		bank_run(&bank);
+		for (int k = 0; k < CHANNELS; k++){
+			float u = scalar(&pid[k], bank.error[k]);
+			if (u == pid[k].limup){ result->high++; }
+			if (u == pid[k].limlow){ result->low++; }
+			if (blocked && pid[k].ui_prev != 0.0f){ result->not_reset++; }
+
+			bool same = SameFloat(u, bank.output[k]) && SameFloat(pid[k].ui_prev, bank.ui_prev[k]);
+			if (scalar == RunPIDController){
+				same = same && SameFloat(pid[k].ud_prev, bank.ud_prev[k]) && SameFloat(pid[k].e_prev, bank.e_prev[k]);
+			}
+			if (!same){
+				if (result->mismatches < 5){
+					printf("  %s: step %llu, channel %d: output %.9g vs %.9g, ui_prev %.9g vs %.9g\n", name,
+							(unsigned long long)n, k, u, bank.output[k], pid[k].ui_prev, bank.ui_prev[k]);
+				}
+				result->mismatches++;
+			}
+		}
+		result->steps++;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint64_t steps = 200000;
+	for (int i = 1; i < argc; i++){
+		if (!strcmp(argv[i], "--steps") && i + 1 < argc){ steps = (uint64_t)atof(argv[++i]); }
+		else{
+			fprintf(stderr, "usage: %s [--steps N]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	printf("%d channels, SIMD_WIDTH %d, %llu steps\n", CHANNELS, SIMD_WIDTH, (unsigned long long)steps);
+	printf("  routine      saturated high   saturated low   mismatches   not reset\n");
+
+	int failures = 0;
+	static const struct{ const char* name; tScalarController scalar; tBankController bank; } cases[] = {
+		{"PI", RunPIController, RunPIControllerBank},
+		{"PID", RunPIDController, RunPIDControllerBank},
+	};
+	for (const auto& c : cases){
+		CheckResult r;
+		RunCheck(&r, c.name, c.scalar, c.bank, steps);
+		bool ok = r.mismatches == 0 && r.not_reset == 0 && r.high > 0 && r.low > 0;		// Both saturations exercised
+		if (!ok){ failures++; }
+		printf("  %-9s  %16llu  %14llu  %11llu  %10llu  %s\n", c.name, (unsigned long long)r.high, (unsigned long long)r.low,
+				(unsigned long long)r.mismatches, (unsigned long long)r.not_reset, ok ? "" : "FAIL");
+	}
+
+	printf("%s\n", failures ? "FAIL" : "PASS");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,155 @@
+/*
+ *	@title	Bit-exactness of the template controllers against the scalar PI and PID controllers
+ *	@file	controllertemplate_check.cpp
+ *
+ *	Controller<PIStructure, BackCalculation> (the loop filter of the PLLs) and
+ *	Controller<PIDStructure, BackCalculation> are configured with the same random gains and limits as
+ *	PIDControllers, then stepped on the same random errors, large enough to drive the outputs into both
+ *	saturations regularly. After every step the outputs and the states (ui_prev, ud_prev, e_prev) must
+ *	equal those of RunPIController and RunPIDController bit for bit, the back-calculated integral
+ *	included.
+ *
+ *	Usage: controllertemplate_check [--steps N]
+ */
+
+#include "controllers.h"
+#include "controllertemplate.h"
+#include "Core/core.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define CONTROLLERS	16
+#define TSAMPLE		50e-6
+
+static uint32_t seed = 1;
+
+// Uniform in [low, high)
+static float Random(float low, float high)
+{
+	seed = seed * 1664525u + 1013904223u;
+	return low + (high - low) * ((seed >> 8) * (1.0f / 16777216));
+}
+
+static bool SameFloat(float a, float b)
+{
+	return !memcmp(&a, &b, sizeof(float));
+}
+
+typedef struct{
+	uint64_t steps;
+	uint64_t high;							// Steps saturated at limup, resp. limlow (all controllers)
+	uint64_t low;
+	uint64_t mismatches;
+} CheckResult;
+
+// Error of step n: long runs into each saturation, plus noise
+static float Error(uint64_t n)
+{
+	float bias = (n / 500) % 3 == 0 ? 0.0f : ((n / 500) % 3 == 1 ? 5.0f : -5.0f);
+	return bias + Random(-2.0f, 2.0f);
+}
+
+static void Count(CheckResult* result, const PIDController* pid, float u, bool same, const char* name, uint64_t n, int k)
+{
+	if (u == pid->limup){ result->high++; }
+	if (u == pid->limlow){ result->low++; }
+	if (!same){
+		if (result->mismatches < 5){
+			printf("  %s: step %llu, controller %d: output %.9g, ui_prev %.9g\n", name, (unsigned long long)n, k, u, pid->ui_prev);
+		}
+		result->mismatches++;
+	}
+}
+
+static void CheckPI(CheckResult* result, uint64_t steps)
+{
+	Controller<PIStructure, BackCalculation> pi[CONTROLLERS];
+	PIDController pid[CONTROLLERS];
+
+	for (int k = 0; k < CONTROLLERS; k++){
+		float kp = Random(0.05f, 20.0f);
+		float ki = Random(0.0f, 0.5f);
+		float limup = Random(0.5f, 50.0f);
+		float limlow = -Random(0.5f, 50.0f);
+		ConfigPIDController(&pid[k], kp, ki, 0.0f, limup, limlow, TSAMPLE, 10);
+		ConfigController(&pi[k], kp, ki);
+		ConfigControllerLimits(&pi[k], limup, limlow);
+	}
+
+	memset(result, 0, sizeof(*result));
+	for (uint64_t n = 0; n < steps; n++){
+		for (int k = 0; k < CONTROLLERS; k++){
+			float e = Error(n);
+			float u = RunPIController(&pid[k], e);
+			float v = RunController(&pi[k], e);
+			Count(result, &pid[k], u, SameFloat(u, v) && SameFloat(pid[k].ui_prev, pi[k].ui_prev), "PI", n, k);
+		}
+		result->steps++;
+	}
+}
+
+static void CheckPID(CheckResult* result, uint64_t steps)
+{
+	Controller<PIDStructure, BackCalculation> ctrl[CONTROLLERS];
+	PIDController pid[CONTROLLERS];
+
+	for (int k = 0; k < CONTROLLERS; k++){
+		float kp = Random(0.05f, 20.0f);
+		float ki = Random(0.0f, 0.5f);
+		float td = Random(0.0f, 1e-3f);
+		float limup = Random(0.5f, 50.0f);
+		float limlow = -Random(0.5f, 50.0f);
+		uint16_t N = 2 + k;
+		ConfigPIDController(&pid[k], kp, ki, td, limup, limlow, TSAMPLE, N);
+		ConfigController(&ctrl[k], kp, ki, td, TSAMPLE, N);
+		ConfigControllerLimits(&ctrl[k], limup, limlow);
+	}
+
+	memset(result, 0, sizeof(*result));
+	for (uint64_t n = 0; n < steps; n++){
+		for (int k = 0; k < CONTROLLERS; k++){
+			float e = Error(n);
+			float u = RunPIDController(&pid[k], e);
+			float v = RunController(&ctrl[k], e);
+			bool same = SameFloat(u, v) && SameFloat(pid[k].ui_prev, ctrl[k].ui_prev) &&
+					SameFloat(pid[k].ud_prev, ctrl[k].ud_prev) && SameFloat(pid[k].e_prev, ctrl[k].e_prev);
+			Count(result, &pid[k], u, same, "PID", n, k);
+		}
+		result->steps++;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint64_t steps = 200000;
+	for (int i = 1; i < argc; i++){
+		if (!strcmp(argv[i], "--steps") && i + 1 < argc){ steps = (uint64_t)atof(argv[++i]); }
+		else{
+			fprintf(stderr, "usage: %s [--steps N]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	HostSetCoreState(OPERATING);
+	printf("%d controllers, %llu steps\n", CONTROLLERS, (unsigned long long)steps);
+	printf("  routine      saturated high   saturated low   mismatches\n");
+
+	int failures = 0;
+	static const struct{ const char* name; void (*check)(CheckResult*, uint64_t); } cases[] = {
+		{"PI", CheckPI},
+		{"PID", CheckPID},
+	};
+	for (const auto& c : cases){
+		CheckResult r;
+		c.check(&r, steps);
+		bool ok = r.mismatches == 0 && r.high > 0 && r.low > 0;			// Both saturations exercised
+		if (!ok){ failures++; }
+		printf("  %-9s  %16llu  %14llu  %11llu  %s\n", c.name, (unsigned long long)r.high, (unsigned long long)r.low,
+				(unsigned long long)r.mismatches, ok ? "" : "FAIL");
+	}
+
+	printf("%s\n", failures ? "FAIL" : "PASS");
+	return failures ? 1 : 0;
+}
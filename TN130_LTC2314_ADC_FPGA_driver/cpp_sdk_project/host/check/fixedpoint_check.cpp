@@ -0,0 +1,166 @@
+/*
+ *	@title	Accuracy of the fixed-point controllers and SOGI against their floating-point versions
+ *	@file	fixedpoint_check.cpp
+ *
+ *	RunPIControllerQ15 and RunSOGI3Q15 run side by side with RunPIController and RunSOGI3, configured with
+ *	the same parameters, on the same Q15 inputs (the float routines receive the exact value of each Q15
+ *	sample). RunPRControllerQ15 runs against the difference equation of RunPRController in double
+ *	precision. The largest deviation of the Q15 outputs from the references, in Q15 LSBs, must stay
+ *	within the bounds documented in fixedpoint.h:
+ *	 - PI: 20 kHz, kp 0.5, ki 200/s, limits +/- 0.9, slow sweep with noise into both saturations
+ *	 - PR: 50 Hz resonance, kp 0.5, ki 20, wdamp 5 rad/s, distorted 50 Hz error of 0.02 full scale
+ *	 - SOGI: gain 1.41 at 50 Hz, distorted 50 Hz input of 0.5 full scale with noise (both outputs)
+ *
+ *	Usage: fixedpoint_check [--steps N]
+ */
+
+#include "controllers.h"
+#include "fixedpoint.h"
+#include "PLLs.h"
+#include "Core/core.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define TSAMPLE		50e-6
+#define OMEGA_GRID	(2 * M_PI * 50.0)
+
+#define PI_BOUND	1.0						// Q15 LSBs, as documented in fixedpoint.h
+#define PR_BOUND	3.0
+#define SOGI_BOUND	1.0
+
+static uint32_t seed = 1;
+
+// Uniform in [-1, 1)
+static double Noise(void)
+{
+	seed = seed * 1664525u + 1013904223u;
+	return (seed >> 8) * (2.0 / 16777216) - 1.0;
+}
+
+// Distorted 50 Hz waveform (5th and 7th harmonics) with white noise, quantized to Q15
+static int16_t GridInput(uint64_t n, double amplitude, double noise)
+{
+	double phase = OMEGA_GRID * n * TSAMPLE;
+	return FloatToQ15((float)(amplitude * (sin(phase) + 0.05 * sin(5 * phase) + 0.03 * sin(7 * phase)) + noise * Noise()));
+}
+
+// Deviation in LSBs of a Q15 output from the float output
+static double DeviationLsb(int16_t q15, float reference)
+{
+	return fabs(q15 - reference * 32768.0);
+}
+
+static double CheckPI(uint64_t steps)
+{
+	PIDController pi;
+	PIControllerQ15 pi_q15;
+	ConfigPIDController(&pi, 0.5, 200.0 * TSAMPLE, 0.0, 0.9, -0.9, TSAMPLE, 10);
+	ConfigPIControllerQ15(&pi_q15, 0.5, 200.0 * TSAMPLE, 0.9, -0.9);
+
+	double worst = 0;
+	for (uint64_t n = 0; n < steps; n++){
+		int16_t e = FloatToQ15((float)(0.3 * sin(2 * M_PI * 0.5 * n * TSAMPLE) + 0.05 * Noise()));
+		double d = DeviationLsb(RunPIControllerQ15(&pi_q15, e), RunPIController(&pi, Q15ToFloat(e)));
+		if (d > worst){ worst = d; }
+	}
+	return worst;
+}
+
+/*
+ * Difference equation of RunPRController in double precision: near wres, the float routine deviates from
+ * it by about 20 LSB on this input (its coefficients, ~kt^2, are rounded to float), so the Q15 routine is
+ * compared with this reference instead
+ */
+typedef struct{
+	double kp, a1, b0, b1, b2;
+	double ui_prev, ui_prev2, e_prev, e_prev2;
+} PRReference;
+
+static void ConfigPRReference(PRReference* me, double kp, double ki, double wres, double wdamp, double tsample)
+{
+	double kt = 2.0/tsample;
+	me->kp = kp;
+	me->a1 = 2*ki*kt*wdamp;
+	me->b0 = kt*kt + 2*kt*wdamp + wres*wres;
+	me->b1 = 2*kt*kt - 2*wres*wres;
+	me->b2 = kt*kt - 2*kt*wdamp + wres*wres;
+	me->ui_prev = me->ui_prev2 = me->e_prev = me->e_prev2 = 0.0;
+}
+
+static double RunPRReference(PRReference* me, double error)
+{
+	double ui = (me->a1 * (me->e_prev - me->e_prev2) + me->b1 * me->ui_prev - me->b2 * me->ui_prev2) / me->b0;
+	me->ui_prev2 = me->ui_prev;
+	me->ui_prev = ui;
+	me->e_prev2 = me->e_prev;
+	me->e_prev = error;
+	return me->kp * error + ui;
+}
+
+static double CheckPR(uint64_t steps)
+{
+	PRReference pr;
+	PRControllerQ15 pr_q15;
+	ConfigPRReference(&pr, 0.5, 20.0, OMEGA_GRID, 5.0, TSAMPLE);
+	ConfigPRControllerQ15(&pr_q15, 0.5, 20.0, OMEGA_GRID, 5.0, TSAMPLE);
+
+	double worst = 0;
+	for (uint64_t n = 0; n < steps; n++){
+		int16_t e = GridInput(n, 0.02, 0.002);
+		double d = fabs(RunPRControllerQ15(&pr_q15, e) - RunPRReference(&pr, Q15ToFloat(e)) * 32768.0);
+		if (d > worst){ worst = d; }
+	}
+	return worst;
+}
+
+static double CheckSOGI(uint64_t steps)
+{
+	SOGI3Parameters sogi;
+	SOGI3ParametersQ15 sogi_q15;
+	ConfigSOGI3(&sogi, 1.41, OMEGA_GRID, TSAMPLE);
+	ConfigSOGI3Q15(&sogi_q15, 1.41, OMEGA_GRID, TSAMPLE);
+
+	double worst = 0;
+	for (uint64_t n = 0; n < steps; n++){
+		int16_t v = GridInput(n, 0.5, 0.01);
+		SpaceVectorQ15 q = RunSOGI3Q15(&sogi_q15, v);
+		SpaceVector f = RunSOGI3(&sogi, Q15ToFloat(v));
+		double d = fmax(DeviationLsb(q.real, f.real), DeviationLsb(q.imaginary, f.imaginary));
+		if (d > worst){ worst = d; }
+	}
+	return worst;
+}
+
+int main(int argc, char** argv)
+{
+	uint64_t steps = 400000;						// 20 s
+	for (int i = 1; i < argc; i++){
+		if (!strcmp(argv[i], "--steps") && i + 1 < argc){ steps = (uint64_t)atof(argv[++i]); }
+		else{
+			fprintf(stderr, "usage: %s [--steps N]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	HostSetCoreState(OPERATING);
+	static const struct{ const char* name; double (*run)(uint64_t); double bound; } cases[] = {
+		{"RunPIControllerQ15", CheckPI, PI_BOUND},
+		{"RunPRControllerQ15", CheckPR, PR_BOUND},
+		{"RunSOGI3Q15", CheckSOGI, SOGI_BOUND},
+	};
+
+	int failures = 0;
+	printf("%llu steps, largest deviation from the reference:\n", (unsigned long long)steps);
+	for (const auto& c : cases){
+		double worst = c.run(steps);
+		bool ok = worst <= c.bound;
+		if (!ok){ failures++; }
+		printf("  %-20s %6.2f LSB (bound %.1f)  %s\n", c.name, worst, c.bound, ok ? "" : "FAIL");
+	}
+
+	printf("%s\n", failures ? "FAIL" : "PASS");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,93 @@
+/*
+ *	@title	Frequency response of the PR controllers against the analytic resonant response
+ *	@file	pr_response_check.cpp
+ *
+ *	RunPRController and RunPRControllerQ15 are driven by sinusoids from 10 Hz to 1 kHz around a 50 Hz
+ *	resonance. Once the resonant term has settled (4 s, i.e. 20 times 1/wdamp), the complex gain is
+ *	measured by a DFT over an integer number of periods and compared with the analytic response:
+ *
+ *		H(s) = kp + ki * 2*wdamp*s / (s^2 + 2*wdamp*s + wres^2)
+ *
+ *	discretized as in ConfigPRController: the denominator by the Tustin transform s = kt*(1-z^-1)/(1+z^-1),
+ *	kt = 2/Ts, and the numerator 2*ki*wdamp*kt*(z^-1 - z^-2), i.e. the Tustin numerator (1 - z^-2) delayed
+ *	by one sample and divided by (1 + z^-1). This is the original form of the routine: it halves the
+ *	resonant gain (kp + ki/2 at wres) and is checked as is. An error in b0, b1 or b2 moves the poles (with
+ *	b2 = b0 they are on the unit circle and the resonant term never settles) and fails the check.
+ *
+ *	Usage: pr_response_check
+ */
+
+#include "controllers.h"
+#include "fixedpoint.h"
+
+#include <cmath>
+#include <complex>
+#include <cstdio>
+
+#define TSAMPLE		50e-6
+#define KP			0.5
+#define KI			20.0
+#define WRES		(2 * M_PI * 50.0)
+#define WDAMP		5.0
+#define STEPS		80000					// 4 s
+#define ANALYZED	40000					// Last 2 s: an integer number of periods at every frequency
+#define TOLERANCE	5e-3					// Relative to |H|, float (2.5e-3 at wres: b0, b1, b2 ~ kt^2 rounded to float)
+#define TOLERANCE_Q15	1e-2				// Input of 0.01 full scale (328 LSB)
+#define AMPLITUDE_Q15	0.01
+
+typedef std::complex<double> Complex;
+
+static Complex ExpectedResponse(double frequency)
+{
+	double kt = 2 / TSAMPLE;
+	Complex z1 = std::exp(Complex(0, -2 * M_PI * frequency * TSAMPLE));		// z^-1
+	Complex z2 = z1 * z1;
+	double b0 = kt*kt + 2*kt*WDAMP + WRES*WRES;								// Tustin of s^2 + 2*wdamp*s + wres^2
+	double b1 = 2*kt*kt - 2*WRES*WRES;
+	double b2 = kt*kt - 2*kt*WDAMP + WRES*WRES;
+	return KP + 2*KI*WDAMP*kt * (z1 - z2) / (b0 - b1*z1 + b2*z2);
+}
+
+// Complex gain of a controller on a unit sinusoid: DFT of the output at the input frequency
+template<class Run>
+static Complex MeasureResponse(double frequency, double amplitude, Run run)
+{
+	Complex acc = 0;
+	for (int n = 0; n < STEPS; n++){
+		double phase = 2 * M_PI * frequency * n * TSAMPLE;
+		double u = run(amplitude * sin(phase));
+		if (n >= STEPS - ANALYZED){ acc += u * std::exp(Complex(0, -phase)); }
+	}
+	return acc * (2.0 / ANALYZED) / Complex(0, -amplitude);					// sin = -j/2 (e^jx - e^-jx)
+}
+
+int main(void)
+{
+	static const double frequencies[] = {10, 25, 40, 50, 62.5, 100, 250, 1000};
+	int failures = 0;
+
+	printf("kp %.1f, ki %.1f, wres 2*pi*50 rad/s, wdamp %.1f rad/s, Ts %.0f us\n", KP, KI, WDAMP, TSAMPLE * 1e6);
+	printf("  freq Hz   expected |H|   arg deg   float err   Q15 err\n");
+	for (double f : frequencies){
+		Complex expected = ExpectedResponse(f);
+
+		PRController pr;
+		ConfigPRController(&pr, KP, KI, WRES, WDAMP, TSAMPLE);
+		Complex measured = MeasureResponse(f, 1.0, [&](double e){ return (double)RunPRController(&pr, (float)e); });
+
+		PRControllerQ15 pr_q15;
+		ConfigPRControllerQ15(&pr_q15, KP, KI, WRES, WDAMP, TSAMPLE);
+		Complex measured_q15 = MeasureResponse(f, AMPLITUDE_Q15,
+				[&](double e){ return (double)Q15ToFloat(RunPRControllerQ15(&pr_q15, FloatToQ15((float)e))); });
+
+		double error = std::abs(measured - expected) / std::abs(expected);
+		double error_q15 = std::abs(measured_q15 - expected) / std::abs(expected);
+		bool ok = error <= TOLERANCE && error_q15 <= TOLERANCE_Q15;
+		if (!ok){ failures++; }
+		printf("  %7.1f   %12.5f   %7.2f   %9.2e  %8.2e  %s\n", f, std::abs(expected), std::arg(expected) * 180 / M_PI,
+				error, error_q15, ok ? "" : "FAIL");
+	}
+
+	printf("%s\n", failures ? "FAIL" : "PASS");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,73 @@
+/*
+ *	@title	Interpolation error of the temperature tables against the exact sensor models
+ *	@file	temperature_check.cpp
+ *
+ *	ConvertTemperature is evaluated on every code of the LTC2314 (TEMPERATURE_CODE_BITS) and compared
+ *	with ConstexprSensorTemperature, which saturates at the valid range of the sensor, for the two
+ *	sensors documented in temperature.h and three table sizes. The codes where the curve leaves the
+ *	valid range, and those of an open or shorted sensor, are included. The largest error of each case
+ *	must stay within the bound documented in temperature.h.
+ *
+ *	Usage: temperature_check
+ */
+
+#include "sensorchannels.h"
+#include "temperature.h"
+
+#include <cmath>
+#include <cstdio>
+
+typedef struct{
+	double error;
+	uint32_t code;							// Code of the largest error
+} TableError;
+
+template<int BITS>
+static TableError MeasureTable(const ThermalSensor& sensor)
+{
+	const TemperatureTable<BITS> table(sensor);								// Built at run time here, same values
+
+	TableError worst = {0.0, 0};
+	for (uint32_t code = 0; code < (1u << TEMPERATURE_CODE_BITS); code++){
+		double error = fabs(ConvertTemperature(table, (uint16_t)code) - ConstexprSensorTemperature(sensor, code));
+		if (error > worst.error){
+			worst.error = error;
+			worst.code = code;
+		}
+	}
+	return worst;
+}
+
+int main(void)
+{
+	static const ThermalSensor ntc = NtcDivider(LTC2314_ADCONV, 4.096, 10e3,
+			1.009249522e-3, 2.378405444e-4, 2.019202697e-7, -40.0, 125.0);
+	static const ThermalSensor pt100 = RtdDivider(LTC2314_ADCONV, 4.096, 100.0, PT100_CVD, -200.0, 850.0);
+
+	static const struct{
+		const char* name;
+		const ThermalSensor* sensor;
+		int bits;
+		double bound;						// degC, as documented in temperature.h
+	} cases[] = {
+		{"NTC 10k", &ntc, 6, 3.0},
+		{"NTC 10k", &ntc, 8, 0.2},
+		{"NTC 10k", &ntc, 10, 0.013},
+		{"PT100", &pt100, 6, 13.0},
+		{"PT100", &pt100, 8, 0.8},
+		{"PT100", &pt100, 10, 0.052},
+	};
+
+	int failures = 0;
+	printf("%u codes, largest error of ConvertTemperature against the exact model:\n", 1u << TEMPERATURE_CODE_BITS);
+	for (const auto& c : cases){
+		TableError e = c.bits == 6 ? MeasureTable<6>(*c.sensor) : (c.bits == 8 ? MeasureTable<8>(*c.sensor) : MeasureTable<10>(*c.sensor));
+		bool ok = e.error <= c.bound;
+		if (!ok){ failures++; }
+		printf("  %-8s 2^%-2d intervals  %8.4f degC at code %5u (%8.3f degC)  bound %.3f  %s\n", c.name, c.bits, e.error, e.code,
+				ConstexprSensorTemperature(*c.sensor, e.code), c.bound, ok ? "" : "FAIL");
+	}
+
+	printf("%s\n", failures ? "FAIL" : "PASS");
+	return failures ? 1 : 0;
+}
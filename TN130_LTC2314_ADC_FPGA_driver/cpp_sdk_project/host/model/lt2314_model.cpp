@@ -0,0 +1,226 @@
+/*
+ *	@title	Cycle-accurate model of LT2314_driver and of the LTC2314 on its SPI bus
+ *	@file	lt2314_model.cpp
+ */
+
+#include "lt2314_model.h"
+
+#include <cmath>
+#include <cstring>
+
+
+void ConfigLT2314Model(LT2314Model* me, uint16_t postscaler, uint16_t burst_length)
+{
+	memset(me, 0, sizeof(*me));
+	me->postscaler_in = postscaler;
+	me->burst_length_in = burst_length;
+}
+
+
+/*
+ * The processes read the signals as they were before the edge (copied first) and update their
+ * variables immediately; the new signal values are committed at the end.
+ */
+void StepLT2314Model(LT2314Model* me, bool sampling_pulse, bool spi_din)
+{
+	const bool rising_pulse = me->postscaled_clk_rising_pulse;
+	const bool conv = me->conv;
+	const uint16_t burst_remaining = me->burst_remaining;
+
+	bool next_clk = me->postscaled_clk;
+	bool next_rising_pulse = false;
+	bool next_pulse_detected = me->pulse_detected;
+	bool next_conv = conv;
+	uint16_t next_burst_remaining = burst_remaining;
+
+	// POSTSCALER:
+	if ((uint16_t)(me->postscaler_cnt + 1) >= me->postscaler_in){
+		if (!me->postscaled_clk){ next_rising_pulse = true; }
+		me->postscaler_cnt = 0;
+		next_clk = !me->postscaled_clk;
+	}
+	else{
+		me->postscaler_cnt++;
+	}
+
+	// SAMPLING:
+	if (sampling_pulse){ next_pulse_detected = true; }
+	else if (rising_pulse){ next_pulse_detected = false; }
+
+	// FSM:
+	if (rising_pulse){
+		if (!conv){
+			me->bit_cnt = 0;
+			if (burst_remaining != 0){
+				next_burst_remaining = burst_remaining - 1;
+				next_conv = true;
+			}
+			else if (me->pulse_detected){
+				if (me->burst_length_in > 1){ next_burst_remaining = me->burst_length_in - 1; }
+				next_conv = true;
+			}
+		}
+		else{
+			me->bit_cnt = (me->bit_cnt + 1) & 0x1F;
+			if (me->bit_cnt >= 16){ next_conv = false; }
+		}
+	}
+
+	// SHIFT_REG:
+	if (sampling_pulse){
+		me->valid = false;
+		me->sequence_out &= 0x7FFF;
+	}
+	if (conv && rising_pulse){
+		me->data_reg = (uint16_t)((me->data_reg << 1) | (spi_din ? 1 : 0));
+	}
+	else if (!conv && me->converting){
+		me->data_out = me->data_reg >> 1;
+		me->sequence = (me->sequence + 1) & 0x7FFF;
+
+		me->acc += me->data_out;
+		me->acc_count++;
+		if (burst_remaining == 0){
+			me->acc_sum_out = me->acc;
+			me->acc_count_out = me->acc_count;
+			me->acc = 0;
+			me->acc_count = 0;
+			if (!sampling_pulse){ me->valid = true; }
+		}
+		me->sequence_out = (me->valid ? 0x8000 : 0) | me->sequence;
+	}
+	me->converting = conv;
+
+	me->postscaled_clk = next_clk;
+	me->postscaled_clk_rising_pulse = next_rising_pulse;
+	me->pulse_detected = next_pulse_detected;
+	me->conv = next_conv;
+	me->burst_remaining = next_burst_remaining;
+	me->cycle++;
+}
+
+
+void ConfigLT2314Adc(LT2314Adc* me, double delay, uint8_t blank_bits, uint16_t (*convert)(void*), void* context)
+{
+	memset(me, 0, sizeof(*me));
+	me->delay = (int64_t)llround(delay * 1e12);
+	me->blank_bits = blank_bits;
+	me->convert = convert;
+	me->context = context;
+	me->sck = false;
+	me->cs_n = true;
+	me->counter = 13 + blank_bits;
+}
+
+
+// SDO as seen at the edge 'cycle': the changes old enough are applied
+static bool ReadAdcOutput(LT2314Adc* me, uint64_t cycle)
+{
+	int64_t now = (int64_t)cycle * LT2314_CLOCK_PS;
+	while (me->count > 0 && me->time[me->head] + me->delay < now){
+		me->sdo = me->value[me->head];
+		me->head = (me->head + 1) % LT2314_ADC_EVENTS;
+		me->count--;
+	}
+	return me->sdo;
+}
+
+static void DriveAdcOutput(LT2314Adc* me, uint64_t cycle, bool value)
+{
+	if (me->count == LT2314_ADC_EVENTS){
+		me->sdo = me->value[me->head];									// Oldest change forced through
+		me->head = (me->head + 1) % LT2314_ADC_EVENTS;
+		me->count--;
+		me->overflows++;
+	}
+	uint8_t k = (me->head + me->count) % LT2314_ADC_EVENTS;
+	me->time[k] = (int64_t)cycle * LT2314_CLOCK_PS;
+	me->value[k] = value;
+	me->count++;
+}
+
+// Reaction of the ADC to the SCK and CS levels set by the edge 'cycle' (testbench SPI_TARGET process)
+static void UpdateAdc(LT2314Adc* me, const LT2314Model* driver, uint64_t cycle)
+{
+	bool sck = driver->postscaled_clk;
+	bool cs_n = !driver->conv;
+	bool sck_falling = me->sck && !sck;
+
+	if (me->cs_n && !cs_n){
+		me->rawdata = me->convert ? me->convert(me->context) & 0x3FFF : 0;
+		me->conversions++;
+	}
+	if (cs_n){
+		if (!me->cs_n){ DriveAdcOutput(me, cycle, false); }				// High impedance, read as 0
+		me->counter = 13 + me->blank_bits;
+	}
+	else if (sck_falling){
+		bool bit = me->counter <= 13 && me->counter >= 0 && ((me->rawdata >> me->counter) & 1);
+		DriveAdcOutput(me, cycle, bit);
+		me->counter--;
+	}
+
+	me->sck = sck;
+	me->cs_n = cs_n;
+}
+
+
+bool ClockLT2314(LT2314Model* me, LT2314Adc* adc, bool sampling_pulse)
+{
+	uint64_t cycle = me->cycle;
+	bool din = ReadAdcOutput(adc, cycle);
+	StepLT2314Model(me, sampling_pulse, din);
+	UpdateAdc(adc, me, cycle);
+	return din;
+}
+
+
+/*
+ * Runs at least one edge and at most 'cycles' (> 0), skipping the edges where only the postscaler
+ * counter changes: no SCK toggle, no rising pulse to process, no end of conversion to publish.
+ * Returns the number of edges run.
+ */
+static uint64_t AdvanceStep(LT2314Model* me, LT2314Adc* adc, uint64_t cycles)
+{
+	bool quiet = !me->postscaled_clk_rising_pulse && me->converting == me->conv;
+	if (quiet && me->postscaler_cnt + 1 < me->postscaler_in){
+		uint64_t n = me->postscaler_in - 1 - me->postscaler_cnt;					// Edges until the next toggle
+		if (n > cycles){ n = cycles; }
+		me->postscaler_cnt += (uint16_t)n;
+		me->cycle += n;
+		return n;
+	}
+	ClockLT2314(me, adc, false);
+	return 1;
+}
+
+
+void AdvanceLT2314(LT2314Model* me, LT2314Adc* adc, uint64_t cycles)
+{
+	uint64_t period = 2 * (me->postscaler_in > 1 ? me->postscaler_in : 1);	// SCK period in edges
+
+	while (cycles > 0){
+		// Idle driver: SCK runs alone, whole periods bring it back to the same state
+		bool idle = !me->conv && !me->converting && !me->pulse_detected && me->burst_remaining == 0
+				&& me->postscaler_cnt < period / 2;
+		if (idle && cycles >= period){
+			uint64_t n = cycles / period * period;
+			me->bit_cnt = 0;													// Cleared by the rising pulses in ACQ
+			me->cycle += n;
+			cycles -= n;
+			continue;
+		}
+		cycles -= AdvanceStep(me, adc, cycles);
+	}
+}
+
+
+uint64_t RunLT2314Conversion(LT2314Model* me, LT2314Adc* adc)
+{
+	uint64_t start = me->cycle;
+	ClockLT2314(me, adc, true);
+	while (!(me->sequence_out & 0x8000)){
+		AdvanceStep(me, adc, ~(uint64_t)0);
+	}
+	return me->cycle - start;
+}
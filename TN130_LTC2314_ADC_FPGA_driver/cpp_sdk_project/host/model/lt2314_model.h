@@ -0,0 +1,150 @@
+/*
+ *	@title	Cycle-accurate model of LT2314_driver and of the LTC2314 on its SPI bus
+ *	@file	lt2314_model.h
+ *
+ *	LT2314Model reproduces the POSTSCALER, SAMPLING, FSM and SHIFT_REG processes of
+ *	../../hdl/LT2314_driver.vhd clock by clock: every signal keeps its value until the end of the
+ *	clk_250 edge and every process variable is updated in place, as in the VHDL. One StepLT2314Model
+ *	is one rising edge of clk_250; the outputs read before a step are the values seen by the FPGA
+ *	logic at that edge (as dumped by LT2314_trace_tb.vhd).
+ *
+ *	LT2314Adc is the ADC seen from the FPGA pins: a new code is taken at every falling edge of CS
+ *	(from a callback), then shifted out MSB first on the falling edges of SCK after the blank bits,
+ *	as the ADC model of the testbenches. Every change of SDO reaches the FPGA after a propagation
+ *	delay (ADC output delay + cable + input buffer): a change made after the edge j is seen from the
+ *	first edge k such that j*tclk + delay < k*tclk. With a zero delay, this is the VHDL behaviour.
+ *
+ *	ClockLT2314 runs one edge of both. AdvanceLT2314 fast-forwards: it skips the edges where only the
+ *	postscaler counts, and whole SCK periods when the driver is idle, without changing the result.
+ *	RunLT2314Conversion issues one sampling pulse and runs until the burst is published.
+ */
+
+#ifndef LT2314_MODEL_H_
+#define LT2314_MODEL_H_
+
+#include <stdint.h>
+
+#define LT2314_CLOCK_PS			4000			// clk_250 period, in ps
+#define LT2314_ADC_EVENTS		8				// SDO changes in flight (delay up to 8 SCK half periods)
+
+
+/**
+ * Signals, process variables and outputs of LT2314_driver
+ */
+typedef struct{
+	// Inputs held between the edges:
+	uint16_t postscaler_in;
+	uint16_t burst_length_in;
+
+	// Signals:
+	bool postscaled_clk;						// spi_sck
+	bool postscaled_clk_rising_pulse;
+	bool pulse_detected;
+	bool conv;									// state = CONV (spi_cs_n = not conv)
+	uint16_t burst_remaining;
+
+	// Process variables:
+	uint16_t postscaler_cnt;					// POSTSCALER
+	uint8_t bit_cnt;							// FSM
+	uint16_t data_reg;							// SHIFT_REG
+	bool converting;
+	uint32_t acc;
+	uint16_t acc_count;
+	uint16_t sequence;
+	bool valid;
+
+	// Outputs:
+	uint16_t data_out;
+	uint16_t sequence_out;
+	uint32_t acc_sum_out;
+	uint16_t acc_count_out;
+
+	uint64_t cycle;								// Edges of clk_250 since the configuration
+} LT2314Model;
+
+
+/**
+ * LTC2314 and its connection to spi_din
+ */
+typedef struct{
+	int64_t delay;								// SCK or CS edge to SDO change seen by the FPGA, in ps
+	uint8_t blank_bits;							// Zeros shifted out before the MSB
+	uint16_t (*convert)(void* context);			// Next 14-bit code, called at every falling edge of CS
+	void* context;
+
+	bool sck;									// SCK and CS as of the last update
+	bool cs_n;
+	int counter;								// Next bit to shift out (as the testbench model)
+	uint16_t rawdata;
+	bool sdo;									// SDO as seen by the FPGA
+	uint8_t head, count;						// SDO changes in flight
+	int64_t time[LT2314_ADC_EVENTS];			// Time of the edge causing each change, in ps
+	bool value[LT2314_ADC_EVENTS];
+	uint32_t conversions;
+	uint32_t overflows;							// Changes lost because too many were in flight
+} LT2314Adc;
+
+
+/**
+ * Routine to reset the driver to the state of the bitstream after configuration (VHDL initial values)
+ * @param *me				the model
+ * @param postscaler		postscaler_in (spi_sck = clk_250 / (postscaler*2))
+ * @param burst_length		burst_length_in (0 and 1: one conversion per pulse)
+ * @return void
+ */
+void ConfigLT2314Model(LT2314Model* me, uint16_t postscaler, uint16_t burst_length);
+
+
+/**
+ * Routine to run one rising edge of clk_250
+ * @param *me				the model
+ * @param sampling_pulse	the sampling strobe at this edge
+ * @param spi_din			spi_din at this edge
+ * @return void
+ */
+void StepLT2314Model(LT2314Model* me, bool sampling_pulse, bool spi_din);
+
+
+/**
+ * Routine to reset the ADC model
+ * @param *me				the ADC
+ * @param delay				propagation delay from the SCK/CS edges to spi_din, in s.
+ * @param blank_bits		zeros before the MSB (1 for the LTC2314 as in the testbenches)
+ * @param convert			callback returning the next code (at every CS falling edge)
+ * @param *context			passed to the callback
+ * @return void
+ */
+void ConfigLT2314Adc(LT2314Adc* me, double delay, uint8_t blank_bits, uint16_t (*convert)(void*), void* context);
+
+
+/**
+ * Routine to run one edge of clk_250 of the driver and the ADC
+ * @param *me				the driver
+ * @param *adc				the ADC on its SPI bus
+ * @param sampling_pulse	the sampling strobe at this edge
+ * @return					spi_din as seen by the driver at this edge
+ */
+bool ClockLT2314(LT2314Model* me, LT2314Adc* adc, bool sampling_pulse);
+
+
+/**
+ * Routine to run a number of edges without sampling pulse, as fast as possible (same result as as many
+ * ClockLT2314 calls)
+ * @param *me				the driver
+ * @param *adc				the ADC on its SPI bus
+ * @param cycles			the number of edges of clk_250
+ * @return void
+ */
+void AdvanceLT2314(LT2314Model* me, LT2314Adc* adc, uint64_t cycles);
+
+
+/**
+ * Routine to issue one sampling pulse (one edge) and run until its burst is published
+ * (sequence_out valid), as fast as possible
+ * @param *me				the driver
+ * @param *adc				the ADC on its SPI bus
+ * @return					the latency, in edges of clk_250 from the pulse to the first edge seeing the data
+ */
+uint64_t RunLT2314Conversion(LT2314Model* me, LT2314Adc* adc);
+
+#endif /* LT2314_MODEL_H_ */
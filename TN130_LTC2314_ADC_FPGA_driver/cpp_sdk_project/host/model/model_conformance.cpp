@@ -0,0 +1,294 @@
+/*
+ *	@title	Conformance and speed test of the C++ model of LT2314_driver
+ *	@file	model_conformance.cpp
+ *
+ *	Runs the model and the ADC model on the stimulus of ../../hdl/LT2314_trace_tb.vhd (LT2314_tb
+ *	followed by bursts and pulses during bursts) and checks that:
+ *	 - every burst publishes the codes returned by the ADC (data_out, acc_sum_out, acc_count_out) and
+ *	   a valid sequence number counting the conversions
+ *	 - with --trace, every field of every clock matches the trace dumped by GHDL (make conformance)
+ *	 - the fast-forward (AdvanceLT2314, RunLT2314Conversion) reaches exactly the same states and
+ *	   latencies as clock-by-clock stepping, for several postscalers, burst lengths and SDO delays
+ *	It then measures the speed of both.
+ *
+ *	Usage: model_conformance [--trace LT2314_trace.txt]
+ */
+
+#include "lt2314_model.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <time.h>
+#include <vector>
+
+typedef struct{
+	uint32_t field[11];						// As written by LT2314_trace_tb (see its header)
+} TraceRow;
+
+static const char* const field_names[11] = {"cycle", "sampling_pulse", "postscaler", "burst_length", "spi_din",
+		"spi_sck", "spi_cs_n", "data_out", "sequence_out", "acc_sum", "acc_count"};
+
+typedef struct{
+	bool pulse;
+	uint16_t postscaler;
+	uint16_t burst_length;
+} Stimulus;
+
+static const uint16_t codes[] = {12345, 5782, 777, 16383, 0, 8191, 1, 9999};
+
+typedef struct{
+	uint32_t index;
+	std::vector<uint16_t> returned;			// Codes returned, in conversion order
+} CodeSource;
+
+static uint16_t NextCode(void* context)
+{
+	CodeSource* me = (CodeSource*)context;
+	uint16_t code = codes[me->index++ % (sizeof(codes)/sizeof(codes[0]))];
+	me->returned.push_back(code);
+	return code;
+}
+
+static uint16_t RandomCode(void* context)
+{
+	uint32_t* state = (uint32_t*)context;
+	*state = *state * 1664525u + 1013904223u;
+	return (*state >> 10) & 0x3FFF;
+}
+
+// Edges of LT2314_trace_tb: pulse(w) waits w clocks then pulses for one, configuration changes apply at once
+static std::vector<Stimulus> TraceStimulus(void)
+{
+	std::vector<Stimulus> s;
+	Stimulus current = {false, 2, 0};
+	auto pulse = [&](int wait){
+		for (int k = 0; k < wait; k++){ s.push_back(current); }
+		current.pulse = true;
+		s.push_back(current);
+		current.pulse = false;
+	};
+
+	for (int n = 0; n < 9; n++){ pulse(100); }
+	current.postscaler = 5;
+	current.burst_length = 3;
+	for (int n = 0; n < 3; n++){ pulse(300); }
+	current.postscaler = 1;
+	current.burst_length = 2;
+	for (int n = 0; n < 4; n++){ pulse(20); }
+	for (int k = 0; k < 200; k++){ s.push_back(current); }
+	return s;
+}
+
+static TraceRow Row(const LT2314Model* m, const Stimulus* in, bool din)
+{
+	TraceRow r = {{(uint32_t)m->cycle, in->pulse, in->postscaler, in->burst_length, din, m->postscaled_clk, !m->conv,
+			m->data_out, m->sequence_out, m->acc_sum_out, m->acc_count_out}};
+	return r;
+}
+
+// Runs the trace stimulus clock by clock; every row holds the values seen at the edge
+static std::vector<TraceRow> RunTraceStimulus(const std::vector<Stimulus>& stimulus, CodeSource* source, int* failures)
+{
+	LT2314Model m;
+	LT2314Adc adc;
+	std::vector<TraceRow> rows;
+	uint32_t published = 0;										// Conversions checked
+	uint16_t sequence = 0;
+
+	ConfigLT2314Model(&m, stimulus[0].postscaler, stimulus[0].burst_length);
+	ConfigLT2314Adc(&adc, 0.0, 1, NextCode, source);
+
+	for (size_t k = 0; k < stimulus.size(); k++){
+		m.postscaler_in = stimulus[k].postscaler;
+		m.burst_length_in = stimulus[k].burst_length;
+		uint16_t before = m.sequence_out;
+		ClockLT2314(&m, &adc, stimulus[k].pulse);
+
+		// Every published conversion: data and sequence number, then the sum at the end of a burst
+		if (m.sequence_out != before && (m.sequence_out & 0x7FFF) != sequence){
+			sequence = m.sequence_out & 0x7FFF;
+			uint16_t expected = source->returned[published];
+			if (m.data_out != expected || sequence != published + 1){
+				printf("FAIL: conversion %u: data_out %u (expected %u), sequence %u\n", published, m.data_out, expected, sequence);
+				(*failures)++;
+			}
+			published++;
+			if (m.sequence_out & 0x8000){
+				uint32_t sum = 0;
+				for (uint32_t i = published - m.acc_count_out; i < published; i++){ sum += source->returned[i]; }
+				if (m.acc_sum_out != sum){
+					printf("FAIL: burst ending with conversion %u: acc_sum %u (expected %u)\n", published, m.acc_sum_out, sum);
+					(*failures)++;
+				}
+			}
+		}
+	}
+
+	if (published != source->returned.size()){
+		printf("FAIL: %zu conversions by the ADC, %u published\n", source->returned.size(), published);
+		(*failures)++;
+	}
+
+	// Rows: replay, recording the values seen at each edge
+	source->index = 0;
+	source->returned.clear();
+	ConfigLT2314Model(&m, stimulus[0].postscaler, stimulus[0].burst_length);
+	ConfigLT2314Adc(&adc, 0.0, 1, NextCode, source);
+	for (size_t k = 0; k < stimulus.size(); k++){
+		m.postscaler_in = stimulus[k].postscaler;
+		m.burst_length_in = stimulus[k].burst_length;
+		LT2314Model seen = m;
+		bool din = ClockLT2314(&m, &adc, stimulus[k].pulse);
+		rows.push_back(Row(&seen, &stimulus[k], din));
+	}
+
+	printf("trace stimulus: %zu clocks, %u conversions published and checked\n", stimulus.size(), published);
+	return rows;
+}
+
+static int CompareTrace(const char* name, const std::vector<TraceRow>& model)
+{
+	FILE* f = fopen(name, "r");
+	if (!f){ perror(name); return 1; }
+
+	int mismatches = 0;
+	size_t lines = 0;
+	TraceRow row;
+	while (fscanf(f, "%u %u %u %u %u %u %u %u %u %u %u", &row.field[0], &row.field[1], &row.field[2], &row.field[3],
+			&row.field[4], &row.field[5], &row.field[6], &row.field[7], &row.field[8], &row.field[9], &row.field[10]) == 11){
+		if (lines < model.size()){
+			for (int i = 0; i < 11; i++){
+				if (row.field[i] == model[lines].field[i]){ continue; }
+				if (mismatches < 10){
+					printf("FAIL: clock %zu: %s = %u in the GHDL trace, %u in the model\n", lines, field_names[i], row.field[i], model[lines].field[i]);
+				}
+				mismatches++;
+			}
+		}
+		lines++;
+	}
+	fclose(f);
+
+	// The GHDL clock may run one more edge than the stimulus when it stops
+	bool complete = lines + 1 >= model.size();
+	printf("GHDL trace %s: %zu clocks, %d mismatching values%s\n", name, lines, mismatches, complete ? "" : " (trace too short)");
+	return mismatches || !complete;
+}
+
+static bool SameState(const LT2314Model* a, const LT2314Model* b)
+{
+	return a->postscaled_clk == b->postscaled_clk && a->postscaled_clk_rising_pulse == b->postscaled_clk_rising_pulse
+			&& a->pulse_detected == b->pulse_detected && a->conv == b->conv && a->burst_remaining == b->burst_remaining
+			&& a->postscaler_cnt == b->postscaler_cnt && a->bit_cnt == b->bit_cnt && a->data_reg == b->data_reg
+			&& a->converting == b->converting && a->acc == b->acc && a->acc_count == b->acc_count
+			&& a->sequence == b->sequence && a->valid == b->valid && a->data_out == b->data_out
+			&& a->sequence_out == b->sequence_out && a->acc_sum_out == b->acc_sum_out
+			&& a->acc_count_out == b->acc_count_out && a->cycle == b->cycle;
+}
+
+// Fast-forward against clock by clock: same latencies and states after every conversion and idle gap
+static int CheckFastForward(void)
+{
+	static const uint16_t postscalers[] = {0, 1, 2, 3, 5, 8, 17};
+	static const uint16_t bursts[] = {1, 3, 16};
+	static const double delays[] = {0.0, 3e-9, 9e-9, 21e-9};
+	int failures = 0, runs = 0;
+
+	for (uint16_t p : postscalers){
+		for (uint16_t b : bursts){
+			for (double d : delays){
+				LT2314Model slow, fast;
+				LT2314Adc slow_adc, fast_adc;
+				uint32_t slow_noise = 1, fast_noise = 1;
+				ConfigLT2314Model(&slow, p, b);
+				ConfigLT2314Model(&fast, p, b);
+				ConfigLT2314Adc(&slow_adc, d, 1, RandomCode, &slow_noise);
+				ConfigLT2314Adc(&fast_adc, d, 1, RandomCode, &fast_noise);
+
+				for (int n = 0; n < 20; n++){
+					uint64_t gap = 37 + 101 * n;									// Idle edges before the pulse
+					for (uint64_t k = 0; k < gap; k++){ ClockLT2314(&slow, &slow_adc, false); }
+					uint64_t start = slow.cycle;
+					ClockLT2314(&slow, &slow_adc, true);
+					while (!(slow.sequence_out & 0x8000)){ ClockLT2314(&slow, &slow_adc, false); }
+					uint64_t slow_latency = slow.cycle - start;
+
+					AdvanceLT2314(&fast, &fast_adc, gap);
+					uint64_t fast_latency = RunLT2314Conversion(&fast, &fast_adc);
+
+					if (fast_latency != slow_latency || !SameState(&slow, &fast) || slow_adc.sdo != fast_adc.sdo){
+						printf("FAIL: fast-forward differs (postscaler %u, burst %u, delay %.0f ns, conversion %d): latency %llu / %llu\n",
+								p, b, d * 1e9, n, (unsigned long long)fast_latency, (unsigned long long)slow_latency);
+						failures++;
+						break;
+					}
+				}
+				runs++;
+			}
+		}
+	}
+	printf("fast-forward: %d configurations of 20 conversions, %d differing\n", runs, failures);
+	return failures;
+}
+
+static double NowNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// One sampling pulse every 12500 clocks (20 kHz), bursts of 16 at SCK = 62.5 MHz
+static void MeasureSpeed(void)
+{
+	const uint64_t period = 12500;
+	const int conversions = 2000;
+	LT2314Model m;
+	LT2314Adc adc;
+	uint32_t noise = 1;
+
+	ConfigLT2314Model(&m, 2, 16);
+	ConfigLT2314Adc(&adc, 0.0, 1, RandomCode, &noise);
+	double start = NowNs();
+	for (int n = 0; n < conversions; n++){
+		ClockLT2314(&m, &adc, true);
+		for (uint64_t k = 1; k < period; k++){ ClockLT2314(&m, &adc, false); }
+	}
+	double slow = NowNs() - start;
+
+	ConfigLT2314Model(&m, 2, 16);
+	ConfigLT2314Adc(&adc, 0.0, 1, RandomCode, &noise);
+	start = NowNs();
+	for (int n = 0; n < conversions * 10; n++){
+		uint64_t latency = RunLT2314Conversion(&m, &adc);
+		AdvanceLT2314(&m, &adc, period - latency);
+	}
+	double fast = (NowNs() - start) / 10;
+
+	printf("speed (20 kHz pulses, bursts of 16, SCK 62.5 MHz): clock by clock %.1f Mclk/s (%.2f us per interrupt period), "
+			"fast-forward %.2f us per interrupt period, %.0fx faster\n",
+			conversions * period / slow * 1e3, slow / conversions * 1e-3, fast / conversions * 1e-3, slow / fast);
+}
+
+int main(int argc, char** argv)
+{
+	const char* trace_name = 0;
+	for (int i = 1; i < argc; i++){
+		if (!strcmp(argv[i], "--trace") && i + 1 < argc){ trace_name = argv[++i]; }
+		else{
+			fprintf(stderr, "usage: %s [--trace LT2314_trace.txt]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	int failures = 0;
+	CodeSource source = {0, {}};
+	std::vector<TraceRow> rows = RunTraceStimulus(TraceStimulus(), &source, &failures);
+	if (trace_name){ failures += CompareTrace(trace_name, rows); }
+	failures += CheckFastForward();
+	MeasureSpeed();
+
+	printf("%s\n", failures ? "FAIL" : "PASS");
+	return failures ? 1 : 0;
+}
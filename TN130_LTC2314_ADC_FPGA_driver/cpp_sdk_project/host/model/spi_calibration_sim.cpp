@@ -0,0 +1,218 @@
+/*
+ *	@title	Test of the SPI clock calibration (My_functions/spi_calibration) on the model of LT2314_driver
+ *	@file	spi_calibration_sim.cpp
+ *
+ *	For every SDO propagation delay, the model of the driver and the ADC (model/lt2314_model) finds
+ *	by brute force the postscalers that read the codes exactly. Then the calibration runs as in
+ *	UserInterrupt: one sampling pulse and one ReadAdcSample per 20 kHz period, the postscaler taken
+ *	from the SBO register it writes. It must choose the fastest exact postscaler plus the margin, with a
+ *	known input and with the statistical reference, and the chosen one must read every code exactly.
+ *	With an AC input (50 Hz, +/- 2000 codes, several phases) and no known code, the calibration must
+ *	end UNSTEADY on the slowest postscaler.
+ *	The latencies reported per setting are checked against the model.
+ *
+ *	Usage: spi_calibration_sim [--margin m] [--verbose]
+ */
+
+#include "lt2314_model.h"
+
+#include "Driver/peripherals.h"
+#include "My_functions/sequenced_adc.h"
+#include "My_functions/spi_calibration.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define PERIOD_CLOCKS		12500			// 20 kHz interrupt, in clk_250 edges
+#define BURST_LENGTH		16
+#define SLOWEST				8
+#define FASTEST				1
+#define INPUT_CODE			6000			// Known input, plus noise
+#define NOISE				3				// Codes, peak
+#define AC_AMPLITUDE		2000			// Moving input, codes, peak
+#define AC_FREQUENCY		50.0
+#define AC_PHASES			8
+
+typedef struct{
+	uint32_t state;
+	uint16_t last;							// Last code returned
+	double amplitude;						// Sine added to INPUT_CODE, codes
+	double angle;
+	double step;							// Per conversion
+} NoisyInput;
+
+static uint16_t Convert(void* context)
+{
+	NoisyInput* me = (NoisyInput*)context;
+	me->state = me->state * 1664525u + 1013904223u;
+	int sine = (int)lrint(me->amplitude * sin(me->angle));
+	me->angle += me->step;
+	me->last = INPUT_CODE + sine + (int)((me->state >> 16) % (2 * NOISE + 1)) - NOISE;
+	return me->last;
+}
+
+// Brute force: every burst read exactly at this postscaler and delay (whatever the phase of the pulse)
+static bool ReadsExactly(uint16_t postscaler, double delay, int conversions)
+{
+	LT2314Model m;
+	LT2314Adc adc;
+	NoisyInput input = {12345, 0, 0.0, 0.0, 0.0};
+	ConfigLT2314Model(&m, postscaler, BURST_LENGTH);
+	ConfigLT2314Adc(&adc, delay, 1, Convert, &input);
+	for (int n = 0; n < conversions; n++){
+		AdvanceLT2314(&m, &adc, 1000 + 7 * n);
+		RunLT2314Conversion(&m, &adc);
+		if (m.data_out != input.last){ return false; }
+	}
+	return true;
+}
+
+// One interrupt period: the FPGA converts with the postscaler written in SBO_reg_00, then the interrupt reads
+static void SimulatePeriod(LT2314Model* m, LT2314Adc* adc)
+{
+	m->postscaler_in = HostGetSboRegister(0);
+	uint64_t latency = RunLT2314Conversion(m, adc);
+	HostSetSbiRegister(0, m->data_out);
+	HostSetSbiRegister(4, m->sequence_out);
+	AdvanceLT2314(m, adc, PERIOD_CLOCKS - latency);
+}
+
+typedef struct{
+	SpiCalibration calibration;
+	uint32_t interrupts;
+	bool exact;								// Every conversion read exactly at the chosen postscaler
+} CalibrationRun;
+
+static void RunCalibration(CalibrationRun* run, double delay, uint16_t margin, int32_t expected, double ac_phase = -1.0)
+{
+	LT2314Model m;
+	LT2314Adc adc;
+	NoisyInput input = {1, 0, 0.0, 0.0, 0.0};
+	if (ac_phase >= 0){														// BURST_LENGTH conversions per 20 kHz pulse
+		input.amplitude = AC_AMPLITUDE;
+		input.angle = ac_phase;
+		input.step = 2 * M_PI * AC_FREQUENCY * (PERIOD_CLOCKS * 4e-9) / BURST_LENGTH;
+	}
+	SequencedAdc reader;
+
+	ConfigLT2314Model(&m, 0, BURST_LENGTH);
+	ConfigLT2314Adc(&adc, delay, 1, Convert, &input);
+	ConfigSequencedAdc(&reader, 0, 4, BURST_LENGTH);
+	ConfigSpiCalibration(&run->calibration, 0, BURST_LENGTH, SLOWEST, FASTEST, NOISE, margin, expected);
+
+	run->interrupts = 0;
+	bool done = false;
+	while (!done && run->interrupts < 100000){
+		SimulatePeriod(&m, &adc);
+		done = RunSpiCalibration(&run->calibration, ReadAdcSample(&reader));
+		run->interrupts++;
+	}
+
+	run->exact = true;
+	for (int n = 0; n < 200; n++){
+		SimulatePeriod(&m, &adc);
+		if (ReadAdcSample(&reader).sample != input.last){ run->exact = false; }
+	}
+}
+
+// SpiConversionLatency against the worst case of the model over every phase of the pulse
+static int CheckLatencies(void)
+{
+	static const uint16_t bursts[] = {1, 4, BURST_LENGTH};
+	int failures = 0;
+	for (uint16_t burst : bursts){
+		for (uint16_t p = 0; p <= 16; p++){
+			uint64_t worst = 0;
+			uint16_t phases = 2 * (p > 1 ? p : 1);
+			for (uint16_t phase = 0; phase < phases; phase++){
+				LT2314Model m;
+				LT2314Adc adc;
+				ConfigLT2314Model(&m, p, burst);
+				ConfigLT2314Adc(&adc, 0.0, 1, 0, 0);
+				AdvanceLT2314(&m, &adc, 100 + phase);
+				uint64_t latency = RunLT2314Conversion(&m, &adc);
+				if (latency > worst){ worst = latency; }
+			}
+			uint64_t reported = (uint64_t)(SpiConversionLatency(p, burst) / 4e-9 + 0.5);
+			if (reported != worst){
+				printf("FAIL: postscaler %u, burst %u: latency %llu clocks reported, %llu in the model\n",
+						p, burst, (unsigned long long)reported, (unsigned long long)worst);
+				failures++;
+			}
+		}
+	}
+	printf("latencies: SpiConversionLatency matches the worst case of the model (%d differing)\n", failures);
+	return failures;
+}
+
+static void PrintSettings(const SpiCalibration* c)
+{
+	printf("   postscaler   SCK MHz   latency us       mean   min   max  errors\n");
+	for (int k = 0; k < c->tested; k++){
+		const SpiSetting* s = &c->settings[k];
+		printf("   %10u  %8.2f  %11.3f  %9.1f %5u %5u  %6u  %s\n", s->postscaler, s->sck * 1e-6, s->latency * 1e6,
+				s->mean, s->min, s->max, s->errors, s->passed ? "pass" : "FAIL");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint16_t margin = 1;
+	bool verbose = false;
+	for (int i = 1; i < argc; i++){
+		if (!strcmp(argv[i], "--margin") && i + 1 < argc){ margin = atoi(argv[++i]); }
+		else if (!strcmp(argv[i], "--verbose")){ verbose = true; }
+		else{
+			fprintf(stderr, "usage: %s [--margin m] [--verbose]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	int failures = CheckLatencies();
+
+	printf("\n delay ns  fastest exact  known input: chosen  ms    statistical: chosen  ms   SCK MHz  latency us  AC: unsteady\n");
+	for (int d = 0; d <= 40; d += 4){
+		double delay = d * 1e-9;
+
+		// Fastest postscaler of the contiguous exact range starting from the slowest
+		uint16_t fastest = 0;
+		for (uint16_t p = SLOWEST; p >= FASTEST && ReadsExactly(p, delay, 40); p--){ fastest = p; }
+		bool none = fastest == 0;
+		uint16_t expected = none ? SLOWEST : (fastest + margin < SLOWEST ? fastest + margin : SLOWEST);
+
+		CalibrationRun known, statistical;
+		RunCalibration(&known, delay, margin, INPUT_CODE);
+		RunCalibration(&statistical, delay, margin, -1);
+
+		// A moving input must never be taken for a reference
+		int unsteady = 0;
+		for (int k = 0; k < AC_PHASES; k++){
+			CalibrationRun ac;
+			RunCalibration(&ac, delay, margin, -1, 2 * M_PI * k / AC_PHASES);
+			if (ac.calibration.state == SPI_CAL_UNSTEADY && ac.calibration.postscaler == SLOWEST){ unsteady++; }
+			else if (verbose){ PrintSettings(&ac.calibration); }
+		}
+
+		// Too long a delay for the slowest setting: only a known input can detect it
+		bool ok = known.calibration.postscaler == expected && known.calibration.state == SPI_CAL_FAILED;
+		if (!none){
+			ok = known.calibration.postscaler == expected && known.exact && known.calibration.state == SPI_CAL_DONE
+					&& statistical.calibration.postscaler == expected && statistical.exact
+					&& statistical.calibration.state == SPI_CAL_DONE && unsteady == AC_PHASES;
+		}
+		if (!ok){ failures++; }
+
+		uint16_t p = known.calibration.postscaler;
+		char fastest_text[16];
+		snprintf(fastest_text, sizeof(fastest_text), none ? "none" : "%u", fastest);
+		printf("%9d  %13s  %19u %5.1f  %19u %5.1f  %8.2f  %10.3f  %10d/%d  %s\n", d, fastest_text,
+				p, known.interrupts * 0.05, statistical.calibration.postscaler, statistical.interrupts * 0.05,
+				125.0 / (p > 1 ? p : 1), SpiConversionLatency(p, BURST_LENGTH) * 1e6, unsteady, AC_PHASES, ok ? "" : "FAIL");
+		if (verbose){ PrintSettings(&known.calibration); }
+	}
+
+	printf("%s\n", failures ? "FAIL" : "PASS");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,179 @@
+/*
+ *	@title	Bit-exact replay of recorded interrupt traces through the user code
+ *	@file	trace_replay.cpp
+ *
+ *	Runs the project's UserInit() once, then for every record of the trace sets the core state and
+ *	the SBI registers it holds and calls the main interrupt, as fast as possible. After each call,
+ *	the variables registered as outputs of trace_recorder (user.cpp) are compared bit by bit with
+ *	the ones of the trace. Typical use, to validate a change of the API routines:
+ *
+ *		trace_replay field.bin --record reference.bin		# Reference outputs with the current code
+ *		... change the code, rebuild ...
+ *		trace_replay reference.bin							# Every output must be identical
+ *
+ *	A trace recorded on the target (user.cpp built with INTERRUPT_TRACE set to 1, off by default) can
+ *	be replayed directly too; its outputs then only match bit for bit where the target and the host
+ *	compute the same float operations. The host build always sets INTERRUPT_TRACE (Makefile).
+ *
+ *	Usage: trace_replay trace.bin [--record out.bin] [--repeat N] [--max-diffs N]
+ *	Exit status: 0 if all the outputs match, 1 on a mismatch, 2 on a usage or trace error.
+ */
+
+#include "interrupttrace.h"
+#include "Core/core.h"
+#include "Core/interrupts.h"
+#include "Driver/peripherals.h"
+#include "extern_user.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+extern InterruptRecorder trace_recorder;		// user.cpp
+
+
+static bool LoadFile(const char* name, std::vector<uint8_t>& data)
+{
+	FILE* f = fopen(name, "rb");
+	if (!f){ perror(name); return false; }
+	uint8_t chunk[65536];
+	size_t n;
+	while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0){ data.insert(data.end(), chunk, chunk + n); }
+	fclose(f);
+	return true;
+}
+
+
+static void PrintValue(uint8_t type, uint32_t bits)
+{
+	if (type == TRACE_FLOAT){
+		float x;
+		memcpy(&x, &bits, sizeof(x));
+		printf("%.9g (0x%08x)", x, bits);
+	}
+	else if (type == TRACE_INT32){ printf("%d", (int32_t)bits); }
+	else{ printf("%u", bits); }
+}
+
+
+/*
+ * Host recorder with the same inputs and outputs as the user's one
+ */
+static void CopyRecorderSetup(InterruptRecorder* me, const InterruptRecorder* model)
+{
+	for (int k = 0; k < model->inputs; k++){ AddRecorderInput(me, model->address[k]); }
+	for (int k = 0; k < model->outputs; k++){
+		AddRecorderOutputBits(me, model->name[k], model->variable[k], (tTraceOutputType)model->type[k]);
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	const char* trace_name = 0;
+	const char* record_name = 0;
+	int repeat = 1;
+	long max_diffs = 20;
+
+	for (int i = 1; i < argc; i++){
+		if (!strcmp(argv[i], "--record") && i + 1 < argc){ record_name = argv[++i]; }
+		else if (!strcmp(argv[i], "--repeat") && i + 1 < argc){ repeat = atoi(argv[++i]); }
+		else if (!strcmp(argv[i], "--max-diffs") && i + 1 < argc){ max_diffs = atol(argv[++i]); }
+		else if (argv[i][0] != '-' && !trace_name){ trace_name = argv[i]; }
+		else{ trace_name = 0; break; }
+	}
+	if (!trace_name || repeat < 1){
+		fprintf(stderr, "usage: %s trace.bin [--record out.bin] [--repeat N] [--max-diffs N]\n", argv[0]);
+		return 2;
+	}
+
+	std::vector<uint8_t> trace;
+	TraceReader reader;
+	if (!LoadFile(trace_name, trace)){ return 2; }
+	if (!ConfigTraceReader(&reader, trace.data(), (uint32_t)trace.size())){
+		fprintf(stderr, "%s: not a valid interrupt trace\n", trace_name);
+		return 2;
+	}
+
+	UserInit();
+	tInterruptHandler interrupt = HostGetMainInterrupt();
+	const InterruptRecorder* user = &trace_recorder;
+
+	// The inputs must be the ones the user code reads; the outputs are compared only if they match:
+	bool inputs_match = reader.inputs == user->inputs;
+	for (int k = 0; inputs_match && k < reader.inputs; k++){ inputs_match = reader.address[k] == user->address[k]; }
+	if (!inputs_match){
+		fprintf(stderr, "%s: the recorded SBI registers differ from the ones registered in UserInit()\n", trace_name);
+		return 2;
+	}
+	bool outputs_match = reader.outputs == user->outputs;
+	for (int k = 0; outputs_match && k < reader.outputs; k++){ outputs_match = reader.type[k] == user->type[k]; }
+	if (!outputs_match){ printf("warning: the recorded outputs differ from the registered ones, outputs not compared\n"); }
+
+	std::vector<uint8_t> record_buffer;
+	InterruptRecorder recorder;
+	if (record_name){
+		record_buffer.resize(trace.size() * 2 + 4096);
+		ConfigInterruptRecorder(&recorder, record_buffer.data(), (uint32_t)record_buffer.size());
+		CopyRecorderSetup(&recorder, user);
+	}
+
+	uint64_t records = 0, compared = 0, mismatches = 0, jumps = 0;
+	double seconds = 0.0;
+	for (int pass = 0; pass < repeat; pass++){
+		if (pass > 0){ UserInit(); }											// Fresh user state for every pass
+		trace_recorder.enabled = false;										// The user code must not record the replay
+		ConfigTraceReader(&reader, trace.data(), (uint32_t)trace.size());
+
+		TraceRecord r;
+		uint32_t expected_tick = 0;
+		auto start = std::chrono::steady_clock::now();
+		while (ReadTraceRecord(&reader, &r)){
+			HostSetCoreState(r.state);
+			for (int k = 0; k < reader.inputs; k++){ HostSetSbiRegister(reader.address[k], r.input[k]); }
+			if (record_name && pass == 0){ RecordInterruptInputs(&recorder, r.tick); }
+
+			interrupt();
+
+			if (record_name && pass == 0){ RecordInterruptOutputs(&recorder); }
+			if (pass > 0){ continue; }											// The later passes measure the speed only
+
+			records++;
+			if (r.tick != expected_tick){ jumps++; }
+			expected_tick = r.tick + 1;
+			if (!r.has_outputs || !outputs_match){ continue; }
+			compared++;
+			for (int k = 0; k < reader.outputs; k++){
+				uint32_t bits = *user->variable[k];
+				if (bits == r.output[k]){ continue; }
+				if ((long)mismatches++ < max_diffs){
+					printf("tick %u: %s = ", r.tick, user->name[k]);
+					PrintValue(reader.type[k], bits);
+					printf(", recorded ");
+					PrintValue(reader.type[k], r.output[k]);
+					printf("\n");
+				}
+			}
+		}
+		seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	if (reader.position != trace.size()){ printf("warning: truncated last record ignored\n"); }
+	if (jumps){ printf("warning: %llu tick discontinuities, the user state may not be reproduced after them\n", (unsigned long long)jumps); }
+
+	double rate = records * repeat / seconds;
+	printf("%llu interrupts replayed (%.0f /s, %.0fx real time), %llu with outputs compared, %llu mismatching values\n",
+			(unsigned long long)records, rate, rate / HostGetClockFrequency(CLOCK_0),
+			(unsigned long long)compared, (unsigned long long)mismatches);
+
+	if (record_name){
+		FILE* f = fopen(record_name, "wb");
+		if (!f || fwrite(record_buffer.data(), 1, recorder.length, f) != recorder.length){ perror(record_name); return 2; }
+		fclose(f);
+		printf("%u records (%u bytes) written to %s\n", recorder.records, recorder.length, record_name);
+	}
+
+	return mismatches ? 1 : 0;
+}
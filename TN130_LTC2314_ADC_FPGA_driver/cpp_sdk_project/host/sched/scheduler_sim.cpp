@@ -0,0 +1,210 @@
+/*
+ *	@title	Host test of the multi-rate scheduler on a simulated tick and clock
+ *	@file	scheduler_sim.cpp
+ *
+ *	A typical converter schedule (current loop and PLL every tick, voltage loops and temperature at
+ *	2 kHz, MPPT, telemetry and protections at 100 Hz, housekeeping at 1 Hz) is run for a few seconds of
+ *	simulated 20 kHz ticks. The tasks do not run real code: each one advances a simulated clock by its
+ *	cost, so the run is exactly reproducible. The test checks that:
+ *	 - every task runs at the rate of its group, always on the tick given by its phase
+ *	 - the worst tick load measured with the simulated clock matches the one predicted at start, and
+ *	   is lower than with all the phases at zero (everything aligned on the same tick)
+ *	 - the budget accounting of each group (worst case, mean, overruns) matches the task costs
+ *	 - two runs produce the same sequence of tasks
+ *	It then times RunRateScheduler with empty tasks and the real cycle counter.
+ *
+ *	Usage: scheduler_sim [seconds (default 5)]
+ */
+
+#include "ratescheduler.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <time.h>
+
+#define TICK_HZ			20e3
+#define CLOCK_HZ		1e9												// Simulated clock: 1 count = 1 ns
+
+typedef struct{
+	const char* name;
+	int group;																// Index in groups[]
+	uint32_t cost_ns;
+} TaskSpec;
+
+typedef struct{
+	const char* name;
+	double frequency;
+	double budget;
+} GroupSpec;
+
+static const GroupSpec groups[] = {
+	{"20 kHz",	20e3,	12e-6},
+	{"2 kHz",	2e3,	4e-6},
+	{"100 Hz",	100,	6e-6},
+	{"1 Hz",	1,		20e-6},												// Deliberately too short for its task
+};
+
+static const TaskSpec tasks[] = {
+	{"current loop",	0,	6000},
+	{"pll",				0,	2500},
+	{"dc voltage loop",	1,	1500},
+	{"ac voltage loop",	1,	1500},
+	{"temperature",		1,	800},
+	{"mppt",			2,	4000},
+	{"telemetry",		2,	3000},
+	{"protections",		2,	1200},
+	{"fan control",		2,	600},
+	{"housekeeping",	3,	25000},
+};
+
+#define TASK_COUNT	(sizeof(tasks)/sizeof(tasks[0]))
+#define GROUP_COUNT	(sizeof(groups)/sizeof(groups[0]))
+
+static uint32_t sim_clock;
+static uint32_t current_tick;
+static uint64_t executions[TASK_COUNT];
+static uint64_t misplaced[TASK_COUNT];
+static uint32_t tick_load;													// Simulated ns spent on the current tick
+static uint32_t sequence_hash;												// Order of the executions
+
+static RateScheduler scheduler;
+
+static uint32_t SimulatedClock(void){ return sim_clock; }
+
+static void SimulatedTask(void* context)
+{
+	uint32_t k = (uint32_t)(uintptr_t)context;
+	const ScheduledTask* t = &scheduler.task[k];
+	executions[k]++;
+	if (current_tick % t->divider != t->phase){ misplaced[k]++; }
+	sim_clock += tasks[k].cost_ns;
+	tick_load += tasks[k].cost_ns;
+	sequence_hash = (sequence_hash ^ (k + 1) ^ current_tick) * 16777619u;
+}
+
+static void EmptyTask(void*){}
+
+static float Configure(bool stagger)
+{
+	ConfigRateScheduler(&scheduler, TICK_HZ);
+	SetSchedulerClock(&scheduler, SimulatedClock, CLOCK_HZ);
+	for (uint32_t g = 0; g < GROUP_COUNT; g++){
+		AddRateGroup(&scheduler, groups[g].name, groups[g].frequency, groups[g].budget);
+	}
+	for (uint32_t k = 0; k < TASK_COUNT; k++){
+		AddScheduledTask(&scheduler, tasks[k].group, tasks[k].name, SimulatedTask, (void*)(uintptr_t)k, tasks[k].cost_ns * 1e-3f);
+	}
+	float predicted = StartRateScheduler(&scheduler);
+	if (!stagger){
+		for (uint32_t k = 0; k < TASK_COUNT; k++){
+			scheduler.task[k].phase = 0;
+			scheduler.task[k].countdown = 1;
+		}
+		predicted = GetScheduledCost(&scheduler, 0);
+	}
+	return predicted;
+}
+
+// Runs the schedule, returns the worst simulated tick load in ns
+static uint32_t Run(uint32_t ticks)
+{
+	uint32_t worst = 0;
+	memset(executions, 0, sizeof(executions));
+	memset(misplaced, 0, sizeof(misplaced));
+	sim_clock = 0;
+	sequence_hash = 2166136261u;
+	for (current_tick = 0; current_tick < ticks; current_tick++){
+		tick_load = 0;
+		RunRateScheduler(&scheduler);
+		if (tick_load > worst){ worst = tick_load; }
+		sim_clock += 1000;														// Time between the interrupts, not accounted
+	}
+	return worst;
+}
+
+static double NowNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char** argv)
+{
+	double seconds = argc > 1 ? atof(argv[1]) : 5.0;
+	uint32_t ticks = (uint32_t)(seconds * TICK_HZ);
+	int failures = 0;
+
+	// Aligned schedule (all the phases at zero), for reference:
+	float aligned_predicted = Configure(false);
+	uint32_t aligned_worst = Run(ticks);
+
+	// Staggered schedule:
+	float predicted = Configure(true);
+	uint32_t worst = Run(ticks);
+	uint32_t first_hash = sequence_hash;
+
+	printf("%-16s %-8s %8s %6s %10s %10s %9s\n", "task", "group", "period", "phase", "runs", "expected", "misplaced");
+	for (uint32_t k = 0; k < TASK_COUNT; k++){
+		const ScheduledTask* t = &scheduler.task[k];
+		uint64_t expected = ticks > t->phase ? (ticks - t->phase - 1) / t->divider + 1 : 0;
+		bool ok = executions[k] == expected && misplaced[k] == 0;
+		printf("%-16s %-8s %8u %6u %10llu %10llu %9llu%s\n", t->name, groups[t->group].name, t->divider, t->phase,
+				(unsigned long long)executions[k], (unsigned long long)expected, (unsigned long long)misplaced[k], ok ? "" : "  FAIL");
+		if (!ok){ failures++; }
+	}
+
+	printf("\nworst tick load: aligned %.1f us (predicted %.1f us), staggered %.1f us (predicted %.1f us)\n",
+			aligned_worst * 1e-3, aligned_predicted, worst * 1e-3, predicted);
+	if (worst * 1e-3 > predicted + 1e-3 || worst >= aligned_worst){
+		printf("FAIL: the staggered schedule is not flatter than the aligned one, or above its prediction\n");
+		failures++;
+	}
+
+	// Budget accounting against the costs of the tasks (all the tasks of a group run on distinct ticks
+	// when the group period allows it, otherwise the worst case is the sum of the coinciding ones):
+	printf("\n%-8s %10s %10s %10s %10s %10s\n", "group", "runs", "max us", "mean us", "budget us", "overruns");
+	for (uint8_t g = 0; g < scheduler.groups; g++){
+		RateGroupStats stats;
+		GetRateGroupStats(&scheduler, g, &stats);
+
+		uint32_t expected_max = 0;
+		for (uint32_t tick = 0; tick < 20000; tick++){
+			uint32_t sum = 0;
+			for (uint32_t k = 0; k < TASK_COUNT; k++){
+				const ScheduledTask* t = &scheduler.task[k];
+				if (t->group == g && tick % t->divider == t->phase){ sum += tasks[k].cost_ns; }
+			}
+			if (sum > expected_max){ expected_max = sum; }
+		}
+		bool ok = stats.max == expected_max && (stats.overruns > 0) == (expected_max > stats.budget_seconds * CLOCK_HZ);
+		printf("%-8s %10u %10.2f %10.2f %10.2f %10u%s\n", stats.name, stats.runs, stats.max_seconds * 1e6,
+				stats.mean * 1e-3, stats.budget_seconds * 1e6, stats.overruns, ok ? "" : "  FAIL");
+		if (!ok){ failures++; }
+	}
+
+	// Determinism:
+	Configure(true);
+	Run(ticks);
+	if (sequence_hash != first_hash){
+		printf("FAIL: two runs executed different sequences of tasks\n");
+		failures++;
+	}
+
+	// Overhead with the real clock and empty tasks:
+	ConfigRateScheduler(&scheduler, TICK_HZ);
+	for (uint32_t g = 0; g < GROUP_COUNT; g++){
+		AddRateGroup(&scheduler, groups[g].name, groups[g].frequency, groups[g].budget);
+	}
+	for (uint32_t k = 0; k < TASK_COUNT; k++){
+		AddScheduledTask(&scheduler, tasks[k].group, tasks[k].name, EmptyTask, NULL, tasks[k].cost_ns * 1e-3f);
+	}
+	StartRateScheduler(&scheduler);
+	double start = NowNs();
+	for (uint32_t tick = 0; tick < ticks; tick++){ RunRateScheduler(&scheduler); }
+	printf("\nRunRateScheduler: %.1f ns per tick (%u tasks, empty, host clock)\n", (NowNs() - start) / ticks, (unsigned)TASK_COUNT);
+
+	printf("%s\n", failures ? "FAIL" : "PASS");
+	return failures ? 1 : 0;
+}
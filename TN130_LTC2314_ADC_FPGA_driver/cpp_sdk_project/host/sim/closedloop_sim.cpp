@@ -0,0 +1,420 @@
+/*
+ *	@title	Closed-loop simulations of the control API and of the user code
+ *	@file	closedloop_sim.cpp
+ *
+ *	Every scenario runs unmodified routines of ../Test_LTC2314_driver against a plant model, checks
+ *	the closed-loop behaviour, then measures the throughput of the same loop:
+ *	 - RunDQPLL and RunDSOGIPLL3 on an unbalanced, distorted grid with a frequency offset
+ *	 - RunHarmonicAnalyzer locked to RunDSOGIPLL3 on the same grid, before and after a frequency step
+ *	 - RunPIController (dq frame, with a DQPLL) and RunPRController (alpha-beta) on an RL line
+ *	 - the project's UserInterrupt() on a distorted AC input (ADC_HARMONICS: PLL and harmonic analyzer)
+ *	 - the project's UserInterrupt() on a thermal plant seen through an NTC and the LTC2314 registers
+ *
+ *	Usage: closedloop_sim [--filter text] [--steps N (throughput run, default 2e6)] [--trace file]
+ *	--trace writes the interrupt trace recorded by user.cpp during the thermal scenario (replay/).
+ *	--profile prints the stage timings of UserInterrupt exported by UpdateInterruptProfile (host timings).
+ */
+
+#include "simengine.h"
+#include "plants.h"
+#include "loops.h"
+
+#include "sensorchannels.h"
+#include "temperature.h"
+#include "interrupttrace.h"
+#include "interruptprofiler.h"
+#include "ratescheduler.h"
+#include "samplebuffer.h"
+#include "harmonicanalyzer.h"
+#include "Driver/peripherals.h"
+#include "My_functions/sequenced_adc.h"
+#include "extern_user.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define TSAMPLE			50e-6				// Interrupt period (20 kHz)
+#define F_NOMINAL		50.0
+#define OMEGA_NOMINAL	(2 * M_PI * F_NOMINAL)
+
+extern float Tmeas;							// user.cpp
+extern SequencedAdc adc_sequence;
+extern SampleBuffer adc_capture;
+extern InterruptRecorder trace_recorder;
+extern InterruptProfiler profiler;
+extern ProfileStats profile_stats[];
+extern RateGroupStats rate_group_stats[];
+extern RateScheduler scheduler;
+extern HarmonicAnalysis adc_spectrum;
+void UpdateInterruptProfile(void);
+
+
+/*
+ * Line scenarios: the converter drives an RL line (R = 0.1 ohm, L = 5 mH) connected to a 325 V grid
+ */
+#define LINE_R			0.1
+#define LINE_L			5e-3
+#define GRID_PEAK		325.0
+#define CURRENT_STEP	20.0				// Reference step in A
+#define STEP_TIME		0.1
+
+
+/*
+ * Thermal scenario: 10 W heater on a 2 K/W, 5 J/K body (tau = 10 s) measured by the NTC of
+ * user.cpp; the plant drives the SBI registers read by UserInterrupt (data_out, burst sum and count).
+ */
+#define THERMAL_BURST	1					// As ADC_BURST_LENGTH in user.cpp
+
+typedef struct{
+	ThermalPlant plant;
+	ThermalSensor sensor;
+	double power;
+	uint32_t noise;							// LCG state of the ADC noise
+	uint16_t sequence;						// Conversions completed (sequence_out)
+} ThermalLoop;
+
+static void WriteAdcRegisters(ThermalLoop* me)
+{
+	uint32_t sum = 0;
+	uint16_t code = 0;
+	double level = ThermalSensorLevel(&me->sensor, me->plant.temperature);
+	for (int k = 0; k < THERMAL_BURST; k++){
+		me->noise = me->noise * 1664525u + 1013904223u;
+		code = QuantizeSensorLevel(level + ((me->noise >> 8) & 0xFFFF) / 65536.0 - 0.5);			// +/- 0.5 LSB noise
+		sum += code;
+	}
+	HostSetSbiRegister(0, code);
+	HostSetSbiRegister(1, sum & 0xFFFF);
+	HostSetSbiRegister(2, sum >> 16);
+	HostSetSbiRegister(3, THERMAL_BURST);
+	me->sequence += THERMAL_BURST;
+	HostSetSbiRegister(4, 0x8000 | (me->sequence & 0x7FFF));					// Valid, one burst later
+}
+
+static void ThermalPlantStep(void* context, double time, double tsample)
+{
+	ThermalLoop* me = (ThermalLoop*)context;
+	me->power = time < 30.0 ? 10.0 : 0.0;
+	StepThermalPlant(&me->plant, me->power, tsample);
+	WriteAdcRegisters(me);
+}
+
+
+/*
+ * AC scenario: distorted 50 Hz input around the mid-scale of the LTC2314 (ADC_AC_OFFSET, ADC_AC_PEAK and
+ * the orders of user.cpp): 1 V fundamental, 0.04 V 5th and 0.03 V 7th, i.e. 5 % THD, with +/- 0.5 LSB noise
+ */
+#define AC_OFFSET		2.048
+#define AC_FUNDAMENTAL	1.0
+
+typedef struct{
+	double frequency;
+	double phase;
+	uint32_t noise;
+	uint16_t sequence;
+} AcInput;
+
+static void AcInputStep(void* context, double /*time*/, double tsample)
+{
+	AcInput* me = (AcInput*)context;
+	me->phase = fmod(me->phase + 2 * M_PI * me->frequency * tsample, 2 * M_PI);
+	double v = AC_OFFSET + AC_FUNDAMENTAL * sin(me->phase) + 0.04 * sin(5 * me->phase) + 0.03 * sin(7 * me->phase);
+	me->noise = me->noise * 1664525u + 1013904223u;
+	uint16_t code = QuantizeSensorLevel(v / LTC2314_ADCONV + ((me->noise >> 8) & 0xFFFF) / 65536.0 - 0.5);
+	HostSetSbiRegister(0, code);
+	HostSetSbiRegister(1, code);
+	HostSetSbiRegister(2, 0);
+	HostSetSbiRegister(3, 1);
+	me->sequence++;
+	HostSetSbiRegister(4, 0x8000 | (me->sequence & 0x7FFF));
+}
+
+
+/*
+ * Scenarios
+ */
+typedef struct{
+	double simulated;						// Simulated seconds of the checked run
+	double steps_per_second;				// Throughput of the long run
+	bool pass;
+	char metrics[160];
+} ScenarioResult;
+
+static void Throughput(SimEngine* sim, uint64_t steps, ScenarioResult* result)
+{
+	result->simulated = sim->time;
+	SimEngine run = *sim;
+	run.steps = 0;
+	run.wall_seconds = 0.0;
+	RunSimEngine(&run, steps);
+	result->steps_per_second = GetSimStepsPerSecond(&run);
+}
+
+static void ScenarioPLL(bool dsogi, uint64_t steps, ScenarioResult* result)
+{
+	static GridPlant plant;
+	static PLLLoop loop;
+	SimEngine sim;
+
+	ConfigDistortedGridPlant(&plant);
+	loop.plant = &plant;
+	ConfigDQPLL(&loop.dqpll, 178.0, 125.0*125.0*TSAMPLE, OMEGA_NOMINAL, TSAMPLE);		// wn = 125 rad/s, zeta = 0.7
+	ConfigDSOGIPLL3(&loop.dsogipll, 178.0, 125.0*125.0*TSAMPLE, 1.41, OMEGA_NOMINAL, TSAMPLE);
+	ConfigSimEngine(&sim, TSAMPLE, dsogi ? DSOGIPLLInterrupt : DQPLLInterrupt, &loop, GridPlantStep, &plant);
+
+	// The DQPLL keeps a 100 Hz frequency ripple, hence a lock criterion on the phase only:
+	LoopResponse r = EvaluatePLLLoop(&sim, &loop, dsogi, 1.0);
+
+	result->pass = r.stable && r.settling < 0.2;
+	snprintf(result->metrics, sizeof(result->metrics), "lock %.1f ms, after 0.5 s: phase err %.2f deg, freq err %.3f Hz",
+			r.settling * 1e3, r.steady_error, r.steady_freq_error);
+	Throughput(&sim, steps, result);
+}
+
+static void ScenarioDQPLL(uint64_t steps, ScenarioResult* result){ ScenarioPLL(false, steps, result); }
+static void ScenarioDSOGIPLL(uint64_t steps, ScenarioResult* result){ ScenarioPLL(true, steps, result); }
+
+/*
+ * Harmonic analyzer on phase A of the distorted grid: 1.05 pu fundamental (positive sequence and 5 %
+ * unbalance in phase), 0.04 pu 5th and 0.03 pu 7th, i.e. 4.76 % THD, at 49.5 Hz then 50.5 Hz.
+ */
+typedef struct{
+	PLLLoop pll;
+	HarmonicAnalyzer analyzer;
+} HarmonicLoop;
+
+static tUserSafe HarmonicInterrupt(void* context)
+{
+	HarmonicLoop* me = (HarmonicLoop*)context;
+	RunHarmonicAnalyzer(&me->analyzer, (float)me->pll.plant->v.A, &me->pll.dsogipll.angle);	// Angle of this sample
+	return DSOGIPLLInterrupt(&me->pll);
+}
+
+static void ScenarioHarmonics(uint64_t steps, ScenarioResult* result)
+{
+	static GridPlant plant;
+	static HarmonicLoop loop;
+	static const uint16_t orders[] = {1, 2, 3, 5, 7, 11, 13};
+	static const double expected[] = {1.05, 0.0, 0.0, 0.04, 0.03, 0.0, 0.0};
+	const double thd = 0.05 / 1.05;
+	SimEngine sim;
+
+	ConfigDistortedGridPlant(&plant);
+	loop.pll.plant = &plant;
+	ConfigDSOGIPLL3(&loop.pll.dsogipll, 178.0, 125.0*125.0*TSAMPLE, 1.41, OMEGA_NOMINAL, TSAMPLE);
+	ConfigHarmonicAnalyzer(&loop.analyzer, orders, sizeof(orders)/sizeof(orders[0]), TSAMPLE);
+	ConfigSimEngine(&sim, TSAMPLE, HarmonicInterrupt, &loop, GridPlantStep, &plant);
+
+	// Worst errors over the periods of the last 0.2 s before and after the frequency step:
+	double error_h = 0.0, error_thd = 0.0, error_f = 0.0;
+	uint32_t checked = 0, seen = 0;
+	for (int step = 0; step < 2; step++){
+		double frequency = step ? 50.5 : 49.5;
+		plant.grid.omega = 2 * M_PI * frequency;
+		double end = sim.time + 0.7;
+		while (sim.time < end){
+			RunSimEngine(&sim, 1);
+			HarmonicAnalysis a;
+			if (GetHarmonicAnalysis(&loop.analyzer, &a) == seen || sim.time < end - 0.2){ continue; }
+			seen = a.periods;
+			checked++;
+			for (uint16_t k = 0; k < a.bins; k++){ error_h = fmax(error_h, fabs(a.magnitude[k] - expected[k])); }
+			error_thd = fmax(error_thd, fabs(a.thd - thd));
+			error_f = fmax(error_f, fabs(a.frequency - frequency));
+		}
+	}
+
+	result->pass = checked >= 19 && error_h < 1e-3 && error_thd < 1e-3 && error_f < 0.01;
+	snprintf(result->metrics, sizeof(result->metrics), "%u periods checked: max harmonic err %.2e pu, THD err %.3f %%, freq err %.4f Hz",
+			checked, error_h, error_thd * 100, error_f);
+	Throughput(&sim, steps, result);
+}
+
+
+static void ScenarioCurrent(bool pr, uint64_t steps, ScenarioResult* result)
+{
+	static LinePlant plant;
+	static CurrentLoop loop;
+	SimEngine sim;
+
+	ConfigLinePlant(&plant, LINE_R, LINE_L, GRID_PEAK, F_NOMINAL, TSAMPLE);
+	loop.plant = &plant;
+	loop.sim = &sim;
+	loop.line_l = LINE_L;
+	loop.step_time = STEP_TIME;
+	loop.i_step = CURRENT_STEP;
+	ConfigDQPLL(&loop.pll, 178.0 / GRID_PEAK, 125.0*125.0*TSAMPLE / GRID_PEAK, OMEGA_NOMINAL, TSAMPLE);
+	ConfigPIDController(&loop.pi_d, 15.7, 15.7 / 1e-3 * TSAMPLE, 0.0, 200.0, -200.0, TSAMPLE, 10);		// 500 Hz, Ti = 1 ms
+	ConfigPIDController(&loop.pi_q, 15.7, 15.7 / 1e-3 * TSAMPLE, 0.0, 200.0, -200.0, TSAMPLE, 10);
+	ConfigPRController(&loop.pr_a, 15.7, 500.0, OMEGA_NOMINAL, 5.0, TSAMPLE);
+	ConfigPRController(&loop.pr_b, 15.7, 500.0, OMEGA_NOMINAL, 5.0, TSAMPLE);
+	ConfigSimEngine(&sim, TSAMPLE, pr ? PRCurrentInterrupt : PICurrentInterrupt, &loop, LinePlantStep, &plant);
+
+	// Let the PLL lock before the step, then record the response of the current amplitude:
+	LoopResponse r = EvaluateCurrentLoop(&sim, &loop, 0.2);
+
+	result->pass = r.stable && r.settling < 0.05 && r.overshoot < 20.0;
+	snprintf(result->metrics, sizeof(result->metrics), "2%% settling %.2f ms, overshoot %.1f %%, late error %.3f A",
+			r.settling * 1e3, r.overshoot, r.steady_error);
+	Throughput(&sim, steps, result);
+}
+
+static void ScenarioPI(uint64_t steps, ScenarioResult* result){ ScenarioCurrent(false, steps, result); }
+static void ScenarioPR(uint64_t steps, ScenarioResult* result){ ScenarioCurrent(true, steps, result); }
+
+static void ScenarioAc(uint64_t steps, ScenarioResult* result)
+{
+	static AcInput input;
+	static const double expected[] = {AC_OFFSET, AC_FUNDAMENTAL, 0.0, 0.0, 0.04, 0.03, 0.0, 0.0};		// Orders 0, 1, 2, 3, 5, 7, 11, 13
+	const double thd = 0.05 / AC_FUNDAMENTAL;
+	SimEngine sim;
+
+	input.frequency = 49.5;
+	input.phase = 0.0;
+	input.noise = 1;
+	input.sequence = 0;
+	AcInputStep(&input, 0.0, 0.0);
+
+	UserInit();
+	static tInterruptHandler handler;
+	handler = HostGetMainInterrupt();
+	HostSetCoreState(OPERATING);
+	ConfigSimEngine(&sim, 1.0 / HostGetClockFrequency(CLOCK_0), SimUserInterrupt, &handler, AcInputStep, &input);
+
+	// Worst errors on the spectra exported by the task "harmonics" during the last 0.2 s of each frequency:
+	double error_h = 0.0, error_thd = 0.0, error_f = 0.0;
+	uint32_t checked = 0, seen = 0;
+	bool orders = adc_spectrum.bins == 0;
+	for (int step = 0; step < 2; step++){
+		input.frequency = step ? 50.5 : 49.5;
+		double end = sim.time + 0.7;
+		while (sim.time < end){
+			RunSimEngine(&sim, 1);
+			if (adc_spectrum.periods == seen || sim.time < end - 0.2){ continue; }
+			seen = adc_spectrum.periods;
+			checked++;
+			orders = adc_spectrum.bins == sizeof(expected)/sizeof(expected[0]);
+			for (uint16_t k = 0; orders && k < adc_spectrum.bins; k++){
+				error_h = fmax(error_h, fabs(adc_spectrum.magnitude[k] - expected[k]));
+			}
+			error_thd = fmax(error_thd, fabs(adc_spectrum.thd - thd));
+			error_f = fmax(error_f, fabs(adc_spectrum.frequency - input.frequency));
+		}
+	}
+
+	result->pass = orders && checked >= 15 && error_h < 1e-3 && error_thd < 5e-4 && error_f < 0.01 && sim.unsafe_steps == 0;
+	snprintf(result->metrics, sizeof(result->metrics), "%u spectra checked: max harmonic err %.2e V, THD err %.3f %%, freq err %.4f Hz",
+			checked, error_h, error_thd * 100, error_f);
+	Throughput(&sim, steps, result);
+}
+
+static void ScenarioThermal(uint64_t steps, ScenarioResult* result)
+{
+	static ThermalLoop loop;
+	SimEngine sim;
+
+	ConfigThermalPlant(&loop.plant, 2.0, 5.0, 25.0);
+	loop.sensor = NtcDivider(LTC2314_ADCONV, 4.096, 10e3, 1.009249522e-3, 2.378405444e-4, 2.019202697e-7, -40.0, 125.0);
+	loop.noise = 1;
+	loop.sequence = 0;
+	WriteAdcRegisters(&loop);
+
+	// The unmodified user code, through the bbos stand-in:
+	UserInit();
+	static tInterruptHandler handler;
+	handler = HostGetMainInterrupt();
+	HostSetCoreState(OPERATING);
+	ConfigSimEngine(&sim, 1.0 / HostGetClockFrequency(CLOCK_0), SimUserInterrupt, &handler, ThermalPlantStep, &loop);
+
+	double max_error = 0.0, max_temperature = 0.0;
+	while (sim.time < 60.0){
+		RunSimEngine(&sim, 1);
+		// Tmeas was computed from the registers of the previous period:
+		double error = fabs(Tmeas - loop.plant.temperature);
+		if (sim.time > 0.1 && error > max_error){ max_error = error; }
+		if (loop.plant.temperature > max_temperature){ max_temperature = loop.plant.temperature; }
+	}
+
+	uint32_t anomalies = adc_sequence.stale + adc_sequence.dropped + adc_sequence.pending;
+	uint32_t overruns = GetSampleBufferOverruns(&adc_capture);										// The 100 Hz task keeps up
+	uint32_t backlog = adc_capture.head.load() - adc_capture.tail.load();
+	result->pass = max_error < 0.1 && sim.unsafe_steps == 0 && anomalies == 0 && overruns == 0 && backlog <= 200;
+	snprintf(result->metrics, sizeof(result->metrics), "peak %.2f degC, max |Tmeas - T| %.4f degC, %llu UNSAFE, %u stale/dropped samples, %u capture overruns",
+			max_temperature, max_error, (unsigned long long)sim.unsafe_steps, anomalies, overruns);
+	Throughput(&sim, steps, result);
+}
+
+
+typedef struct{
+	const char* name;
+	void (*run)(uint64_t steps, ScenarioResult* result);
+} Scenario;
+
+static const Scenario scenarios[] = {
+	{"RunDQPLL grid",			ScenarioDQPLL},
+	{"RunDSOGIPLL3 grid",		ScenarioDSOGIPLL},
+	{"HarmonicAnalyzer grid",	ScenarioHarmonics},
+	{"RunPIController RL",		ScenarioPI},
+	{"RunPRController RL",		ScenarioPR},
+	{"UserInterrupt AC",		ScenarioAc},					// Before the thermal scenario: its trace is the one written
+	{"UserInterrupt thermal",	ScenarioThermal},
+};
+
+
+int main(int argc, char** argv)
+{
+	const char* filter = 0;
+	const char* trace_name = 0;
+	bool profile = false;
+	uint64_t steps = 2000000;
+
+	for (int i = 1; i < argc; i++){
+		if (!strcmp(argv[i], "--filter") && i + 1 < argc){ filter = argv[++i]; }
+		else if (!strcmp(argv[i], "--steps") && i + 1 < argc){ steps = (uint64_t)atof(argv[++i]); }
+		else if (!strcmp(argv[i], "--trace") && i + 1 < argc){ trace_name = argv[++i]; }
+		else if (!strcmp(argv[i], "--profile")){ profile = true; }
+		else{
+			fprintf(stderr, "usage: %s [--filter text] [--steps N] [--trace file] [--profile]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	int failures = 0;
+	printf("%-24s %9s %12s %9s  %s\n", "scenario", "sim s", "steps/s", "x real", "result");
+	for (unsigned int k = 0; k < sizeof(scenarios)/sizeof(scenarios[0]); k++){
+		if (filter && !strstr(scenarios[k].name, filter)){ continue; }
+
+		ScenarioResult result;
+		scenarios[k].run(steps, &result);
+		printf("%-24s %9.2f %12.3g %9.0f  %s  %s\n", scenarios[k].name, result.simulated, result.steps_per_second,
+				result.steps_per_second * TSAMPLE, result.pass ? "PASS" : "FAIL", result.metrics);
+		if (!result.pass){ failures++; }
+	}
+
+	if (profile && profiler.stages > 0){
+		UpdateInterruptProfile();											// Latest figures (exported incrementally by the "profile" task)
+		printf("\nUserInterrupt stages, in counts of the host cycle counter (%.2f GHz):\n", profiler.counter_hz / 1e9);
+		printf("  %-14s %10s %8s %8s %8s %8s %8s %8s %9s\n", "stage", "count", "mean", "p50", "p99", "p99.9", "max", "max ns", "budget %");
+		for (int k = 0; k < profiler.stages; k++){
+			const ProfileStats* s = &profile_stats[k];
+			printf("  %-14s %10u %8.0f %8u %8u %8u %8u %8.0f %9.3f\n", s->name, s->count, s->mean, s->p50, s->p99, s->p999,
+					s->max, s->max_seconds * 1e9, s->max_budget * 100);
+		}
+		printf("\nRate groups:\n  %-14s %10s %10s %9s %9s\n", "group", "runs", "overruns", "max ns", "budget %");
+		for (int k = 0; k < scheduler.groups; k++){
+			const RateGroupStats* g = &rate_group_stats[k];
+			printf("  %-14s %10u %10u %9.0f %9.3f\n", g->name, g->runs, g->overruns, g->max_seconds * 1e9, g->max_budget * 100);
+		}
+	}
+
+	if (trace_name && trace_recorder.length > 0){
+		FILE* f = fopen(trace_name, "wb");
+		if (!f || fwrite(trace_recorder.buffer, 1, trace_recorder.length, f) != trace_recorder.length){ perror(trace_name); return 1; }
+		fclose(f);
+		printf("%u interrupts (%u bytes) recorded in %s\n", trace_recorder.records, trace_recorder.length, trace_name);
+	}
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,179 @@
+/*
+ *	@title	Reusable closed loops (plant + interrupt routine) and their evaluation
+ *	@file	loops.cpp
+ */
+
+#include "loops.h"
+
+#include <cmath>
+
+#define DEG				(M_PI / 180.0)
+
+
+void ConfigDistortedGridPlant(GridPlant* me)
+{
+	ConfigGridSource(&me->grid, 1.0, 49.5, 60 * DEG);
+	SetGridUnbalance(&me->grid, 0.05, 0.0);
+	AddGridHarmonic(&me->grid, 5, 0.04, 0.0);
+	AddGridHarmonic(&me->grid, 7, 0.03, 0.0);
+	GridVoltage(&me->grid, &me->v);
+}
+
+
+void GridPlantStep(void* context, double time, double tsample)
+{
+	(void)time;
+	GridPlant* me = (GridPlant*)context;
+	StepGridSource(&me->grid, tsample);
+	GridVoltage(&me->grid, &me->v);
+}
+
+
+tUserSafe DQPLLInterrupt(void* context)
+{
+	PLLLoop* me = (PLLLoop*)context;
+	SpaceVector vdq;
+	abc2DQ0(&vdq, &me->plant->v, GetDQPLLAngle(&me->dqpll));
+	RunDQPLL(&me->dqpll, &vdq);
+	return SAFE;
+}
+
+
+tUserSafe DSOGIPLLInterrupt(void* context)
+{
+	PLLLoop* me = (PLLLoop*)context;
+	SpaceVector vabg;
+	abc2ABG(&vabg, &me->plant->v);
+	RunDSOGIPLL3(&me->dsogipll, &vabg);
+	return SAFE;
+}
+
+
+void ConfigLinePlant(LinePlant* me, double R, double L, double grid_peak, double frequency, double tsample)
+{
+	ConfigGridSource(&me->grid, grid_peak, frequency, 0.0);
+	ConfigRLLine(&me->line, R, L, tsample);
+	GridVoltage(&me->grid, &me->vg);
+	me->vconv = me->vg;
+	LineCurrent(&me->line, &me->i);
+}
+
+
+void LinePlantStep(void* context, double time, double tsample)
+{
+	(void)time;
+	LinePlant* me = (LinePlant*)context;
+	StepRLLine(&me->line, &me->vconv, &me->vg);
+	StepGridSource(&me->grid, tsample);
+	GridVoltage(&me->grid, &me->vg);
+	LineCurrent(&me->line, &me->i);
+}
+
+
+tUserSafe PICurrentInterrupt(void* context)
+{
+	CurrentLoop* me = (CurrentLoop*)context;
+	SpaceVector vg_dq, i_dq, u;
+
+	float i_ref = me->sim->time >= me->step_time ? me->i_step : 0.0f;
+
+	abc2DQ0(&vg_dq, &me->plant->vg, GetDQPLLAngle(&me->pll));
+	abc2DQ0(&i_dq, &me->plant->i, GetDQPLLAngle(&me->pll));
+
+	// PI on each axis, grid feedforward and decoupling:
+	float omega_l = me->pll.omega * me->line_l;
+	u.real = RunPIController(&me->pi_d, i_ref - i_dq.real) + vg_dq.real - omega_l * i_dq.imaginary;
+	u.imaginary = RunPIController(&me->pi_q, 0.0f - i_dq.imaginary) + vg_dq.imaginary + omega_l * i_dq.real;
+	u.offset = 0.0f;
+
+	DQ02abc(&me->plant->vconv, &u, GetDQPLLAngle(&me->pll));
+	RunDQPLL(&me->pll, &vg_dq);
+	return SAFE;
+}
+
+
+tUserSafe PRCurrentInterrupt(void* context)
+{
+	CurrentLoop* me = (CurrentLoop*)context;
+	SpaceVector vg_abg, i_abg, u;
+
+	// Sinusoidal reference in phase with the grid (ideal angle, the PLLs are evaluated separately):
+	float amplitude = me->sim->time >= me->step_time ? me->i_step : 0.0f;
+	float theta = (float)me->plant->grid.theta;
+
+	abc2ABG(&vg_abg, &me->plant->vg);
+	abc2ABG(&i_abg, &me->plant->i);
+
+	u.real = RunPRController(&me->pr_a, amplitude * cosf(theta) - i_abg.real) + vg_abg.real;
+	u.imaginary = RunPRController(&me->pr_b, amplitude * sinf(theta) - i_abg.imaginary) + vg_abg.imaginary;
+	u.offset = 0.0f;
+
+	ABG2abc(&me->plant->vconv, &u);
+	return SAFE;
+}
+
+
+/*
+ * Lock = last time the phase error exceeded 2 deg. Overshoot = largest excursion past zero of the
+ * phase error, relative to the sign of the initial error.
+ */
+LoopResponse EvaluatePLLLoop(SimEngine* sim, const PLLLoop* loop, bool dsogi, double duration)
+{
+	LoopResponse r = {true, 0.0, 0.0, 0.0, 0.0};
+	const GridSource* grid = &loop->plant->grid;
+	double start = sim->time;
+	double initial = 0.0;
+
+	while (sim->time < start + duration){
+		RunSimEngine(sim, 1);
+		double theta = dsogi ? loop->dsogipll.theta : loop->dqpll.theta;
+		double omega = dsogi ? loop->dsogipll.omega : loop->dqpll.omega;
+		double error = remainder(theta - grid->theta, 2 * M_PI);
+		double freq_error = fabs(omega - grid->omega) / (2 * M_PI);
+
+		if (!std::isfinite(error) || !std::isfinite(freq_error)){ r.stable = false; break; }
+		if (initial == 0.0){ initial = error; }
+		if (fabs(error) > 2 * DEG){ r.settling = sim->time - start; }
+		if (error * initial < 0 && fabs(error) / DEG > r.overshoot){ r.overshoot = fabs(error) / DEG; }
+		if (sim->time - start > duration / 2){
+			if (fabs(error) / DEG > r.steady_error){ r.steady_error = fabs(error) / DEG; }
+			if (freq_error > r.steady_freq_error){ r.steady_freq_error = freq_error; }
+		}
+	}
+
+	if (r.settling > duration / 2){ r.stable = false; }										// Never locked
+	return r;
+}
+
+
+/*
+ * The response is that of the amplitude of the current space vector after the reference step.
+ */
+LoopResponse EvaluateCurrentLoop(SimEngine* sim, const CurrentLoop* loop, double duration)
+{
+	LoopResponse r = {true, 0.0, 0.0, 0.0, 0.0};
+	double target = loop->i_step;
+	double peak = 0.0;
+
+	RunSimEngineUntil(sim, loop->step_time);
+	double start = sim->time;
+
+	while (sim->time < start + duration){
+		RunSimEngine(sim, 1);
+		TimeDomain i;
+		SpaceVector i_abg;
+		LineCurrent(&loop->plant->line, &i);
+		abc2ABG(&i_abg, &i);
+		double amplitude = hypot(i_abg.real, i_abg.imaginary);
+		double error = fabs(amplitude - target);
+
+		if (!std::isfinite(amplitude) || amplitude > 100 * target){ r.stable = false; break; }
+		if (amplitude > peak){ peak = amplitude; }
+		if (error > 0.02 * target){ r.settling = sim->time - start; }
+		if (sim->time - start > duration / 2 && error > r.steady_error){ r.steady_error = error; }
+	}
+
+	r.overshoot = peak > target ? 100.0 * (peak - target) / target : 0.0;
+	if (r.settling > duration / 2){ r.stable = false; }										// Never settled
+	return r;
+}
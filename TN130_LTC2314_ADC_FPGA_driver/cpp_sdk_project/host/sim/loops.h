@@ -0,0 +1,93 @@
+/*
+ *	@title	Reusable closed loops (plant + interrupt routine) and their evaluation
+ *	@file	loops.h
+ *
+ *	Shared by closedloop_sim and the gain tuner. Every loop keeps all its state in its own structs,
+ *	so that any number of them can be simulated concurrently.
+ */
+
+#ifndef LOOPS_H_
+#define LOOPS_H_
+
+#include "simengine.h"
+#include "plants.h"
+
+#include "controllers.h"
+#include "PLLs.h"
+#include "transformations.h"
+
+
+/**
+ * Grid voltage measured by a PLL, sampled in per unit of the positive sequence
+ */
+typedef struct{
+	GridSource grid;
+	TimeDomain v;							// Sampled voltage for the next interrupt
+} GridPlant;
+
+typedef struct{
+	const GridPlant* plant;
+	DQPLLParameters dqpll;
+	DSOGIPLL3Parameters dsogipll;
+} PLLLoop;
+
+// Test grid: 49.5 Hz, 60 deg initial offset, 5 % unbalance, 4 % 5th and 3 % 7th harmonics
+void ConfigDistortedGridPlant(GridPlant* me);
+void GridPlantStep(void* context, double time, double tsample);
+tUserSafe DQPLLInterrupt(void* context);
+tUserSafe DSOGIPLLInterrupt(void* context);
+
+
+/**
+ * Converter connected to a grid through an RL line, current-controlled either by two PIs in the
+ * dq frame (with a DQPLL, grid feedforward and decoupling) or by two PRs in the alpha-beta frame
+ */
+typedef struct{
+	GridSource grid;
+	RLLine line;
+	TimeDomain vg;							// Sampled grid voltage
+	TimeDomain i;							// Sampled line current
+	TimeDomain vconv;						// Converter voltage held during the period
+} LinePlant;
+
+typedef struct{
+	LinePlant* plant;
+	const SimEngine* sim;
+	DQPLLParameters pll;
+	PIDController pi_d, pi_q;
+	PRController pr_a, pr_b;
+	float line_l;							// Inductance used for the decoupling
+	double step_time;						// Time of the reference step
+	float i_step;							// Reference amplitude after the step
+} CurrentLoop;
+
+void ConfigLinePlant(LinePlant* me, double R, double L, double grid_peak, double frequency, double tsample);
+void LinePlantStep(void* context, double time, double tsample);
+tUserSafe PICurrentInterrupt(void* context);
+tUserSafe PRCurrentInterrupt(void* context);
+
+
+/**
+ * Results of the evaluation of a loop. A loop is 'stable' when its error stays bounded and finite.
+ */
+typedef struct{
+	bool stable;
+	double settling;						// Lock time (PLL) or 2 % settling time after the step (current), in s
+	double overshoot;						// Phase overshoot in deg (PLL) or current overshoot in % (current)
+	double steady_error;					// Peak phase error in deg (PLL) or peak current error in A (current) in the second half
+	double steady_freq_error;				// Peak frequency error in Hz in the second half (PLL only)
+} LoopResponse;
+
+
+/**
+ * Routines to simulate a loop from its current state and evaluate its response
+ * @param *sim			the engine, configured with the loop (time = 0)
+ * @param *loop			the loop
+ * @param dsogi			evaluate the DSOGIPLL3 (true) or the DQPLL (false) of the loop
+ * @param duration		the simulated time in s (after the step for the current loops)
+ * @return				the response
+ */
+LoopResponse EvaluatePLLLoop(SimEngine* sim, const PLLLoop* loop, bool dsogi, double duration);
+LoopResponse EvaluateCurrentLoop(SimEngine* sim, const CurrentLoop* loop, double duration);
+
+#endif /* LOOPS_H_ */
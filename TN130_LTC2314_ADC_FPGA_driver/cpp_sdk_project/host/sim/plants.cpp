@@ -0,0 +1,141 @@
+/*
+ *	@title	Plant models for the closed-loop simulations
+ *	@file	plants.cpp
+ */
+
+#include "plants.h"
+
+#include <cmath>
+
+
+void ConfigGridSource(GridSource* me, double amplitude, double frequency, double phase)
+{
+	me->amplitude = amplitude;
+	me->omega = 2 * M_PI * frequency;
+	me->theta = remainder(phase, 2 * M_PI);
+	me->unbalance = 0.0;
+	me->unbalance_phase = 0.0;
+	me->harmonics = 0;
+}
+
+
+void SetGridUnbalance(GridSource* me, double ratio, double phase)
+{
+	me->unbalance = ratio;
+	me->unbalance_phase = phase;
+}
+
+
+int AddGridHarmonic(GridSource* me, int order, double ratio, double phase)
+{
+	if (me->harmonics >= GRID_MAX_HARMONICS){ return -1; }
+	me->order[me->harmonics] = order;
+	me->ratio[me->harmonics] = ratio;
+	me->phase[me->harmonics] = phase;
+	me->harmonics++;
+	return 0;
+}
+
+
+void GridVoltage(const GridSource* me, TimeDomain* v)
+{
+	double out[3];
+	for (int k = 0; k < 3; k++){
+		double shift = k * 2 * M_PI / 3;
+		double x = cos(me->theta - shift) + me->unbalance * cos(me->theta + shift + me->unbalance_phase);
+		for (int h = 0; h < me->harmonics; h++){
+			x += me->ratio[h] * cos(me->order[h] * (me->theta - shift) + me->phase[h]);	// 5th: negative sequence, 7th: positive, ...
+		}
+		out[k] = me->amplitude * x;
+	}
+	v->A = out[0];
+	v->B = out[1];
+	v->C = out[2];
+}
+
+
+void StepGridSource(GridSource* me, double tsample)
+{
+	me->theta += me->omega * tsample;
+	if (me->theta >= M_PI){ me->theta -= 2 * M_PI; }
+	else if (me->theta < -M_PI){ me->theta += 2 * M_PI; }
+}
+
+
+void ConfigRLLine(RLLine* me, double R, double L, double tsample)
+{
+	me->a = exp(-R * tsample / L);
+	me->b = R > 0 ? (1 - me->a) / R : tsample / L;
+	me->current[0] = me->current[1] = me->current[2] = 0.0;
+}
+
+
+void StepRLLine(RLLine* me, const TimeDomain* v_converter, const TimeDomain* v_source)
+{
+	me->current[0] = me->a * me->current[0] + me->b * ((double)v_converter->A - v_source->A);
+	me->current[1] = me->a * me->current[1] + me->b * ((double)v_converter->B - v_source->B);
+	me->current[2] = me->a * me->current[2] + me->b * ((double)v_converter->C - v_source->C);
+}
+
+
+void LineCurrent(const RLLine* me, TimeDomain* i)
+{
+	i->A = me->current[0];
+	i->B = me->current[1];
+	i->C = me->current[2];
+}
+
+
+void ConfigThermalPlant(ThermalPlant* me, double r_th, double c_th, double ambient)
+{
+	me->r_th = r_th;
+	me->c_th = c_th;
+	me->ambient = ambient;
+	me->temperature = ambient;
+}
+
+
+void StepThermalPlant(ThermalPlant* me, double power, double tsample)
+{
+	double steady = me->ambient + power * me->r_th;
+	me->temperature = steady + (me->temperature - steady) * exp(-tsample / (me->r_th * me->c_th));
+}
+
+
+/*
+ * Resistance of the sensor at a temperature: Steinhart-Hart solved for ln(R) by Newton's method
+ * (monotonic cubic), Callendar-Van Dusen evaluated directly.
+ */
+static double SensorResistance(const ThermalSensor* s, double celsius)
+{
+	if (s->model == THERMISTOR_STEINHART_HART){
+		double y = 1.0 / (celsius + KELVIN_OFFSET);
+		double x = 9.0;
+		for (int k = 0; k < 50; k++){
+			double f = s->c[0] + s->c[1] * x + s->c[2] * x * x * x - y;
+			double dx = f / (s->c[1] + 3 * s->c[2] * x * x);
+			x -= dx;
+			if (fabs(dx) < 1e-12){ break; }
+		}
+		return exp(x);
+	}
+	double t = celsius;
+	double c = t < 0 ? s->c[3] : 0.0;
+	return s->c[0] * (1 + s->c[1] * t + s->c[2] * t * t + c * (t - 100) * t * t * t);
+}
+
+
+double ThermalSensorLevel(const ThermalSensor* sensor, double celsius)
+{
+	double r = SensorResistance(sensor, celsius);
+	double v = sensor->r_series > 0 ? sensor->v_excitation * r / (r + sensor->r_series) : r * sensor->i_excitation;
+	return v / sensor->lsb;
+}
+
+
+uint16_t QuantizeSensorLevel(double level)
+{
+	double code = floor(level + 0.5);
+	double full_scale = (1 << TEMPERATURE_CODE_BITS) - 1;
+	return (uint16_t)(code < 0 ? 0 : (code > full_scale ? full_scale : code));
+}
@@ -0,0 +1,84 @@
+/*
+ *	@title	Plant models for the closed-loop simulations
+ *	@file	plants.h
+ *
+ *	All the models are discretized exactly for a zero-order-hold input (the converter holds its
+ *	output during one sampling period) and run in double precision, so that the discretization of
+ *	the plant never masks the behaviour of the single-precision control code under test.
+ */
+
+#ifndef PLANTS_H_
+#define PLANTS_H_
+
+#include "transformations.h"
+#include "temperature.h"
+
+#include <stdint.h>
+
+#define GRID_MAX_HARMONICS	8
+
+
+/**
+ * Three-phase voltage source: positive sequence, negative sequence (unbalance) and harmonics.
+ * Phase A of the positive sequence is amplitude * cos(theta), so that a locked PLL reads theta.
+ */
+typedef struct{
+	double amplitude;						// Positive-sequence peak value
+	double omega;							// Angular frequency in rad/s (can be changed on the fly)
+	double theta;							// Phase of the positive sequence in rad, in [-PI, PI)
+	double unbalance;						// Negative-sequence amplitude relative to the positive sequence
+	double unbalance_phase;					// Negative-sequence phase at theta = 0
+	int harmonics;
+	int order[GRID_MAX_HARMONICS];			// Harmonic order (its sequence follows from the order)
+	double ratio[GRID_MAX_HARMONICS];		// Amplitude relative to the positive sequence
+	double phase[GRID_MAX_HARMONICS];		// Phase at theta = 0
+} GridSource;
+
+void ConfigGridSource(GridSource* me, double amplitude, double frequency, double phase);
+void SetGridUnbalance(GridSource* me, double ratio, double phase);
+int AddGridHarmonic(GridSource* me, int order, double ratio, double phase);				// 0, or -1 when full
+void GridVoltage(const GridSource* me, TimeDomain* v);									// Instantaneous phase voltages
+void StepGridSource(GridSource* me, double tsample);
+
+
+/**
+ * Three-phase series RL line between a converter and a voltage source (as parameterized by ConfigFAE):
+ * v_converter - v_source = R i + L di/dt
+ */
+typedef struct{
+	double a;								// exp(-R Ts / L)
+	double b;								// (1 - a) / R
+	double current[3];
+} RLLine;
+
+void ConfigRLLine(RLLine* me, double R, double L, double tsample);
+void StepRLLine(RLLine* me, const TimeDomain* v_converter, const TimeDomain* v_source);
+void LineCurrent(const RLLine* me, TimeDomain* i);
+
+
+/**
+ * First-order thermal plant (heat capacity and thermal resistance to the ambient) seen through a
+ * temperature sensor and the LTC2314
+ */
+typedef struct{
+	double r_th;							// K/W
+	double c_th;							// J/K
+	double ambient;							// degC
+	double temperature;						// degC
+} ThermalPlant;
+
+void ConfigThermalPlant(ThermalPlant* me, double r_th, double c_th, double ambient);
+void StepThermalPlant(ThermalPlant* me, double power, double tsample);
+
+
+/**
+ * Routines to compute the code returned by the ADC for a temperature (inverse of the sensor model)
+ * @param *sensor	the sensor and front-end description (cf. temperature.h)
+ * @param celsius	the temperature
+ * @param level		the ideal (unquantized) code, plus noise if any
+ * @return			the ideal code, resp. the 14-bit code
+ */
+double ThermalSensorLevel(const ThermalSensor* sensor, double celsius);
+uint16_t QuantizeSensorLevel(double level);
+
+#endif /* PLANTS_H_ */
@@ -0,0 +1,65 @@
+/*
+ *	@title	Faster-than-real-time closed-loop simulation engine
+ *	@file	simengine.cpp
+ */
+
+#include "simengine.h"
+
+#include <time.h>
+
+
+static double NowS(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+
+void ConfigSimEngine(SimEngine* me, double tsample, tSimInterrupt interrupt, void* interrupt_context, tSimPlant plant, void* plant_context)
+{
+	me->tsample = tsample;
+	me->time = 0.0;
+	me->steps = 0;
+	me->unsafe_steps = 0;
+	me->wall_seconds = 0.0;
+	me->interrupt = interrupt;
+	me->interrupt_context = interrupt_context;
+	me->plant = plant;
+	me->plant_context = plant_context;
+}
+
+
+void RunSimEngine(SimEngine* me, uint64_t steps)
+{
+	double start = NowS();
+	uint64_t first = me->steps;
+
+	for (uint64_t k = 0; k < steps; k++){
+		if (me->interrupt(me->interrupt_context) != SAFE){ me->unsafe_steps++; }
+		me->plant(me->plant_context, me->time, me->tsample);
+		me->time = (first + k + 1) * me->tsample;										// No accumulated rounding
+	}
+
+	me->steps = first + steps;
+	me->wall_seconds += NowS() - start;
+}
+
+
+void RunSimEngineUntil(SimEngine* me, double time)
+{
+	double remaining = (time - me->time) / me->tsample;
+	if (remaining > 0){ RunSimEngine(me, (uint64_t)(remaining + 0.5)); }
+}
+
+
+double GetSimStepsPerSecond(const SimEngine* me)
+{
+	return me->wall_seconds > 0 ? me->steps / me->wall_seconds : 0.0;
+}
+
+
+tUserSafe SimUserInterrupt(void* context)
+{
+	return (*(tInterruptHandler*)context)();
+}
@@ -0,0 +1,87 @@
+/*
+ *	@title	Faster-than-real-time closed-loop simulation engine
+ *	@file	simengine.h
+ *
+ *	The engine alternates, at every sampling period, a UserInterrupt-like routine (reads its inputs,
+ *	runs the unmodified control API, writes its outputs) and the plant (holds the outputs during one
+ *	period, then leaves the sampled inputs for the next interrupt), exactly like the B-Box does with
+ *	the main interrupt and the converter. Both sides keep their state in a context pointer, so that
+ *	several engines can run in parallel threads. The real UserInterrupt() of the project can be used
+ *	as is through SimUserInterrupt(), the plant then talks to it through the SBI/SBO stand-ins.
+ */
+
+#ifndef SIMENGINE_H_
+#define SIMENGINE_H_
+
+#include "Core/core.h"
+#include "Core/interrupts.h"
+
+#include <stdint.h>
+
+typedef tUserSafe (*tSimInterrupt)(void* context);						// One execution of the interrupt routine
+typedef void (*tSimPlant)(void* context, double time, double tsample);	// Advances the plant by one period
+
+
+/**
+ * Pseudo-object describing one simulation
+ */
+typedef struct{
+	double tsample;							// Sampling (interrupt) period in s
+	double time;							// Simulated time in s
+	uint64_t steps;							// Executed periods
+	uint64_t unsafe_steps;					// Periods for which the interrupt returned UNSAFE
+	double wall_seconds;					// Host time spent in RunSimEngine()
+	tSimInterrupt interrupt;
+	void* interrupt_context;
+	tSimPlant plant;
+	void* plant_context;
+} SimEngine;
+
+
+/**
+ * Routine to configure a simulation (the time and the statistics start from zero)
+ * @param *me					the engine pseudo-object
+ * @param tsample				the sampling period in s
+ * @param interrupt				the routine executed at every period
+ * @param interrupt_context		its context (controllers, measurements, ...)
+ * @param plant					the plant model
+ * @param plant_context			its context (plant state)
+ * @return void
+ */
+void ConfigSimEngine(SimEngine* me, double tsample, tSimInterrupt interrupt, void* interrupt_context, tSimPlant plant, void* plant_context);
+
+
+/**
+ * Routine to simulate a number of periods (can be called repeatedly, e.g. between two events)
+ * @param *me		the engine pseudo-object
+ * @param steps		the number of periods to simulate
+ * @return void
+ */
+void RunSimEngine(SimEngine* me, uint64_t steps);
+
+
+/**
+ * Routine to simulate until a given time
+ * @param *me		the engine pseudo-object
+ * @param time		the simulated time to reach in s
+ * @return void
+ */
+void RunSimEngineUntil(SimEngine* me, double time);
+
+
+/**
+ * Routine to read the simulation throughput
+ * @param *me		the engine pseudo-object
+ * @return			the simulated periods per second of host time
+ */
+double GetSimStepsPerSecond(const SimEngine* me);
+
+
+/**
+ * Adapter running a parameterless interrupt routine (e.g. the project's UserInterrupt)
+ * @param context	pointer to a tInterruptHandler
+ * @return			what the routine returned
+ */
+tUserSafe SimUserInterrupt(void* context);
+
+#endif /* SIMENGINE_H_ */
@@ -0,0 +1,101 @@
+/*
+ *	@title	Host stress test of the SPSC sample buffer
+ *	@file	samplebuffer_stress.cpp
+ *
+ *	A producer thread plays the role of UserInterrupt: it reads the ADC through the Sbi_Read()
+ *	stand-in and pushes (raw, tick) as fast as possible, or at a given rate. A consumer thread plays
+ *	the background loop and drains in bulk. The consumer checks that the ticks are strictly increasing,
+ *	that every raw value matches its tick, and that the gaps add up exactly to the overrun count.
+ *
+ *	Usage: samplebuffer_stress [samples (default 50e6)] [rate in Hz, 0 = unthrottled (default)]
+ */
+
+#include "samplebuffer.h"
+#include "Driver/peripherals.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <time.h>
+
+static SampleBuffer buffer;
+static std::atomic<bool> producer_done(false);
+static std::atomic<uint32_t> adc_tick(0);
+
+// Simulated ADC: a 14-bit ramp derived from the current tick, so that the consumer can check it
+static unsigned int SimulatedAdc(unsigned int address)
+{
+	(void)address;
+	return (adc_tick.load(std::memory_order_relaxed) * 7u) & 0x3FFF;
+}
+
+static double NowS(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+static void Producer(uint32_t samples, double rate)
+{
+	double period = rate > 0 ? 1.0 / rate : 0.0;
+	double next = NowS();
+
+	for (uint32_t tick = 0; tick < samples; tick++){
+		if (period > 0){
+			while (NowS() < next){}
+			next += period;
+		}
+		adc_tick.store(tick, std::memory_order_relaxed);
+		PushSample(&buffer, Sbi_Read(0), tick);
+	}
+	producer_done.store(true, std::memory_order_release);
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t samples = argc > 1 ? (uint32_t)atof(argv[1]) : 50000000u;
+	double rate = argc > 2 ? atof(argv[2]) : 0.0;
+
+	HostSetSbiSource(SimulatedAdc);
+	ConfigSampleBuffer(&buffer);
+
+	static Sample block[1024];
+	uint64_t received = 0, errors = 0, gaps = 0, drains = 0;
+	int64_t last_tick = -1;
+
+	double start = NowS();
+	std::thread producer(Producer, samples, rate);
+
+	for (;;){
+		bool done = producer_done.load(std::memory_order_acquire);				// Read before draining: nothing is missed
+		uint32_t count = DrainSamples(&buffer, block, sizeof(block)/sizeof(block[0]));
+		if (count){ drains++; }
+
+		for (uint32_t i = 0; i < count; i++){
+			if ((int64_t)block[i].tick <= last_tick){ errors++; }
+			if (block[i].raw != ((block[i].tick * 7u) & 0x3FFF)){ errors++; }
+			gaps += block[i].tick - last_tick - 1;
+			last_tick = block[i].tick;
+		}
+		received += count;
+
+		if (done && count == 0){ break; }
+	}
+	producer.join();
+	double elapsed = NowS() - start;
+
+	gaps += (samples - 1) - last_tick;											// Samples dropped after the last one received
+	uint32_t overruns = GetSampleBufferOverruns(&buffer);
+
+	printf("pushed %u samples in %.3f s (%.2f MS/s), received %llu in %llu drains\n", samples, elapsed,
+			samples / elapsed * 1e-6, (unsigned long long)received, (unsigned long long)drains);
+	printf("overruns %u, gaps %llu, errors %llu\n", overruns, (unsigned long long)gaps, (unsigned long long)errors);
+
+	if (errors || gaps != overruns || received + overruns != samples){
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,380 @@
+/*
+ *	@title	Parallel gain sweeps of the PLLs and current controllers, ranked by Pareto dominance
+ *	@file	gain_tuner.cpp
+ *
+ *	Every candidate is a complete closed loop of sim/loops.h (same plants and interrupt routines as
+ *	closedloop_sim) configured through the unmodified Config* routines, simulated on its own from
+ *	zero and scored on three objectives, all minimized:
+ *	 - settling	PLLs: lock time (phase error < 2 deg for good), current loops: 2 % settling after a step
+ *	 - overshoot	PLLs: phase overshoot past zero in deg, current loops: amplitude overshoot in %
+ *	 - ripple	PLLs: peak phase error over the second half, current loops: peak amplitude error
+ *	The candidates are simulated on a work-stealing thread pool (diverging candidates stop early,
+ *	so their costs differ widely). Unstable candidates are discarded, the others are sorted into
+ *	non-dominated fronts per loop structure; the first fronts (the Pareto set of each structure) are
+ *	printed ordered by settling time. The interrupt cost (host ns per call of the interrupt routine,
+ *	measured once without the plant) only depends on the structure: it is reported per structure, not
+ *	ranked. A gain at the first or last value of its axis is marked with '*' when that end is open, i.e.
+ *	at least 10 % of the candidates there are stable: the optimum may lie outside the swept range, which
+ *	should be widened. An end where the loops are mostly unstable brackets the optimum and is not marked.
+ *
+ *	Sweeps (log-spaced grids, --points sets the points per gain axis, default 16):
+ *	 - PLL:	DQPLL kp x ki, DSOGIPLL3 kp x ki x SOGI gain, on the distorted 49.5 Hz grid with a 60 deg offset;
+ *			SOGI gain from 0.25 to 40, both ends mostly unstable; the DSOGIPLL3 kp and ki end well past the
+ *			saturation of the loop filter (+/- 10 % of omega0), where every candidate locks at the same
+ *			slew rate (these ends are limits of the sweep)
+ *	 - current:	PI (dq, with DQPLL) kp x Ti, PR (alpha-beta) kp x ki x wdamp, 20 A step on the 5 mH line;
+ *				kp up to 400 V/A, past the stability limit set by the one-sample delay (~ 2 L / 3 Ts);
+ *				wdamp from 1/STEP_DURATION: below, the resonant term does not build up within the simulated
+ *				response and cannot be judged (the ripple keeps decreasing towards wdamp = 0)
+ *
+ *	Usage: gain_tuner [--threads N] [--points N] [--top N] [--csv file]
+ */
+
+#include "threadpool.h"
+#include "loops.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#define TSAMPLE			50e-6				// Interrupt period (20 kHz)
+#define OMEGA_NOMINAL	(2 * M_PI * 50.0)
+#define PLL_DURATION	0.5					// Simulated time of a PLL candidate
+#define LINE_R			0.1
+#define LINE_L			5e-3
+#define GRID_PEAK		325.0
+#define CURRENT_STEP	20.0
+#define STEP_TIME		0.02				// Enough for the DQPLL of the PI loop (starts in phase)
+#define STEP_DURATION	0.1					// Simulated time after the step
+#define COST_CALLS		200000				// Interrupt calls timed to estimate the cost
+#define OBJECTIVES		3
+#define OPEN_END		0.1					// An axis end is open if this fraction of its candidates is stable
+
+typedef enum{
+	LOOP_DQPLL = 0,
+	LOOP_DSOGIPLL = 1,
+	LOOP_PI = 2,
+	LOOP_PR = 3
+} tLoopType;
+
+static const char* loop_names[] = {"DQPLL", "DSOGIPLL3", "PI", "PR"};
+static const char* gain_names[][3] = {
+	{"kp", "ki", ""}, {"kp", "ki", "sogi"}, {"kp", "Ti", ""}, {"kp", "ki", "wdamp"}
+};
+
+
+typedef struct{
+	tLoopType type;
+	float gain[3];
+	LoopResponse response;
+	double objective[OBJECTIVES];			// settling, overshoot, ripple
+	double cost;							// Interrupt cost of the structure, host ns
+	uint8_t end;							// Bit 2g: gain[g] is the first value of its axis, bit 2g+1: the last
+	uint8_t bounded;						// Ends (as in 'end') that are limits of the sweep, not of the grid
+	uint8_t edge;							// Bit g: gain[g] is at an open end of its axis (optimum possibly beyond)
+	int front;								// 1 = Pareto set of its structure, 0 = unstable
+} Candidate;
+
+
+/*
+ * Simulation of one candidate, from its own zero state (no shared data but the read-only gains)
+ */
+static void ConfigPLLCandidate(const Candidate* c, GridPlant* plant, PLLLoop* loop, SimEngine* sim)
+{
+	ConfigDistortedGridPlant(plant);
+	loop->plant = plant;
+	if (c->type == LOOP_DQPLL){
+		ConfigDQPLL(&loop->dqpll, c->gain[0], c->gain[1], OMEGA_NOMINAL, TSAMPLE);
+		ConfigSimEngine(sim, TSAMPLE, DQPLLInterrupt, loop, GridPlantStep, plant);
+	}
+	else{
+		ConfigDSOGIPLL3(&loop->dsogipll, c->gain[0], c->gain[1], c->gain[2], OMEGA_NOMINAL, TSAMPLE);
+		ConfigSimEngine(sim, TSAMPLE, DSOGIPLLInterrupt, loop, GridPlantStep, plant);
+	}
+}
+
+static void ConfigCurrentCandidate(const Candidate* c, LinePlant* plant, CurrentLoop* loop, SimEngine* sim)
+{
+	ConfigLinePlant(plant, LINE_R, LINE_L, GRID_PEAK, 50.0, TSAMPLE);
+	loop->plant = plant;
+	loop->sim = sim;
+	loop->line_l = LINE_L;
+	loop->step_time = STEP_TIME;
+	loop->i_step = CURRENT_STEP;
+	ConfigDQPLL(&loop->pll, 178.0 / GRID_PEAK, 125.0*125.0*TSAMPLE / GRID_PEAK, OMEGA_NOMINAL, TSAMPLE);
+	if (c->type == LOOP_PI){
+		float ki = c->gain[0] / c->gain[1] * TSAMPLE;											// Per-sample ki = kp Ts / Ti
+		ConfigPIDController(&loop->pi_d, c->gain[0], ki, 0.0, 2 * GRID_PEAK, -2 * GRID_PEAK, TSAMPLE, 10);
+		ConfigPIDController(&loop->pi_q, c->gain[0], ki, 0.0, 2 * GRID_PEAK, -2 * GRID_PEAK, TSAMPLE, 10);
+		ConfigSimEngine(sim, TSAMPLE, PICurrentInterrupt, loop, LinePlantStep, plant);
+	}
+	else{
+		ConfigPRController(&loop->pr_a, c->gain[0], c->gain[1], OMEGA_NOMINAL, c->gain[2], TSAMPLE);
+		ConfigPRController(&loop->pr_b, c->gain[0], c->gain[1], OMEGA_NOMINAL, c->gain[2], TSAMPLE);
+		ConfigSimEngine(sim, TSAMPLE, PRCurrentInterrupt, loop, LinePlantStep, plant);
+	}
+}
+
+static LoopResponse SimulateCandidate(const Candidate* c, double* interrupt_ns)
+{
+	SimEngine sim;
+	LoopResponse r;
+	GridPlant grid_plant;
+	PLLLoop pll_loop;
+	LinePlant line_plant;
+	CurrentLoop current_loop;
+
+	if (c->type == LOOP_DQPLL || c->type == LOOP_DSOGIPLL){
+		ConfigPLLCandidate(c, &grid_plant, &pll_loop, &sim);
+		r = EvaluatePLLLoop(&sim, &pll_loop, c->type == LOOP_DSOGIPLL, PLL_DURATION);
+	}
+	else{
+		ConfigCurrentCandidate(c, &line_plant, &current_loop, &sim);
+		r = EvaluateCurrentLoop(&sim, &current_loop, STEP_DURATION);
+	}
+
+	// Interrupt routine alone, from the final (steady) state, on frozen plant outputs:
+	if (interrupt_ns){
+		auto start = std::chrono::steady_clock::now();
+		for (int k = 0; k < COST_CALLS; k++){ sim.interrupt(sim.interrupt_context); }
+		*interrupt_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / COST_CALLS;
+	}
+	return r;
+}
+
+static void CandidateTask(void* context, uint64_t index, unsigned int worker)
+{
+	(void)worker;
+	Candidate* c = (Candidate*)context + index;
+	c->response = SimulateCandidate(c, 0);
+}
+
+
+/*
+ * Candidate grids
+ */
+static std::vector<float> LogSpace(double first, double last, int points)
+{
+	std::vector<float> v;
+	for (int k = 0; k < points; k++){
+		v.push_back((float)(first * pow(last / first, points > 1 ? (double)k / (points - 1) : 0.0)));
+	}
+	return v;
+}
+
+static void AddGrid(std::vector<Candidate>& list, tLoopType type, const std::vector<float>& g0, const std::vector<float>& g1,
+		const std::vector<float>& g2, uint8_t bounded = 0)
+{
+	const std::vector<float>* axis[3] = {&g0, &g1, &g2};
+	for (size_t i = 0; i < g0.size(); i++){
+		for (size_t j = 0; j < g1.size(); j++){
+			for (size_t k = 0; k < g2.size(); k++){
+				Candidate cand = {};
+				cand.type = type;
+				cand.bounded = bounded;
+				size_t index[3] = {i, j, k};
+				for (int g = 0; g < 3; g++){
+					cand.gain[g] = (*axis[g])[index[g]];
+					if (axis[g]->size() > 1 && index[g] == 0){ cand.end |= 1 << (2*g); }
+					if (axis[g]->size() > 1 && index[g] == axis[g]->size() - 1){ cand.end |= 1 << (2*g + 1); }
+				}
+				list.push_back(cand);
+			}
+		}
+	}
+}
+
+static std::vector<float> WnToKi(const std::vector<float>& wn)
+{
+	std::vector<float> ki;
+	for (float w : wn){ ki.push_back((float)(w * w * TSAMPLE)); }							// Per-sample ki of the PLLs
+	return ki;
+}
+
+
+/*
+ * Fast non-dominated sorting: front 1 holds the candidates no other one of the same structure beats on
+ * every objective
+ */
+static bool Dominates(const Candidate& a, const Candidate& b)
+{
+	if (a.type != b.type){ return false; }
+	bool strictly = false;
+	for (int k = 0; k < OBJECTIVES; k++){
+		if (a.objective[k] > b.objective[k]){ return false; }
+		if (a.objective[k] < b.objective[k]){ strictly = true; }
+	}
+	return strictly;
+}
+
+static void SortFronts(std::vector<Candidate>& list)
+{
+	std::vector<size_t> stable;
+	for (size_t i = 0; i < list.size(); i++){
+		list[i].front = 0;
+		if (list[i].response.stable){ stable.push_back(i); }
+	}
+
+	size_t n = stable.size();
+	std::vector<int> dominated_by(n, 0);
+	std::vector<std::vector<size_t>> dominates(n);
+	for (size_t i = 0; i < n; i++){
+		for (size_t j = i + 1; j < n; j++){
+			if (Dominates(list[stable[i]], list[stable[j]])){ dominates[i].push_back(j); dominated_by[j]++; }
+			else if (Dominates(list[stable[j]], list[stable[i]])){ dominates[j].push_back(i); dominated_by[i]++; }
+		}
+	}
+
+	std::vector<size_t> current;
+	for (size_t i = 0; i < n; i++){ if (dominated_by[i] == 0){ current.push_back(i); } }
+	for (int front = 1; !current.empty(); front++){
+		std::vector<size_t> next;
+		for (size_t i : current){
+			list[stable[i]].front = front;
+			for (size_t j : dominates[i]){ if (--dominated_by[j] == 0){ next.push_back(j); } }
+		}
+		current.swap(next);
+	}
+}
+
+
+/*
+ * One sweep: cost estimate per loop type, parallel simulation, ranking and report
+ */
+static void RunSweep(const char* title, std::vector<Candidate>& list, WorkStealingPool* pool, int top, FILE* csv)
+{
+	// Interrupt cost of each structure, single-threaded (it does not depend on the gains):
+	double cost[4] = {0, 0, 0, 0};
+	for (int t = 0; t < 4; t++){
+		for (const Candidate& c : list){
+			if (c.type == t){ SimulateCandidate(&c, &cost[t]); break; }
+		}
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	RunParallelFor(pool, list.size(), CandidateTask, list.data());
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	for (Candidate& c : list){
+		bool pll = c.type == LOOP_DQPLL || c.type == LOOP_DSOGIPLL;
+		c.objective[0] = c.response.settling;
+		c.objective[1] = c.response.overshoot;
+		c.objective[2] = c.response.steady_error;
+		c.cost = cost[c.type];
+		if (pll && c.response.stable && c.response.steady_freq_error > 5.0){ c.response.stable = false; }	// Locked on a harmonic
+	}
+	SortFronts(list);
+
+	// Ends of the axes past which the candidates are still mostly stable (an end where the loops become
+	// unstable brackets the optimum, as does a limit of the sweep):
+	size_t at_end[4][6] = {}, stable_at_end[4][6] = {};
+	for (const Candidate& c : list){
+		for (int e = 0; e < 6; e++){
+			if (c.end & (1 << e)){
+				at_end[c.type][e]++;
+				if (c.response.stable){ stable_at_end[c.type][e]++; }
+			}
+		}
+	}
+	for (Candidate& c : list){
+		c.edge = 0;
+		for (int e = 0; e < 6; e++){
+			bool open = !(c.bounded & (1 << e)) && stable_at_end[c.type][e] >= OPEN_END * at_end[c.type][e];
+			if ((c.end & (1 << e)) && open){ c.edge |= 1 << (e / 2); }
+		}
+	}
+
+	std::vector<const Candidate*> pareto;
+	size_t unstable = 0, at_edge = 0;
+	for (const Candidate& c : list){
+		if (c.front == 1){ pareto.push_back(&c); }
+		if (c.front == 1 && c.edge){ at_edge++; }
+		if (c.front == 0){ unstable++; }
+	}
+	std::sort(pareto.begin(), pareto.end(), [](const Candidate* a, const Candidate* b){
+		return a->objective[0] != b->objective[0] ? a->objective[0] < b->objective[0] : a->objective[2] < b->objective[2];
+	});
+
+	printf("\n%s: %zu candidates in %.2f s on %u threads (%.0f candidates/s, %llu stolen), %zu unstable, Pareto set of %zu\n",
+			title, list.size(), elapsed, pool->workers, list.size() / elapsed,
+			(unsigned long long)GetPoolStolenItems(pool), unstable, pareto.size());
+	printf("  cost estimate:");
+	for (int t = 0; t < 4; t++){ if (cost[t] > 0){ printf(" %s %.1f ns", loop_names[t], cost[t]); } }
+	printf(" per interrupt (host)\n");
+	if (at_edge){ printf("  %zu of the Pareto set with a gain at an end of its swept range (*): widen it\n", at_edge); }
+	printf("  %-10s %-34s %12s %11s %10s %8s\n", "loop", "gains", "settling ms", "overshoot", "ripple", "cost ns");
+	for (int k = 0; k < (int)pareto.size() && k < top; k++){
+		const Candidate* c = pareto[k];
+		char gains[64];
+		int len = 0;
+		for (int g = 0; g < 3; g++){
+			if (gain_names[c->type][g][0]){
+				len += snprintf(gains + len, sizeof(gains) - len, "%s=%.4g%s ", gain_names[c->type][g], c->gain[g],
+						c->edge & (1 << g) ? "*" : "");
+			}
+		}
+		printf("  %-10s %-34s %12.2f %11.2f %10.3f %8.1f\n", loop_names[c->type], gains,
+				c->objective[0] * 1e3, c->objective[1], c->objective[2], c->cost);
+	}
+
+	if (csv){
+		for (const Candidate& c : list){
+			fprintf(csv, "%s,%s,%g,%g,%g,%d,%d,%g,%g,%g,%g,%d\n", title, loop_names[c.type], c.gain[0], c.gain[1], c.gain[2],
+					c.response.stable ? 1 : 0, c.front, c.objective[0], c.objective[1], c.objective[2], c.cost, c.edge);
+		}
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	unsigned int threads = 0;
+	int points = 16;
+	int top = 15;
+	const char* csv_name = 0;
+
+	for (int i = 1; i < argc; i++){
+		if (!strcmp(argv[i], "--threads") && i + 1 < argc){ threads = (unsigned int)atoi(argv[++i]); }
+		else if (!strcmp(argv[i], "--points") && i + 1 < argc){ points = atoi(argv[++i]); }
+		else if (!strcmp(argv[i], "--top") && i + 1 < argc){ top = atoi(argv[++i]); }
+		else if (!strcmp(argv[i], "--csv") && i + 1 < argc){ csv_name = argv[++i]; }
+		else{
+			fprintf(stderr, "usage: %s [--threads N] [--points N] [--top N] [--csv file]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (points < 2){ points = 2; }
+
+	FILE* csv = 0;
+	if (csv_name){
+		csv = fopen(csv_name, "w");
+		if (!csv){ perror(csv_name); return 1; }
+		fprintf(csv, "sweep,loop,gain0,gain1,gain2,stable,front,settling_s,overshoot,ripple,cost_ns,edge\n");
+	}
+
+	static WorkStealingPool pool;
+	ConfigWorkStealingPool(&pool, threads);
+
+	// PLLs (per-unit grid): kp around 2 zeta wn, ki = wn^2 Ts:
+	std::vector<Candidate> pll;
+	std::vector<float> none(1, 0.0f);
+	AddGrid(pll, LOOP_DQPLL, LogSpace(20.0, 800.0, points), WnToKi(LogSpace(5.0, 500.0, points * 5 / 4)), none);
+	AddGrid(pll, LOOP_DSOGIPLL, LogSpace(10.0, 12800.0, points * 3 / 2), WnToKi(LogSpace(2.5, 3200.0, points * 3 / 2)),
+			LogSpace(0.25, 40.0, points * 3 / 4), 1 << 1 | 1 << 3);			// kp, ki: saturated loop filter
+	RunSweep("PLL", pll, &pool, top, csv);
+
+	// Current loops (RL line, bandwidth kp / L): PI kp x Ti, PR kp x ki x wdamp:
+	std::vector<Candidate> current;
+	AddGrid(current, LOOP_PI, LogSpace(1.0, 400.0, points * 3 / 2), LogSpace(5e-5, 2e-2, points * 3 / 2), none);
+	AddGrid(current, LOOP_PR, LogSpace(1.0, 400.0, points * 3 / 2), LogSpace(5.0, 1e6, points * 3 / 2),
+			LogSpace(1.0 / STEP_DURATION, 3000.0, points * 3 / 4 > 2 ? points * 3 / 4 : 2), 1 << 4);		// wdamp: limit of the sweep
+	RunSweep("current", current, &pool, top, csv);
+
+	CloseWorkStealingPool(&pool);
+	if (csv){ fclose(csv); }
+	return 0;
+}
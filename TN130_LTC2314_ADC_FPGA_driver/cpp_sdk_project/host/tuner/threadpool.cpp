@@ -0,0 +1,157 @@
+/*
+ *	@title	Work-stealing thread pool for parallel loops over independent items
+ *	@file	threadpool.cpp
+ */
+
+#include "threadpool.h"
+
+
+/*
+ * Takes the next item of the worker's own range
+ */
+static bool PopOwn(WorkerRange* r, uint64_t* index)
+{
+	std::lock_guard<std::mutex> guard(r->lock);
+	if (r->begin >= r->end){ return false; }
+	*index = r->begin;
+	__atomic_store_n(&r->begin, r->begin + 1, __ATOMIC_RELAXED);					// Also read by the thieves
+	return true;
+}
+
+
+/*
+ * Moves the upper half of the largest other range into the (empty) range of the thief. The sizes
+ * are read without the locks to choose the victim, then checked again under its lock.
+ */
+static bool Steal(WorkStealingPool* me, unsigned int thief)
+{
+	for (;;){
+		unsigned int victim = thief;
+		uint64_t largest = 0;
+		for (unsigned int w = 0; w < me->workers; w++){
+			if (w == thief){ continue; }
+			uint64_t begin = __atomic_load_n(&me->range[w].begin, __ATOMIC_RELAXED);
+			uint64_t end = __atomic_load_n(&me->range[w].end, __ATOMIC_RELAXED);
+			if (end > begin && end - begin > largest){
+				largest = end - begin;
+				victim = w;
+			}
+		}
+		if (victim == thief){ return false; }										// Nothing left anywhere
+
+		WorkerRange* v = &me->range[victim];
+		WorkerRange* t = &me->range[thief];
+		std::unique_lock<std::mutex> lock_v(v->lock);
+		if (v->begin >= v->end){ continue; }										// Emptied meanwhile, look again
+
+		uint64_t half = (v->end - v->begin + 1) / 2;
+		uint64_t begin = v->end - half;
+		uint64_t end = v->end;
+		__atomic_store_n(&v->end, begin, __ATOMIC_RELAXED);
+		lock_v.unlock();
+
+		std::lock_guard<std::mutex> lock_t(t->lock);
+		t->begin = begin;
+		t->end = end;
+		t->stolen += half;
+		return true;
+	}
+}
+
+
+static void RunWorker(WorkStealingPool* me, unsigned int worker)
+{
+	uint64_t index;
+	for (;;){
+		while (PopOwn(&me->range[worker], &index)){
+			me->task(me->context, index, worker);
+			me->range[worker].executed++;
+		}
+		if (!Steal(me, worker)){ return; }
+	}
+}
+
+
+static void WorkerThread(WorkStealingPool* me, unsigned int worker)
+{
+	uint64_t seen = 0;
+	for (;;){
+		{
+			std::unique_lock<std::mutex> lock(me->lock);
+			me->wake.wait(lock, [&]{ return me->shutdown || me->generation != seen; });
+			if (me->shutdown){ return; }
+			seen = me->generation;
+		}
+
+		RunWorker(me, worker);
+
+		std::lock_guard<std::mutex> lock(me->lock);
+		if (--me->active == 0){ me->done.notify_one(); }
+	}
+}
+
+
+void ConfigWorkStealingPool(WorkStealingPool* me, unsigned int workers)
+{
+	if (workers == 0){ workers = std::thread::hardware_concurrency(); }
+	if (workers == 0){ workers = 1; }
+	if (workers > POOL_MAX_WORKERS){ workers = POOL_MAX_WORKERS; }
+
+	me->workers = workers;
+	me->generation = 0;
+	me->active = 0;
+	me->shutdown = false;
+	for (unsigned int w = 0; w < workers; w++){
+		me->range[w].begin = me->range[w].end = 0;
+		me->range[w].executed = me->range[w].stolen = 0;
+	}
+	for (unsigned int w = 1; w < workers; w++){
+		me->thread[w] = std::thread(WorkerThread, me, w);
+	}
+}
+
+
+void RunParallelFor(WorkStealingPool* me, uint64_t count, tParallelTask task, void* context)
+{
+	// Contiguous initial split (neighbouring items usually have similar costs):
+	for (unsigned int w = 0; w < me->workers; w++){
+		std::lock_guard<std::mutex> guard(me->range[w].lock);
+		__atomic_store_n(&me->range[w].begin, count * w / me->workers, __ATOMIC_RELAXED);
+		__atomic_store_n(&me->range[w].end, count * (w + 1) / me->workers, __ATOMIC_RELAXED);
+		me->range[w].executed = 0;
+		me->range[w].stolen = 0;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(me->lock);
+		me->task = task;
+		me->context = context;
+		me->active = me->workers - 1;
+		me->generation++;
+	}
+	me->wake.notify_all();
+
+	RunWorker(me, 0);
+
+	std::unique_lock<std::mutex> lock(me->lock);
+	me->done.wait(lock, [&]{ return me->active == 0; });
+}
+
+
+uint64_t GetPoolStolenItems(WorkStealingPool* me)
+{
+	uint64_t stolen = 0;
+	for (unsigned int w = 0; w < me->workers; w++){ stolen += me->range[w].stolen; }
+	return stolen;
+}
+
+
+void CloseWorkStealingPool(WorkStealingPool* me)
+{
+	{
+		std::lock_guard<std::mutex> lock(me->lock);
+		me->shutdown = true;
+	}
+	me->wake.notify_all();
+	for (unsigned int w = 1; w < me->workers; w++){ me->thread[w].join(); }
+}
@@ -0,0 +1,93 @@
+/*
+ *	@title	Work-stealing thread pool for parallel loops over independent items
+ *	@file	threadpool.h
+ *
+ *	RunParallelFor() splits the index range [0, count) into one contiguous sub-range per worker.
+ *	Each worker takes its items one by one from the front of its own range; a worker that runs out
+ *	steals the upper half of the largest remaining range. Items of very unequal cost (e.g. simulated
+ *	candidates that diverge and stop early) therefore keep all the cores busy until the end, with
+ *	one short lock per item and no central queue. The workers are started once and sleep between
+ *	two loops; the calling thread takes part in the loop as worker 0.
+ */
+
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <stdint.h>
+
+#define POOL_MAX_WORKERS	64
+
+typedef void (*tParallelTask)(void* context, uint64_t index, unsigned int worker);
+
+
+/**
+ * Range of indexes owned by one worker (one cache line each, to avoid false sharing)
+ */
+typedef struct alignas(64){
+	std::mutex lock;
+	uint64_t begin;							// Next index to execute
+	uint64_t end;							// One past the last index
+	uint64_t executed;						// Statistics of the last loop
+	uint64_t stolen;
+} WorkerRange;
+
+
+/**
+ * Pseudo-object describing the pool
+ */
+typedef struct{
+	unsigned int workers;					// Number of workers, including the calling thread
+	WorkerRange range[POOL_MAX_WORKERS];
+	std::thread thread[POOL_MAX_WORKERS];
+	std::mutex lock;
+	std::condition_variable wake;			// Signals a new loop (or the shutdown) to the workers
+	std::condition_variable done;			// Signals the end of a worker's participation
+	uint64_t generation;					// Incremented at every loop
+	unsigned int active;					// Workers still busy with the current loop
+	bool shutdown;
+	tParallelTask task;
+	void* context;
+} WorkStealingPool;
+
+
+/**
+ * Routine to start the workers of a pool
+ * @param *me			the pool pseudo-object
+ * @param workers		the number of workers (0: one per hardware thread), including the caller
+ * @return void
+ */
+void ConfigWorkStealingPool(WorkStealingPool* me, unsigned int workers);
+
+
+/**
+ * Routine to execute task(context, index, worker) for every index in [0, count), in parallel.
+ * Returns when all the items have been executed. The worker number (0..workers-1) can be used to
+ * index per-worker scratch data.
+ * @param *me			the pool pseudo-object
+ * @param count			the number of items
+ * @param task			the routine executing one item
+ * @param *context		its context
+ * @return void
+ */
+void RunParallelFor(WorkStealingPool* me, uint64_t count, tParallelTask task, void* context);
+
+
+/**
+ * Routine to read the number of items stolen during the last loop (all workers)
+ * @param *me			the pool pseudo-object
+ * @return				the number of stolen items
+ */
+uint64_t GetPoolStolenItems(WorkStealingPool* me);
+
+
+/**
+ * Routine to stop and join the workers
+ * @param *me			the pool pseudo-object
+ * @return void
+ */
+void CloseWorkStealingPool(WorkStealingPool* me);
+
+#endif /* THREADPOOL_H_ */
@@ -0,0 +1,152 @@
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use IEEE.NUMERIC_STD.ALL;
+
+-- Self-checking testbench of the burst (oversampling) mode and of the sequence counter of LT2314_driver
+-- ghdl -a LT2314_multi_driver.vhd LT2314_driver.vhd LT2314_burst_tb.vhd && ghdl -e LT2314_burst_tb && ghdl -r LT2314_burst_tb
+entity LT2314_burst_tb is end;
+
+architecture bench of LT2314_burst_tb is
+
+	-- number of blank bits provided by the ADC
+	constant NBLANKBITS : positive := 1;
+
+	-- SCK = CLK_250_MHZ / (POSTSCALER*2) = 62.5 MHz
+	constant SCK_POSTSCALER : std_logic_vector := "0000000000000010";
+
+	-- main clock period
+	constant CLK_PERIOD : time := 4.0 ns; -- 250 MHz
+
+	-- conversions per sampling pulse
+	constant BURST : natural := 4;
+
+	-- successive samples produced by the ADC, one per conversion
+	type code_array is array (natural range <>) of natural;
+	constant CODES : code_array := (12345, 5782, 777, 16383, 0, 8191, 1, 9999, 4242, 321, 16000, 2);
+
+	-- clock signals
+	signal clk_250, sampling_pulse : std_logic := '0';
+	signal done : boolean := false;
+
+	-- SPI signals
+	signal SPI_DIN, SPI_nCS, SPI_CLK : std_logic := '0';
+
+	-- DUT configuration and outputs
+	signal burst_length : std_logic_vector(15 downto 0) := std_logic_vector(to_unsigned(BURST, 16));
+	signal data_out : std_logic_vector(15 downto 0);
+	signal acc_sum : std_logic_vector(31 downto 0);
+	signal acc_count : std_logic_vector(15 downto 0);
+	signal sequence : std_logic_vector(15 downto 0);
+
+	begin
+
+		primary_clock: clk_250 <= not clk_250 after CLK_PERIOD / 2 when not done;
+
+		--------------------------------------------------------------------------------
+		-- DEVICE UNDER TEST
+		--------------------------------------------------------------------------------
+
+		DUT: entity work.LT2314_driver
+		port map(
+			clk_250 => clk_250,
+			sampling_pulse => sampling_pulse,
+			postscaler_in => SCK_POSTSCALER,
+			burst_length_in => burst_length,
+			spi_sck => SPI_CLK,
+			spi_cs_n => SPI_nCS,
+			spi_din => SPI_DIN,
+			data_out => data_out,
+			acc_sum_out => acc_sum,
+			acc_count_out => acc_count,
+			sequence_out => sequence);
+
+		--------------------------------------------------------------------------------
+		-- ANALOG-TO-DIGITAL CONVERTER MODEL (next code at every chip select)
+		--------------------------------------------------------------------------------
+
+		SPI_TARGET: process(SPI_nCS,SPI_CLK)
+		variable counter : integer := 0;
+		variable index : natural := 0;
+		variable rawdata : unsigned(13 downto 0) := (others=>'0');
+		begin
+			if falling_edge(SPI_nCS) then
+				rawdata := to_unsigned(CODES(index mod CODES'length), 14);
+				index := index + 1;
+			end if;
+
+			if SPI_nCS='1' then
+				SPI_DIN <= 'Z';
+				counter := 13 + NBLANKBITS;
+			elsif SPI_nCS='0' and falling_edge(SPI_CLK) then
+				if (counter > 13 or counter < 0) then
+					SPI_DIN <= '0';
+				else
+					SPI_DIN <= std_logic(rawdata(counter));
+				end if;
+				counter := counter - 1;
+			end if;
+		end process SPI_TARGET;
+
+		--------------------------------------------------------------------------------
+		-- STIMULUS AND CHECKS
+		--------------------------------------------------------------------------------
+
+		CHECK: process
+		variable index : natural := 0;
+		variable expected : natural;
+		variable last : natural;
+		variable conversions : natural := 0;
+
+		procedure pulse_and_check(n : natural) is
+		begin
+			wait for CLK_PERIOD*100;
+			sampling_pulse <= '1';
+			wait for CLK_PERIOD;
+			sampling_pulse <= '0';
+
+			assert sequence(15) = '0'
+				report "sequence_out still valid after a sampling pulse" severity failure;
+
+			-- one conversion = 16 SCK + 1 SCK in ACQ = 68 clk_250 periods
+			wait for CLK_PERIOD*(68*n + 40);
+
+			expected := 0;
+			for k in 0 to n-1 loop
+				last := CODES(index mod CODES'length);
+				expected := expected + last;
+				index := index + 1;
+			end loop;
+			conversions := conversions + n;
+
+			assert to_integer(unsigned(acc_count)) = n
+				report "acc_count_out = " & integer'image(to_integer(unsigned(acc_count))) & ", expected " & integer'image(n)
+				severity failure;
+			assert to_integer(unsigned(acc_sum)) = expected
+				report "acc_sum_out = " & integer'image(to_integer(unsigned(acc_sum))) & ", expected " & integer'image(expected)
+				severity failure;
+			assert to_integer(unsigned(data_out)) = last
+				report "data_out = " & integer'image(to_integer(unsigned(data_out))) & ", expected " & integer'image(last)
+				severity failure;
+			assert sequence(15) = '1' and to_integer(unsigned(sequence(14 downto 0))) = conversions
+				report "sequence_out = " & integer'image(to_integer(unsigned(sequence(14 downto 0)))) & ", expected " & integer'image(conversions)
+				severity failure;
+		end procedure;
+
+		begin
+			-- three bursts of BURST conversions
+			for b in 1 to 3 loop
+				pulse_and_check(BURST);
+			end loop;
+
+			-- back to one conversion per pulse (legacy behaviour)
+			burst_length <= (others => '0');
+			pulse_and_check(1);
+			burst_length <= std_logic_vector(to_unsigned(1, 16));
+			pulse_and_check(1);
+
+			report "LT2314_burst_tb passed" severity note;
+			done <= true;
+			wait;
+		end process CHECK;
+
+	end architecture bench;
@@ -0,0 +1,193 @@
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use IEEE.NUMERIC_STD.ALL;
+
+-- CHANNELS LTC2314 sharing spi_sck and spi_cs_n: their spi_din lines are shifted in parallel and the
+-- results are latched together as one frame. A conversion takes the same time whatever the number of
+-- channels (16 SCK + 1 SCK in ACQ). LT2314_driver is the CHANNELS = 1 case of this entity, so both
+-- have the same SPI timing, burst mode, accumulation and sequence numbering.
+entity LT2314_multi_driver is
+	generic(
+		CHANNELS: positive := 8 -- number of ADCs on the shared SCK / CS
+	);
+	port(
+		-- CLOCKS:
+		clk_250: in std_logic; -- 250 MHz clock
+		sampling_pulse: in std_logic; -- sampling strobe
+
+		-- CONFIGURATION:
+		-- spi_sck = clk_250 / (postscaler_in*2)
+		postscaler_in: in std_logic_vector(15 downto 0);
+		-- number of back-to-back conversions per sampling_pulse (burst mode)
+		-- 0 and 1 both select a single conversion per pulse
+		burst_length_in: in std_logic_vector(15 downto 0) := (others => '0');
+
+		-- OUTPUT DATA (one frame, all the channels updated on the same clock, once per conversion):
+		-- channel k in data_out(16*k+15 downto 16*k), e.g. -> SBI_reg_k
+		data_out: out std_logic_vector(16*CHANNELS-1 downto 0) := (others => '0');
+
+		-- CONVERSION SEQUENCE (updated on the same clock as data_out, e.g. -> SBI_reg_CHANNELS):
+		-- bits 14..0: number of frames completed (wraps around)
+		-- bit 15 (valid): cleared by sampling_pulse, set when the last frame it triggered is in data_out
+		sequence_out: out std_logic_vector(15 downto 0) := (others => '0');
+
+		-- BURST ACCUMULATION (updated together, once per completed burst):
+		-- sum of the conversions of the last burst, channel k in acc_sum_out(32*k+31 downto 32*k),
+		-- and number of conversions summed (the same for all the channels)
+		acc_sum_out: out std_logic_vector(32*CHANNELS-1 downto 0) := (others => '0');
+		acc_count_out: out std_logic_vector(15 downto 0) := (others => '0');
+
+		-- SPI SIGNALS:
+		spi_sck: out std_logic; -- communication clock, shared
+		spi_cs_n: out std_logic; -- chip select strobe / sampling trigger, shared
+		spi_din: in std_logic_vector(CHANNELS-1 downto 0) -- serial data in, one per ADC
+	);
+end LT2314_multi_driver;
+
+architecture impl of LT2314_multi_driver is
+
+	TYPE states is (ACQ,CONV);
+
+	TYPE shift_regs is array (0 to CHANNELS-1) of std_logic_vector(15 downto 0);
+	TYPE accumulators is array (0 to CHANNELS-1) of unsigned(31 downto 0);
+
+	SIGNAL state : states := ACQ; -- FSM state register
+
+	-- Signal used as SPI communication clock
+	-- spi_sck = postscaled_clk = clk_250 / (postscaler_in*2)
+	SIGNAL postscaled_clk : std_logic := '0';
+
+	-- Indicates a rising edge on postscaled_clk
+	SIGNAL postscaled_clk_rising_pulse : std_logic := '0';
+
+	-- Asserted when sampling_pulse = '1'
+	-- Cleared when postscaled_clk_rising_pulse = '1'
+	SIGNAL pulse_detected : std_logic := '0';
+
+	-- Conversions still to perform in the current burst (after the one in progress)
+	SIGNAL burst_remaining : unsigned(15 downto 0) := (others => '0');
+begin
+
+	spi_sck <= postscaled_clk;
+	spi_cs_n <= '1' when state=ACQ else '0';
+
+	-- Generate postscaled_clk and postscaled_clk_rising_pulse
+	POSTSCALER: process(clk_250)
+		variable postscaler_cnt: unsigned(15 downto 0):=(others=>'0');
+	begin
+		if rising_edge(clk_250) then
+
+			postscaled_clk_rising_pulse <= '0';
+
+			-- Toggle postscaled_clk
+			-- Assert postscaled_clk_rising_pulse if rising edge
+			if postscaler_cnt+1 >= unsigned(postscaler_in) then
+				if postscaled_clk = '0' then
+					postscaled_clk_rising_pulse <= '1';
+				end if;
+				postscaler_cnt := (others => '0');
+				postscaled_clk <= not postscaled_clk;
+			else
+				postscaler_cnt := postscaler_cnt + 1;
+			end if;
+
+		end if;
+	end process POSTSCALER;
+
+	-- Generate pulse_detected
+	SAMPLING: process(clk_250)
+	begin
+		if rising_edge(clk_250) then
+			if sampling_pulse = '1' then
+				pulse_detected <= '1';
+			elsif postscaled_clk_rising_pulse = '1' then
+				pulse_detected <= '0';
+			end if;
+		end if;
+	end process SAMPLING;
+
+	-- Finite State Machine
+	-- Run at SPI clock speed (using postscaled_clk_rising_pulse)
+	FSM : process(clk_250)
+		variable bit_cnt : unsigned(4 downto 0) := (others=>'0'); -- bit counter
+	begin
+		if rising_edge(clk_250) and postscaled_clk_rising_pulse = '1' then
+				case state is
+
+					when ACQ =>
+						bit_cnt := (others => '0');
+						if burst_remaining /= 0 then
+							-- next conversion of the burst (sampling pulses are ignored meanwhile)
+							burst_remaining <= burst_remaining - 1;
+							state <= CONV;
+						elsif pulse_detected = '1' then
+							-- first conversion of a burst
+							if unsigned(burst_length_in) > 1 then
+								burst_remaining <= unsigned(burst_length_in) - 1;
+							end if;
+							state <= CONV;
+						end if;
+
+					when CONV =>
+						bit_cnt := bit_cnt + 1;
+						if bit_cnt >= 16 then
+							state <= ACQ;
+						end if;
+
+					when others => null;
+				end case;
+		end if;
+	end process FSM;
+
+	-- Sample all the spi_din lines on spi_sck rising edge during ACQUISITION phase
+	-- Publish every completed frame with its sequence number (data_out is never rewritten between
+	-- two conversions), accumulate it, publish the sums at the end of the burst
+	SHIFT_REG: process (clk_250)
+		variable data_reg: shift_regs := (others => (others => '0'));
+		variable converting: std_logic := '0'; -- state was CONV on the previous clock
+		variable acc: accumulators := (others => (others => '0'));
+		variable acc_count: unsigned(15 downto 0) := (others=>'0');
+		variable sequence: unsigned(14 downto 0) := (others=>'0');
+		variable valid: std_logic := '0';
+	begin
+		if rising_edge(clk_250) then
+			if sampling_pulse = '1' then -- a new sample is requested: data_out becomes stale
+				valid := '0';
+				sequence_out(15) <= '0';
+			end if;
+
+			if state = CONV and postscaled_clk_rising_pulse = '1' then
+				for k in 0 to CHANNELS-1 loop
+					data_reg(k) := data_reg(k)(14 downto 0) & spi_din(k);
+				end loop;
+			elsif state = ACQ and converting = '1' then -- first clock after a conversion
+				for k in 0 to CHANNELS-1 loop
+					data_out(16*k+15 downto 16*k) <= "0" & data_reg(k)(15 downto 1); -- re-align data
+					acc(k) := acc(k) + unsigned("0" & data_reg(k)(15 downto 1));
+				end loop;
+				sequence := sequence + 1;
+				acc_count := acc_count + 1;
+
+				if burst_remaining = 0 then
+					for k in 0 to CHANNELS-1 loop
+						acc_sum_out(32*k+31 downto 32*k) <= std_logic_vector(acc(k));
+						acc(k) := (others => '0');
+					end loop;
+					acc_count_out <= std_logic_vector(acc_count);
+					acc_count := (others => '0');
+					if sampling_pulse = '0' then
+						valid := '1';
+					end if;
+				end if;
+				sequence_out <= valid & std_logic_vector(sequence);
+			end if;
+
+			if state = CONV then
+				converting := '1';
+			else
+				converting := '0';
+			end if;
+		end if;
+	end process SHIFT_REG;
+
+end impl;
@@ -0,0 +1,226 @@
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use IEEE.NUMERIC_STD.ALL;
+
+-- Self-checking testbench of LT2314_multi_driver
+-- Three drivers (1, 8 and 16 channels) run from the same sampling pulses and ADC models; the testbench
+-- checks the data of every channel, the frame coherence (data_out only changes together with the
+-- sequence number) and that the frames of the three drivers complete on the same clock. Single
+-- conversions are followed by bursts, checked on the 16 channel driver: sequence, valid bit, data of
+-- the last conversion, sum and count of every channel.
+-- ghdl -a LT2314_multi_driver.vhd LT2314_multi_tb.vhd && ghdl -e LT2314_multi_tb && ghdl -r LT2314_multi_tb
+entity LT2314_multi_tb is end;
+
+architecture bench of LT2314_multi_tb is
+
+	-- number of blank bits provided by the ADC
+	constant NBLANKBITS : positive := 1;
+
+	-- SCK = CLK_250_MHZ / (POSTSCALER*2) = 62.5 MHz
+	constant SCK_POSTSCALER : std_logic_vector := "0000000000000010";
+
+	-- main clock period
+	constant CLK_PERIOD : time := 4.0 ns; -- 250 MHz
+
+	-- channels of the largest driver
+	constant CHANNELS : positive := 16;
+
+	-- number of sampling pulses with a single conversion, then with a burst of BURST conversions
+	constant FRAMES : positive := 6;
+	constant BURSTS : positive := 3;
+	constant BURST : positive := 4;
+
+	-- code returned by the ADC of a channel at its n-th conversion (all different)
+	function code(channel : natural; n : natural) return natural is
+	begin
+		return (1000*channel + 4099*n + 17) mod 16384;
+	end function;
+
+	-- clock signals
+	signal clk_250, sampling_pulse : std_logic := '0';
+	signal burst_length : std_logic_vector(15 downto 0) := (others => '0');
+	signal done : boolean := false;
+
+	-- SPI signals (driven by the 16-channel driver, the others generate the same SCK and CS)
+	signal SPI_DIN : std_logic_vector(CHANNELS-1 downto 0) := (others => '0');
+	signal SPI_nCS, SPI_CLK : std_logic := '0';
+	signal SPI_nCS_1, SPI_CLK_1, SPI_nCS_8, SPI_CLK_8 : std_logic;
+
+	-- DUT outputs
+	signal data_16 : std_logic_vector(16*CHANNELS-1 downto 0);
+	signal data_8 : std_logic_vector(16*8-1 downto 0);
+	signal data_1 : std_logic_vector(15 downto 0);
+	signal sequence_16, sequence_8, sequence_1 : std_logic_vector(15 downto 0);
+	signal acc_sum_16 : std_logic_vector(32*CHANNELS-1 downto 0);
+	signal acc_count_16 : std_logic_vector(15 downto 0);
+
+	begin
+
+		primary_clock: clk_250 <= not clk_250 after CLK_PERIOD / 2 when not done;
+
+		--------------------------------------------------------------------------------
+		-- DEVICES UNDER TEST
+		--------------------------------------------------------------------------------
+
+		DUT_16: entity work.LT2314_multi_driver
+		generic map(CHANNELS => CHANNELS)
+		port map(
+			clk_250 => clk_250,
+			sampling_pulse => sampling_pulse,
+			postscaler_in => SCK_POSTSCALER,
+			burst_length_in => burst_length,
+			data_out => data_16,
+			sequence_out => sequence_16,
+			acc_sum_out => acc_sum_16,
+			acc_count_out => acc_count_16,
+			spi_sck => SPI_CLK,
+			spi_cs_n => SPI_nCS,
+			spi_din => SPI_DIN);
+
+		DUT_8: entity work.LT2314_multi_driver
+		generic map(CHANNELS => 8)
+		port map(
+			clk_250 => clk_250,
+			sampling_pulse => sampling_pulse,
+			postscaler_in => SCK_POSTSCALER,
+			burst_length_in => burst_length,
+			data_out => data_8,
+			sequence_out => sequence_8,
+			spi_sck => SPI_CLK_8,
+			spi_cs_n => SPI_nCS_8,
+			spi_din => SPI_DIN(7 downto 0));
+
+		DUT_1: entity work.LT2314_multi_driver
+		generic map(CHANNELS => 1)
+		port map(
+			clk_250 => clk_250,
+			sampling_pulse => sampling_pulse,
+			postscaler_in => SCK_POSTSCALER,
+			burst_length_in => burst_length,
+			data_out => data_1,
+			sequence_out => sequence_1,
+			spi_sck => SPI_CLK_1,
+			spi_cs_n => SPI_nCS_1,
+			spi_din => SPI_DIN(0 downto 0));
+
+		--------------------------------------------------------------------------------
+		-- ANALOG-TO-DIGITAL CONVERTER MODELS (one per channel, next code at every chip select)
+		--------------------------------------------------------------------------------
+
+		ADC: for k in 0 to CHANNELS-1 generate
+			SPI_TARGET: process(SPI_nCS,SPI_CLK)
+			variable counter : integer := 0;
+			variable index : natural := 0;
+			variable rawdata : unsigned(13 downto 0) := (others=>'0');
+			begin
+				if falling_edge(SPI_nCS) then
+					rawdata := to_unsigned(code(k, index), 14);
+					index := index + 1;
+				end if;
+
+				if SPI_nCS='1' then
+					SPI_DIN(k) <= 'Z';
+					counter := 13 + NBLANKBITS;
+				elsif SPI_nCS='0' and falling_edge(SPI_CLK) then
+					if (counter > 13 or counter < 0) then
+						SPI_DIN(k) <= '0';
+					else
+						SPI_DIN(k) <= std_logic(rawdata(counter));
+					end if;
+					counter := counter - 1;
+				end if;
+			end process SPI_TARGET;
+		end generate ADC;
+
+		--------------------------------------------------------------------------------
+		-- CHECKS ON EVERY CLOCK
+		--------------------------------------------------------------------------------
+
+		-- Same SPI timing and same frame completion whatever the number of channels,
+		-- and no change of data_out without a new frame number
+		COHERENCE: process(clk_250)
+		variable previous_data : std_logic_vector(16*CHANNELS-1 downto 0) := (others => '0');
+		variable previous_sequence : std_logic_vector(14 downto 0) := (others => '0');
+		begin
+			if rising_edge(clk_250) then
+				assert SPI_nCS_1 = SPI_nCS and SPI_nCS_8 = SPI_nCS and SPI_CLK_1 = SPI_CLK and SPI_CLK_8 = SPI_CLK
+					report "SPI timing depends on the number of channels" severity failure;
+				assert sequence_1 = sequence_16 and sequence_8 = sequence_16
+					report "frames of 1, 8 and 16 channels not completed on the same clock" severity failure;
+				assert data_16 = previous_data or sequence_16(14 downto 0) /= previous_sequence
+					report "data_out changed without a new frame" severity failure;
+				previous_data := data_16;
+				previous_sequence := sequence_16(14 downto 0);
+			end if;
+		end process COHERENCE;
+
+		--------------------------------------------------------------------------------
+		-- STIMULUS AND FRAME CHECKS
+		--------------------------------------------------------------------------------
+
+		CHECK: process
+		variable value, sum, index : natural;
+		begin
+			for n in 0 to FRAMES-1 loop
+				wait for CLK_PERIOD*100;
+				sampling_pulse <= '1';
+				wait for CLK_PERIOD;
+				sampling_pulse <= '0';
+
+				-- one conversion = 16 SCK + 1 SCK in ACQ = 68 clk_250 periods, for any number of channels
+				wait for CLK_PERIOD*(68 + 40);
+
+				assert to_integer(unsigned(sequence_16(14 downto 0))) = n + 1 and sequence_16(15) = '1'
+					report "sequence_out = " & integer'image(to_integer(unsigned(sequence_16))) & ", expected valid and " & integer'image(n + 1)
+					severity failure;
+
+				for k in 0 to CHANNELS-1 loop
+					value := to_integer(unsigned(data_16(16*k+15 downto 16*k)));
+					assert value = code(k, n)
+						report "channel " & integer'image(k) & ": data = " & integer'image(value) & ", expected " & integer'image(code(k, n))
+						severity failure;
+				end loop;
+				assert data_8 = data_16(16*8-1 downto 0) and data_1 = data_16(15 downto 0)
+					report "channels of the 1 and 8 channel drivers differ from the 16 channel one" severity failure;
+			end loop;
+
+			burst_length <= std_logic_vector(to_unsigned(BURST, 16));
+			for b in 0 to BURSTS-1 loop
+				wait for CLK_PERIOD*100;
+				sampling_pulse <= '1';
+				wait for CLK_PERIOD;
+				sampling_pulse <= '0';
+
+				-- valid only once the last conversion of the burst is published
+				wait for CLK_PERIOD*(68*(BURST-1) + 40);
+				assert sequence_16(15) = '0' report "valid set before the end of the burst" severity failure;
+				wait for CLK_PERIOD*68;
+
+				index := FRAMES + BURST*(b + 1);
+				assert to_integer(unsigned(sequence_16(14 downto 0))) = index and sequence_16(15) = '1'
+					report "sequence_out = " & integer'image(to_integer(unsigned(sequence_16))) & ", expected valid and " & integer'image(index)
+					severity failure;
+				assert to_integer(unsigned(acc_count_16)) = BURST report "acc_count_out differs from the burst length" severity failure;
+
+				for k in 0 to CHANNELS-1 loop
+					value := to_integer(unsigned(data_16(16*k+15 downto 16*k)));
+					assert value = code(k, index - 1)
+						report "channel " & integer'image(k) & ": data = " & integer'image(value) & ", expected " & integer'image(code(k, index - 1))
+						severity failure;
+					sum := 0;
+					for m in index - BURST to index - 1 loop
+						sum := sum + code(k, m);
+					end loop;
+					value := to_integer(unsigned(acc_sum_16(32*k+30 downto 32*k)));
+					assert value = sum
+						report "channel " & integer'image(k) & ": sum = " & integer'image(value) & ", expected " & integer'image(sum)
+						severity failure;
+				end loop;
+			end loop;
+
+			report "LT2314_multi_tb passed" severity note;
+			done <= true;
+			wait;
+		end process CHECK;
+
+	end architecture bench;
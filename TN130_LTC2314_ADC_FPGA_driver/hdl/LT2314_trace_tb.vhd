@@ -0,0 +1,166 @@
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use IEEE.NUMERIC_STD.ALL;
+use STD.TEXTIO.ALL;
+
+-- Reference trace of LT2314_driver for the conformance test of its C++ model (host/model)
+-- The stimulus of LT2314_tb (one sampling pulse every 101 clocks, codes 12345, 5782 and 777) is
+-- followed by bursts at a slower SCK and by pulses arriving during bursts at the fastest SCK.
+-- At every rising edge of clk_250, one line gives the inputs and outputs seen by the driver:
+-- cycle sampling_pulse postscaler burst_length spi_din spi_sck spi_cs_n data_out sequence_out acc_sum acc_count
+-- ghdl -a LT2314_multi_driver.vhd LT2314_driver.vhd LT2314_trace_tb.vhd && ghdl -e LT2314_trace_tb && ghdl -r LT2314_trace_tb
+-- then: model_conformance --trace LT2314_trace.txt
+entity LT2314_trace_tb is end;
+
+architecture bench of LT2314_trace_tb is
+
+	-- number of blank bits provided by the ADC
+	constant NBLANKBITS : positive := 1;
+
+	-- main clock period
+	constant CLK_PERIOD : time := 4.0 ns; -- 250 MHz
+
+	-- successive samples produced by the ADC, one per conversion (the first three as in LT2314_tb)
+	type code_array is array (natural range <>) of natural;
+	constant CODES : code_array := (12345, 5782, 777, 16383, 0, 8191, 1, 9999);
+
+	-- clock signals
+	signal clk_250, sampling_pulse : std_logic := '0';
+	signal done : boolean := false;
+
+	-- SPI signals
+	signal SPI_DIN, SPI_nCS, SPI_CLK : std_logic := '0';
+
+	-- DUT configuration and outputs
+	signal postscaler : std_logic_vector(15 downto 0) := std_logic_vector(to_unsigned(2, 16));
+	signal burst_length : std_logic_vector(15 downto 0) := (others => '0');
+	signal data_out : std_logic_vector(15 downto 0);
+	signal sequence : std_logic_vector(15 downto 0);
+	signal acc_sum : std_logic_vector(31 downto 0);
+	signal acc_count : std_logic_vector(15 downto 0);
+
+	-- '1' as 1, anything else (including 'Z') as 0
+	function bit_value(s : std_logic) return natural is
+	begin
+		if s = '1' then
+			return 1;
+		else
+			return 0;
+		end if;
+	end function;
+
+	begin
+
+		primary_clock: clk_250 <= not clk_250 after CLK_PERIOD / 2 when not done;
+
+		--------------------------------------------------------------------------------
+		-- DEVICE UNDER TEST
+		--------------------------------------------------------------------------------
+
+		DUT: entity work.LT2314_driver
+		port map(
+			clk_250 => clk_250,
+			sampling_pulse => sampling_pulse,
+			postscaler_in => postscaler,
+			burst_length_in => burst_length,
+			spi_sck => SPI_CLK,
+			spi_cs_n => SPI_nCS,
+			spi_din => SPI_DIN,
+			data_out => data_out,
+			sequence_out => sequence,
+			acc_sum_out => acc_sum,
+			acc_count_out => acc_count);
+
+		--------------------------------------------------------------------------------
+		-- ANALOG-TO-DIGITAL CONVERTER MODEL (next code at every chip select)
+		--------------------------------------------------------------------------------
+
+		SPI_TARGET: process(SPI_nCS,SPI_CLK)
+		variable counter : integer := 0;
+		variable index : natural := 0;
+		variable rawdata : unsigned(13 downto 0) := (others=>'0');
+		begin
+			if falling_edge(SPI_nCS) then
+				rawdata := to_unsigned(CODES(index mod CODES'length), 14);
+				index := index + 1;
+			end if;
+
+			if SPI_nCS='1' then
+				SPI_DIN <= 'Z';
+				counter := 13 + NBLANKBITS;
+			elsif SPI_nCS='0' and falling_edge(SPI_CLK) then
+				if (counter > 13 or counter < 0) then
+					SPI_DIN <= '0';
+				else
+					SPI_DIN <= std_logic(rawdata(counter));
+				end if;
+				counter := counter - 1;
+			end if;
+		end process SPI_TARGET;
+
+		--------------------------------------------------------------------------------
+		-- STIMULUS
+		--------------------------------------------------------------------------------
+
+		STIMULUS: process
+
+		procedure pulse(wait_clocks : natural) is
+		begin
+			wait for CLK_PERIOD*wait_clocks;
+			sampling_pulse <= '1';
+			wait for CLK_PERIOD;
+			sampling_pulse <= '0';
+		end procedure;
+
+		begin
+			-- LT2314_tb: SCK = 62.5 MHz, one conversion per pulse
+			for n in 1 to 9 loop
+				pulse(100);
+			end loop;
+
+			-- bursts of 3 at SCK = 25 MHz
+			postscaler <= std_logic_vector(to_unsigned(5, 16));
+			burst_length <= std_logic_vector(to_unsigned(3, 16));
+			for n in 1 to 3 loop
+				pulse(300);
+			end loop;
+
+			-- bursts of 2 at SCK = 125 MHz, with pulses arriving during the bursts
+			postscaler <= std_logic_vector(to_unsigned(1, 16));
+			burst_length <= std_logic_vector(to_unsigned(2, 16));
+			for n in 1 to 4 loop
+				pulse(20);
+			end loop;
+
+			wait for CLK_PERIOD*200;
+			done <= true;
+			wait;
+		end process STIMULUS;
+
+		--------------------------------------------------------------------------------
+		-- TRACE
+		--------------------------------------------------------------------------------
+
+		TRACE: process(clk_250)
+		file trace_file : text open write_mode is "LT2314_trace.txt";
+		variable l : line;
+		variable cycle : natural := 0;
+		begin
+			if rising_edge(clk_250) then
+				write(l, cycle);
+				write(l, ' '); write(l, bit_value(sampling_pulse));
+				write(l, ' '); write(l, to_integer(unsigned(postscaler)));
+				write(l, ' '); write(l, to_integer(unsigned(burst_length)));
+				write(l, ' '); write(l, bit_value(SPI_DIN));
+				write(l, ' '); write(l, bit_value(SPI_CLK));
+				write(l, ' '); write(l, bit_value(SPI_nCS));
+				write(l, ' '); write(l, to_integer(unsigned(data_out)));
+				write(l, ' '); write(l, to_integer(unsigned(sequence)));
+				write(l, ' '); write(l, to_integer(unsigned(acc_sum)));
+				write(l, ' '); write(l, to_integer(unsigned(acc_count)));
+				writeline(trace_file, l);
+				cycle := cycle + 1;
+			end if;
+		end process TRACE;
+
+	end architecture bench;